@@ -0,0 +1,196 @@
+/**
+ * Measure GLSL compile and link times.
+ * Compiles the example shaders in this directory a number of times and
+ * prints the average time per compile of each one, and per link of
+ * each vertex/fragment pair.
+ *
+ * Usage: compilebench [-n iterations]
+ *
+ * Unset MESA_GLSL_CACHE_DIR when running this, otherwise the compiles
+ * may be satisfied from the shader cache.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <GL/gl.h>
+#include <GL/glut.h>
+#include <GL/glext.h>
+#include "extfuncs.h"
+#include "shaderutil.h"
+
+
+static const char *VertFiles[] = {
+   "CH06-brick.vert",
+   "CH11-bumpmap.vert",
+   "CH11-toyball.vert",
+   "CH18-mandel.vert",
+   "convolution.vert",
+   "multitex.vert",
+   "reflect.vert",
+   "simple.vert",
+   "skinning.vert",
+   NULL
+};
+
+static const char *FragFiles[] = {
+   "CH06-brick.frag",
+   "CH11-bumpmap.frag",
+   "CH11-toyball.frag",
+   "CH18-mandel.frag",
+   "convolution.frag",
+   "cubemap.frag",
+   "multitex.frag",
+   "shadowtex.frag",
+   "skinning.frag",
+   NULL
+};
+
+/** vertex/fragment shader pairs to link */
+static const char *Programs[][2] = {
+   { "CH06-brick.vert", "CH06-brick.frag" },
+   { "CH11-bumpmap.vert", "CH11-bumpmap.frag" },
+   { "CH11-toyball.vert", "CH11-toyball.frag" },
+   { "CH18-mandel.vert", "CH18-mandel.frag" },
+   { "convolution.vert", "convolution.frag" },
+   { "multitex.vert", "multitex.frag" },
+   { "skinning.vert", "skinning.frag" },
+   { NULL, NULL }
+};
+
+static int Iterations = 100;
+
+
+static char *
+ReadFile(const char *filename)
+{
+   const int max = 100*1000;
+   int n;
+   char *buffer = (char*) malloc(max);
+   FILE *f = fopen(filename, "r");
+   if (!f) {
+      fprintf(stderr, "Unable to open shader file %s\n", filename);
+      exit(1);
+   }
+   n = fread(buffer, 1, max - 1, f);
+   buffer[n > 0 ? n : 0] = 0;
+   fclose(f);
+   return buffer;
+}
+
+
+/**
+ * Compile the shader Iterations times.
+ * \return milliseconds per compile
+ */
+static double
+TimeCompile(GLenum type, const char *filename)
+{
+   char *text = ReadFile(filename);
+   int start, i;
+
+   start = glutGet(GLUT_ELAPSED_TIME);
+   for (i = 0; i < Iterations; i++) {
+      GLuint shader = CompileShaderText(type, text);
+      glDeleteShader_func(shader);
+   }
+   glFinish();
+
+   free(text);
+   return (double) (glutGet(GLUT_ELAPSED_TIME) - start) / Iterations;
+}
+
+
+/**
+ * Link the two shaders into a program Iterations times.
+ * \return milliseconds per link
+ */
+static double
+TimeLink(const char *vertFile, const char *fragFile)
+{
+   char *vertText = ReadFile(vertFile), *fragText = ReadFile(fragFile);
+   GLuint vertShader = CompileShaderText(GL_VERTEX_SHADER, vertText);
+   GLuint fragShader = CompileShaderText(GL_FRAGMENT_SHADER, fragText);
+   int start, i;
+
+   start = glutGet(GLUT_ELAPSED_TIME);
+   for (i = 0; i < Iterations; i++) {
+      GLuint program = LinkShaders(vertShader, fragShader);
+      if (!program)
+         exit(1);
+      glDeleteProgram_func(program);
+   }
+   glFinish();
+
+   glDeleteShader_func(vertShader);
+   glDeleteShader_func(fragShader);
+   free(vertText);
+   free(fragText);
+   return (double) (glutGet(GLUT_ELAPSED_TIME) - start) / Iterations;
+}
+
+
+static void
+RunBenchmark(void)
+{
+   double total = 0.0;
+   int i, count = 0;
+
+   /* the first compile also builds the built-in library; keep it out */
+   glDeleteShader_func(CompileShaderText(GL_VERTEX_SHADER,
+                                         "void main() {}"));
+
+   printf("Compile (ms, average of %d):\n", Iterations);
+   for (i = 0; VertFiles[i]; i++, count++) {
+      double t = TimeCompile(GL_VERTEX_SHADER, VertFiles[i]);
+      printf("  %-24s %8.3f\n", VertFiles[i], t);
+      total += t;
+   }
+   for (i = 0; FragFiles[i]; i++, count++) {
+      double t = TimeCompile(GL_FRAGMENT_SHADER, FragFiles[i]);
+      printf("  %-24s %8.3f\n", FragFiles[i], t);
+      total += t;
+   }
+   printf("  %-24s %8.3f\n", "mean", total / count);
+
+   printf("Link (ms, average of %d):\n", Iterations);
+   for (i = 0; Programs[i][0]; i++) {
+      printf("  %-24s %8.3f\n", Programs[i][0],
+             TimeLink(Programs[i][0], Programs[i][1]));
+   }
+}
+
+
+static void
+ParseOptions(int argc, char *argv[])
+{
+   int i;
+   for (i = 1; i < argc; i++) {
+      if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+         Iterations = atoi(argv[++i]);
+         if (Iterations < 1)
+            Iterations = 1;
+      }
+   }
+}
+
+
+int
+main(int argc, char *argv[])
+{
+   glutInit(&argc, argv);
+   glutInitWindowPosition( 0, 0);
+   glutInitWindowSize(100, 100);
+   glutInitDisplayMode(GLUT_RGB | GLUT_DOUBLE);
+   glutCreateWindow(argv[0]);
+
+   if (!ShadersSupported())
+      exit(1);
+
+   GetExtensionFuncs();
+
+   ParseOptions(argc, argv);
+   RunBenchmark();
+
+   return 0;
+}
@@ -0,0 +1,132 @@
+/*
+ * Test that display lists compile glColor calls which repeat the current
+ * color when glMaterial, glColorMaterial or glEnable/glDisable of
+ * GL_COLOR_MATERIAL come between them.  Each command sequence is run in
+ * immediate mode and from a display list, and the resulting material and
+ * current color must agree.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <GL/glut.h>
+
+
+static const GLfloat Red[4] = { 1.0, 0.0, 0.0, 1.0 };
+static const GLfloat Blue[4] = { 0.0, 0.0, 1.0, 1.0 };
+
+
+static void
+SeqMaterial(void)
+{
+   glColor4fv(Red);
+   glLineWidth(2.0);  /* a state change between the calls */
+   glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, Blue);
+   glColor4fv(Red);
+}
+
+
+static void
+SeqEnable(void)
+{
+   glColor4fv(Red);
+   glDisable(GL_COLOR_MATERIAL);
+   glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, Blue);
+   glEnable(GL_COLOR_MATERIAL);
+   glColor4fv(Red);
+}
+
+
+static void
+SeqColorMaterial(void)
+{
+   glColor4fv(Red);
+   glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT);
+   glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, Blue);
+   glColor4fv(Red);
+}
+
+
+static void
+Reset(void)
+{
+   static const GLfloat white[4] = { 1.0, 1.0, 1.0, 1.0 };
+   static const GLfloat gray[4] = { 0.2, 0.2, 0.2, 1.0 };
+   glColorMaterial(GL_FRONT_AND_BACK, GL_DIFFUSE);
+   glEnable(GL_COLOR_MATERIAL);
+   glColor4fv(white);
+   glDisable(GL_COLOR_MATERIAL);
+   glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, gray);
+   glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, white);
+   glEnable(GL_COLOR_MATERIAL);
+   glLineWidth(1.0);
+}
+
+
+static void
+GetResult(GLfloat result[12])
+{
+   glGetMaterialfv(GL_FRONT, GL_AMBIENT, result);
+   glGetMaterialfv(GL_FRONT, GL_DIFFUSE, result + 4);
+   glGetFloatv(GL_CURRENT_COLOR, result + 8);
+}
+
+
+static int
+Test(const char *name, void (*seq)(void))
+{
+   GLfloat expected[12], result[12];
+   int i;
+
+   Reset();
+   seq();
+   GetResult(expected);
+
+   Reset();
+   glNewList(1, GL_COMPILE);
+   /* attribute calls after the first primitive compile to list opcodes */
+   glBegin(GL_POINTS);
+   glVertex2f(0.0, 0.0);
+   glEnd();
+   seq();
+   glEndList();
+   glCallList(1);
+   glDeleteLists(1, 1);
+   GetResult(result);
+
+   for (i = 0; i < 12; i++) {
+      if (result[i] != expected[i]) {
+         printf("%s: value %d is %f, expected %f\n",
+                name, i, result[i], expected[i]);
+         return 0;
+      }
+   }
+   return 1;
+}
+
+
+static void
+Display(void)
+{
+}
+
+
+int
+main(int argc, char *argv[])
+{
+   int pass = 1;
+
+   glutInit(&argc, argv);
+   glutInitWindowSize(64, 64);
+   glutInitDisplayMode(GLUT_RGB);
+   glutCreateWindow(argv[0]);
+   glutDisplayFunc(Display);
+
+   pass &= Test("glMaterial", SeqMaterial);
+   pass &= Test("glEnable(GL_COLOR_MATERIAL)", SeqEnable);
+   pass &= Test("glColorMaterial", SeqColorMaterial);
+
+   printf("%s\n", pass ? "PASS" : "FAIL!");
+   return pass ? 0 : 1;
+}
@@ -0,0 +1,130 @@
+/**
+ * \file vao-03.c
+ *
+ * Regression test for deleting an APPLE_vertex_array_object which is no
+ * longer bound while draws made with it may still be queued.  Two
+ * glDrawArrays calls are made from a VAO whose only array lives in a
+ * buffer object, the default VAO is bound, the VAO is deleted and then
+ * the result is read back.  The draws must appear and the implementation
+ * must not read the deleted object.
+ */
+
+#define GL_GLEXT_PROTOTYPES
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#ifdef __darwin__
+#include <GLUT/glut.h>
+
+typedef void (* PFNGLBINDVERTEXARRAYAPPLEPROC) (GLuint array);
+typedef void (* PFNGLDELETEVERTEXARRAYSAPPLEPROC) (GLsizei n, const GLuint *arrays);
+typedef void (* PFNGLGENVERTEXARRAYSAPPLEPROC) (GLsizei n, GLuint *arrays);
+
+#else
+#include <GL/glut.h>
+#endif
+
+static PFNGLBINDVERTEXARRAYAPPLEPROC bind_vertex_array = NULL;
+static PFNGLGENVERTEXARRAYSAPPLEPROC gen_vertex_arrays = NULL;
+static PFNGLDELETEVERTEXARRAYSAPPLEPROC delete_vertex_arrays = NULL;
+
+static int Width = 64;
+static int Height = 64;
+
+
+static void Display( void )
+{
+}
+
+
+static void Init( void )
+{
+   static const GLfloat verts[] = {
+      -1.0, -1.0,   1.0, -1.0,   1.0,  1.0,
+      -1.0, -1.0,   1.0,  1.0,  -1.0,  1.0
+   };
+   GLuint obj, buf;
+   GLubyte pixel[4];
+   int pass = 1;
+   GLenum err;
+
+
+   printf("GL_RENDERER = %s\n", (char *) glGetString(GL_RENDERER));
+   printf("GL_VERSION = %s\n\n", (char *) glGetString(GL_VERSION));
+
+   if ( !glutExtensionSupported("GL_APPLE_vertex_array_object") ||
+        !glutExtensionSupported("GL_ARB_vertex_buffer_object") ) {
+      printf("Sorry, this program requires GL_APPLE_vertex_array_object "
+             "and GL_ARB_vertex_buffer_object\n");
+      exit(2);
+   }
+
+   bind_vertex_array = glutGetProcAddress( "glBindVertexArrayAPPLE" );
+   gen_vertex_arrays = glutGetProcAddress( "glGenVertexArraysAPPLE" );
+   delete_vertex_arrays = glutGetProcAddress( "glDeleteVertexArraysAPPLE" );
+
+   glDrawBuffer( GL_BACK );
+   glReadBuffer( GL_BACK );
+   glClearColor( 0.0, 0.0, 0.0, 0.0 );
+   glClear( GL_COLOR_BUFFER_BIT );
+   glColor3f( 0.0, 1.0, 0.0 );
+
+   glGenBuffersARB( 1, & buf );
+   glBindBufferARB( GL_ARRAY_BUFFER_ARB, buf );
+   glBufferDataARB( GL_ARRAY_BUFFER_ARB, sizeof(verts), verts,
+                    GL_STATIC_DRAW_ARB );
+
+   (*gen_vertex_arrays)( 1, & obj );
+   (*bind_vertex_array)( obj );
+   glVertexPointer( 2, GL_FLOAT, 0, (void *) 0 );
+   glEnableClientState( GL_VERTEX_ARRAY );
+
+   /* adjacent draws from buffer objects may be held back and drawn
+    * together later
+    */
+   glDrawArrays( GL_TRIANGLES, 0, 3 );
+   glDrawArrays( GL_TRIANGLES, 3, 3 );
+
+   (*bind_vertex_array)( 0 );
+   (*delete_vertex_arrays)( 1, & obj );
+
+   glReadPixels( Width / 2, Height / 2, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE,
+                 pixel );
+
+   err = glGetError();
+   if (err) {
+      printf( "glGetError incorrectly returned 0x%04x.\n", err );
+      pass = 0;
+   }
+
+   if ( pixel[0] != 0 || pixel[1] != 255 || pixel[2] != 0 ) {
+      printf( "Pixel is incorrectly %u, %u, %u.\n",
+              pixel[0], pixel[1], pixel[2] );
+      pass = 0;
+   }
+
+   glDeleteBuffersARB( 1, & buf );
+
+   if ( ! pass ) {
+      printf( "FAIL!\n" );
+      exit(1);
+   }
+
+   printf( "PASS\n" );
+}
+
+
+int main( int argc, char *argv[] )
+{
+   glutInit( &argc, argv );
+   glutInitWindowPosition( 0, 0 );
+   glutInitWindowSize( Width, Height );
+   glutInitDisplayMode( GLUT_RGB | GLUT_DOUBLE );
+   glutCreateWindow( "GL_APPLE_vertex_array_object demo" );
+   glutDisplayFunc( Display );
+
+   Init();
+
+   return 0;
+}
@@ -39,6 +39,7 @@
 #include "main/extensions.h"
 #include "main/framebuffer.h"
 #include "main/imports.h"
+#include "main/marshal.h"
 #include "main/mtypes.h"
 #include "main/renderbuffer.h"
 #include "swrast/swrast.h"
@@ -1279,6 +1280,7 @@ OSMesaCreateContextExt( GLenum format, GLint depthBits, GLint stencilBits,
          /* use default TCL pipeline */
          tnl = TNL_CONTEXT(ctx);
          tnl->Driver.RunPipeline = _tnl_run_pipeline;
+         _tnl_allow_guard_band( ctx, SWRAST_GUARD_BAND );
 
          /* Extend the software rasterizer with our optimized line and triangle
           * drawing functions.
@@ -1286,6 +1288,8 @@ OSMesaCreateContextExt( GLenum format, GLint depthBits, GLint stencilBits,
          swrast = SWRAST_CONTEXT( ctx );
          swrast->choose_line = osmesa_choose_line;
          swrast->choose_triangle = osmesa_choose_triangle;
+
+         _mesa_marshal_create( ctx );
       }
    }
    return osmesa;
@@ -1301,6 +1305,8 @@ GLAPI void GLAPIENTRY
 OSMesaDestroyContext( OSMesaContext osmesa )
 {
    if (osmesa) {
+      _mesa_marshal_destroy( &osmesa->mesa );
+
       if (osmesa->rb)
          _mesa_reference_renderbuffer(&osmesa->rb, NULL);
 
@@ -1367,6 +1373,9 @@ OSMesaMakeCurrent( OSMesaContext osmesa, void *buffer, GLenum type,
    }
 #endif
 
+   /* The worker thread may still be drawing into the old buffer */
+   _mesa_marshal_finish( &osmesa->mesa );
+
    osmesa_update_state( &osmesa->mesa, 0 );
 
    /* Call this periodically to detect when the user has begun using
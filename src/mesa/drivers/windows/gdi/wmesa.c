@@ -1526,6 +1526,7 @@ WMesaContext WMesaCreateContext(HDC hDC,
     }
     _swsetup_Wakeup(ctx);
     TNL_CONTEXT(ctx)->Driver.RunPipeline = _tnl_run_pipeline;
+    _tnl_allow_guard_band(ctx, SWRAST_GUARD_BAND);
 
     return c;
 }
@@ -69,6 +69,7 @@
 #include "main/framebuffer.h"
 #include "main/imports.h"
 #include "main/macros.h"
+#include "main/marshal.h"
 #include "main/renderbuffer.h"
 #include "main/teximage.h"
 #include "glapi/glthread.h"
@@ -1634,6 +1635,9 @@ XMesaContext XMesaCreateContext( XMesaVisual v, XMesaContext share_list )
    /* swrast setup */
    xmesa_register_swrast_functions( mesaCtx );
    _swsetup_Wakeup(mesaCtx);
+   _tnl_allow_guard_band(mesaCtx, SWRAST_GUARD_BAND);
+
+   _mesa_marshal_create(mesaCtx);
 
    return c;
 }
@@ -1645,6 +1649,8 @@ void XMesaDestroyContext( XMesaContext c )
 {
    GLcontext *mesaCtx = &c->mesa;
 
+   _mesa_marshal_destroy( mesaCtx );
+
 #ifdef FX
    FXdestroyContext( XMESA_BUFFER(mesaCtx->DrawBuffer) );
 #endif
@@ -1910,6 +1916,9 @@ GLboolean XMesaMakeCurrent2( XMesaContext c, XMesaBuffer drawBuffer,
          return GL_TRUE;
       }
 
+      /* The worker thread may still be drawing into the old buffers */
+      _mesa_marshal_finish(&c->mesa);
+
       c->xm_buffer = drawBuffer;
 
 #ifdef FX
@@ -246,7 +246,8 @@ _mesa_BindVertexArrayAPPLE( GLuint id )
    GET_CURRENT_CONTEXT(ctx);
    struct gl_array_object * const oldObj = ctx->Array.ArrayObj;
    struct gl_array_object *newObj = NULL;
-   ASSERT_OUTSIDE_BEGIN_END(ctx);
+   /* queued draws refer to the arrays of the bound object */
+   ASSERT_OUTSIDE_BEGIN_END_AND_FLUSH(ctx);
 
    ASSERT(oldObj != NULL);
 
@@ -301,7 +302,8 @@ _mesa_DeleteVertexArraysAPPLE(GLsizei n, const GLuint *ids)
 {
    GET_CURRENT_CONTEXT(ctx);
    GLsizei i;
-   ASSERT_OUTSIDE_BEGIN_END(ctx);
+   /* draws may still be queued from an object which is no longer bound */
+   ASSERT_OUTSIDE_BEGIN_END_AND_FLUSH(ctx);
 
    if (n < 0) {
       _mesa_error(ctx, GL_INVALID_VALUE, "glDeleteVertexArrayAPPLE(n)");
@@ -1005,8 +1005,7 @@ _mesa_PopAttrib(void)
                /* lighting enable */
                _mesa_set_enable(ctx, GL_LIGHTING, light->Enabled);
                /* per-light state */
-               if (_math_matrix_is_dirty(ctx->ModelviewMatrixStack.Top))
-                  _math_matrix_analyse( ctx->ModelviewMatrixStack.Top );
+               _mesa_analyse_stack_top( &ctx->ModelviewMatrixStack );
 	       
                for (i = 0; i < ctx->Const.MaxLights; i++) {
 		  const struct gl_light *l = &light->Light[i];
@@ -1171,8 +1170,7 @@ _mesa_PopAttrib(void)
                const struct gl_transform_attrib *xform;
                xform = (const struct gl_transform_attrib *) attr->data;
                _mesa_MatrixMode(xform->MatrixMode);
-               if (_math_matrix_is_dirty(ctx->ProjectionMatrixStack.Top))
-                  _math_matrix_analyse( ctx->ProjectionMatrixStack.Top );
+               _mesa_analyse_stack_top( &ctx->ProjectionMatrixStack );
 
                /* restore clip planes */
                for (i = 0; i < MAX_CLIP_PLANES; i++) {
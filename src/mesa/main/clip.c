@@ -27,6 +27,7 @@
 #include "clip.h"
 #include "context.h"
 #include "macros.h"
+#include "matrix.h"
 #include "mtypes.h"
 
 #include "math/m_xform.h"
@@ -67,8 +68,7 @@ _mesa_ClipPlane( GLenum plane, const GLdouble *eq )
     * clipping now takes place.  The clip-space equations are recalculated
     * whenever the projection matrix changes.
     */
-   if (_math_matrix_is_dirty(ctx->ModelviewMatrixStack.Top))
-      _math_matrix_analyse( ctx->ModelviewMatrixStack.Top );
+   _mesa_analyse_stack_top( &ctx->ModelviewMatrixStack );
 
    _mesa_transform_vector( equation, equation,
                            ctx->ModelviewMatrixStack.Top->inv );
@@ -84,8 +84,7 @@ _mesa_ClipPlane( GLenum plane, const GLdouble *eq )
     * code in _mesa_update_state().
     */
    if (ctx->Transform.ClipPlanesEnabled & (1 << p)) {
-      if (_math_matrix_is_dirty(ctx->ProjectionMatrixStack.Top))
-         _math_matrix_analyse( ctx->ProjectionMatrixStack.Top );
+      _mesa_analyse_stack_top( &ctx->ProjectionMatrixStack );
 
       _mesa_transform_vector( ctx->Transform._ClipUserPlane[p],
 			   ctx->Transform.EyeUserPlane[p],
@@ -290,6 +290,12 @@
 #define ACOMP 3
 
 
+/**
+ * Number of glDrawElements index ranges remembered per buffer object.
+ */
+#define MAX_INDEX_RANGES 4
+
+
 /**
  * Maximum number of temporary vertices required for clipping.  
  *
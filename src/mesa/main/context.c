@@ -118,6 +118,7 @@
 #include "light.h"
 #include "lines.h"
 #include "macros.h"
+#include "marshal.h"
 #include "matrix.h"
 #include "multisample.h"
 #include "pixel.h"
@@ -149,6 +150,7 @@
 #include "shader/program.h"
 #endif
 #include "shader/shader_api.h"
+#include "shader/shader_queue.h"
 #if FEATURE_ATI_fragment_shader
 #include "shader/atifragshader.h"
 #endif
@@ -188,6 +190,7 @@ GLfloat _mesa_ubyte_to_float_color_tab[256];
 void
 _mesa_notifySwapBuffers(__GLcontext *gc)
 {
+   _mesa_marshal_finish( gc );
    FLUSH_VERTICES( gc, 0 );
 }
 
@@ -1279,6 +1282,12 @@ _mesa_free_context_data( GLcontext *ctx )
       _mesa_make_current(ctx, NULL, NULL);
    }
 
+   /* drivers normally stop it earlier, before their own teardown */
+   _mesa_marshal_destroy(ctx);
+
+   /* wait for shader compiles and links still running with this context */
+   _mesa_free_shader_queue(ctx);
+
    /* unreference WinSysDraw/Read buffers */
    _mesa_unreference_framebuffer(&ctx->WinSysDrawBuffer);
    _mesa_unreference_framebuffer(&ctx->WinSysReadBuffer);
@@ -1605,6 +1614,15 @@ _mesa_make_current( GLcontext *newCtx, GLframebuffer *drawBuffer,
       }
    }
 
+   /* Commands queued for the current context must execute before it
+    * is unbound.
+    */
+   {
+      GLcontext *curCtx = _mesa_get_current_context();
+      if (curCtx)
+         _mesa_marshal_finish(curCtx);
+   }
+
    /* We used to call _glapi_check_multithread() here.  Now do it in drivers */
    _glapi_set_context((void *) newCtx);
    ASSERT(_mesa_get_current_context() == newCtx);
@@ -1689,6 +1707,8 @@ _mesa_make_current( GLcontext *newCtx, GLframebuffer *drawBuffer,
 
 	 newCtx->FirstTimeCurrent = GL_FALSE;
       }
+
+      _mesa_marshal_make_current(newCtx);
    }
 }
 
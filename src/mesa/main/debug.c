@@ -166,7 +166,8 @@ static void add_debug_flags( const char *debug )
       { "lighting",  VERBOSE_LIGHTING },
       { "disassem",  VERBOSE_DISASSEM },
       { "glsl",      VERBOSE_GLSL },     /* report GLSL compile/link errors */
-      { "glsl_dump", VERBOSE_GLSL_DUMP } /* print shader GPU instructions */
+      { "glsl_dump", VERBOSE_GLSL_DUMP }, /* print shader GPU instructions */
+      { "glsl_mem",  VERBOSE_GLSL_MEM }   /* GLSL compiler memory usage */
    };
    GLuint i;
 
@@ -953,6 +953,32 @@ save_BlendColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
 }
 
 
+/**
+ * Forget the current attribute values and state tracked while compiling
+ * the list, after a command whose effect on them is only known when the
+ * list is executed.
+ */
+static void
+invalidate_saved_current_state(GLcontext *ctx)
+{
+   ctx->ListState.KnownAttribs = 0;
+   ctx->ListState.ShadeModel = 0;
+}
+
+
+/**
+ * With GL_COLOR_MATERIAL, a glColor call which repeats the current color
+ * still sets the material.  Forget the known color after commands which
+ * change the material or how the color is tracked, so that the next
+ * glColor call is compiled.
+ */
+static void
+forget_color_material(GLcontext *ctx)
+{
+   ctx->ListState.KnownAttribs &= ~VERT_BIT_COLOR0;
+}
+
+
 void GLAPIENTRY
 _mesa_save_CallList(GLuint list)
 {
@@ -965,9 +991,11 @@ _mesa_save_CallList(GLuint list)
       n[1].ui = list;
    }
 
-   /* After this, we don't know what begin/end state we're in:
+   /* After this, we don't know what begin/end state we're in, nor
+    * what the current attributes are:
     */
    ctx->Driver.CurrentSavePrimitive = PRIM_UNKNOWN;
+   invalidate_saved_current_state(ctx);
 
    if (ctx->ExecuteFlag) {
       CALL_CallList(ctx->Exec, (list));
@@ -1010,9 +1038,11 @@ _mesa_save_CallLists(GLsizei n, GLenum type, const GLvoid * lists)
       }
    }
 
-   /* After this, we don't know what begin/end state we're in:
+   /* After this, we don't know what begin/end state we're in, nor
+    * what the current attributes are:
     */
    ctx->Driver.CurrentSavePrimitive = PRIM_UNKNOWN;
+   invalidate_saved_current_state(ctx);
 
    if (ctx->ExecuteFlag) {
       CALL_CallLists(ctx->Exec, (n, type, lists));
@@ -1175,6 +1205,7 @@ save_ColorMaterial(GLenum face, GLenum mode)
       n[1].e = face;
       n[2].e = mode;
    }
+   forget_color_material(ctx);
    if (ctx->ExecuteFlag) {
       CALL_ColorMaterial(ctx->Exec, (face, mode));
    }
@@ -1727,6 +1758,8 @@ save_Disable(GLenum cap)
    if (n) {
       n[1].e = cap;
    }
+   if (cap == GL_COLOR_MATERIAL)
+      forget_color_material(ctx);
    if (ctx->ExecuteFlag) {
       CALL_Disable(ctx->Exec, (cap));
    }
@@ -1786,6 +1819,8 @@ save_Enable(GLenum cap)
    if (n) {
       n[1].e = cap;
    }
+   if (cap == GL_COLOR_MATERIAL)
+      forget_color_material(ctx);
    if (ctx->ExecuteFlag) {
       CALL_Enable(ctx->Exec, (cap));
    }
@@ -1799,6 +1834,8 @@ _mesa_save_EvalMesh1(GLenum mode, GLint i1, GLint i2)
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
    ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
+   /* evaluators set the current attributes */
+   ctx->ListState.KnownAttribs = 0;
    n = ALLOC_INSTRUCTION(ctx, OPCODE_EVALMESH1, 3);
    if (n) {
       n[1].e = mode;
@@ -1817,6 +1854,7 @@ _mesa_save_EvalMesh2(GLenum mode, GLint i1, GLint i2, GLint j1, GLint j2)
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
    ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
+   ctx->ListState.KnownAttribs = 0;
    n = ALLOC_INSTRUCTION(ctx, OPCODE_EVALMESH2, 5);
    if (n) {
       n[1].e = mode;
@@ -2778,6 +2816,7 @@ save_PopAttrib(void)
    GET_CURRENT_CONTEXT(ctx);
    ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
    (void) ALLOC_INSTRUCTION(ctx, OPCODE_POP_ATTRIB, 0);
+   invalidate_saved_current_state(ctx);
    if (ctx->ExecuteFlag) {
       CALL_PopAttrib(ctx->Exec, ());
    }
@@ -3172,11 +3211,20 @@ save_ShadeModel(GLenum mode)
 {
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
-   ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
-   n = ALLOC_INSTRUCTION(ctx, OPCODE_SHADE_MODEL, 1);
-   if (n) {
-      n[1].e = mode;
+   ASSERT_OUTSIDE_SAVE_BEGIN_END(ctx);
+
+   /* Don't compile (or flush vertices for) a no-op, so that the
+    * vertex lists around it can be merged.
+    */
+   if (ctx->ListState.ShadeModel != mode) {
+      SAVE_FLUSH_VERTICES(ctx);
+      n = ALLOC_INSTRUCTION(ctx, OPCODE_SHADE_MODEL, 1);
+      if (n) {
+         n[1].e = mode;
+      }
+      ctx->ListState.ShadeModel = mode;
    }
+
    if (ctx->ExecuteFlag) {
       CALL_ShadeModel(ctx->Exec, (mode));
    }
@@ -4836,21 +4884,45 @@ save_SetFragmentShaderConstantATI(GLuint dst, const GLfloat *value)
 }
 #endif
 
+/**
+ * Test if setting vertex attribute 'attr' to the given value would be a
+ * no-op at this point of the list being compiled.  Such calls are not
+ * compiled, which lets the vertex lists on either side of them be merged
+ * into one.  Position (and generic attribute 0, which aliases it) emits
+ * a vertex, so it is never a no-op.
+ */
+static GLboolean
+is_current_attrib(GLcontext *ctx, GLuint attr, GLuint size,
+                  GLfloat x, GLfloat y, GLfloat z, GLfloat w)
+{
+   const GLfloat *current = ctx->ListState.CurrentAttrib[attr];
+
+   return (attr != VERT_ATTRIB_POS &&
+           (ctx->ListState.KnownAttribs & (1 << attr)) &&
+           ctx->ListState.ActiveAttribSize[attr] == size &&
+           current[0] == x && current[1] == y &&
+           current[2] == z && current[3] == w);
+}
+
 static void
 save_Attr1fNV(GLenum attr, GLfloat x)
 {
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
    SAVE_FLUSH_VERTICES(ctx);
-   n = ALLOC_INSTRUCTION(ctx, OPCODE_ATTR_1F_NV, 2);
-   if (n) {
-      n[1].e = attr;
-      n[2].f = x;
-   }
 
    ASSERT(attr < MAX_VERTEX_PROGRAM_ATTRIBS);
-   ctx->ListState.ActiveAttribSize[attr] = 1;
-   ASSIGN_4V(ctx->ListState.CurrentAttrib[attr], x, 0, 0, 1);
+   if (!is_current_attrib(ctx, attr, 1, x, 0, 0, 1)) {
+      n = ALLOC_INSTRUCTION(ctx, OPCODE_ATTR_1F_NV, 2);
+      if (n) {
+         n[1].e = attr;
+         n[2].f = x;
+      }
+
+      ctx->ListState.ActiveAttribSize[attr] = 1;
+      ASSIGN_4V(ctx->ListState.CurrentAttrib[attr], x, 0, 0, 1);
+      ctx->ListState.KnownAttribs |= 1 << attr;
+   }
 
    if (ctx->ExecuteFlag) {
       CALL_VertexAttrib1fNV(ctx->Exec, (attr, x));
@@ -4863,16 +4935,20 @@ save_Attr2fNV(GLenum attr, GLfloat x, GLfloat y)
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
    SAVE_FLUSH_VERTICES(ctx);
-   n = ALLOC_INSTRUCTION(ctx, OPCODE_ATTR_2F_NV, 3);
-   if (n) {
-      n[1].e = attr;
-      n[2].f = x;
-      n[3].f = y;
-   }
 
    ASSERT(attr < MAX_VERTEX_PROGRAM_ATTRIBS);
-   ctx->ListState.ActiveAttribSize[attr] = 2;
-   ASSIGN_4V(ctx->ListState.CurrentAttrib[attr], x, y, 0, 1);
+   if (!is_current_attrib(ctx, attr, 2, x, y, 0, 1)) {
+      n = ALLOC_INSTRUCTION(ctx, OPCODE_ATTR_2F_NV, 3);
+      if (n) {
+         n[1].e = attr;
+         n[2].f = x;
+         n[3].f = y;
+      }
+
+      ctx->ListState.ActiveAttribSize[attr] = 2;
+      ASSIGN_4V(ctx->ListState.CurrentAttrib[attr], x, y, 0, 1);
+      ctx->ListState.KnownAttribs |= 1 << attr;
+   }
 
    if (ctx->ExecuteFlag) {
       CALL_VertexAttrib2fNV(ctx->Exec, (attr, x, y));
@@ -4885,17 +4961,21 @@ save_Attr3fNV(GLenum attr, GLfloat x, GLfloat y, GLfloat z)
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
    SAVE_FLUSH_VERTICES(ctx);
-   n = ALLOC_INSTRUCTION(ctx, OPCODE_ATTR_3F_NV, 4);
-   if (n) {
-      n[1].e = attr;
-      n[2].f = x;
-      n[3].f = y;
-      n[4].f = z;
-   }
 
    ASSERT(attr < MAX_VERTEX_PROGRAM_ATTRIBS);
-   ctx->ListState.ActiveAttribSize[attr] = 3;
-   ASSIGN_4V(ctx->ListState.CurrentAttrib[attr], x, y, z, 1);
+   if (!is_current_attrib(ctx, attr, 3, x, y, z, 1)) {
+      n = ALLOC_INSTRUCTION(ctx, OPCODE_ATTR_3F_NV, 4);
+      if (n) {
+         n[1].e = attr;
+         n[2].f = x;
+         n[3].f = y;
+         n[4].f = z;
+      }
+
+      ctx->ListState.ActiveAttribSize[attr] = 3;
+      ASSIGN_4V(ctx->ListState.CurrentAttrib[attr], x, y, z, 1);
+      ctx->ListState.KnownAttribs |= 1 << attr;
+   }
 
    if (ctx->ExecuteFlag) {
       CALL_VertexAttrib3fNV(ctx->Exec, (attr, x, y, z));
@@ -4908,18 +4988,22 @@ save_Attr4fNV(GLenum attr, GLfloat x, GLfloat y, GLfloat z, GLfloat w)
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
    SAVE_FLUSH_VERTICES(ctx);
-   n = ALLOC_INSTRUCTION(ctx, OPCODE_ATTR_4F_NV, 5);
-   if (n) {
-      n[1].e = attr;
-      n[2].f = x;
-      n[3].f = y;
-      n[4].f = z;
-      n[5].f = w;
-   }
 
    ASSERT(attr < MAX_VERTEX_PROGRAM_ATTRIBS);
-   ctx->ListState.ActiveAttribSize[attr] = 4;
-   ASSIGN_4V(ctx->ListState.CurrentAttrib[attr], x, y, z, w);
+   if (!is_current_attrib(ctx, attr, 4, x, y, z, w)) {
+      n = ALLOC_INSTRUCTION(ctx, OPCODE_ATTR_4F_NV, 5);
+      if (n) {
+         n[1].e = attr;
+         n[2].f = x;
+         n[3].f = y;
+         n[4].f = z;
+         n[5].f = w;
+      }
+
+      ctx->ListState.ActiveAttribSize[attr] = 4;
+      ASSIGN_4V(ctx->ListState.CurrentAttrib[attr], x, y, z, w);
+      ctx->ListState.KnownAttribs |= 1 << attr;
+   }
 
    if (ctx->ExecuteFlag) {
       CALL_VertexAttrib4fNV(ctx->Exec, (attr, x, y, z, w));
@@ -4941,6 +5025,7 @@ save_Attr1fARB(GLenum attr, GLfloat x)
 
    ASSERT(attr < MAX_VERTEX_ATTRIBS);
    ctx->ListState.ActiveAttribSize[attr] = 1;
+   ctx->ListState.KnownAttribs &= ~(1 << attr);
    ASSIGN_4V(ctx->ListState.CurrentAttrib[attr], x, 0, 0, 1);
 
    if (ctx->ExecuteFlag) {
@@ -4963,6 +5048,7 @@ save_Attr2fARB(GLenum attr, GLfloat x, GLfloat y)
 
    ASSERT(attr < MAX_VERTEX_ATTRIBS);
    ctx->ListState.ActiveAttribSize[attr] = 2;
+   ctx->ListState.KnownAttribs &= ~(1 << attr);
    ASSIGN_4V(ctx->ListState.CurrentAttrib[attr], x, y, 0, 1);
 
    if (ctx->ExecuteFlag) {
@@ -4986,6 +5072,7 @@ save_Attr3fARB(GLenum attr, GLfloat x, GLfloat y, GLfloat z)
 
    ASSERT(attr < MAX_VERTEX_ATTRIBS);
    ctx->ListState.ActiveAttribSize[attr] = 3;
+   ctx->ListState.KnownAttribs &= ~(1 << attr);
    ASSIGN_4V(ctx->ListState.CurrentAttrib[attr], x, y, z, 1);
 
    if (ctx->ExecuteFlag) {
@@ -5010,6 +5097,7 @@ save_Attr4fARB(GLenum attr, GLfloat x, GLfloat y, GLfloat z, GLfloat w)
 
    ASSERT(attr < MAX_VERTEX_ATTRIBS);
    ctx->ListState.ActiveAttribSize[attr] = 4;
+   ctx->ListState.KnownAttribs &= ~(1 << attr);
    ASSIGN_4V(ctx->ListState.CurrentAttrib[attr], x, y, z, w);
 
    if (ctx->ExecuteFlag) {
@@ -5024,6 +5112,8 @@ save_EvalCoord1f(GLfloat x)
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
    SAVE_FLUSH_VERTICES(ctx);
+   /* evaluators set the current attributes */
+   ctx->ListState.KnownAttribs = 0;
    n = ALLOC_INSTRUCTION(ctx, OPCODE_EVAL_C1, 1);
    if (n) {
       n[1].f = x;
@@ -5045,6 +5135,7 @@ save_EvalCoord2f(GLfloat x, GLfloat y)
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
    SAVE_FLUSH_VERTICES(ctx);
+   ctx->ListState.KnownAttribs = 0;
    n = ALLOC_INSTRUCTION(ctx, OPCODE_EVAL_C2, 2);
    if (n) {
       n[1].f = x;
@@ -5068,6 +5159,7 @@ save_EvalPoint1(GLint x)
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
    SAVE_FLUSH_VERTICES(ctx);
+   ctx->ListState.KnownAttribs = 0;
    n = ALLOC_INSTRUCTION(ctx, OPCODE_EVAL_P1, 1);
    if (n) {
       n[1].i = x;
@@ -5083,6 +5175,7 @@ save_EvalPoint2(GLint x, GLint y)
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
    SAVE_FLUSH_VERTICES(ctx);
+   ctx->ListState.KnownAttribs = 0;
    n = ALLOC_INSTRUCTION(ctx, OPCODE_EVAL_P2, 2);
    if (n) {
       n[1].i = x;
@@ -5165,6 +5258,7 @@ save_Materialfv(GLenum face, GLenum pname, const GLfloat * param)
             COPY_SZ_4V(ctx->ListState.CurrentMaterial[i], args, param);
          }
    }
+   forget_color_material(ctx);
 
    if (ctx->ExecuteFlag) {
       CALL_Materialfv(ctx->Exec, (face, pname, param));
@@ -6769,6 +6863,8 @@ _mesa_NewList(GLuint list, GLenum mode)
    for (i = 0; i < MAT_ATTRIB_MAX; i++)
       ctx->ListState.ActiveMaterialSize[i] = 0;
 
+   invalidate_saved_current_state(ctx);
+
    ctx->Driver.CurrentSavePrimitive = PRIM_UNKNOWN;
    ctx->Driver.NewList(ctx, list, mode);
 
@@ -33,6 +33,7 @@
 #include "enable.h"
 #include "light.h"
 #include "macros.h"
+#include "matrix.h"
 #include "simple_list.h"
 #include "mtypes.h"
 #include "enums.h"
@@ -299,8 +300,7 @@ _mesa_set_enable(GLcontext *ctx, GLenum cap, GLboolean state)
             if (state) {
                ctx->Transform.ClipPlanesEnabled |= (1 << p);
 
-               if (_math_matrix_is_dirty(ctx->ProjectionMatrixStack.Top))
-                  _math_matrix_analyse( ctx->ProjectionMatrixStack.Top );
+               _mesa_analyse_stack_top( &ctx->ProjectionMatrixStack );
 
                /* This derived state also calculated in clip.c and
                 * from _mesa_update_state() on changes to EyeUserPlane
@@ -179,13 +179,13 @@ static GLboolean check_active_shininess( GLcontext *ctx,
 }
 
 
-static void make_state_key( GLcontext *ctx, struct state_key *key )
+/**
+ * Key fields which are cheap to compute and are refreshed on every
+ * lookup.
+ */
+static void make_state_key_common( GLcontext *ctx, struct state_key *key )
 {
-   const struct gl_fragment_program *fp;
-   GLuint i;
-
-   memset(key, 0, sizeof(struct state_key));
-   fp = ctx->FragmentProgram._Current;
+   const struct gl_fragment_program *fp = ctx->FragmentProgram._Current;
 
    /* This now relies on texenvprogram.c being active:
     */
@@ -203,6 +203,48 @@ static void make_state_key( GLcontext *ctx, struct state_key *key )
    key->separate_specular = (ctx->Light.Model.ColorControl ==
 			     GL_SEPARATE_SPECULAR_COLOR);
 
+   key->normalize = ctx->Transform.Normalize ? 1 : 0;
+   key->rescale_normals = ctx->Transform.RescaleNormals ? 1 : 0;
+
+   key->fog_mode = translate_fog_mode(fp->FogOption);
+   key->fog_source_is_depth =
+      (ctx->Fog.FogCoordinateSource == GL_FRAGMENT_DEPTH_EXT);
+   key->tnl_do_vertex_fog = tnl_get_per_vertex_fog(ctx);
+
+   key->point_attenuated = ctx->Point._Attenuated ? 1 : 0;
+
+#if FEATURE_point_size_array
+   key->point_array = ctx->Array.ArrayObj->PointSize.Enabled ? 1 : 0;
+#endif
+
+   key->texture_enabled_global = (ctx->Texture._TexGenEnabled ||
+                                  ctx->Texture._TexMatEnabled ||
+                                  ctx->Texture._EnabledUnits) ? 1 : 0;
+}
+
+
+/**
+ * Lighting part of the key, depends only on _NEW_LIGHT.
+ */
+static void make_state_key_light( GLcontext *ctx, struct state_key *key )
+{
+   GLuint i;
+
+   key->light_global_enabled = 0;
+   key->light_local_viewer = 0;
+   key->light_twoside = 0;
+   key->light_color_material = 0;
+   key->light_color_material_mask = 0;
+   key->light_material_mask = 0;
+   key->material_shininess_is_zero = 0;
+
+   for (i = 0; i < MAX_LIGHTS; i++) {
+      key->unit[i].light_enabled = 0;
+      key->unit[i].light_eyepos3_is_zero = 0;
+      key->unit[i].light_spotcutoff_is_180 = 0;
+      key->unit[i].light_attenuated = 0;
+   }
+
    if (ctx->Light.Enabled) {
       key->light_global_enabled = 1;
 
@@ -249,41 +291,24 @@ static void make_state_key( GLcontext *ctx, struct state_key *key )
          key->material_shininess_is_zero = 1;
       }
    }
+}
 
-   if (ctx->Transform.Normalize)
-      key->normalize = 1;
-
-   if (ctx->Transform.RescaleNormals)
-      key->rescale_normals = 1;
-
-   key->fog_mode = translate_fog_mode(fp->FogOption);
-   
-   if (ctx->Fog.FogCoordinateSource == GL_FRAGMENT_DEPTH_EXT)
-      key->fog_source_is_depth = 1;
-   
-   key->tnl_do_vertex_fog = tnl_get_per_vertex_fog(ctx);
-
-   if (ctx->Point._Attenuated)
-      key->point_attenuated = 1;
 
-#if FEATURE_point_size_array
-   if (ctx->Array.ArrayObj->PointSize.Enabled)
-      key->point_array = 1;
-#endif
+/**
+ * Texturing part of the key.  The derived texture enables are
+ * recomputed on _NEW_TEXTURE, _NEW_TEXTURE_MATRIX and _NEW_PROGRAM.
+ */
+static void make_state_key_texture( GLcontext *ctx, struct state_key *key )
+{
+   GLuint i;
 
-   if (ctx->Texture._TexGenEnabled ||
-       ctx->Texture._TexMatEnabled ||
-       ctx->Texture._EnabledUnits)
-      key->texture_enabled_global = 1;
-      
    for (i = 0; i < MAX_TEXTURE_COORD_UNITS; i++) {
       struct gl_texture_unit *texUnit = &ctx->Texture.Unit[i];
 
-      if (texUnit->_ReallyEnabled)
-	 key->unit[i].texunit_really_enabled = 1;
+      key->unit[i].texunit_really_enabled = texUnit->_ReallyEnabled ? 1 : 0;
 
-      if (ctx->Texture._TexMatEnabled & ENABLE_TEXMAT(i))      
-	 key->unit[i].texmat_enabled = 1;
+      key->unit[i].texmat_enabled =
+         (ctx->Texture._TexMatEnabled & ENABLE_TEXMAT(i)) ? 1 : 0;
       
       if (texUnit->TexGenEnabled) {
 	 key->unit[i].texgen_enabled = 1;
@@ -301,7 +326,52 @@ static void make_state_key( GLcontext *ctx, struct state_key *key )
 	    translate_texgen( texUnit->TexGenEnabled & (1<<3),
 			      texUnit->GenModeQ );
       }
+      else {
+	 key->unit[i].texgen_enabled = 0;
+	 key->unit[i].texgen_mode0 = TXG_NONE;
+	 key->unit[i].texgen_mode1 = TXG_NONE;
+	 key->unit[i].texgen_mode2 = TXG_NONE;
+	 key->unit[i].texgen_mode3 = TXG_NONE;
+      }
+   }
+}
+
+
+#define KEY_LIGHT_STATE   _NEW_LIGHT
+#define KEY_TEXTURE_STATE (_NEW_TEXTURE | _NEW_TEXTURE_MATRIX | _NEW_PROGRAM)
+
+/**
+ * Bring the context's state key up to date.  Only the parts of the key
+ * affected by the dirty state flags are recomputed, unless the previous
+ * validation selected some other vertex program, in which case state
+ * changes may have been missed and the whole key is rebuilt.
+ */
+static const struct state_key *update_state_key( GLcontext *ctx )
+{
+   struct state_key *key = (struct state_key *) ctx->VertexProgram._TnlKey;
+   GLbitfield new_state = ctx->NewState;
+
+   if (!key) {
+      key = CALLOC_STRUCT(state_key);
+      if (!key)
+         return NULL;
+      ctx->VertexProgram._TnlKey = key;
+      new_state = ~0;
    }
+   else if (!ctx->VertexProgram._TnlProgram ||
+            ctx->VertexProgram._Current != ctx->VertexProgram._TnlProgram) {
+      new_state = ~0;
+   }
+
+   make_state_key_common(ctx, key);
+
+   if (new_state & KEY_LIGHT_STATE)
+      make_state_key_light(ctx, key);
+
+   if (new_state & KEY_TEXTURE_STATE)
+      make_state_key_texture(ctx, key);
+
+   return key;
 }
 
 
@@ -1747,16 +1817,18 @@ struct gl_vertex_program *
 _mesa_get_fixed_func_vertex_program(GLcontext *ctx)
 {
    struct gl_vertex_program *prog;
-   struct state_key key;
+   const struct state_key *key;
 
    /* Grab all the relevent state and put it in a single structure:
     */
-   make_state_key(ctx, &key);
+   key = update_state_key(ctx);
+   if (!key)
+      return NULL;
 
    /* Look for an already-prepared program for this state:
     */
    prog = (struct gl_vertex_program *)
-      _mesa_search_program_cache(ctx->VertexProgram.Cache, &key, sizeof(key));
+      _mesa_search_program_cache(ctx->VertexProgram.Cache, key, sizeof(*key));
    
    if (!prog) {
       /* OK, we'll have to build a new one */
@@ -1768,7 +1840,7 @@ _mesa_get_fixed_func_vertex_program(GLcontext *ctx)
       if (!prog)
          return NULL;
 
-      create_new_program( &key, prog,
+      create_new_program( key, prog,
                           ctx->Const.VertexProgram.MaxTemps );
 
 #if 0
@@ -1777,7 +1849,7 @@ _mesa_get_fixed_func_vertex_program(GLcontext *ctx)
                                           &prog->Base );
 #endif
       _mesa_program_cache_insert(ctx, ctx->VertexProgram.Cache,
-                                 &key, sizeof(key), &prog->Base);
+                                 key, sizeof(*key), &prog->Base);
    }
 
    return prog;
@@ -4,6 +4,9 @@
  *
  * Used for display lists, texture objects, vertex/fragment programs,
  * buffer objects, etc.  The hash functions are thread-safe.
+ *
+ * Small keys index an array directly, larger ones go into an
+ * open-addressed table with linear probing.  Both grow as needed.
  * 
  * \note key=0 is illegal.
  *
@@ -41,18 +44,55 @@
 #include "hash.h"
 
 
-#define TABLE_SIZE 1023  /**< Size of lookup table/array */
+/**
+ * Keys below this are stored in a directly indexed array, the rest in
+ * an open-addressed hash table.  glGen* hands out names sequentially
+ * from 1, so nearly all keys end up in the array.
+ */
+#define DENSE_MAX_SIZE (1 << 16)
 
-#define HASH_FUNC(K)  ((K) % TABLE_SIZE)
+#define MIN_STORE_SIZE 64  /**< Smallest size of either part of the table */
+
+/**
+ * _mesa_HashFindFreeKeyBlock() keeps track of the keys below this in a
+ * bitmap, which is only as large as the highest such key needs.
+ */
+#define BITMAP_MAX_KEYS (1 << 24)
+
+#define HASH_FUNC(K)  ((K) * 2654435761u)
 
 
 /**
- * An entry in the hash table.  
+ * An entry in the hash table.  Key is zero for a free slot.
  */
 struct HashEntry {
    GLuint Key;             /**< the entry's key */
    void *Data;             /**< the entry's data */
-   struct HashEntry *Next; /**< pointer to next entry */
+};
+
+
+/**
+ * Entries of the hashed part whose key was removed point at this.  The
+ * slot stays in the probe sequence until the table is rebuilt.
+ */
+static char DeletedData;
+#define DELETED ((void *) &DeletedData)
+
+
+/**
+ * Storage for one part of the table.  Lookups in the dense part don't
+ * take the table's lock, so a dense store that has to grow is replaced
+ * rather than reallocated and the old one is only freed along with the
+ * table.  That's bounded, since the dense part stops growing at
+ * DENSE_MAX_SIZE.  The hashed part is rebuilt as names churn, so it is
+ * only read with the lock held.  A replaced hashed store is freed at
+ * once, unless _mesa_HashWalk() is still going through it; then it is
+ * kept up to date and freed when the walk ends.
+ */
+struct HashStore {
+   GLuint Size;                /**< number of entries, a power of two */
+   struct HashEntry *Entries;
+   struct HashStore *Retired;  /**< store this one replaced, if kept */
 };
 
 
@@ -60,15 +100,299 @@ struct HashEntry {
  * The hash table data structure.  
  */
 struct _mesa_HashTable {
-   struct HashEntry *Table[TABLE_SIZE];  /**< the lookup table */
+   struct HashStore *Dense;    /**< entries indexed by key, or NULL */
+   struct HashStore *Hashed;   /**< entries for keys >= DENSE_MAX_SIZE */
+   GLuint HashedUsed;          /**< Hashed slots in use, deleted ones too */
+   GLuint HashedLive;          /**< Hashed slots holding an entry */
    GLuint MaxKey;                        /**< highest key inserted so far */
    _glthread_Mutex Mutex;                /**< mutual exclusion lock */
    _glthread_Mutex WalkMutex;            /**< for _mesa_HashWalk() */
+   GLboolean Walking;                    /**< _mesa_HashWalk() running */
    GLboolean InDeleteAll;                /**< Debug check */
+   GLuint *UsedBits;                     /**< keys < BITMAP_MAX_KEYS in use */
+   GLuint UsedWords;                     /**< size of UsedBits */
+   GLuint FirstFreeWord;                 /**< UsedBits before this are full */
 };
 
 
 
+static struct HashStore *
+new_store(GLuint size, struct HashStore *retired)
+{
+   struct HashStore *store = (struct HashStore *)
+      _mesa_calloc(sizeof(struct HashStore) + size * sizeof(struct HashEntry));
+   if (store) {
+      store->Size = size;
+      store->Entries = (struct HashEntry *) (store + 1);
+      store->Retired = retired;
+   }
+   return store;
+}
+
+
+static void
+free_stores(struct HashStore *store)
+{
+   while (store) {
+      struct HashStore *retired = store->Retired;
+      _mesa_free(store);
+      store = retired;
+   }
+}
+
+
+/**
+ * Find the entry for key in the hashed part of the table.
+ */
+static struct HashEntry *
+find_hashed(const struct HashStore *store, GLuint key)
+{
+   const GLuint mask = store->Size - 1;
+   GLuint pos = HASH_FUNC(key) & mask;
+
+   for (;;) {
+      struct HashEntry *entry = &store->Entries[pos];
+      if (entry->Key == key && entry->Data != DELETED)
+         return entry;
+      if (entry->Key == 0)
+         return NULL;
+      pos = (pos + 1) & mask;
+   }
+}
+
+
+/**
+ * Return the data for key in the hashed part, or NULL.  Called with the
+ * lock held.
+ */
+static void *
+lookup_hashed(const struct _mesa_HashTable *table, GLuint key)
+{
+   const struct HashEntry *entry =
+      table->Hashed ? find_hashed(table->Hashed, key) : NULL;
+   return entry ? entry->Data : NULL;
+}
+
+
+/**
+ * Return a free or deleted slot for a new key in the hashed part.
+ */
+static struct HashEntry *
+find_free_hashed(const struct HashStore *store, GLuint key)
+{
+   const GLuint mask = store->Size - 1;
+   GLuint pos = HASH_FUNC(key) & mask;
+
+   while (store->Entries[pos].Key && store->Entries[pos].Data != DELETED)
+      pos = (pos + 1) & mask;
+
+   return &store->Entries[pos];
+}
+
+
+/**
+ * Make room in the dense part for the given key.
+ */
+static GLboolean
+grow_dense(struct _mesa_HashTable *table, GLuint key)
+{
+   struct HashStore *old = table->Dense;
+   struct HashStore *store;
+   GLuint size = old ? old->Size : MIN_STORE_SIZE;
+
+   while (size <= key)
+      size *= 2;
+
+   store = new_store(size, old);
+   if (!store)
+      return GL_FALSE;
+
+   if (old)
+      _mesa_memcpy(store->Entries, old->Entries,
+                   old->Size * sizeof(struct HashEntry));
+
+   table->Dense = store;
+   return GL_TRUE;
+}
+
+
+/**
+ * Rebuild the hashed part of the table, dropping deleted slots and
+ * sizing it for twice the live entries.  Called with the lock held.
+ */
+static GLboolean
+rehash(struct _mesa_HashTable *table)
+{
+   struct HashStore *old = table->Hashed;
+   struct HashStore *store;
+   GLuint size = MIN_STORE_SIZE;
+   GLuint i;
+
+   while (size < (table->HashedLive + 1) * 2)
+      size *= 2;
+
+   /* a walk in progress goes on through the old store */
+   store = new_store(size, table->Walking ? old : NULL);
+   if (!store)
+      return GL_FALSE;
+
+   if (old) {
+      for (i = 0; i < old->Size; i++) {
+         const struct HashEntry *entry = &old->Entries[i];
+         if (entry->Key && entry->Data != DELETED)
+            *find_free_hashed(store, entry->Key) = *entry;
+      }
+      if (!table->Walking)
+         _mesa_free(old);
+   }
+
+   table->HashedUsed = table->HashedLive;
+   table->Hashed = store;
+   return GL_TRUE;
+}
+
+
+/**
+ * Return the first entry at or after position *pos and update *pos to
+ * its position.  Positions count through the dense part of the table
+ * and then the hashed part.
+ */
+static const struct HashEntry *
+next_entry_in(const struct HashStore *dense, const struct HashStore *hashed,
+              GLuint *pos)
+{
+   const GLuint denseSize = dense ? dense->Size : 0;
+   GLuint i;
+
+   for (i = *pos; i < denseSize; i++) {
+      if (dense->Entries[i].Key) {
+         *pos = i;
+         return &dense->Entries[i];
+      }
+   }
+
+   if (hashed) {
+      for (i -= denseSize; i < hashed->Size; i++) {
+         const struct HashEntry *entry = &hashed->Entries[i];
+         if (entry->Key && entry->Data != DELETED) {
+            *pos = denseSize + i;
+            return entry;
+         }
+      }
+   }
+
+   return NULL;
+}
+
+
+static const struct HashEntry *
+next_entry(const struct _mesa_HashTable *table, GLuint *pos)
+{
+   return next_entry_in(table->Dense, table->Hashed, pos);
+}
+
+
+/**
+ * Mark key as used in the bitmap, growing it if needed.
+ */
+static GLboolean
+set_key_used(struct _mesa_HashTable *table, GLuint key)
+{
+   const GLuint w = key / 32;
+
+   if (w >= table->UsedWords) {
+      GLuint words = table->UsedWords ? table->UsedWords : 64;
+      GLuint *bits;
+
+      while (words <= w)
+         words *= 2;
+
+      bits = (GLuint *) _mesa_realloc(table->UsedBits,
+                                      table->UsedWords * sizeof(GLuint),
+                                      words * sizeof(GLuint));
+      if (!bits)
+         return GL_FALSE;
+
+      _mesa_bzero(bits + table->UsedWords,
+                  (words - table->UsedWords) * sizeof(GLuint));
+      bits[0] |= 1;  /* key 0 is never handed out */
+      table->UsedBits = bits;
+      table->UsedWords = words;
+   }
+
+   table->UsedBits[w] |= 1u << (key % 32);
+   return GL_TRUE;
+}
+
+
+static void
+set_key_unused(struct _mesa_HashTable *table, GLuint key)
+{
+   const GLuint w = key / 32;
+
+   if (w < table->UsedWords) {
+      table->UsedBits[w] &= ~(1u << (key % 32));
+      if (w < table->FirstFreeWord)
+         table->FirstFreeWord = w;
+   }
+}
+
+
+/**
+ * Find numKeys adjacent keys below BITMAP_MAX_KEYS that aren't in use.
+ * \param run  returns the number of unused keys just below BITMAP_MAX_KEYS
+ * \return first key of the block or 0 if there's none
+ */
+static GLuint
+find_unused_bits(struct _mesa_HashTable *table, GLuint numKeys, GLuint *run)
+{
+   GLuint w = table->FirstFreeWord, start;
+
+   while (w < table->UsedWords && table->UsedBits[w] == ~0u)
+      w++;
+   table->FirstFreeWord = w;
+
+   *run = 0;
+   for (; w < table->UsedWords; w++) {
+      const GLuint bits = table->UsedBits[w];
+      GLuint free, b, k;
+
+      if (bits == 0) {
+         if (*run + 32 >= numKeys)
+            return w * 32 - *run;
+         *run += 32;
+         continue;
+      }
+
+      /* unused keys at the bottom of the word extend the current run */
+      for (b = 0; !(bits & (1u << b)); b++)
+         ;
+      if (*run + b >= numKeys)
+         return w * 32 - *run;
+
+      /* bit i of free is set if keys i..i+numKeys-1 of the word are unused */
+      free = ~bits;
+      for (k = 1; k < numKeys && free; k++)
+         free &= free >> 1;
+      if (free) {
+         for (b = 0; !(free & (1u << b)); b++)
+            ;
+         return w * 32 + b;
+      }
+
+      /* unused keys at the top of the word start a new run */
+      for (b = 0; b < 32 && !(bits & (0x80000000u >> b)); b++)
+         ;
+      *run = b;
+   }
+
+   /* the keys past the end of the bitmap are unused */
+   start = table->UsedWords ? table->UsedWords * 32 - *run : 1;
+   *run = BITMAP_MAX_KEYS - start;
+   return *run >= numKeys ? start : 0;
+}
+
+
 /**
  * Create a new hash table.
  * 
@@ -98,20 +422,19 @@ _mesa_NewHashTable(void)
 void
 _mesa_DeleteHashTable(struct _mesa_HashTable *table)
 {
+   const struct HashEntry *entry;
    GLuint pos;
    assert(table);
-   for (pos = 0; pos < TABLE_SIZE; pos++) {
-      struct HashEntry *entry = table->Table[pos];
-      while (entry) {
-	 struct HashEntry *next = entry->Next;
-         if (entry->Data) {
-            _mesa_problem(NULL,
-                          "In _mesa_DeleteHashTable, found non-freed data");
-         }
-	 _mesa_free(entry);
-	 entry = next;
+   for (pos = 0; (entry = next_entry(table, &pos)) != NULL; pos++) {
+      if (entry->Data) {
+         _mesa_problem(NULL,
+                       "In _mesa_DeleteHashTable, found non-freed data");
       }
    }
+   free_stores(table->Dense);
+   free_stores(table->Hashed);
+   if (table->UsedBits)
+      _mesa_free(table->UsedBits);
    _glthread_DESTROY_MUTEX(table->Mutex);
    _glthread_DESTROY_MUTEX(table->WalkMutex);
    _mesa_free(table);
@@ -126,25 +449,30 @@ _mesa_DeleteHashTable(struct _mesa_HashTable *table)
  * \param key the key.
  * 
  * \return pointer to user's data or NULL if key not in table
+ *
+ * Keys in the dense part are looked up without taking the lock: dense
+ * stores are filled before they are installed and replaced ones stay
+ * allocated, and entries are written data first.
  */
 void *
 _mesa_HashLookup(const struct _mesa_HashTable *table, GLuint key)
 {
-   GLuint pos;
-   const struct HashEntry *entry;
+   const struct HashStore *dense = table->Dense;
+   void *data;
 
    assert(table);
    assert(key);
 
-   pos = HASH_FUNC(key);
-   entry = table->Table[pos];
-   while (entry) {
-      if (entry->Key == key) {
-	 return entry->Data;
-      }
-      entry = entry->Next;
+   if (key < DENSE_MAX_SIZE) {
+      if (dense && key < dense->Size && dense->Entries[key].Key == key)
+         return dense->Entries[key].Data;
+      return NULL;
    }
-   return NULL;
+
+   _glthread_LOCK_MUTEX(((struct _mesa_HashTable *) table)->Mutex);
+   data = lookup_hashed(table, key);
+   _glthread_UNLOCK_MUTEX(((struct _mesa_HashTable *) table)->Mutex);
+   return data;
 }
 
 
@@ -160,8 +488,6 @@ _mesa_HashLookup(const struct _mesa_HashTable *table, GLuint key)
 void
 _mesa_HashInsert(struct _mesa_HashTable *table, GLuint key, void *data)
 {
-   /* search for existing entry with this key */
-   GLuint pos;
    struct HashEntry *entry;
 
    assert(table);
@@ -169,32 +495,59 @@ _mesa_HashInsert(struct _mesa_HashTable *table, GLuint key, void *data)
 
    _glthread_LOCK_MUTEX(table->Mutex);
 
+   if (key < BITMAP_MAX_KEYS && !set_key_used(table, key)) {
+      _glthread_UNLOCK_MUTEX(table->Mutex);
+      return;
+   }
+
    if (key > table->MaxKey)
       table->MaxKey = key;
 
-   pos = HASH_FUNC(key);
+   if (key < DENSE_MAX_SIZE) {
+      if ((!table->Dense || key >= table->Dense->Size) &&
+          !grow_dense(table, key)) {
+         _glthread_UNLOCK_MUTEX(table->Mutex);
+         return;
+      }
+      entry = &table->Dense->Entries[key];
+      entry->Data = data;
+      entry->Key = key;
+      _glthread_UNLOCK_MUTEX(table->Mutex);
+      return;
+   }
 
    /* check if replacing an existing entry with same key */
-   for (entry = table->Table[pos]; entry; entry = entry->Next) {
-      if (entry->Key == key) {
-         /* replace entry's data */
-#if 0 /* not sure this check is always valid */
-         if (entry->Data) {
-            _mesa_problem(NULL, "Memory leak detected in _mesa_HashInsert");
-         }
-#endif
-	 entry->Data = data;
-         _glthread_UNLOCK_MUTEX(table->Mutex);
-	 return;
+   entry = table->Hashed ? find_hashed(table->Hashed, key) : NULL;
+   if (entry) {
+      struct HashStore *store;
+      entry->Data = data;
+      for (store = table->Hashed->Retired; store; store = store->Retired) {
+         entry = find_hashed(store, key);
+         if (entry)
+            entry->Data = data;
       }
+      _glthread_UNLOCK_MUTEX(table->Mutex);
+      return;
    }
 
-   /* alloc and insert new table entry */
-   entry = MALLOC_STRUCT(HashEntry);
-   entry->Key = key;
-   entry->Data = data;
-   entry->Next = table->Table[pos];
-   table->Table[pos] = entry;
+   if ((table->HashedUsed + 1) * 4 > (table->Hashed ? table->Hashed->Size : 0) * 3 &&
+       !rehash(table)) {
+      _glthread_UNLOCK_MUTEX(table->Mutex);
+      return;
+   }
+
+   entry = find_free_hashed(table->Hashed, key);
+   if (entry->Key) {
+      /* reusing a deleted slot: readers skip it until the data is set */
+      entry->Key = key;
+      entry->Data = data;
+   }
+   else {
+      entry->Data = data;
+      entry->Key = key;
+      table->HashedUsed++;
+   }
+   table->HashedLive++;
 
    _glthread_UNLOCK_MUTEX(table->Mutex);
 }
@@ -208,13 +561,12 @@ _mesa_HashInsert(struct _mesa_HashTable *table, GLuint key, void *data)
  * \param key key of entry to remove.
  *
  * While holding the hash table's lock, searches the entry with the matching
- * key and unlinks it.
+ * key and marks its slot free (dense part) or deleted (hashed part).
  */
 void
 _mesa_HashRemove(struct _mesa_HashTable *table, GLuint key)
 {
-   GLuint pos;
-   struct HashEntry *entry, *prev;
+   struct HashEntry *entry;
 
    assert(table);
    assert(key);
@@ -228,24 +580,28 @@ _mesa_HashRemove(struct _mesa_HashTable *table, GLuint key)
 
    _glthread_LOCK_MUTEX(table->Mutex);
 
-   pos = HASH_FUNC(key);
-   prev = NULL;
-   entry = table->Table[pos];
-   while (entry) {
-      if (entry->Key == key) {
-         /* found it! */
-         if (prev) {
-            prev->Next = entry->Next;
-         }
-         else {
-            table->Table[pos] = entry->Next;
+   if (key < DENSE_MAX_SIZE) {
+      if (table->Dense && key < table->Dense->Size &&
+          table->Dense->Entries[key].Key == key) {
+         entry = &table->Dense->Entries[key];
+         entry->Key = 0;
+         entry->Data = NULL;
+         set_key_unused(table, key);
+      }
+   }
+   else if (table->Hashed) {
+      entry = find_hashed(table->Hashed, key);
+      if (entry) {
+         struct HashStore *store;
+         entry->Data = DELETED;
+         table->HashedLive--;
+         set_key_unused(table, key);
+         for (store = table->Hashed->Retired; store; store = store->Retired) {
+            entry = find_hashed(store, key);
+            if (entry)
+               entry->Data = DELETED;
          }
-         _mesa_free(entry);
-         _glthread_UNLOCK_MUTEX(table->Mutex);
-	 return;
       }
-      prev = entry;
-      entry = entry->Next;
    }
 
    _glthread_UNLOCK_MUTEX(table->Mutex);
@@ -267,20 +623,28 @@ _mesa_HashDeleteAll(struct _mesa_HashTable *table,
                     void (*callback)(GLuint key, void *data, void *userData),
                     void *userData)
 {
+   const struct HashEntry *entry;
+   struct HashStore *store;
    GLuint pos;
    ASSERT(table);
    ASSERT(callback);
    _glthread_LOCK_MUTEX(table->Mutex);
    table->InDeleteAll = GL_TRUE;
-   for (pos = 0; pos < TABLE_SIZE; pos++) {
-      struct HashEntry *entry, *next;
-      for (entry = table->Table[pos]; entry; entry = next) {
-         callback(entry->Key, entry->Data, userData);
-         next = entry->Next;
-         _mesa_free(entry);
-      }
-      table->Table[pos] = NULL;
+   for (pos = 0; (entry = next_entry(table, &pos)) != NULL; pos++) {
+      callback(entry->Key, entry->Data, userData);
    }
+   if (table->Dense)
+      _mesa_bzero(table->Dense->Entries,
+                  table->Dense->Size * sizeof(struct HashEntry));
+   for (store = table->Hashed; store; store = store->Retired)
+      _mesa_bzero(store->Entries, store->Size * sizeof(struct HashEntry));
+   table->HashedUsed = 0;
+   table->HashedLive = 0;
+   if (table->UsedBits) {
+      _mesa_bzero(table->UsedBits, table->UsedWords * sizeof(GLuint));
+      table->UsedBits[0] = 1;
+   }
+   table->FirstFreeWord = 0;
    table->InDeleteAll = GL_FALSE;
    _glthread_UNLOCK_MUTEX(table->Mutex);
 }
@@ -305,18 +669,49 @@ _mesa_HashWalk(const struct _mesa_HashTable *table,
 {
    /* cast-away const */
    struct _mesa_HashTable *table2 = (struct _mesa_HashTable *) table;
-   GLuint pos;
+   const struct HashStore *hashed;
+   const struct HashEntry *entry;
+   GLuint pos, key;
+   void *data;
    ASSERT(table);
    ASSERT(callback);
    _glthread_LOCK_MUTEX(table2->WalkMutex);
-   for (pos = 0; pos < TABLE_SIZE; pos++) {
-      struct HashEntry *entry, *next;
-      for (entry = table->Table[pos]; entry; entry = next) {
-         /* save 'next' pointer now in case the callback deletes the entry */
-         next = entry->Next;
-         callback(entry->Key, entry->Data, userData);
+
+   /* Inserts from other threads may rebuild the hashed part while the
+    * callbacks run.  Keep going through the store the walk started on,
+    * which rehash() keeps alive and up to date until the walk is over.
+    */
+   _glthread_LOCK_MUTEX(table2->Mutex);
+   table2->Walking = GL_TRUE;
+   hashed = table->Hashed;
+   _glthread_UNLOCK_MUTEX(table2->Mutex);
+
+   for (pos = 0; ; pos++) {
+      _glthread_LOCK_MUTEX(table2->Mutex);
+      entry = next_entry_in(table->Dense, hashed, &pos);
+      if (entry) {
+         key = entry->Key;
+         data = entry->Data;
       }
+      _glthread_UNLOCK_MUTEX(table2->Mutex);
+
+      if (!entry)
+         break;
+
+      /* removing an entry leaves the others in place, so the callback
+       * may delete the entry
+       */
+      callback(key, data, userData);
+   }
+
+   _glthread_LOCK_MUTEX(table2->Mutex);
+   table2->Walking = GL_FALSE;
+   if (table->Hashed) {
+      free_stores(table->Hashed->Retired);
+      table2->Hashed->Retired = NULL;
    }
+   _glthread_UNLOCK_MUTEX(table2->Mutex);
+
    _glthread_UNLOCK_MUTEX(table2->WalkMutex);
 }
 
@@ -324,7 +719,7 @@ _mesa_HashWalk(const struct _mesa_HashTable *table,
 /**
  * Return the key of the "first" entry in the hash table.
  * While holding the lock, walks through all table positions until finding
- * the first entry of the first non-empty one.
+ * the first entry in use.
  * 
  * \param table  the hash table
  * \return key for the "first" entry in the hash table.
@@ -332,17 +727,14 @@ _mesa_HashWalk(const struct _mesa_HashTable *table,
 GLuint
 _mesa_HashFirstEntry(struct _mesa_HashTable *table)
 {
-   GLuint pos;
+   const struct HashEntry *entry;
+   GLuint pos = 0, key;
    assert(table);
    _glthread_LOCK_MUTEX(table->Mutex);
-   for (pos = 0; pos < TABLE_SIZE; pos++) {
-      if (table->Table[pos]) {
-         _glthread_UNLOCK_MUTEX(table->Mutex);
-         return table->Table[pos]->Key;
-      }
-   }
+   entry = next_entry(table, &pos);
+   key = entry ? entry->Key : 0;
    _glthread_UNLOCK_MUTEX(table->Mutex);
-   return 0;
+   return key;
 }
 
 
@@ -355,40 +747,44 @@ _mesa_HashFirstEntry(struct _mesa_HashTable *table)
 GLuint
 _mesa_HashNextEntry(const struct _mesa_HashTable *table, GLuint key)
 {
+   /* cast-away const */
+   struct _mesa_HashTable *table2 = (struct _mesa_HashTable *) table;
+   const struct HashStore *dense;
    const struct HashEntry *entry;
-   GLuint pos;
+   GLuint pos = 0, next;
 
    assert(table);
    assert(key);
 
-   /* Find the entry with given key */
-   pos = HASH_FUNC(key);
-   for (entry = table->Table[pos]; entry ; entry = entry->Next) {
-      if (entry->Key == key) {
-         break;
-      }
-   }
+   _glthread_LOCK_MUTEX(table2->Mutex);
+   dense = table->Dense;
 
-   if (!entry) {
-      /* the given key was not found, so we can't find the next entry */
-      return 0;
+   /* Find the position of the entry with given key */
+   if (key < DENSE_MAX_SIZE) {
+      if (!dense || key >= dense->Size || dense->Entries[key].Key != key)
+         entry = NULL;
+      else
+         entry = &dense->Entries[key];
+      pos = key;
+   }
+   else {
+      entry = table->Hashed ? find_hashed(table->Hashed, key) : NULL;
+      if (entry)
+         pos = (dense ? dense->Size : 0) + (entry - table->Hashed->Entries);
    }
 
-   if (entry->Next) {
-      /* return next in linked list */
-      return entry->Next->Key;
+   if (entry) {
+      pos++;
+      entry = next_entry(table, &pos);
+      next = entry ? entry->Key : 0;
    }
    else {
-      /* look for next non-empty table slot */
-      pos++;
-      while (pos < TABLE_SIZE) {
-         if (table->Table[pos]) {
-            return table->Table[pos]->Key;
-         }
-         pos++;
-      }
-      return 0;
+      /* the given key was not found, so we can't find the next entry */
+      next = 0;
    }
+
+   _glthread_UNLOCK_MUTEX(table2->Mutex);
+   return next;
 }
 
 
@@ -400,14 +796,11 @@ _mesa_HashNextEntry(const struct _mesa_HashTable *table, GLuint key)
 void
 _mesa_HashPrint(const struct _mesa_HashTable *table)
 {
+   const struct HashEntry *entry;
    GLuint pos;
    assert(table);
-   for (pos = 0; pos < TABLE_SIZE; pos++) {
-      const struct HashEntry *entry = table->Table[pos];
-      while (entry) {
-	 _mesa_debug(NULL, "%u %p\n", entry->Key, entry->Data);
-	 entry = entry->Next;
-      }
+   for (pos = 0; (entry = next_entry(table, &pos)) != NULL; pos++) {
+      _mesa_debug(NULL, "%u %p\n", entry->Key, entry->Data);
    }
 }
 
@@ -423,48 +816,52 @@ _mesa_HashPrint(const struct _mesa_HashTable *table)
  *
  * If there are enough free keys between the maximum key existing in the table
  * (_mesa_HashTable::MaxKey) and the maximum key possible, then simply return
- * the adjacent key. Otherwise do a full search for a free key block in the
- * allowable key range.
+ * the adjacent key. Otherwise search the bitmap of keys below BITMAP_MAX_KEYS,
+ * and only when that has no room search the allowable key range above it.
  */
 GLuint
 _mesa_HashFindFreeKeyBlock(struct _mesa_HashTable *table, GLuint numKeys)
 {
    const GLuint maxKey = ~((GLuint) 0);
+   GLuint key, run;
    _glthread_LOCK_MUTEX(table->Mutex);
    if (maxKey - numKeys > table->MaxKey) {
       /* the quick solution */
-      _glthread_UNLOCK_MUTEX(table->Mutex);
-      return table->MaxKey + 1;
+      key = table->MaxKey + 1;
    }
    else {
-      /* the slow solution */
-      GLuint freeCount = 0;
-      GLuint freeStart = 1;
-      GLuint key;
-      for (key = 1; key != maxKey; key++) {
-	 if (_mesa_HashLookup(table, key)) {
-	    /* darn, this key is already in use */
-	    freeCount = 0;
-	    freeStart = key+1;
-	 }
-	 else {
-	    /* this key not in use, check if we've found enough */
-	    freeCount++;
-	    if (freeCount == numKeys) {
-               _glthread_UNLOCK_MUTEX(table->Mutex);
-	       return freeStart;
-	    }
-	 }
+      /* look for free keys in the bitmap first */
+      key = find_unused_bits(table, numKeys, &run);
+      if (!key) {
+         /* the slow solution, continuing any free run at the bitmap's end */
+         GLuint freeCount = run;
+         GLuint freeStart = BITMAP_MAX_KEYS - run;
+         for (key = BITMAP_MAX_KEYS; key != maxKey; key++) {
+            if (lookup_hashed(table, key)) {
+               /* darn, this key is already in use */
+               freeCount = 0;
+               freeStart = key+1;
+            }
+            else {
+               /* this key not in use, check if we've found enough */
+               freeCount++;
+               if (freeCount == numKeys)
+                  break;
+            }
+         }
+         /* 0 if we cannot allocate a block of numKeys consecutive keys */
+         key = freeCount == numKeys ? freeStart : 0;
       }
-      /* cannot allocate a block of numKeys consecutive keys */
-      _glthread_UNLOCK_MUTEX(table->Mutex);
-      return 0;
    }
+   _glthread_UNLOCK_MUTEX(table->Mutex);
+   return key;
 }
 
 
 #if 0 /* debug only */
 
+#include <time.h>
+
 /**
  * Test walking over all the entries in a hash table.
  */
@@ -506,6 +903,213 @@ test_hash_walking(void)
 }
 
 
+/**
+ * State for test_hash_walk_rehash().
+ */
+struct walk_test {
+   struct _mesa_HashTable *Table;
+   GLuint Visits[1000];
+   GLuint NextKey;
+};
+
+
+static void
+walk_insert_cb(GLuint key, void *data, void *userData)
+{
+   struct walk_test *w = (struct walk_test *) userData;
+   GLuint i;
+
+   if (data == w) {
+      /* an original entry: count it, remove it and add new ones, which
+       * makes the hashed part be rebuilt under the walk
+       */
+      w->Visits[key - DENSE_MAX_SIZE]++;
+      _mesa_HashRemove(w->Table, key);
+      for (i = 0; i < 4; i++)
+         _mesa_HashInsert(w->Table, w->NextKey++, w->Visits);
+   }
+}
+
+
+/**
+ * Test a walk whose callback removes the visited entry and inserts new
+ * ones.  Every original entry must be visited once.
+ */
+static void
+test_hash_walk_rehash(void)
+{
+   static struct walk_test w;
+   GLuint i;
+
+   w.Table = _mesa_NewHashTable();
+   w.NextKey = DENSE_MAX_SIZE * 2;
+   for (i = 0; i < 1000; i++)
+      _mesa_HashInsert(w.Table, DENSE_MAX_SIZE + i, &w);
+
+   _mesa_HashWalk(w.Table, walk_insert_cb, &w);
+
+   for (i = 0; i < 1000; i++)
+      assert(w.Visits[i] == 1);
+   assert(!w.Table->Hashed->Retired);
+
+   for (i = DENSE_MAX_SIZE * 2; i < w.NextKey; i++)
+      _mesa_HashRemove(w.Table, i);
+   _mesa_DeleteHashTable(w.Table);
+}
+
+
+/**
+ * Time inserts, lookups and removals of sequential keys (as handed out
+ * by glGen*) and of random keys.
+ */
+static void
+test_hash_performance(void)
+{
+   const GLuint limit = 200000, lookups = 20;
+   GLuint *keys = (GLuint *) _mesa_malloc(limit * sizeof(GLuint));
+   GLuint pass, i, j;
+
+   for (pass = 0; pass < 2; pass++) {
+      struct _mesa_HashTable *t = _mesa_NewHashTable();
+      clock_t start, insert, lookup;
+      GLuint found = 0;
+
+      for (i = 0; i < limit; i++)
+         keys[i] = pass ? ((GLuint) rand() * 2654435761u) | 1 : i + 1;
+
+      start = clock();
+      for (i = 0; i < limit; i++)
+         _mesa_HashInsert(t, keys[i], keys + i);
+      insert = clock();
+      for (j = 0; j < lookups; j++)
+         for (i = 0; i < limit; i++)
+            found += _mesa_HashLookup(t, keys[i]) != NULL;
+      lookup = clock();
+      for (i = 0; i < limit; i++)
+         _mesa_HashRemove(t, keys[i]);
+
+      _mesa_printf("%s keys: insert %.1f ns, lookup %.1f ns, "
+                   "remove %.1f ns (%u found)\n",
+                   pass ? "random" : "sequential",
+                   (insert - start) * 1e9 / CLOCKS_PER_SEC / limit,
+                   (lookup - insert) * 1e9 / CLOCKS_PER_SEC / (limit * lookups),
+                   (clock() - lookup) * 1e9 / CLOCKS_PER_SEC / limit,
+                   found);
+
+      _mesa_DeleteHashTable(t);
+   }
+
+   _mesa_free(keys);
+}
+
+
+/**
+ * Generate and delete names the way an application streaming textures
+ * would.  The top of the key space is in use, so every name has to come
+ * from the free ranges.
+ */
+static void
+test_hash_churn(void)
+{
+   const GLuint live = 100000, rounds = 1000000;
+   const GLuint top = 0xfffffff0;
+   struct _mesa_HashTable *t = _mesa_NewHashTable();
+   GLuint *keys = (GLuint *) _mesa_malloc(live * sizeof(GLuint));
+   GLuint dummy, i;
+   clock_t start = 0;
+
+   _mesa_HashInsert(t, top, &dummy);
+
+   for (i = 0; i < live; i++) {
+      keys[i] = _mesa_HashFindFreeKeyBlock(t, 1);
+      assert(keys[i] && !_mesa_HashLookup(t, keys[i]));
+      _mesa_HashInsert(t, keys[i], &dummy);
+   }
+
+   for (i = 0; i < rounds; i++) {
+      /* delete a few names and generate a block of as many */
+      const GLuint n = i < rounds / 2 ? 1 : 1 + i % 4;
+      const GLuint j = rand() % (live - n);
+      GLuint first, k;
+      for (k = 0; k < n; k++)
+         _mesa_HashRemove(t, keys[j + k]);
+      first = _mesa_HashFindFreeKeyBlock(t, n);
+      assert(first);
+      for (k = 0; k < n; k++) {
+         keys[j + k] = first + k;
+         assert(!_mesa_HashLookup(t, first + k));
+         _mesa_HashInsert(t, first + k, &dummy);
+      }
+
+      if (i == 0 || i == rounds / 2) {
+         start = clock();
+      }
+      else if (i == rounds / 2 - 1 || i == rounds - 1) {
+         _mesa_printf("churn, %s: %.1f ns per delete/gen/insert round\n",
+                      i < rounds / 2 ? "single keys" : "blocks of 1-4",
+                      (clock() - start) * 1e9 / CLOCKS_PER_SEC / (rounds / 2));
+      }
+   }
+
+   for (i = 0; i < live; i++)
+      _mesa_HashRemove(t, keys[i]);
+   _mesa_HashRemove(t, top);
+   assert(!_mesa_HashFirstEntry(t));
+
+   _mesa_DeleteHashTable(t);
+   _mesa_free(keys);
+}
+
+
+/**
+ * Sum the sizes of a store and the stores it replaced.
+ */
+static GLuint
+store_bytes(const struct HashStore *store)
+{
+   GLuint bytes = 0;
+   for (; store; store = store->Retired)
+      bytes += sizeof(struct HashStore) +
+               store->Size * sizeof(struct HashEntry);
+   return bytes;
+}
+
+
+/**
+ * Generate, insert and remove blocks of names the way glGenBuffers and
+ * glDeleteBuffers do when an application keeps creating and deleting
+ * objects.  The names soon pass DENSE_MAX_SIZE, and the memory held by
+ * the table has to stay flat as they go on.
+ */
+static void
+test_hash_memory(void)
+{
+   const GLuint rounds = 20000, n = 100;
+   struct _mesa_HashTable *t = _mesa_NewHashTable();
+   GLuint dummy, bytes = 0, i, k;
+
+   for (i = 0; i < rounds; i++) {
+      const GLuint first = _mesa_HashFindFreeKeyBlock(t, n);
+      assert(first);
+      for (k = 0; k < n; k++)
+         _mesa_HashInsert(t, first + k, &dummy);
+      for (k = 0; k < n; k++)
+         _mesa_HashRemove(t, first + k);
+
+      if (i == rounds / 10)
+         bytes = store_bytes(t->Dense) + store_bytes(t->Hashed);
+   }
+
+   assert(t->MaxKey > DENSE_MAX_SIZE * 10);
+   i = store_bytes(t->Dense) + store_bytes(t->Hashed);
+   _mesa_printf("churn: %u bytes of stores after %u rounds, %u after %u\n",
+                bytes, rounds / 10, i, rounds);
+   assert(i <= bytes);
+
+   _mesa_DeleteHashTable(t);
+}
+
+
 void
 _mesa_test_hash_functions(void)
 {
@@ -525,6 +1129,10 @@ _mesa_test_hash_functions(void)
    _mesa_DeleteHashTable(t);
 
    test_hash_walking();
+   test_hash_walk_rehash();
+   test_hash_performance();
+   test_hash_churn();
+   test_hash_memory();
 }
 
 #endif
@@ -29,6 +29,7 @@
 #include "enums.h"
 #include "light.h"
 #include "macros.h"
+#include "matrix.h"
 #include "simple_list.h"
 #include "mtypes.h"
 #include "math/m_matrix.h"
@@ -205,9 +206,7 @@ _mesa_Lightfv( GLenum light, GLenum pname, const GLfloat *params )
       break;
    case GL_SPOT_DIRECTION:
       /* transform direction by inverse modelview */
-      if (_math_matrix_is_dirty(ctx->ModelviewMatrixStack.Top)) {
-	 _math_matrix_analyse(ctx->ModelviewMatrixStack.Top);
-      }
+      _mesa_analyse_stack_top( &ctx->ModelviewMatrixStack );
       TRANSFORM_DIRECTION(temp, params, ctx->ModelviewMatrixStack.Top->m);
       params = temp;
       break;
@@ -0,0 +1,1810 @@
+/*
+ * Mesa 3-D graphics library
+ * Version:  7.4
+ *
+ * Copyright (C) 1999-2008  Brian Paul   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * BRIAN PAUL BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/**
+ * \file marshal.c
+ * Threaded command stream.
+ *
+ * When the MESA_GLTHREAD environment variable is set, drivers which call
+ * _mesa_marshal_create() get a worker thread per context.  While such a
+ * context is current, the application thread's dispatch table records
+ * the most common state and immediate mode calls into batches, and the
+ * worker replays them against the context's real dispatch table.  This
+ * lets the application's own work overlap with transformation and
+ * rasterization.
+ *
+ * Every other entry point synchronizes: it waits for the worker to drain
+ * all queued batches and then runs on the application thread.  That
+ * covers all calls returning values (glGet*, glReadPixels, glGetError,
+ * ...) and all calls reading client memory (vertex arrays, images).
+ *
+ * glDrawArrays, glDrawElements and glDrawRangeElements are queued too
+ * when all enabled arrays, and the indices, are in buffer objects.
+ * Deciding that reads the vertex array state on the application thread.
+ * That state is only changed by synchronizing calls, so apart from the
+ * batch queue it's the only state the two threads share.
+ */
+
+
+#include "glheader.h"
+#include "imports.h"
+#include "context.h"
+#include "marshal.h"
+#include "mtypes.h"
+#include "glapi/dispatch.h"
+#include "glapi/glapi.h"
+#include "glapi/glthread.h"
+
+
+#if defined(PTHREADS)
+
+#include <pthread.h>
+
+
+/** Size of one batch, in nodes */
+#define MARSHAL_BATCH_SIZE  4096
+
+/** Number of batches which may be queued for the worker */
+#define MARSHAL_MAX_BATCHES 4
+
+
+/**
+ * Marshalled command opcodes.
+ */
+typedef enum
+{
+   MARSHAL_BEGIN,
+   MARSHAL_END,
+   MARSHAL_VERTEX_2F,
+   MARSHAL_VERTEX_3F,
+   MARSHAL_VERTEX_4F,
+   MARSHAL_VERTEX_2FV,
+   MARSHAL_VERTEX_3FV,
+   MARSHAL_VERTEX_4FV,
+   MARSHAL_VERTEX_2I,
+   MARSHAL_VERTEX_3I,
+   MARSHAL_COLOR_3F,
+   MARSHAL_COLOR_4F,
+   MARSHAL_COLOR_3FV,
+   MARSHAL_COLOR_4FV,
+   MARSHAL_COLOR_3UB,
+   MARSHAL_COLOR_4UB,
+   MARSHAL_COLOR_3UBV,
+   MARSHAL_COLOR_4UBV,
+   MARSHAL_NORMAL_3F,
+   MARSHAL_NORMAL_3FV,
+   MARSHAL_TEX_COORD_1F,
+   MARSHAL_TEX_COORD_2F,
+   MARSHAL_TEX_COORD_3F,
+   MARSHAL_TEX_COORD_4F,
+   MARSHAL_TEX_COORD_2FV,
+   MARSHAL_MULTI_TEX_COORD_2F_ARB,
+   MARSHAL_MULTI_TEX_COORD_2FV_ARB,
+   MARSHAL_EDGE_FLAG,
+   MARSHAL_MATERIALF,
+   MARSHAL_RECTF,
+   MARSHAL_ENABLE,
+   MARSHAL_DISABLE,
+   MARSHAL_SHADE_MODEL,
+   MARSHAL_MATRIX_MODE,
+   MARSHAL_LOAD_IDENTITY,
+   MARSHAL_PUSH_MATRIX,
+   MARSHAL_POP_MATRIX,
+   MARSHAL_TRANSLATEF,
+   MARSHAL_ROTATEF,
+   MARSHAL_SCALEF,
+   MARSHAL_LOAD_MATRIXF,
+   MARSHAL_MULT_MATRIXF,
+   MARSHAL_VIEWPORT,
+   MARSHAL_SCISSOR,
+   MARSHAL_BIND_TEXTURE,
+   MARSHAL_TEX_ENVF,
+   MARSHAL_TEX_ENVI,
+   MARSHAL_TEX_PARAMETERF,
+   MARSHAL_TEX_PARAMETERI,
+   MARSHAL_LIGHTF,
+   MARSHAL_LIGHT_MODELI,
+   MARSHAL_FOGF,
+   MARSHAL_FOGI,
+   MARSHAL_ALPHA_FUNC,
+   MARSHAL_BLEND_FUNC,
+   MARSHAL_DEPTH_FUNC,
+   MARSHAL_DEPTH_MASK,
+   MARSHAL_COLOR_MASK,
+   MARSHAL_STENCIL_FUNC,
+   MARSHAL_STENCIL_OP,
+   MARSHAL_STENCIL_MASK,
+   MARSHAL_CULL_FACE,
+   MARSHAL_FRONT_FACE,
+   MARSHAL_POLYGON_MODE,
+   MARSHAL_LINE_WIDTH,
+   MARSHAL_LINE_STIPPLE,
+   MARSHAL_POINT_SIZE,
+   MARSHAL_HINT,
+   MARSHAL_PUSH_ATTRIB,
+   MARSHAL_POP_ATTRIB,
+   MARSHAL_CLEAR_COLOR,
+   MARSHAL_CLEAR,
+   MARSHAL_DRAW_ARRAYS,
+   MARSHAL_DRAW_ELEMENTS,
+   MARSHAL_DRAW_RANGE_ELEMENTS,
+   MARSHAL_CALL_LIST,
+   MARSHAL_FLUSH
+} MarshalOpCode;
+
+
+/**
+ * Marshalled commands are an opcode node, holding the number of
+ * parameter nodes which follow.
+ */
+union marshal_node
+{
+   struct {
+      GLushort opcode;
+      GLushort size;
+   } cmd;
+   GLboolean b;
+   GLubyte ub;
+   GLushort us;
+   GLint i;
+   GLuint ui;
+   GLenum e;
+   GLfloat f;
+};
+
+
+struct marshal_batch
+{
+   union marshal_node buffer[MARSHAL_BATCH_SIZE];
+   GLuint used;
+};
+
+
+struct gl_marshal_context
+{
+   GLcontext *ctx;
+   struct _glapi_table *table;   /**< marshalling dispatch table */
+
+   struct marshal_batch batch[MARSHAL_MAX_BATCHES];
+   GLuint next;        /**< batch being filled by the application */
+   GLuint last;        /**< oldest batch queued for the worker */
+   GLuint pending;     /**< number of batches queued or executing */
+
+   pthread_t thread;
+   pthread_mutex_t mutex;
+   pthread_cond_t work;  /**< signalled when a batch is queued */
+   pthread_cond_t done;  /**< signalled when a batch has executed */
+   GLboolean started;
+   GLboolean quit;
+};
+
+
+/**
+ * Execute the commands in a batch, on the worker thread.
+ */
+static void
+execute_batch(GLcontext *ctx, const struct marshal_batch *batch)
+{
+   const union marshal_node *n = batch->buffer;
+   const union marshal_node *end = batch->buffer + batch->used;
+
+   /* Calls run on the application thread may have switched the
+    * context's dispatch (glNewList, glEndList).
+    */
+   if (GET_DISPATCH() != ctx->CurrentDispatch)
+      _glapi_set_dispatch(ctx->CurrentDispatch);
+
+   while (n < end) {
+      switch ((MarshalOpCode) n[0].cmd.opcode) {
+      case MARSHAL_BEGIN:
+         CALL_Begin(GET_DISPATCH(), (n[1].e));
+         break;
+      case MARSHAL_END:
+         CALL_End(GET_DISPATCH(), ());
+         break;
+      case MARSHAL_VERTEX_2F:
+         CALL_Vertex2f(GET_DISPATCH(), (n[1].f, n[2].f));
+         break;
+      case MARSHAL_VERTEX_3F:
+         CALL_Vertex3f(GET_DISPATCH(), (n[1].f, n[2].f, n[3].f));
+         break;
+      case MARSHAL_VERTEX_4F:
+         CALL_Vertex4f(GET_DISPATCH(), (n[1].f, n[2].f, n[3].f, n[4].f));
+         break;
+      case MARSHAL_VERTEX_2FV:
+         CALL_Vertex2fv(GET_DISPATCH(), (&n[1].f));
+         break;
+      case MARSHAL_VERTEX_3FV:
+         CALL_Vertex3fv(GET_DISPATCH(), (&n[1].f));
+         break;
+      case MARSHAL_VERTEX_4FV:
+         CALL_Vertex4fv(GET_DISPATCH(), (&n[1].f));
+         break;
+      case MARSHAL_VERTEX_2I:
+         CALL_Vertex2i(GET_DISPATCH(), (n[1].i, n[2].i));
+         break;
+      case MARSHAL_VERTEX_3I:
+         CALL_Vertex3i(GET_DISPATCH(), (n[1].i, n[2].i, n[3].i));
+         break;
+      case MARSHAL_COLOR_3F:
+         CALL_Color3f(GET_DISPATCH(), (n[1].f, n[2].f, n[3].f));
+         break;
+      case MARSHAL_COLOR_4F:
+         CALL_Color4f(GET_DISPATCH(), (n[1].f, n[2].f, n[3].f, n[4].f));
+         break;
+      case MARSHAL_COLOR_3FV:
+         CALL_Color3fv(GET_DISPATCH(), (&n[1].f));
+         break;
+      case MARSHAL_COLOR_4FV:
+         CALL_Color4fv(GET_DISPATCH(), (&n[1].f));
+         break;
+      case MARSHAL_COLOR_3UB:
+         CALL_Color3ub(GET_DISPATCH(), (n[1].ub, n[2].ub, n[3].ub));
+         break;
+      case MARSHAL_COLOR_4UB:
+         CALL_Color4ub(GET_DISPATCH(), (n[1].ub, n[2].ub, n[3].ub, n[4].ub));
+         break;
+      case MARSHAL_COLOR_3UBV:
+         CALL_Color3ub(GET_DISPATCH(), (n[1].ub, n[2].ub, n[3].ub));
+         break;
+      case MARSHAL_COLOR_4UBV:
+         CALL_Color4ub(GET_DISPATCH(), (n[1].ub, n[2].ub, n[3].ub, n[4].ub));
+         break;
+      case MARSHAL_NORMAL_3F:
+         CALL_Normal3f(GET_DISPATCH(), (n[1].f, n[2].f, n[3].f));
+         break;
+      case MARSHAL_NORMAL_3FV:
+         CALL_Normal3fv(GET_DISPATCH(), (&n[1].f));
+         break;
+      case MARSHAL_TEX_COORD_1F:
+         CALL_TexCoord1f(GET_DISPATCH(), (n[1].f));
+         break;
+      case MARSHAL_TEX_COORD_2F:
+         CALL_TexCoord2f(GET_DISPATCH(), (n[1].f, n[2].f));
+         break;
+      case MARSHAL_TEX_COORD_3F:
+         CALL_TexCoord3f(GET_DISPATCH(), (n[1].f, n[2].f, n[3].f));
+         break;
+      case MARSHAL_TEX_COORD_4F:
+         CALL_TexCoord4f(GET_DISPATCH(), (n[1].f, n[2].f, n[3].f, n[4].f));
+         break;
+      case MARSHAL_TEX_COORD_2FV:
+         CALL_TexCoord2fv(GET_DISPATCH(), (&n[1].f));
+         break;
+      case MARSHAL_MULTI_TEX_COORD_2F_ARB:
+         CALL_MultiTexCoord2fARB(GET_DISPATCH(), (n[1].e, n[2].f, n[3].f));
+         break;
+      case MARSHAL_MULTI_TEX_COORD_2FV_ARB:
+         CALL_MultiTexCoord2fvARB(GET_DISPATCH(), (n[1].e, &n[2].f));
+         break;
+      case MARSHAL_EDGE_FLAG:
+         CALL_EdgeFlag(GET_DISPATCH(), (n[1].b));
+         break;
+      case MARSHAL_MATERIALF:
+         CALL_Materialf(GET_DISPATCH(), (n[1].e, n[2].e, n[3].f));
+         break;
+      case MARSHAL_RECTF:
+         CALL_Rectf(GET_DISPATCH(), (n[1].f, n[2].f, n[3].f, n[4].f));
+         break;
+      case MARSHAL_ENABLE:
+         CALL_Enable(GET_DISPATCH(), (n[1].e));
+         break;
+      case MARSHAL_DISABLE:
+         CALL_Disable(GET_DISPATCH(), (n[1].e));
+         break;
+      case MARSHAL_SHADE_MODEL:
+         CALL_ShadeModel(GET_DISPATCH(), (n[1].e));
+         break;
+      case MARSHAL_MATRIX_MODE:
+         CALL_MatrixMode(GET_DISPATCH(), (n[1].e));
+         break;
+      case MARSHAL_LOAD_IDENTITY:
+         CALL_LoadIdentity(GET_DISPATCH(), ());
+         break;
+      case MARSHAL_PUSH_MATRIX:
+         CALL_PushMatrix(GET_DISPATCH(), ());
+         break;
+      case MARSHAL_POP_MATRIX:
+         CALL_PopMatrix(GET_DISPATCH(), ());
+         break;
+      case MARSHAL_TRANSLATEF:
+         CALL_Translatef(GET_DISPATCH(), (n[1].f, n[2].f, n[3].f));
+         break;
+      case MARSHAL_ROTATEF:
+         CALL_Rotatef(GET_DISPATCH(), (n[1].f, n[2].f, n[3].f, n[4].f));
+         break;
+      case MARSHAL_SCALEF:
+         CALL_Scalef(GET_DISPATCH(), (n[1].f, n[2].f, n[3].f));
+         break;
+      case MARSHAL_LOAD_MATRIXF:
+         CALL_LoadMatrixf(GET_DISPATCH(), (&n[1].f));
+         break;
+      case MARSHAL_MULT_MATRIXF:
+         CALL_MultMatrixf(GET_DISPATCH(), (&n[1].f));
+         break;
+      case MARSHAL_VIEWPORT:
+         CALL_Viewport(GET_DISPATCH(), (n[1].i, n[2].i, n[3].i, n[4].i));
+         break;
+      case MARSHAL_SCISSOR:
+         CALL_Scissor(GET_DISPATCH(), (n[1].i, n[2].i, n[3].i, n[4].i));
+         break;
+      case MARSHAL_BIND_TEXTURE:
+         CALL_BindTexture(GET_DISPATCH(), (n[1].e, n[2].ui));
+         break;
+      case MARSHAL_TEX_ENVF:
+         CALL_TexEnvf(GET_DISPATCH(), (n[1].e, n[2].e, n[3].f));
+         break;
+      case MARSHAL_TEX_ENVI:
+         CALL_TexEnvi(GET_DISPATCH(), (n[1].e, n[2].e, n[3].i));
+         break;
+      case MARSHAL_TEX_PARAMETERF:
+         CALL_TexParameterf(GET_DISPATCH(), (n[1].e, n[2].e, n[3].f));
+         break;
+      case MARSHAL_TEX_PARAMETERI:
+         CALL_TexParameteri(GET_DISPATCH(), (n[1].e, n[2].e, n[3].i));
+         break;
+      case MARSHAL_LIGHTF:
+         CALL_Lightf(GET_DISPATCH(), (n[1].e, n[2].e, n[3].f));
+         break;
+      case MARSHAL_LIGHT_MODELI:
+         CALL_LightModeli(GET_DISPATCH(), (n[1].e, n[2].i));
+         break;
+      case MARSHAL_FOGF:
+         CALL_Fogf(GET_DISPATCH(), (n[1].e, n[2].f));
+         break;
+      case MARSHAL_FOGI:
+         CALL_Fogi(GET_DISPATCH(), (n[1].e, n[2].i));
+         break;
+      case MARSHAL_ALPHA_FUNC:
+         CALL_AlphaFunc(GET_DISPATCH(), (n[1].e, n[2].f));
+         break;
+      case MARSHAL_BLEND_FUNC:
+         CALL_BlendFunc(GET_DISPATCH(), (n[1].e, n[2].e));
+         break;
+      case MARSHAL_DEPTH_FUNC:
+         CALL_DepthFunc(GET_DISPATCH(), (n[1].e));
+         break;
+      case MARSHAL_DEPTH_MASK:
+         CALL_DepthMask(GET_DISPATCH(), (n[1].b));
+         break;
+      case MARSHAL_COLOR_MASK:
+         CALL_ColorMask(GET_DISPATCH(), (n[1].b, n[2].b, n[3].b, n[4].b));
+         break;
+      case MARSHAL_STENCIL_FUNC:
+         CALL_StencilFunc(GET_DISPATCH(), (n[1].e, n[2].i, n[3].ui));
+         break;
+      case MARSHAL_STENCIL_OP:
+         CALL_StencilOp(GET_DISPATCH(), (n[1].e, n[2].e, n[3].e));
+         break;
+      case MARSHAL_STENCIL_MASK:
+         CALL_StencilMask(GET_DISPATCH(), (n[1].ui));
+         break;
+      case MARSHAL_CULL_FACE:
+         CALL_CullFace(GET_DISPATCH(), (n[1].e));
+         break;
+      case MARSHAL_FRONT_FACE:
+         CALL_FrontFace(GET_DISPATCH(), (n[1].e));
+         break;
+      case MARSHAL_POLYGON_MODE:
+         CALL_PolygonMode(GET_DISPATCH(), (n[1].e, n[2].e));
+         break;
+      case MARSHAL_LINE_WIDTH:
+         CALL_LineWidth(GET_DISPATCH(), (n[1].f));
+         break;
+      case MARSHAL_LINE_STIPPLE:
+         CALL_LineStipple(GET_DISPATCH(), (n[1].i, n[2].us));
+         break;
+      case MARSHAL_POINT_SIZE:
+         CALL_PointSize(GET_DISPATCH(), (n[1].f));
+         break;
+      case MARSHAL_HINT:
+         CALL_Hint(GET_DISPATCH(), (n[1].e, n[2].e));
+         break;
+      case MARSHAL_PUSH_ATTRIB:
+         CALL_PushAttrib(GET_DISPATCH(), (n[1].ui));
+         break;
+      case MARSHAL_POP_ATTRIB:
+         CALL_PopAttrib(GET_DISPATCH(), ());
+         break;
+      case MARSHAL_CLEAR_COLOR:
+         CALL_ClearColor(GET_DISPATCH(), (n[1].f, n[2].f, n[3].f, n[4].f));
+         break;
+      case MARSHAL_CLEAR:
+         CALL_Clear(GET_DISPATCH(), (n[1].ui));
+         break;
+      case MARSHAL_DRAW_ARRAYS:
+         CALL_DrawArrays(GET_DISPATCH(), (n[1].e, n[2].i, n[3].i));
+         break;
+      case MARSHAL_DRAW_ELEMENTS:
+         CALL_DrawElements(GET_DISPATCH(), (n[1].e, n[2].i, n[3].e,
+                                            (const GLvoid *) (size_t) n[4].ui));
+         break;
+      case MARSHAL_DRAW_RANGE_ELEMENTS:
+         CALL_DrawRangeElements(GET_DISPATCH(),
+                                (n[1].e, n[2].ui, n[3].ui, n[4].i, n[5].e,
+                                 (const GLvoid *) (size_t) n[6].ui));
+         break;
+      case MARSHAL_CALL_LIST:
+         CALL_CallList(GET_DISPATCH(), (n[1].ui));
+         break;
+      case MARSHAL_FLUSH:
+         CALL_Flush(GET_DISPATCH(), ());
+         break;
+      default:
+         _mesa_problem(ctx, "bad opcode in execute_batch");
+         return;
+      }
+      n += 1 + n[0].cmd.size;
+   }
+}
+
+
+static void *
+worker_main(void *data)
+{
+   struct gl_marshal_context *m = (struct gl_marshal_context *) data;
+
+   /* Switch glapi to per-thread dispatch and make the context current
+    * here too.
+    */
+   _glapi_check_multithread();
+   _glapi_set_context((void *) m->ctx);
+   _glapi_set_dispatch(m->ctx->CurrentDispatch);
+
+   pthread_mutex_lock(&m->mutex);
+   m->started = GL_TRUE;
+   pthread_cond_broadcast(&m->done);
+
+   for (;;) {
+      struct marshal_batch *batch;
+
+      while (!m->pending && !m->quit)
+         pthread_cond_wait(&m->work, &m->mutex);
+      if (!m->pending)
+         break;
+
+      batch = &m->batch[m->last];
+      pthread_mutex_unlock(&m->mutex);
+
+      execute_batch(m->ctx, batch);
+      batch->used = 0;
+
+      pthread_mutex_lock(&m->mutex);
+      m->last = (m->last + 1) % MARSHAL_MAX_BATCHES;
+      m->pending--;
+      pthread_cond_broadcast(&m->done);
+   }
+
+   pthread_mutex_unlock(&m->mutex);
+   return NULL;
+}
+
+
+/**
+ * Queue the batch being filled for the worker, and wait for the next
+ * one to become free.
+ */
+static void
+flush_batch(struct gl_marshal_context *m)
+{
+   if (!m->batch[m->next].used)
+      return;
+
+   pthread_mutex_lock(&m->mutex);
+   m->pending++;
+   m->next = (m->next + 1) % MARSHAL_MAX_BATCHES;
+   pthread_cond_signal(&m->work);
+   while (m->pending == MARSHAL_MAX_BATCHES)
+      pthread_cond_wait(&m->done, &m->mutex);
+   pthread_mutex_unlock(&m->mutex);
+}
+
+
+/**
+ * Reserve room for a command with 'size' parameter nodes.
+ */
+static INLINE union marshal_node *
+alloc_command(GLcontext *ctx, MarshalOpCode opcode, GLuint size)
+{
+   struct gl_marshal_context *m = ctx->Marshal;
+   struct marshal_batch *batch = &m->batch[m->next];
+   union marshal_node *n;
+
+   if (batch->used + 1 + size > MARSHAL_BATCH_SIZE) {
+      flush_batch(m);
+      batch = &m->batch[m->next];
+   }
+
+   n = batch->buffer + batch->used;
+   n[0].cmd.opcode = (GLushort) opcode;
+   n[0].cmd.size = (GLushort) size;
+   batch->used += 1 + size;
+   return n;
+}
+
+
+/**
+ * Wait for all queued commands to execute.
+ */
+void
+_mesa_marshal_finish(GLcontext *ctx)
+{
+   struct gl_marshal_context *m = ctx->Marshal;
+
+   if (!m)
+      return;
+
+   flush_batch(m);
+
+   pthread_mutex_lock(&m->mutex);
+   while (m->pending)
+      pthread_cond_wait(&m->done, &m->mutex);
+   pthread_mutex_unlock(&m->mutex);
+}
+
+
+/**********************************************************************/
+/** \name Marshalling functions, run on the application thread */
+/*@{*/
+
+static void GLAPIENTRY
+marshal_Begin(GLenum mode)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_BEGIN, 1);
+   n[1].e = mode;
+}
+
+
+static void GLAPIENTRY
+marshal_End(void)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   (void) alloc_command(ctx, MARSHAL_END, 0);
+}
+
+
+static void GLAPIENTRY
+marshal_Vertex2f(GLfloat x, GLfloat y)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_VERTEX_2F, 2);
+   n[1].f = x;
+   n[2].f = y;
+}
+
+
+static void GLAPIENTRY
+marshal_Vertex3f(GLfloat x, GLfloat y, GLfloat z)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_VERTEX_3F, 3);
+   n[1].f = x;
+   n[2].f = y;
+   n[3].f = z;
+}
+
+
+static void GLAPIENTRY
+marshal_Vertex4f(GLfloat x, GLfloat y, GLfloat z, GLfloat w)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_VERTEX_4F, 4);
+   n[1].f = x;
+   n[2].f = y;
+   n[3].f = z;
+   n[4].f = w;
+}
+
+
+static void GLAPIENTRY
+marshal_Vertex2fv(const GLfloat *v)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_VERTEX_2FV, 2);
+   n[1].f = v[0];
+   n[2].f = v[1];
+}
+
+
+static void GLAPIENTRY
+marshal_Vertex3fv(const GLfloat *v)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_VERTEX_3FV, 3);
+   n[1].f = v[0];
+   n[2].f = v[1];
+   n[3].f = v[2];
+}
+
+
+static void GLAPIENTRY
+marshal_Vertex4fv(const GLfloat *v)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_VERTEX_4FV, 4);
+   n[1].f = v[0];
+   n[2].f = v[1];
+   n[3].f = v[2];
+   n[4].f = v[3];
+}
+
+
+static void GLAPIENTRY
+marshal_Vertex2i(GLint x, GLint y)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_VERTEX_2I, 2);
+   n[1].i = x;
+   n[2].i = y;
+}
+
+
+static void GLAPIENTRY
+marshal_Vertex3i(GLint x, GLint y, GLint z)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_VERTEX_3I, 3);
+   n[1].i = x;
+   n[2].i = y;
+   n[3].i = z;
+}
+
+
+static void GLAPIENTRY
+marshal_Color3f(GLfloat red, GLfloat green, GLfloat blue)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_COLOR_3F, 3);
+   n[1].f = red;
+   n[2].f = green;
+   n[3].f = blue;
+}
+
+
+static void GLAPIENTRY
+marshal_Color4f(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_COLOR_4F, 4);
+   n[1].f = red;
+   n[2].f = green;
+   n[3].f = blue;
+   n[4].f = alpha;
+}
+
+
+static void GLAPIENTRY
+marshal_Color3fv(const GLfloat *v)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_COLOR_3FV, 3);
+   n[1].f = v[0];
+   n[2].f = v[1];
+   n[3].f = v[2];
+}
+
+
+static void GLAPIENTRY
+marshal_Color4fv(const GLfloat *v)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_COLOR_4FV, 4);
+   n[1].f = v[0];
+   n[2].f = v[1];
+   n[3].f = v[2];
+   n[4].f = v[3];
+}
+
+
+static void GLAPIENTRY
+marshal_Color3ub(GLubyte red, GLubyte green, GLubyte blue)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_COLOR_3UB, 3);
+   n[1].ub = red;
+   n[2].ub = green;
+   n[3].ub = blue;
+}
+
+
+static void GLAPIENTRY
+marshal_Color4ub(GLubyte red, GLubyte green, GLubyte blue, GLubyte alpha)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_COLOR_4UB, 4);
+   n[1].ub = red;
+   n[2].ub = green;
+   n[3].ub = blue;
+   n[4].ub = alpha;
+}
+
+
+static void GLAPIENTRY
+marshal_Color3ubv(const GLubyte *v)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_COLOR_3UBV, 3);
+   n[1].ub = v[0];
+   n[2].ub = v[1];
+   n[3].ub = v[2];
+}
+
+
+static void GLAPIENTRY
+marshal_Color4ubv(const GLubyte *v)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_COLOR_4UBV, 4);
+   n[1].ub = v[0];
+   n[2].ub = v[1];
+   n[3].ub = v[2];
+   n[4].ub = v[3];
+}
+
+
+static void GLAPIENTRY
+marshal_Normal3f(GLfloat nx, GLfloat ny, GLfloat nz)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_NORMAL_3F, 3);
+   n[1].f = nx;
+   n[2].f = ny;
+   n[3].f = nz;
+}
+
+
+static void GLAPIENTRY
+marshal_Normal3fv(const GLfloat *v)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_NORMAL_3FV, 3);
+   n[1].f = v[0];
+   n[2].f = v[1];
+   n[3].f = v[2];
+}
+
+
+static void GLAPIENTRY
+marshal_TexCoord1f(GLfloat s)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_TEX_COORD_1F, 1);
+   n[1].f = s;
+}
+
+
+static void GLAPIENTRY
+marshal_TexCoord2f(GLfloat s, GLfloat t)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_TEX_COORD_2F, 2);
+   n[1].f = s;
+   n[2].f = t;
+}
+
+
+static void GLAPIENTRY
+marshal_TexCoord3f(GLfloat s, GLfloat t, GLfloat r)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_TEX_COORD_3F, 3);
+   n[1].f = s;
+   n[2].f = t;
+   n[3].f = r;
+}
+
+
+static void GLAPIENTRY
+marshal_TexCoord4f(GLfloat s, GLfloat t, GLfloat r, GLfloat q)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_TEX_COORD_4F, 4);
+   n[1].f = s;
+   n[2].f = t;
+   n[3].f = r;
+   n[4].f = q;
+}
+
+
+static void GLAPIENTRY
+marshal_TexCoord2fv(const GLfloat *v)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_TEX_COORD_2FV, 2);
+   n[1].f = v[0];
+   n[2].f = v[1];
+}
+
+
+static void GLAPIENTRY
+marshal_MultiTexCoord2fARB(GLenum target, GLfloat s, GLfloat t)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_MULTI_TEX_COORD_2F_ARB, 3);
+   n[1].e = target;
+   n[2].f = s;
+   n[3].f = t;
+}
+
+
+static void GLAPIENTRY
+marshal_MultiTexCoord2fvARB(GLenum target, const GLfloat *v)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_MULTI_TEX_COORD_2FV_ARB, 3);
+   n[1].e = target;
+   n[2].f = v[0];
+   n[3].f = v[1];
+}
+
+
+static void GLAPIENTRY
+marshal_EdgeFlag(GLboolean flag)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_EDGE_FLAG, 1);
+   n[1].b = flag;
+}
+
+
+static void GLAPIENTRY
+marshal_Materialf(GLenum face, GLenum pname, GLfloat param)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_MATERIALF, 3);
+   n[1].e = face;
+   n[2].e = pname;
+   n[3].f = param;
+}
+
+
+static void GLAPIENTRY
+marshal_Rectf(GLfloat x1, GLfloat y1, GLfloat x2, GLfloat y2)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_RECTF, 4);
+   n[1].f = x1;
+   n[2].f = y1;
+   n[3].f = x2;
+   n[4].f = y2;
+}
+
+
+/**
+ * Is this one of the vertex arrays glEnable() also accepts?  Those have
+ * to change on the application thread, see arrays_in_buffers().
+ */
+static GLboolean
+is_client_state(GLenum cap)
+{
+   switch (cap) {
+   case GL_VERTEX_ARRAY:
+   case GL_NORMAL_ARRAY:
+   case GL_COLOR_ARRAY:
+   case GL_INDEX_ARRAY:
+   case GL_TEXTURE_COORD_ARRAY:
+   case GL_EDGE_FLAG_ARRAY:
+   case GL_FOG_COORDINATE_ARRAY_EXT:
+   case GL_SECONDARY_COLOR_ARRAY_EXT:
+   case GL_POINT_SIZE_ARRAY_OES:
+      return GL_TRUE;
+   default:
+      return GL_FALSE;
+   }
+}
+
+
+static void GLAPIENTRY
+marshal_Enable(GLenum cap)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n;
+
+   if (is_client_state(cap)) {
+      _mesa_marshal_finish(ctx);
+      CALL_Enable(ctx->CurrentDispatch, (cap));
+      return;
+   }
+
+   n = alloc_command(ctx, MARSHAL_ENABLE, 1);
+   n[1].e = cap;
+}
+
+
+static void GLAPIENTRY
+marshal_Disable(GLenum cap)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n;
+
+   if (is_client_state(cap)) {
+      _mesa_marshal_finish(ctx);
+      CALL_Disable(ctx->CurrentDispatch, (cap));
+      return;
+   }
+
+   n = alloc_command(ctx, MARSHAL_DISABLE, 1);
+   n[1].e = cap;
+}
+
+
+static void GLAPIENTRY
+marshal_ShadeModel(GLenum mode)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_SHADE_MODEL, 1);
+   n[1].e = mode;
+}
+
+
+static void GLAPIENTRY
+marshal_MatrixMode(GLenum mode)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_MATRIX_MODE, 1);
+   n[1].e = mode;
+}
+
+
+static void GLAPIENTRY
+marshal_LoadIdentity(void)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   (void) alloc_command(ctx, MARSHAL_LOAD_IDENTITY, 0);
+}
+
+
+static void GLAPIENTRY
+marshal_PushMatrix(void)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   (void) alloc_command(ctx, MARSHAL_PUSH_MATRIX, 0);
+}
+
+
+static void GLAPIENTRY
+marshal_PopMatrix(void)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   (void) alloc_command(ctx, MARSHAL_POP_MATRIX, 0);
+}
+
+
+static void GLAPIENTRY
+marshal_Translatef(GLfloat x, GLfloat y, GLfloat z)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_TRANSLATEF, 3);
+   n[1].f = x;
+   n[2].f = y;
+   n[3].f = z;
+}
+
+
+static void GLAPIENTRY
+marshal_Rotatef(GLfloat angle, GLfloat x, GLfloat y, GLfloat z)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_ROTATEF, 4);
+   n[1].f = angle;
+   n[2].f = x;
+   n[3].f = y;
+   n[4].f = z;
+}
+
+
+static void GLAPIENTRY
+marshal_Scalef(GLfloat x, GLfloat y, GLfloat z)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_SCALEF, 3);
+   n[1].f = x;
+   n[2].f = y;
+   n[3].f = z;
+}
+
+
+static void GLAPIENTRY
+marshal_LoadMatrixf(const GLfloat *m)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_LOAD_MATRIXF, 16);
+   n[1].f = m[0];
+   n[2].f = m[1];
+   n[3].f = m[2];
+   n[4].f = m[3];
+   n[5].f = m[4];
+   n[6].f = m[5];
+   n[7].f = m[6];
+   n[8].f = m[7];
+   n[9].f = m[8];
+   n[10].f = m[9];
+   n[11].f = m[10];
+   n[12].f = m[11];
+   n[13].f = m[12];
+   n[14].f = m[13];
+   n[15].f = m[14];
+   n[16].f = m[15];
+}
+
+
+static void GLAPIENTRY
+marshal_MultMatrixf(const GLfloat *m)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_MULT_MATRIXF, 16);
+   n[1].f = m[0];
+   n[2].f = m[1];
+   n[3].f = m[2];
+   n[4].f = m[3];
+   n[5].f = m[4];
+   n[6].f = m[5];
+   n[7].f = m[6];
+   n[8].f = m[7];
+   n[9].f = m[8];
+   n[10].f = m[9];
+   n[11].f = m[10];
+   n[12].f = m[11];
+   n[13].f = m[12];
+   n[14].f = m[13];
+   n[15].f = m[14];
+   n[16].f = m[15];
+}
+
+
+static void GLAPIENTRY
+marshal_Viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_VIEWPORT, 4);
+   n[1].i = x;
+   n[2].i = y;
+   n[3].i = width;
+   n[4].i = height;
+}
+
+
+static void GLAPIENTRY
+marshal_Scissor(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_SCISSOR, 4);
+   n[1].i = x;
+   n[2].i = y;
+   n[3].i = width;
+   n[4].i = height;
+}
+
+
+static void GLAPIENTRY
+marshal_BindTexture(GLenum target, GLuint texture)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_BIND_TEXTURE, 2);
+   n[1].e = target;
+   n[2].ui = texture;
+}
+
+
+static void GLAPIENTRY
+marshal_TexEnvf(GLenum target, GLenum pname, GLfloat param)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_TEX_ENVF, 3);
+   n[1].e = target;
+   n[2].e = pname;
+   n[3].f = param;
+}
+
+
+static void GLAPIENTRY
+marshal_TexEnvi(GLenum target, GLenum pname, GLint param)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_TEX_ENVI, 3);
+   n[1].e = target;
+   n[2].e = pname;
+   n[3].i = param;
+}
+
+
+static void GLAPIENTRY
+marshal_TexParameterf(GLenum target, GLenum pname, GLfloat param)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_TEX_PARAMETERF, 3);
+   n[1].e = target;
+   n[2].e = pname;
+   n[3].f = param;
+}
+
+
+static void GLAPIENTRY
+marshal_TexParameteri(GLenum target, GLenum pname, GLint param)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_TEX_PARAMETERI, 3);
+   n[1].e = target;
+   n[2].e = pname;
+   n[3].i = param;
+}
+
+
+static void GLAPIENTRY
+marshal_Lightf(GLenum light, GLenum pname, GLfloat param)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_LIGHTF, 3);
+   n[1].e = light;
+   n[2].e = pname;
+   n[3].f = param;
+}
+
+
+static void GLAPIENTRY
+marshal_LightModeli(GLenum pname, GLint param)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_LIGHT_MODELI, 2);
+   n[1].e = pname;
+   n[2].i = param;
+}
+
+
+static void GLAPIENTRY
+marshal_Fogf(GLenum pname, GLfloat param)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_FOGF, 2);
+   n[1].e = pname;
+   n[2].f = param;
+}
+
+
+static void GLAPIENTRY
+marshal_Fogi(GLenum pname, GLint param)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_FOGI, 2);
+   n[1].e = pname;
+   n[2].i = param;
+}
+
+
+static void GLAPIENTRY
+marshal_AlphaFunc(GLenum func, GLclampf ref)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_ALPHA_FUNC, 2);
+   n[1].e = func;
+   n[2].f = ref;
+}
+
+
+static void GLAPIENTRY
+marshal_BlendFunc(GLenum sfactor, GLenum dfactor)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_BLEND_FUNC, 2);
+   n[1].e = sfactor;
+   n[2].e = dfactor;
+}
+
+
+static void GLAPIENTRY
+marshal_DepthFunc(GLenum func)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_DEPTH_FUNC, 1);
+   n[1].e = func;
+}
+
+
+static void GLAPIENTRY
+marshal_DepthMask(GLboolean flag)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_DEPTH_MASK, 1);
+   n[1].b = flag;
+}
+
+
+static void GLAPIENTRY
+marshal_ColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_COLOR_MASK, 4);
+   n[1].b = red;
+   n[2].b = green;
+   n[3].b = blue;
+   n[4].b = alpha;
+}
+
+
+static void GLAPIENTRY
+marshal_StencilFunc(GLenum func, GLint ref, GLuint mask)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_STENCIL_FUNC, 3);
+   n[1].e = func;
+   n[2].i = ref;
+   n[3].ui = mask;
+}
+
+
+static void GLAPIENTRY
+marshal_StencilOp(GLenum fail, GLenum zfail, GLenum zpass)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_STENCIL_OP, 3);
+   n[1].e = fail;
+   n[2].e = zfail;
+   n[3].e = zpass;
+}
+
+
+static void GLAPIENTRY
+marshal_StencilMask(GLuint mask)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_STENCIL_MASK, 1);
+   n[1].ui = mask;
+}
+
+
+static void GLAPIENTRY
+marshal_CullFace(GLenum mode)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_CULL_FACE, 1);
+   n[1].e = mode;
+}
+
+
+static void GLAPIENTRY
+marshal_FrontFace(GLenum mode)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_FRONT_FACE, 1);
+   n[1].e = mode;
+}
+
+
+static void GLAPIENTRY
+marshal_PolygonMode(GLenum face, GLenum mode)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_POLYGON_MODE, 2);
+   n[1].e = face;
+   n[2].e = mode;
+}
+
+
+static void GLAPIENTRY
+marshal_LineWidth(GLfloat width)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_LINE_WIDTH, 1);
+   n[1].f = width;
+}
+
+
+static void GLAPIENTRY
+marshal_LineStipple(GLint factor, GLushort pattern)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_LINE_STIPPLE, 2);
+   n[1].i = factor;
+   n[2].us = pattern;
+}
+
+
+static void GLAPIENTRY
+marshal_PointSize(GLfloat size)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_POINT_SIZE, 1);
+   n[1].f = size;
+}
+
+
+static void GLAPIENTRY
+marshal_Hint(GLenum target, GLenum mode)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_HINT, 2);
+   n[1].e = target;
+   n[2].e = mode;
+}
+
+
+static void GLAPIENTRY
+marshal_PushAttrib(GLbitfield mask)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_PUSH_ATTRIB, 1);
+   n[1].ui = mask;
+}
+
+
+static void GLAPIENTRY
+marshal_PopAttrib(void)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   (void) alloc_command(ctx, MARSHAL_POP_ATTRIB, 0);
+}
+
+
+static void GLAPIENTRY
+marshal_ClearColor(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_CLEAR_COLOR, 4);
+   n[1].f = red;
+   n[2].f = green;
+   n[3].f = blue;
+   n[4].f = alpha;
+}
+
+
+static void GLAPIENTRY
+marshal_Clear(GLbitfield mask)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_CLEAR, 1);
+   n[1].ui = mask;
+}
+
+
+static void GLAPIENTRY
+marshal_CallList(GLuint list)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n = alloc_command(ctx, MARSHAL_CALL_LIST, 1);
+   n[1].ui = list;
+}
+
+
+static void GLAPIENTRY
+marshal_Flush(void)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   (void) alloc_command(ctx, MARSHAL_FLUSH, 0);
+   flush_batch(ctx->Marshal);
+}
+
+
+/*@}*/
+
+
+/**********************************************************************/
+/** \name Synchronizing functions for everything else */
+/*@{*/
+
+/**
+ * Start running a call on the application thread.  Any calls it makes
+ * through the dispatch (glArrayElement, display list loopback) must
+ * not be marshalled, so the real dispatch is installed meanwhile.
+ */
+static void
+sync_begin(GLcontext *ctx)
+{
+   _mesa_marshal_finish(ctx);
+   _glapi_set_dispatch(ctx->CurrentDispatch);
+}
+
+static void
+sync_end(GLcontext *ctx)
+{
+   _glapi_set_dispatch(ctx->Marshal->table);
+}
+
+#define KEYWORD1 static
+/* Most _dispatch_stub_NNN aliases aren't in sync_table; don't emit them */
+#define KEYWORD1_ALT static INLINE
+#define KEYWORD2 GLAPIENTRY
+#define NAME(func)  sync_##func
+
+#define F NULL
+
+#define DISPATCH(FUNC, ARGS, MESSAGE)		\
+   GET_CURRENT_CONTEXT(ctx);			\
+   sync_begin(ctx);				\
+   CALL_ ## FUNC(ctx->CurrentDispatch, ARGS);	\
+   sync_end(ctx)
+
+/* None of the calls returning a value dispatch any further. */
+#define RETURN_DISPATCH(FUNC, ARGS, MESSAGE)	\
+   GET_CURRENT_CONTEXT(ctx);			\
+   _mesa_marshal_finish(ctx);			\
+   return CALL_ ## FUNC(ctx->CurrentDispatch, ARGS)
+
+#define DISPATCH_TABLE_NAME sync_table
+#define UNUSED_TABLE_NAME unused_sync_functions
+
+#define TABLE_ENTRY(name) (_glapi_proc) sync_##name
+
+/** Placeholder for the slots of functions registered at runtime */
+static void GLAPIENTRY
+sync_Unused(void)
+{
+}
+
+#include "glapi/glapitemp.h"
+
+/*@}*/
+
+
+/**********************************************************************/
+/** \name Draws from buffer objects */
+/*@{*/
+
+/**
+ * Can a draw from the current vertex arrays be queued?  Only if no
+ * enabled array is in client memory, which the application may change
+ * as soon as the call returns.
+ */
+static GLboolean
+arrays_in_buffers(const GLcontext *ctx)
+{
+   const struct gl_array_object *obj = ctx->Array.ArrayObj;
+   GLuint i;
+
+#define IN_CLIENT_MEMORY(array)  ((array).Enabled && !(array).BufferObj->Name)
+
+   if (IN_CLIENT_MEMORY(obj->Vertex) ||
+       IN_CLIENT_MEMORY(obj->Normal) ||
+       IN_CLIENT_MEMORY(obj->Color) ||
+       IN_CLIENT_MEMORY(obj->SecondaryColor) ||
+       IN_CLIENT_MEMORY(obj->FogCoord) ||
+       IN_CLIENT_MEMORY(obj->Index) ||
+       IN_CLIENT_MEMORY(obj->EdgeFlag) ||
+       IN_CLIENT_MEMORY(obj->PointSize))
+      return GL_FALSE;
+
+   for (i = 0; i < MAX_TEXTURE_COORD_UNITS; i++) {
+      if (IN_CLIENT_MEMORY(obj->TexCoord[i]))
+         return GL_FALSE;
+   }
+
+   for (i = 0; i < VERT_ATTRIB_MAX; i++) {
+      if (IN_CLIENT_MEMORY(obj->VertexAttrib[i]))
+         return GL_FALSE;
+   }
+
+#undef IN_CLIENT_MEMORY
+
+   return GL_TRUE;
+}
+
+
+/**
+ * Can the indices of a draw be queued?  They must be an offset into
+ * the element buffer object, and fit in a node.
+ */
+static GLboolean
+indices_in_buffer(const GLcontext *ctx, const GLvoid *indices)
+{
+   return ctx->Array.ElementArrayBufferObj->Name &&
+          (size_t) (GLuint) (size_t) indices == (size_t) indices;
+}
+
+
+static void GLAPIENTRY
+marshal_DrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n;
+
+   if (!arrays_in_buffers(ctx)) {
+      sync_DrawArrays(mode, first, count);
+      return;
+   }
+
+   n = alloc_command(ctx, MARSHAL_DRAW_ARRAYS, 3);
+   n[1].e = mode;
+   n[2].i = first;
+   n[3].i = count;
+}
+
+
+static void GLAPIENTRY
+marshal_DrawElements(GLenum mode, GLsizei count, GLenum type,
+                     const GLvoid *indices)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n;
+
+   if (!arrays_in_buffers(ctx) || !indices_in_buffer(ctx, indices)) {
+      sync_DrawElements(mode, count, type, indices);
+      return;
+   }
+
+   n = alloc_command(ctx, MARSHAL_DRAW_ELEMENTS, 4);
+   n[1].e = mode;
+   n[2].i = count;
+   n[3].e = type;
+   n[4].ui = (GLuint) (size_t) indices;
+}
+
+
+static void GLAPIENTRY
+marshal_DrawRangeElements(GLenum mode, GLuint start, GLuint end,
+                          GLsizei count, GLenum type, const GLvoid *indices)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   union marshal_node *n;
+
+   if (!arrays_in_buffers(ctx) || !indices_in_buffer(ctx, indices)) {
+      sync_DrawRangeElements(mode, start, end, count, type, indices);
+      return;
+   }
+
+   n = alloc_command(ctx, MARSHAL_DRAW_RANGE_ELEMENTS, 6);
+   n[1].e = mode;
+   n[2].ui = start;
+   n[3].ui = end;
+   n[4].i = count;
+   n[5].e = type;
+   n[6].ui = (GLuint) (size_t) indices;
+}
+
+/*@}*/
+
+
+/**
+ * Build the marshalling dispatch table.
+ */
+static struct _glapi_table *
+create_table(GLcontext *ctx)
+{
+   const GLuint numEntries = _glapi_get_dispatch_table_size();
+   const GLuint numSync = sizeof(sync_table) / sizeof(sync_table[0]);
+   _glapi_proc *entries;
+   struct _glapi_table *table;
+   GLuint i;
+
+   (void) unused_sync_functions;
+
+   entries = (_glapi_proc *) _mesa_malloc(numEntries * sizeof(_glapi_proc));
+   if (!entries)
+      return NULL;
+
+   /* Functions registered by drivers at runtime have no synchronizing
+    * wrapper, and run unsynchronized.  Drivers using this don't have any.
+    */
+   for (i = 0; i < numEntries; i++) {
+      if (i < numSync && sync_table[i] != (_glapi_proc) sync_Unused)
+         entries[i] = sync_table[i];
+      else
+         entries[i] = ((_glapi_proc *) ctx->Exec)[i];
+   }
+
+   table = (struct _glapi_table *) entries;
+
+   SET_Begin(table, marshal_Begin);
+   SET_End(table, marshal_End);
+   SET_Vertex2f(table, marshal_Vertex2f);
+   SET_Vertex3f(table, marshal_Vertex3f);
+   SET_Vertex4f(table, marshal_Vertex4f);
+   SET_Vertex2fv(table, marshal_Vertex2fv);
+   SET_Vertex3fv(table, marshal_Vertex3fv);
+   SET_Vertex4fv(table, marshal_Vertex4fv);
+   SET_Vertex2i(table, marshal_Vertex2i);
+   SET_Vertex3i(table, marshal_Vertex3i);
+   SET_Color3f(table, marshal_Color3f);
+   SET_Color4f(table, marshal_Color4f);
+   SET_Color3fv(table, marshal_Color3fv);
+   SET_Color4fv(table, marshal_Color4fv);
+   SET_Color3ub(table, marshal_Color3ub);
+   SET_Color4ub(table, marshal_Color4ub);
+   SET_Color3ubv(table, marshal_Color3ubv);
+   SET_Color4ubv(table, marshal_Color4ubv);
+   SET_Normal3f(table, marshal_Normal3f);
+   SET_Normal3fv(table, marshal_Normal3fv);
+   SET_TexCoord1f(table, marshal_TexCoord1f);
+   SET_TexCoord2f(table, marshal_TexCoord2f);
+   SET_TexCoord3f(table, marshal_TexCoord3f);
+   SET_TexCoord4f(table, marshal_TexCoord4f);
+   SET_TexCoord2fv(table, marshal_TexCoord2fv);
+   SET_MultiTexCoord2fARB(table, marshal_MultiTexCoord2fARB);
+   SET_MultiTexCoord2fvARB(table, marshal_MultiTexCoord2fvARB);
+   SET_EdgeFlag(table, marshal_EdgeFlag);
+   SET_Materialf(table, marshal_Materialf);
+   SET_Rectf(table, marshal_Rectf);
+   SET_Enable(table, marshal_Enable);
+   SET_Disable(table, marshal_Disable);
+   SET_ShadeModel(table, marshal_ShadeModel);
+   SET_MatrixMode(table, marshal_MatrixMode);
+   SET_LoadIdentity(table, marshal_LoadIdentity);
+   SET_PushMatrix(table, marshal_PushMatrix);
+   SET_PopMatrix(table, marshal_PopMatrix);
+   SET_Translatef(table, marshal_Translatef);
+   SET_Rotatef(table, marshal_Rotatef);
+   SET_Scalef(table, marshal_Scalef);
+   SET_LoadMatrixf(table, marshal_LoadMatrixf);
+   SET_MultMatrixf(table, marshal_MultMatrixf);
+   SET_Viewport(table, marshal_Viewport);
+   SET_Scissor(table, marshal_Scissor);
+   SET_BindTexture(table, marshal_BindTexture);
+   SET_TexEnvf(table, marshal_TexEnvf);
+   SET_TexEnvi(table, marshal_TexEnvi);
+   SET_TexParameterf(table, marshal_TexParameterf);
+   SET_TexParameteri(table, marshal_TexParameteri);
+   SET_Lightf(table, marshal_Lightf);
+   SET_LightModeli(table, marshal_LightModeli);
+   SET_Fogf(table, marshal_Fogf);
+   SET_Fogi(table, marshal_Fogi);
+   SET_AlphaFunc(table, marshal_AlphaFunc);
+   SET_BlendFunc(table, marshal_BlendFunc);
+   SET_DepthFunc(table, marshal_DepthFunc);
+   SET_DepthMask(table, marshal_DepthMask);
+   SET_ColorMask(table, marshal_ColorMask);
+   SET_StencilFunc(table, marshal_StencilFunc);
+   SET_StencilOp(table, marshal_StencilOp);
+   SET_StencilMask(table, marshal_StencilMask);
+   SET_CullFace(table, marshal_CullFace);
+   SET_FrontFace(table, marshal_FrontFace);
+   SET_PolygonMode(table, marshal_PolygonMode);
+   SET_LineWidth(table, marshal_LineWidth);
+   SET_LineStipple(table, marshal_LineStipple);
+   SET_PointSize(table, marshal_PointSize);
+   SET_Hint(table, marshal_Hint);
+   SET_PushAttrib(table, marshal_PushAttrib);
+   SET_PopAttrib(table, marshal_PopAttrib);
+   SET_ClearColor(table, marshal_ClearColor);
+   SET_Clear(table, marshal_Clear);
+   SET_DrawArrays(table, marshal_DrawArrays);
+   SET_DrawElements(table, marshal_DrawElements);
+   SET_DrawRangeElements(table, marshal_DrawRangeElements);
+   SET_CallList(table, marshal_CallList);
+   SET_Flush(table, marshal_Flush);
+
+   return table;
+}
+
+
+/**
+ * Start the worker thread for a context, if enabled with the
+ * MESA_GLTHREAD environment variable.
+ */
+void
+_mesa_marshal_create(GLcontext *ctx)
+{
+   struct gl_marshal_context *m;
+
+   if (ctx->Marshal || !_mesa_getenv("MESA_GLTHREAD"))
+      return;
+
+   m = CALLOC_STRUCT(gl_marshal_context);
+   if (!m)
+      return;
+
+   m->ctx = ctx;
+   m->table = create_table(ctx);
+   if (!m->table) {
+      _mesa_free(m);
+      return;
+   }
+
+   pthread_mutex_init(&m->mutex, NULL);
+   pthread_cond_init(&m->work, NULL);
+   pthread_cond_init(&m->done, NULL);
+
+   if (pthread_create(&m->thread, NULL, worker_main, m) != 0) {
+      pthread_cond_destroy(&m->done);
+      pthread_cond_destroy(&m->work);
+      pthread_mutex_destroy(&m->mutex);
+      _mesa_free(m->table);
+      _mesa_free(m);
+      return;
+   }
+
+   /* Don't let the application thread dispatch anything while glapi
+    * switches to per-thread dispatch.
+    */
+   pthread_mutex_lock(&m->mutex);
+   while (!m->started)
+      pthread_cond_wait(&m->done, &m->mutex);
+   pthread_mutex_unlock(&m->mutex);
+
+   ctx->Marshal = m;
+}
+
+
+/**
+ * Drain the command stream and stop the worker thread.  Drivers call
+ * this before tearing down the modules the worker may be executing in.
+ */
+void
+_mesa_marshal_destroy(GLcontext *ctx)
+{
+   struct gl_marshal_context *m = ctx->Marshal;
+
+   if (!m)
+      return;
+
+   _mesa_marshal_finish(ctx);
+
+   pthread_mutex_lock(&m->mutex);
+   m->quit = GL_TRUE;
+   pthread_cond_signal(&m->work);
+   pthread_mutex_unlock(&m->mutex);
+   pthread_join(m->thread, NULL);
+
+   pthread_cond_destroy(&m->done);
+   pthread_cond_destroy(&m->work);
+   pthread_mutex_destroy(&m->mutex);
+
+   if (_mesa_get_current_context() == ctx)
+      _glapi_set_dispatch(ctx->CurrentDispatch);
+
+   ctx->Marshal = NULL;
+   _mesa_free(m->table);
+   _mesa_free(m);
+}
+
+
+/**
+ * Called when the context is made current on the application thread.
+ */
+void
+_mesa_marshal_make_current(GLcontext *ctx)
+{
+   if (ctx->Marshal)
+      _glapi_set_dispatch(ctx->Marshal->table);
+}
+
+
+#else /* PTHREADS */
+
+
+void
+_mesa_marshal_create(GLcontext *ctx)
+{
+   (void) ctx;
+}
+
+void
+_mesa_marshal_destroy(GLcontext *ctx)
+{
+   (void) ctx;
+}
+
+void
+_mesa_marshal_finish(GLcontext *ctx)
+{
+   (void) ctx;
+}
+
+void
+_mesa_marshal_make_current(GLcontext *ctx)
+{
+   (void) ctx;
+}
+
+
+#endif /* PTHREADS */
@@ -657,13 +657,45 @@ _mesa_DepthRange( GLclampd nearval, GLclampd farval )
 /*@{*/
 
 
+/**
+ * Analyse the top matrix of a stack.
+ *
+ * \param stack matrix stack.
+ *
+ * Stacks are often reloaded with the matrices they already held, like a
+ * glLoadIdentity() of the texture matrix or the same camera and object
+ * transforms every frame.  If the dirty top matrix has the same values and
+ * flags as the one analysed last at this depth, its type and inverse are
+ * copied from gl_matrix_stack::_Analysed instead of being worked out again.
+ */
+void
+_mesa_analyse_stack_top( struct gl_matrix_stack *stack )
+{
+   GLmatrix *top = stack->Top;
+   GLmatrix *analysed = &stack->_Analysed[stack->Depth];
+
+   if (!_math_matrix_is_dirty(top))
+      return;
+
+   if (top->flags == stack->_AnalysedFrom[stack->Depth] &&
+       _mesa_memcmp(top->m, analysed->m, 16 * sizeof(GLfloat)) == 0) {
+      _math_matrix_copy( top, analysed );
+      return;
+   }
+
+   stack->_AnalysedFrom[stack->Depth] = top->flags;
+   _math_matrix_analyse( top );
+   _math_matrix_copy( analysed, top );
+}
+
+
 /**
  * Update the projection matrix stack.
  *
  * \param ctx GL context.
  *
- * Calls _math_matrix_analyse() with the top-matrix of the projection matrix
- * stack, and recomputes user clip positions if necessary.
+ * Calls _mesa_analyse_stack_top() for the projection matrix stack, and
+ * recomputes user clip positions if necessary.
  * 
  * \note This routine references __GLcontextRec::Tranform attribute values to
  * compute userclip positions in clip space, but is only called on
@@ -673,7 +705,7 @@ _mesa_DepthRange( GLclampd nearval, GLclampd farval )
 static void
 update_projection( GLcontext *ctx )
 {
-   _math_matrix_analyse( ctx->ProjectionMatrixStack.Top );
+   _mesa_analyse_stack_top( &ctx->ProjectionMatrixStack );
 
 #if FEATURE_userclip
    /* Recompute clip plane positions in clipspace.  This is also done
@@ -693,6 +725,17 @@ update_projection( GLcontext *ctx )
 }
 
 
+/**
+ * Test if a matrix differs from a previously saved copy.
+ */
+static GLboolean
+matrix_changed( const GLmatrix *mat, const GLmatrix *saved )
+{
+   return (mat->flags != saved->flags ||
+           _mesa_memcmp(mat->m, saved->m, 16 * sizeof(GLfloat)) != 0);
+}
+
+
 /**
  * Calculate the combined modelview-projection matrix.
  *
@@ -701,15 +744,27 @@ update_projection( GLcontext *ctx )
  * Multiplies the top matrices of the projection and model view stacks into
  * __GLcontextRec::_ModelProjectMatrix via _math_matrix_mul_matrix() and
  * analyzes the resulting matrix via _math_matrix_analyse().
+ *
+ * Matrices restored by glPopMatrix() or reloaded with the same values are
+ * common, so the product is only recomputed when one of the two inputs
+ * really differs from those it was last built from.
  */
 static void
 calculate_model_project_matrix( GLcontext *ctx )
 {
-   _math_matrix_mul_matrix( &ctx->_ModelProjectMatrix,
-                            ctx->ProjectionMatrixStack.Top,
-                            ctx->ModelviewMatrixStack.Top );
+   const GLmatrix *proj = ctx->ProjectionMatrixStack.Top;
+   const GLmatrix *mv = ctx->ModelviewMatrixStack.Top;
+
+   if (!matrix_changed(proj, &ctx->_ModelProjectSource[0]) &&
+       !matrix_changed(mv, &ctx->_ModelProjectSource[1]))
+      return;
+
+   _math_matrix_mul_matrix( &ctx->_ModelProjectMatrix, proj, mv );
 
    _math_matrix_analyse( &ctx->_ModelProjectMatrix );
+
+   _math_matrix_copy( &ctx->_ModelProjectSource[0], proj );
+   _math_matrix_copy( &ctx->_ModelProjectSource[1], mv );
 }
 
 
@@ -727,7 +782,7 @@ calculate_model_project_matrix( GLcontext *ctx )
 void _mesa_update_modelview_project( GLcontext *ctx, GLuint new_state )
 {
    if (new_state & _NEW_MODELVIEW) {
-      _math_matrix_analyse( ctx->ModelviewMatrixStack.Top );
+      _mesa_analyse_stack_top( &ctx->ModelviewMatrixStack );
     
       /* Bring cull position uptodate.
        */
@@ -763,7 +818,8 @@ void _mesa_update_modelview_project( GLcontext *ctx, GLuint new_state )
  * 
  * Allocates an array of \p maxDepth elements for the matrix stack and calls
  * _math_matrix_ctr() and _math_matrix_alloc_inv() for each element to
- * initialize it.
+ * initialize it.  The same is done for the copies of the last analysed
+ * matrices, which start out matching no dirty matrix.
  */
 static void
 init_matrix_stack( struct gl_matrix_stack *stack,
@@ -781,6 +837,12 @@ init_matrix_stack( struct gl_matrix_stack *stack,
       _math_matrix_alloc_inv(&stack->Stack[i]);
    }
    stack->Top = stack->Stack;
+   stack->_Analysed = (GLmatrix *) CALLOC(maxDepth * sizeof(GLmatrix));
+   stack->_AnalysedFrom = (GLuint *) CALLOC(maxDepth * sizeof(GLuint));
+   for (i = 0; i < maxDepth; i++) {
+      _math_matrix_ctr(&stack->_Analysed[i]);
+      _math_matrix_alloc_inv(&stack->_Analysed[i]);
+   }
 }
 
 /**
@@ -788,8 +850,8 @@ init_matrix_stack( struct gl_matrix_stack *stack,
  * 
  * \param stack matrix stack.
  * 
- * Calls _math_matrix_dtr() for each element of the matrix stack and
- * frees the array.
+ * Calls _math_matrix_dtr() for each element of the matrix stack and of the
+ * analysed copies, and frees the arrays.
  */
 static void
 free_matrix_stack( struct gl_matrix_stack *stack )
@@ -797,9 +859,14 @@ free_matrix_stack( struct gl_matrix_stack *stack )
    GLuint i;
    for (i = 0; i < stack->MaxDepth; i++) {
       _math_matrix_dtr(&stack->Stack[i]);
+      _math_matrix_dtr(&stack->_Analysed[i]);
    }
    FREE(stack->Stack);
+   FREE(stack->_Analysed);
+   FREE(stack->_AnalysedFrom);
    stack->Stack = stack->Top = NULL;
+   stack->_Analysed = NULL;
+   stack->_AnalysedFrom = NULL;
 }
 
 /*@}*/
@@ -837,8 +904,12 @@ void _mesa_init_matrix( GLcontext * ctx )
 		        MAX_PROGRAM_MATRIX_STACK_DEPTH, _NEW_TRACK_MATRIX);
    ctx->CurrentStack = &ctx->ModelviewMatrixStack;
 
-   /* Init combined Modelview*Projection matrix */
+   /* Init combined Modelview*Projection matrix, and the copies of the
+    * identity matrices it is the product of.
+    */
    _math_matrix_ctr( &ctx->_ModelProjectMatrix );
+   _math_matrix_ctr( &ctx->_ModelProjectSource[0] );
+   _math_matrix_ctr( &ctx->_ModelProjectSource[1] );
 }
 
 
@@ -863,6 +934,8 @@ void _mesa_free_matrix_data( GLcontext *ctx )
       free_matrix_stack(&ctx->ProgramMatrixStack[i]);
    /* combined Modelview*Projection matrix */
    _math_matrix_dtr( &ctx->_ModelProjectMatrix );
+   _math_matrix_dtr( &ctx->_ModelProjectSource[0] );
+   _math_matrix_dtr( &ctx->_ModelProjectSource[1] );
 
 }
 
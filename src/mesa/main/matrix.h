@@ -124,6 +124,9 @@ _mesa_free_matrix_data( GLcontext *ctx );
 extern void 
 _mesa_free_viewport_data( GLcontext *ctx );
 
+extern void
+_mesa_analyse_stack_top( struct gl_matrix_stack *stack );
+
 extern void 
 _mesa_update_modelview_project( GLcontext *ctx, GLuint newstate );
 
@@ -120,6 +120,7 @@ typedef int GLfixed;
  */
 /*@{*/
 struct _mesa_HashTable;
+struct gl_marshal_context;
 struct gl_pixelstore_attrib;
 struct gl_program_cache;
 struct gl_texture_format;
@@ -1627,6 +1628,19 @@ struct gl_attrib_node
 };
 
 
+/**
+ * Smallest and largest index referenced by a glDrawElements call
+ * which reads \c Count indices of \c Type at \c Offset in a buffer object.
+ */
+struct gl_index_range
+{
+   GLintptrARB Offset;
+   GLsizei Count;
+   GLenum Type;
+   GLuint Min, Max;
+};
+
+
 /**
  * GL_ARB_vertex/pixel_buffer_object buffer object
  */
@@ -1640,6 +1654,10 @@ struct gl_buffer_object
    GLsizeiptrARB Size;       /**< Size of storage in bytes */
    GLubyte *Data;            /**< Location of storage either in RAM or VRAM. */
    GLboolean OnCard;         /**< Is buffer in VRAM? (hardware drivers) */
+
+   /** Index ranges found by glDrawElements, reset when the data changes */
+   struct gl_index_range IndexRanges[MAX_INDEX_RANGES];
+   GLuint NumIndexRanges;
 };
 
 
@@ -1864,6 +1882,7 @@ enum register_file
 struct prog_instruction;
 struct gl_program_parameter_list;
 struct gl_uniform_list;
+struct prog_decoded_program;
 
 
 /**
@@ -1926,6 +1945,9 @@ struct gl_program
    GLuint NumNativeTexInstructions;
    GLuint NumNativeTexIndirections;
    /*@}*/
+
+   /** Instructions decoded for the software interpreter, see prog_execute.c */
+   struct prog_decoded_program *Decoded;
 };
 
 
@@ -1993,6 +2015,9 @@ struct gl_vertex_program_state
    /** Cache of fixed-function programs */
    struct gl_program_cache *Cache;
 
+   /** Fixed-function state key, kept up to date by ffvertex_prog.c */
+   void *_TnlKey;
+
 #if FEATURE_MESA_program_debug
    GLprogramcallbackMESA Callback;
    GLvoid *CallbackData;
@@ -2127,6 +2152,8 @@ struct gl_shader
    struct gl_program *Program;  /**< Post-compile assembly code */
    GLchar *InfoLog;
    struct gl_sl_pragmas Pragmas;
+   GLuint PendingJobs;      /**< Queued compiles and links using this shader */
+   GLuint PendingCompiles;  /**< Queued compiles of this shader */
 };
 
 
@@ -2155,6 +2182,7 @@ struct gl_shader_program
    GLboolean LinkStatus;   /**< GL_LINK_STATUS */
    GLboolean Validated;
    GLchar *InfoLog;
+   GLuint PendingJobs;     /**< Queued links of this program */
 };   
 
 
@@ -2168,7 +2196,7 @@ struct gl_shader_state
    GLboolean EmitHighLevelInstructions; /**< IF/ELSE/ENDIF vs. BRA, etc. */
    GLboolean EmitCondCodes;             /**< Use condition codes? */
    GLboolean EmitComments;              /**< Annotated instructions */
-   void *MemPool;
+   GLuint PendingJobs;  /**< Queued compiles/links run for this context */
 };
 
 
@@ -2664,6 +2692,8 @@ struct gl_matrix_stack
    GLuint Depth;       /**< 0 <= Depth < MaxDepth */
    GLuint MaxDepth;    /**< size of Stack[] array */
    GLuint DirtyFlag;   /**< _NEW_MODELVIEW or _NEW_PROJECTION, for example */
+   GLmatrix *_Analysed;    /**< array [MaxDepth], last matrix analysed there */
+   GLuint *_AnalysedFrom;  /**< array [MaxDepth], its flags before analysis */
 };
 
 
@@ -2913,6 +2943,9 @@ struct gl_dlist_state
    
    GLubyte ActiveEdgeFlag;
    GLboolean CurrentEdgeFlag;
+
+   GLbitfield KnownAttribs;	/**< CurrentAttrib[] values known to be current */
+   GLenum ShadeModel;		/**< Shade model known to be current, or 0 */
 };
 
 
@@ -2966,6 +2999,8 @@ struct __GLcontextRec
 
    /** Combined modelview and projection matrix */
    GLmatrix _ModelProjectMatrix;
+   /** Projection and modelview matrices _ModelProjectMatrix was built from */
+   GLmatrix _ModelProjectSource[2];
 
    /** \name Display lists */
    struct gl_dlist_state ListState;
@@ -3064,6 +3099,15 @@ struct __GLcontextRec
    GLenum RenderMode;        /**< either GL_RENDER, GL_SELECT, GL_FEEDBACK */
    GLbitfield NewState;      /**< bitwise-or of _NEW_* flags */
 
+   /**
+    * Stamped by _mesa_update_state() with a value which increases with
+    * every update, and for each _NEW_* bit the stamp of the last update
+    * which included it.  Used to tell which program state parameters
+    * need reloading.
+    */
+   GLuint StateStamp;
+   GLuint StateFlagStamp[32];
+
    GLboolean ViewportInitialized;  /**< has viewport size been initialized? */
 
    /** \name Derived state */
@@ -3101,6 +3145,9 @@ struct __GLcontextRec
    /** Core tnl module support */
    struct gl_tnl_module TnlModule;
 
+   /** Threaded command stream, or NULL (see marshal.c) */
+   struct gl_marshal_context *Marshal;
+
    /**
     * \name Hooks for module contexts.  
     *
@@ -3150,7 +3197,8 @@ enum _verbose
    VERBOSE_VERTS		= 0x0800,
    VERBOSE_DISASSEM		= 0x1000,
    VERBOSE_GLSL			= 0x2000,
-   VERBOSE_GLSL_DUMP		= 0x4000
+   VERBOSE_GLSL_DUMP		= 0x4000,
+   VERBOSE_GLSL_MEM		= 0x8000
 };
 
 
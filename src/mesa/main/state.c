@@ -43,6 +43,7 @@
 #if FEATURE_pixel_transfer
 #include "pixel.h"
 #endif
+#include "glapi/glthread.h"
 #include "shader/program.h"
 #include "state.h"
 #include "stencil.h"
@@ -442,6 +443,38 @@ update_tricaps(GLcontext *ctx, GLbitfield new_state)
 #endif
 
 
+/**
+ * Source of __GLcontextRec::StateStamp values.  Shared by all contexts so
+ * that a stamp is never reused, even by a new context which happens to
+ * get the address of a destroyed one.  Contexts may be validated in
+ * different threads, so the counter is protected by a mutex.
+ */
+static GLuint StateStamp = 0;
+_glthread_DECLARE_STATIC_MUTEX(StateStampMutex);
+
+
+/**
+ * Record in the context which _NEW_* flags the current update includes.
+ */
+static void
+stamp_state(GLcontext *ctx, GLbitfield new_state)
+{
+   GLuint i;
+
+   if (!new_state)
+      return;
+
+   _glthread_LOCK_MUTEX(StateStampMutex);
+   ctx->StateStamp = ++StateStamp;
+   _glthread_UNLOCK_MUTEX(StateStampMutex);
+
+   for (i = 0; new_state; i++, new_state >>= 1) {
+      if (new_state & 1)
+         ctx->StateFlagStamp[i] = ctx->StateStamp;
+   }
+}
+
+
 /**
  * Compute derived GL state.
  * If __GLcontextRec::NewState is non-zero then this function \b must
@@ -559,6 +592,7 @@ _mesa_update_state_locked( GLcontext *ctx )
     * Driver.UpdateState() has to call FLUSH_VERTICES().  (fixed?)
     */
    new_state = ctx->NewState | new_prog_state;
+   stamp_state(ctx, new_state);
    ctx->NewState = 0;
    ctx->Driver.UpdateState(ctx, new_state);
    ctx->Array.NewState = 0;
@@ -33,6 +33,7 @@
 #include "main/context.h"
 #include "main/enums.h"
 #include "main/macros.h"
+#include "main/matrix.h"
 #include "main/texgen.h"
 #include "math/m_xform.h"
 
@@ -99,9 +100,7 @@ _mesa_TexGenfv( GLenum coord, GLenum pname, const GLfloat *params )
 	 else if (pname==GL_EYE_PLANE) {
 	    GLfloat tmp[4];
             /* Transform plane equation by the inverse modelview matrix */
-            if (_math_matrix_is_dirty(ctx->ModelviewMatrixStack.Top)) {
-               _math_matrix_analyse( ctx->ModelviewMatrixStack.Top );
-            }
+            _mesa_analyse_stack_top( &ctx->ModelviewMatrixStack );
             _mesa_transform_vector( tmp, params, ctx->ModelviewMatrixStack.Top->inv );
 	    if (TEST_EQ_4V(texUnit->EyePlaneS, tmp))
 	       return;
@@ -152,9 +151,7 @@ _mesa_TexGenfv( GLenum coord, GLenum pname, const GLfloat *params )
 	 else if (pname==GL_EYE_PLANE) {
 	    GLfloat tmp[4];
             /* Transform plane equation by the inverse modelview matrix */
-	    if (_math_matrix_is_dirty(ctx->ModelviewMatrixStack.Top)) {
-               _math_matrix_analyse( ctx->ModelviewMatrixStack.Top );
-            }
+	    _mesa_analyse_stack_top( &ctx->ModelviewMatrixStack );
             _mesa_transform_vector( tmp, params, ctx->ModelviewMatrixStack.Top->inv );
 	    if (TEST_EQ_4V(texUnit->EyePlaneT, tmp))
 		return;
@@ -202,9 +199,7 @@ _mesa_TexGenfv( GLenum coord, GLenum pname, const GLfloat *params )
 	 else if (pname==GL_EYE_PLANE) {
 	    GLfloat tmp[4];
             /* Transform plane equation by the inverse modelview matrix */
-            if (_math_matrix_is_dirty(ctx->ModelviewMatrixStack.Top)) {
-               _math_matrix_analyse( ctx->ModelviewMatrixStack.Top );
-            }
+            _mesa_analyse_stack_top( &ctx->ModelviewMatrixStack );
             _mesa_transform_vector( tmp, params, ctx->ModelviewMatrixStack.Top->inv );
 	    if (TEST_EQ_4V(texUnit->EyePlaneR, tmp))
 	       return;
@@ -246,9 +241,7 @@ _mesa_TexGenfv( GLenum coord, GLenum pname, const GLfloat *params )
 	 else if (pname==GL_EYE_PLANE) {
 	    GLfloat tmp[4];
             /* Transform plane equation by the inverse modelview matrix */
-            if (_math_matrix_is_dirty(ctx->ModelviewMatrixStack.Top)) {
-               _math_matrix_analyse( ctx->ModelviewMatrixStack.Top );
-            }
+            _mesa_analyse_stack_top( &ctx->ModelviewMatrixStack );
             _mesa_transform_vector( tmp, params, ctx->ModelviewMatrixStack.Top->inv );
 	    if (TEST_EQ_4V(texUnit->EyePlaneQ, tmp))
 	       return;
@@ -36,6 +36,7 @@
 #include "context.h"
 #include "enums.h"
 #include "macros.h"
+#include "matrix.h"
 #include "texcompress.h"
 #include "texobj.h"
 #include "teximage.h"
@@ -626,7 +627,7 @@ update_texture_matrices( GLcontext *ctx )
 
    for (i=0; i < ctx->Const.MaxTextureCoordUnits; i++) {
       if (_math_matrix_is_dirty(ctx->TextureMatrixStack[i].Top)) {
-	 _math_matrix_analyse( ctx->TextureMatrixStack[i].Top );
+	 _mesa_analyse_stack_top( &ctx->TextureMatrixStack[i] );
 
 	 if (ctx->Texture.Unit[i]._ReallyEnabled &&
 	     ctx->TextureMatrixStack[i].Top->type != MATRIX_IDENTITY)
@@ -98,6 +98,12 @@
 			    MAT_DIRTY_FLAGS | \
 			    MAT_DIRTY_INVERSE)
 
+/** Is the matrix analysed and known to be of the given type? */
+#define MAT_IS_TYPE(mat, t) \
+   (!((mat)->flags & MAT_DIRTY_TYPE) && (mat)->type == (t))
+
+#define MAT_IS_IDENTITY(mat) MAT_IS_TYPE(mat, MATRIX_IDENTITY)
+
 /*@}*/
 
 
@@ -198,6 +204,32 @@ static void matmul34( GLfloat *product, const GLfloat *a, const GLfloat *b )
    P(3,3) = 1;
 }
 
+/**
+ * Multiply a perspective projection matrix, as built by
+ * _math_matrix_frustum(), by a general matrix.
+ *
+ * Only the seven entries of \p a which may be non-zero for
+ * MATRIX_PERSPECTIVE are used, so this takes 28 multiplications instead
+ * of 64.  \p a is read up front and \p b a column at a time, so
+ * \p product may be either \p a or \p b.
+ */
+static void matmul_perspective( GLfloat *product, const GLfloat *a,
+                                const GLfloat *b )
+{
+   const GLfloat a00 = A(0,0), a02 = A(0,2);
+   const GLfloat a11 = A(1,1), a12 = A(1,2);
+   const GLfloat a22 = A(2,2), a23 = A(2,3);
+   const GLfloat a32 = A(3,2);
+   GLint j;
+   for (j = 0; j < 4; j++) {
+      const GLfloat b0j = B(0,j), b1j = B(1,j), b2j = B(2,j), b3j = B(3,j);
+      P(0,j) = a00 * b0j + a02 * b2j;
+      P(1,j) = a11 * b1j + a12 * b2j;
+      P(2,j) = a22 * b2j + a23 * b3j;
+      P(3,j) = a32 * b2j;
+   }
+}
+
 #undef A
 #undef B
 #undef P
@@ -215,9 +247,13 @@ static void matmul34( GLfloat *product, const GLfloat *a, const GLfloat *b )
  */
 static void matrix_multf( GLmatrix *mat, const GLfloat *m, GLuint flags )
 {
+   const GLboolean identity = MAT_IS_IDENTITY(mat);
+
    mat->flags |= (flags | MAT_DIRTY_TYPE | MAT_DIRTY_INVERSE);
 
-   if (TEST_MAT_FLAGS(mat, MAT_FLAGS_3D))
+   if (identity)
+      MEMCPY( mat->m, m, 16*sizeof(GLfloat) );
+   else if (TEST_MAT_FLAGS(mat, MAT_FLAGS_3D))
       matmul34( mat->m, mat->m, m );
    else
       matmul4( mat->m, mat->m, m );
@@ -230,19 +266,35 @@ static void matrix_multf( GLmatrix *mat, const GLfloat *m, GLuint flags )
  * \param a left matrix.
  * \param b right matrix.
  * 
- * Joins both flags and marks the type and inverse as dirty.  Calls matmul34()
- * if both matrices are 3D, or matmul4() otherwise.
+ * Joins both flags and marks the type and inverse as dirty.  Multiplication
+ * by an analysed identity matrix is a copy; otherwise calls matmul34() if
+ * both matrices are 3D, matmul_perspective() if \p a is a perspective
+ * projection, or matmul4().
  */
 void
 _math_matrix_mul_matrix( GLmatrix *dest, const GLmatrix *a, const GLmatrix *b )
 {
+   const GLboolean a_identity = MAT_IS_IDENTITY(a);
+   const GLboolean b_identity = MAT_IS_IDENTITY(b);
+   const GLboolean a_perspective = MAT_IS_TYPE(a, MATRIX_PERSPECTIVE);
+
    dest->flags = (a->flags |
 		  b->flags |
 		  MAT_DIRTY_TYPE |
 		  MAT_DIRTY_INVERSE);
 
-   if (TEST_MAT_FLAGS(dest, MAT_FLAGS_3D))
+   if (a_identity) {
+      if (dest != b)
+         MEMCPY( dest->m, b->m, 16*sizeof(GLfloat) );
+   }
+   else if (b_identity) {
+      if (dest != a)
+         MEMCPY( dest->m, a->m, 16*sizeof(GLfloat) );
+   }
+   else if (TEST_MAT_FLAGS(dest, MAT_FLAGS_3D))
       matmul34( dest->m, a->m, b->m );
+   else if (a_perspective)
+      matmul_perspective( dest->m, a->m, b->m );
    else
       matmul4( dest->m, a->m, b->m );
 }
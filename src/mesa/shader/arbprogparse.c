@@ -41,6 +41,7 @@
 #include "prog_parameter.h"
 #include "prog_statevars.h"
 #include "prog_instruction.h"
+#include "prog_execute.h"
 
 
 /* For ARB programs, use the NV instruction limits */
@@ -3897,6 +3898,7 @@ _mesa_parse_arb_fragment_program(GLcontext* ctx, GLenum target,
    if (program->Base.Instructions)
       _mesa_free(program->Base.Instructions);
    program->Base.Instructions = ap.Base.Instructions;
+   _mesa_free_decoded_program(&program->Base);
 
    if (program->Base.Parameters)
       _mesa_free_parameter_list(program->Base.Parameters);
@@ -3950,6 +3952,7 @@ _mesa_parse_arb_vertex_program(GLcontext *ctx, GLenum target,
    if (program->Base.Instructions)
       _mesa_free(program->Base.Instructions);
    program->Base.Instructions = ap.Base.Instructions;
+   _mesa_free_decoded_program(&program->Base);
 
    if (program->Base.Parameters)
       _mesa_free_parameter_list(program->Base.Parameters);
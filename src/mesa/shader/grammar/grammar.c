@@ -274,47 +274,78 @@ static const byte *INVALID_REGISTER_NAME =  (byte *) "internal error 1004: inval
 /*static const byte *DUPLICATE_IDENTIFIER =   (byte *) "internal error 1005: identifier '$' already defined";*/
 static const byte *UNREFERENCED_IDENTIFIER =(byte *) "internal error 1006: unreferenced identifier '$'";
 
-static const byte *error_message = NULL;    /* points to one of the error messages above */
-static byte *error_param = NULL;        /* this is inserted into error_message in place of $ */
-static int error_position = -1;
+/*
+    The last error is kept per thread: the port stores a pointer to it with
+    grammar_thread_data_set.  If it cannot be allocated, the shared
+    error_fallback is used instead.
+*/
+typedef struct error_state_
+{
+    const byte *message;    /* points to one of the error messages above */
+    byte *param;            /* this is inserted into message in place of $ */
+    int position;
+} error_state;
+
+static error_state error_fallback = { NULL, NULL, -1 };
 
 static byte *unknown = (byte *) "???";
 
+static error_state *get_error_state (void)
+{
+    error_state *es = (error_state *) grammar_thread_data_get ();
+
+    if (es == NULL)
+    {
+        es = (error_state *) grammar_alloc_malloc (sizeof (error_state));
+        if (es == NULL)
+            return &error_fallback;
+        es->message = NULL;
+        es->param = NULL;
+        es->position = -1;
+        grammar_thread_data_set (es);
+    }
+    return es;
+}
+
 static void clear_last_error (void)
 {
+    error_state *es = get_error_state ();
+
     /* reset error message */
-    error_message = NULL;
+    es->message = NULL;
 
-    /* free error parameter - if error_param is a "???" don't free it - it's static */
-    if (error_param != unknown)
-        mem_free ((void **) (void *) &error_param);
+    /* free error parameter - if param is a "???" don't free it - it's static */
+    if (es->param != unknown)
+        mem_free ((void **) (void *) &es->param);
     else
-        error_param = NULL;
+        es->param = NULL;
 
     /* reset error position */
-    error_position = -1;
+    es->position = -1;
 }
 
 static void set_last_error (const byte *msg, byte *param, int pos)
 {
+    error_state *es = get_error_state ();
+
     /* error message can be set only once */
-    if (error_message != NULL)
+    if (es->message != NULL)
     {
         mem_free ((void **) (void *) &param);
         return;
     }
 
-    error_message = msg;
+    es->message = msg;
 
-    /* if param is NULL, set error_param to unknown ("???") */
+    /* if param is NULL, set error param to unknown ("???") */
     /* note: do not try to strdup the "???" - it may be that we are here because of */
     /* out of memory error so strdup can fail */
     if (param != NULL)
-        error_param = param;
+        es->param = param;
     else
-        error_param = unknown;
+        es->param = unknown;
 
-    error_position = pos;
+    es->position = pos;
 }
 
 /*
@@ -2824,7 +2855,9 @@ grammar grammar_load_from_text (const byte *text)
         return 0;
     }
 
+    grammar_lock ();
     dict_create (&g->di);
+    grammar_unlock ();
     if (g->di == NULL)
     {
         grammar_load_state_destroy (&g);
@@ -2979,7 +3012,9 @@ grammar grammar_load_from_text (const byte *text)
         return 0;
     }
 
+    grammar_lock ();
     dict_append (&g_dicts, g->di);
+    grammar_unlock ();
     id = g->di->m_id;
     g->di = NULL;
 
@@ -2995,7 +3030,9 @@ int grammar_set_reg8 (grammar id, const byte *name, byte value)
 
     clear_last_error ();
 
+    grammar_lock ();
     dict_find (&g_dicts, id, &di);
+    grammar_unlock ();
     if (di == NULL)
     {
         set_last_error (INVALID_GRAMMAR_ID, NULL, -1);
@@ -3024,7 +3061,9 @@ static int _grammar_check (grammar id, const byte *text, byte **prod, unsigned i
 
     clear_last_error ();
 
+    grammar_lock ();
     dict_find (&g_dicts, id, &di);
+    grammar_unlock ();
     if (di == NULL)
     {
         set_last_error (INVALID_GRAMMAR_ID, NULL, -1);
@@ -3108,18 +3147,21 @@ int grammar_destroy (grammar id)
 
     clear_last_error ();
 
+    grammar_lock ();
     while (*di != NULL)
     {
         if ((**di).m_id == id)
         {
             dict *tmp = *di;
             *di = (**di).next;
+            grammar_unlock ();
             dict_destroy (&tmp);
             return 1;
         }
 
         di = &(**di).next;
     }
+    grammar_unlock ();
 
     set_last_error (INVALID_GRAMMAR_ID, NULL, -1);
     return 0;
@@ -3147,8 +3189,9 @@ static void append_character (const char x, byte *text, int *dots_made, int *len
 
 void grammar_get_last_error (byte *text, unsigned int size, int *pos)
 {
+    const error_state *es = get_error_state ();
     int len = 0, dots_made = 0;
-    const byte *p = error_message;
+    const byte *p = es->message;
 
     *text = '\0';
 
@@ -3158,7 +3201,7 @@ void grammar_get_last_error (byte *text, unsigned int size, int *pos)
         {
             if (*p == '$')
             {
-                const byte *r = error_param;
+                const byte *r = es->param;
 
                 while (*r)
                 {
@@ -3174,5 +3217,5 @@ void grammar_get_last_error (byte *text, unsigned int size, int *pos)
         }
     }
 
-    *pos = error_position;
+    *pos = es->position;
 }
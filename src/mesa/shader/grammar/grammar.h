@@ -46,6 +46,15 @@ byte *grammar_string_copy_n (byte *, const byte *, size_t);
 byte *grammar_string_duplicate (const byte *);
 unsigned int grammar_string_length (const byte *);
 
+/*
+    the port serializes access to the list of grammar objects with grammar_lock and
+    grammar_unlock, and keeps one pointer per thread for the last error state
+*/
+void grammar_lock (void);
+void grammar_unlock (void);
+void *grammar_thread_data_get (void);
+void grammar_thread_data_set (void *);
+
 /*
     loads grammar script from null-terminated ASCII <text>
     returns unique grammar id to grammar object
@@ -88,8 +97,8 @@ int grammar_fast_check (grammar id, const byte *text, byte **prod, unsigned int
 int grammar_destroy (grammar id);
 
 /*
-    retrieves last grammar error reported either by grammar_load_from_text, grammar_check
-    or grammar_destroy
+    retrieves last grammar error reported to the calling thread either by
+    grammar_load_from_text, grammar_check or grammar_destroy
     the user allocated <text> buffer receives error description, <pos> points to error position,
     <size> is the size of the text buffer to fill in - it must be at least 4 bytes long,
 */
@@ -62,3 +62,23 @@ byte *grammar_string_duplicate (const byte *src)
     return str;
 }
 
+
+void grammar_lock (void)
+{
+}
+
+void grammar_unlock (void)
+{
+}
+
+static void *thread_data = NULL;
+
+void *grammar_thread_data_get (void)
+{
+    return thread_data;
+}
+
+void grammar_thread_data_set (void *data)
+{
+    thread_data = data;
+}
@@ -29,6 +29,7 @@
  */
 
 #include "grammar_mesa.h"
+#include "glapi/glthread.h"
 
 #define GRAMMAR_PORT_BUILD 1
 #include "grammar.c"
@@ -85,3 +86,45 @@ unsigned int grammar_string_length (const byte *str)
     return (unsigned int)_mesa_strlen ((const char *) str);
 }
 
+
+_glthread_DECLARE_STATIC_MUTEX(GrammarMutex);
+
+void grammar_lock (void)
+{
+    _glthread_LOCK_MUTEX(GrammarMutex);
+}
+
+void grammar_unlock (void)
+{
+    _glthread_UNLOCK_MUTEX(GrammarMutex);
+}
+
+#if defined(THREADS)
+
+static _glthread_TSD GrammarTSD;
+
+void *grammar_thread_data_get (void)
+{
+    return _glthread_GetTSD (&GrammarTSD);
+}
+
+void grammar_thread_data_set (void *data)
+{
+    _glthread_SetTSD (&GrammarTSD, data);
+}
+
+#else
+
+static void *GrammarData = NULL;
+
+void *grammar_thread_data_get (void)
+{
+    return GrammarData;
+}
+
+void grammar_thread_data_set (void *data)
+{
+    GrammarData = data;
+}
+
+#endif
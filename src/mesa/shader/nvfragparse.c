@@ -44,6 +44,7 @@
 #include "program.h"
 #include "prog_parameter.h"
 #include "prog_instruction.h"
+#include "prog_execute.h"
 #include "nvfragparse.h"
 
 
@@ -1554,6 +1555,7 @@ _mesa_parse_nv_fragment_program(GLcontext *ctx, GLenum dstTarget,
          _mesa_free(program->Base.Instructions);
       }
       program->Base.Instructions = newInst;
+      _mesa_free_decoded_program(&program->Base);
       program->Base.NumInstructions = parseState.numInst;
       program->Base.InputsRead = parseState.inputsRead;
       program->Base.OutputsWritten = parseState.outputsWritten;
@@ -44,6 +44,7 @@
 #include "nvprogram.h"
 #include "nvvertparse.h"
 #include "prog_instruction.h"
+#include "prog_execute.h"
 #include "program.h"
 
 
@@ -1391,6 +1392,7 @@ _mesa_parse_nv_vertex_program(GLcontext *ctx, GLenum dstTarget,
          _mesa_free(program->Base.Instructions);
       }
       program->Base.Instructions = newInst;
+      _mesa_free_decoded_program(&program->Base);
       program->Base.InputsRead = parseState.inputsRead;
       if (parseState.isPositionInvariant)
          program->Base.InputsRead |= VERT_BIT_POS;
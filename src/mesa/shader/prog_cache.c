@@ -33,10 +33,19 @@
 #include "shader/program.h"
 
 
+/**
+ * Maximum number of programs kept in a cache.  When full, the least
+ * recently used entry is evicted.
+ */
+#define MAX_CACHE_ITEMS 256
+
+
 struct cache_item
 {
    GLuint hash;
    void *key;
+   GLuint keysize;
+   GLuint last_used;     /**< cache->stamp when last returned/inserted */
    struct gl_program *program;
    struct cache_item *next;
 };
@@ -44,7 +53,12 @@ struct cache_item
 struct gl_program_cache
 {
    struct cache_item **items;
+   struct cache_item *last;   /**< most recent hit, checked first */
    GLuint size, n_items;
+   GLuint stamp;
+
+   /* statistics */
+   GLuint hits, misses, evictions;
 };
 
 
@@ -56,19 +70,20 @@ static GLuint
 hash_key(const void *key, GLuint key_size)
 {
    const GLuint *ikey = (const GLuint *) key;
-   GLuint hash = 0, i;
+   GLuint hash = 2166136261u, i;
 
    assert(key_size >= 4);
 
-   /* Make a slightly better attempt at a hash function:
+   /* FNV-1a over 32-bit words rather than bytes; one multiply per
+    * word, with a final mix so the low bits used for the bucket
+    * index depend on the whole key.
     */
-   for (i = 0; i < key_size / sizeof(*ikey); i++)
-   {
-      hash += ikey[i];
-      hash += (hash << 10);
-      hash ^= (hash >> 6);
+   for (i = 0; i < key_size / sizeof(*ikey); i++) {
+      hash ^= ikey[i];
+      hash *= 16777619u;
    }
 
+   hash ^= hash >> 15;
    return hash;
 }
 
@@ -118,6 +133,43 @@ clear_cache(GLcontext *ctx, struct gl_program_cache *cache)
 
 
    cache->n_items = 0;
+   cache->last = NULL;
+}
+
+
+/**
+ * Remove the least recently used item from the cache.
+ */
+static void
+evict_lru(GLcontext *ctx, struct gl_program_cache *cache)
+{
+   struct cache_item *c, **prev, **lru_prev = NULL;
+   GLuint i;
+
+   for (i = 0; i < cache->size; i++) {
+      for (prev = &cache->items[i]; *prev; prev = &(*prev)->next) {
+         if (!lru_prev ||
+             cache->stamp - (*prev)->last_used >
+             cache->stamp - (*lru_prev)->last_used)
+            lru_prev = prev;
+      }
+   }
+
+   if (!lru_prev)
+      return;
+
+   c = *lru_prev;
+   *lru_prev = c->next;
+
+   if (cache->last == c)
+      cache->last = NULL;
+
+   _mesa_free(c->key);
+   _mesa_reference_program(ctx, &c->program, NULL);
+   _mesa_free(c);
+
+   cache->n_items--;
+   cache->evictions++;
 }
 
 
@@ -142,6 +194,10 @@ _mesa_new_program_cache(void)
 void
 _mesa_delete_program_cache(GLcontext *ctx, struct gl_program_cache *cache)
 {
+   if (MESA_VERBOSE & VERBOSE_STATE)
+      _mesa_debug(ctx, "program cache: %u hits, %u misses, %u evictions\n",
+                  cache->hits, cache->misses, cache->evictions);
+
    clear_cache(ctx, cache);
    _mesa_free(cache->items);
    _mesa_free(cache);
@@ -149,17 +205,34 @@ _mesa_delete_program_cache(GLcontext *ctx, struct gl_program_cache *cache)
 
 
 struct gl_program *
-_mesa_search_program_cache(const struct gl_program_cache *cache,
+_mesa_search_program_cache(struct gl_program_cache *cache,
                            const void *key, GLuint keysize)
 {
-   const GLuint hash = hash_key(key, keysize);
+   GLuint hash;
    struct cache_item *c;
 
+   /* State usually flips between a handful of programs, and most
+    * validations land on the same one as last time.
+    */
+   c = cache->last;
+   if (c && c->keysize == keysize && memcmp(c->key, key, keysize) == 0) {
+      c->last_used = ++cache->stamp;
+      cache->hits++;
+      return c->program;
+   }
+
+   hash = hash_key(key, keysize);
+
    for (c = cache->items[hash % cache->size]; c; c = c->next) {
-      if (c->hash == hash && memcmp(c->key, key, keysize) == 0)
+      if (c->hash == hash && memcmp(c->key, key, keysize) == 0) {
+         c->last_used = ++cache->stamp;
+         cache->last = c;
+         cache->hits++;
 	 return c->program;
+      }
    }
 
+   cache->misses++;
    return NULL;
 }
 
@@ -177,17 +250,18 @@ _mesa_program_cache_insert(GLcontext *ctx,
 
    c->key = _mesa_malloc(keysize);
    memcpy(c->key, key, keysize);
+   c->keysize = keysize;
 
    c->program = program;  /* no refcount change */
+   c->last_used = ++cache->stamp;
 
-   if (cache->n_items > cache->size * 1.5) {
-      if (cache->size < 1000)
-	 rehash(cache);
-      else 
-	 clear_cache(ctx, cache);
-   }
+   if (cache->n_items >= MAX_CACHE_ITEMS)
+      evict_lru(ctx, cache);
+   else if (cache->n_items > cache->size * 1.5)
+      rehash(cache);
 
    cache->n_items++;
    c->next = cache->items[hash % cache->size];
    cache->items[hash % cache->size] = c;
+   cache->last = c;
 }
@@ -69,6 +69,9 @@
 
 static const GLfloat ZeroVec[4] = { 0.0F, 0.0F, 0.0F, 0.0F };
 
+/** Destination for writes to write-only or out-of-range registers */
+static GLfloat DummyReg[4];
+
 
 
 /**
@@ -151,30 +154,29 @@ static INLINE GLfloat *
 get_dst_register_pointer(const struct prog_dst_register *dest,
                          struct gl_program_machine *machine)
 {
-   static GLfloat dummyReg[4];
    GLint reg = dest->Index;
 
    if (dest->RelAddr) {
       /* add address register value to src index/offset */
       reg += machine->AddressReg[0][0];
       if (reg < 0) {
-         return dummyReg;
+         return DummyReg;
       }
    }
 
    switch (dest->File) {
    case PROGRAM_TEMPORARY:
       if (reg >= MAX_PROGRAM_TEMPS)
-         return dummyReg;
+         return DummyReg;
       return machine->Temporaries[reg];
 
    case PROGRAM_OUTPUT:
       if (reg >= MAX_PROGRAM_OUTPUTS)
-         return dummyReg;
+         return DummyReg;
       return machine->Outputs[reg];
 
    case PROGRAM_WRITE_ONLY:
-      return dummyReg;
+      return DummyReg;
 
    default:
       _mesa_problem(NULL,
@@ -186,6 +188,250 @@ get_dst_register_pointer(const struct prog_dst_register *dest,
 
 
 
+/*
+ * Programs are decoded once before they are first executed, so that
+ * fetching an operand doesn't switch on the register file and check its
+ * bounds each time.  A decoded operand is found at a fixed offset in one
+ * of the machine's register banks; registers out of range are moved to
+ * the zero or dummy bank at decode time.  Relative addressing still goes
+ * through get_src/dst_register_pointer().
+ */
+
+#define DECODE_REL_ADDR      0x1  /**< resolve through the address register */
+#define DECODE_NOOP_SWIZZLE  0x2  /**< source swizzle is .xyzw */
+#define DECODE_NO_MODIFIERS  0x4  /**< source has no negate or abs */
+#define DECODE_PLAIN_STORE   0x8  /**< store all of xyzw unconditionally */
+
+
+/** A source operand */
+struct prog_decoded_src
+{
+   GLubyte Bank;         /**< PROG_BANK_x */
+   GLubyte Flags;        /**< DECODE_x flags */
+   GLubyte Swizzle[4];   /**< source component of each result component */
+   GLuint Offset;        /**< in floats from the start of the bank */
+   const struct prog_src_register *Reg;
+};
+
+/** An instruction's operands */
+struct prog_decoded_inst
+{
+   struct prog_decoded_src SrcReg[3];
+   GLubyte DstBank;
+   GLubyte DstFlags;
+   GLuint DstOffset;
+   const struct prog_instruction *Inst;
+};
+
+struct prog_decoded_program
+{
+   /** The instructions and parameter count decoded from */
+   const struct prog_instruction *Instructions;
+   GLuint NumInstructions;
+   GLuint NumParameters;
+
+   struct prog_decoded_inst *Inst;   /**< Array [NumInstructions] */
+};
+
+
+static void
+decode_src_register(const struct gl_program *prog,
+                    const struct prog_src_register *source,
+                    struct prog_decoded_src *d)
+{
+   const GLint reg = source->Index;
+   GLuint bank, size, stride = 4;
+   GLuint i;
+
+   switch (source->File) {
+   case PROGRAM_TEMPORARY:
+      bank = PROG_BANK_TEMPORARY;
+      size = MAX_PROGRAM_TEMPS;
+      break;
+   case PROGRAM_INPUT:
+      bank = PROG_BANK_INPUT;
+      if (prog->Target == GL_VERTEX_PROGRAM_ARB) {
+         size = VERT_ATTRIB_MAX;
+      }
+      else {
+         size = FRAG_ATTRIB_MAX;
+         stride = MAX_WIDTH * 4;
+      }
+      break;
+   case PROGRAM_OUTPUT:
+      bank = PROG_BANK_OUTPUT;
+      size = MAX_PROGRAM_OUTPUTS;
+      break;
+   case PROGRAM_LOCAL_PARAM:
+      bank = PROG_BANK_LOCAL_PARAM;
+      size = MAX_PROGRAM_LOCAL_PARAMS;
+      break;
+   case PROGRAM_ENV_PARAM:
+      bank = PROG_BANK_ENV_PARAM;
+      size = MAX_PROGRAM_ENV_PARAMS;
+      break;
+   case PROGRAM_STATE_VAR:
+   case PROGRAM_CONSTANT:
+   case PROGRAM_UNIFORM:
+   case PROGRAM_NAMED_PARAM:
+      bank = PROG_BANK_PARAM;
+      size = prog->Parameters ? prog->Parameters->NumParameters : 0;
+      break;
+   default:
+      /* includes the unused operands of an instruction */
+      bank = PROG_BANK_ZERO;
+      size = 0;
+   }
+
+   d->Flags = 0;
+   if (source->RelAddr) {
+      d->Flags |= DECODE_REL_ADDR;
+   }
+   else if (reg < 0 || reg >= (GLint) size) {
+      bank = PROG_BANK_ZERO;
+   }
+   d->Bank = bank;
+   d->Offset = (bank == PROG_BANK_ZERO) ? 0 : reg * stride;
+
+   for (i = 0; i < 4; i++)
+      d->Swizzle[i] = GET_SWZ(source->Swizzle, i);
+   if (source->Swizzle == SWIZZLE_NOOP)
+      d->Flags |= DECODE_NOOP_SWIZZLE;
+   if (!source->NegateBase && !source->Abs && !source->NegateAbs)
+      d->Flags |= DECODE_NO_MODIFIERS;
+
+   d->Reg = source;
+}
+
+
+static void
+decode_dst_register(const struct prog_instruction *inst,
+                    struct prog_decoded_inst *d)
+{
+   const struct prog_dst_register *dest = &inst->DstReg;
+   const GLint reg = dest->Index;
+   GLuint bank, size;
+
+   switch (dest->File) {
+   case PROGRAM_TEMPORARY:
+      bank = PROG_BANK_TEMPORARY;
+      size = MAX_PROGRAM_TEMPS;
+      break;
+   case PROGRAM_OUTPUT:
+      bank = PROG_BANK_OUTPUT;
+      size = MAX_PROGRAM_OUTPUTS;
+      break;
+   default:
+      bank = PROG_BANK_DUMMY;
+      size = 0;
+   }
+
+   d->DstFlags = 0;
+   if (dest->RelAddr) {
+      d->DstFlags |= DECODE_REL_ADDR;
+   }
+   else if (reg < 0 || reg >= (GLint) size) {
+      bank = PROG_BANK_DUMMY;
+   }
+   d->DstBank = bank;
+   d->DstOffset = (bank == PROG_BANK_DUMMY) ? 0 : reg * 4;
+
+   if (dest->WriteMask == WRITEMASK_XYZW &&
+       dest->CondMask == COND_TR &&
+       inst->SaturateMode == SATURATE_OFF &&
+       !inst->CondUpdate)
+      d->DstFlags |= DECODE_PLAIN_STORE;
+}
+
+
+/**
+ * Return the decoded form of the program, decoding it if it is new or
+ * its instructions or parameters have changed since.
+ */
+static const struct prog_decoded_program *
+get_decoded_program(const struct gl_program *program)
+{
+   /* the decoded form is a cache, not part of the program's state */
+   struct gl_program *prog = (struct gl_program *) program;
+   struct prog_decoded_program *decoded = prog->Decoded;
+   const GLuint numParams =
+      prog->Parameters ? prog->Parameters->NumParameters : 0;
+   GLuint i, j;
+
+   if (decoded &&
+       decoded->Instructions == prog->Instructions &&
+       decoded->NumInstructions == prog->NumInstructions &&
+       decoded->NumParameters == numParams)
+      return decoded;
+
+   _mesa_free_decoded_program(prog);
+
+   decoded = (struct prog_decoded_program *)
+      _mesa_malloc(sizeof(struct prog_decoded_program) +
+                   prog->NumInstructions * sizeof(struct prog_decoded_inst));
+   if (!decoded)
+      return NULL;
+
+   decoded->Instructions = prog->Instructions;
+   decoded->NumInstructions = prog->NumInstructions;
+   decoded->NumParameters = numParams;
+   decoded->Inst = (struct prog_decoded_inst *) (decoded + 1);
+
+   for (i = 0; i < prog->NumInstructions; i++) {
+      const struct prog_instruction *inst = prog->Instructions + i;
+      struct prog_decoded_inst *d = decoded->Inst + i;
+      for (j = 0; j < 3; j++)
+         decode_src_register(prog, &inst->SrcReg[j], &d->SrcReg[j]);
+      decode_dst_register(inst, d);
+      d->Inst = inst;
+   }
+
+   prog->Decoded = decoded;
+   return decoded;
+}
+
+
+/**
+ * Free the program's decoded instructions.  Called when the program is
+ * deleted, and when its instructions are replaced, since new ones may be
+ * allocated at the address of the old.
+ */
+void
+_mesa_free_decoded_program(struct gl_program *program)
+{
+   if (program->Decoded) {
+      _mesa_free(program->Decoded);
+      program->Decoded = NULL;
+   }
+}
+
+
+/**
+ * Return a pointer to the 4-element float vector of a decoded source.
+ */
+static INLINE const GLfloat *
+get_decoded_src_pointer(const struct prog_decoded_src *source,
+                        const struct gl_program_machine *machine)
+{
+   if (source->Flags & DECODE_REL_ADDR)
+      return get_src_register_pointer(source->Reg, machine);
+   return machine->RegBanks[source->Bank] + source->Offset;
+}
+
+
+/**
+ * Return a pointer to the 4-element float vector of a decoded destination.
+ */
+static INLINE GLfloat *
+get_decoded_dst_pointer(const struct prog_decoded_inst *d,
+                        struct gl_program_machine *machine)
+{
+   if (d->DstFlags & DECODE_REL_ADDR)
+      return get_dst_register_pointer(&d->Inst->DstReg, machine);
+   return machine->RegBanks[d->DstBank] + d->DstOffset;
+}
+
+
 #if FEATURE_MESA_program_debug
 static struct gl_program_machine *CurrentMachine = NULL;
 
@@ -214,28 +460,32 @@ _mesa_get_program_register(GLcontext *ctx, enum register_file file,
  * Fetch a 4-element float vector from the given source register.
  * Apply swizzling and negating as needed.
  */
-static void
-fetch_vector4(const struct prog_src_register *source,
+static INLINE void
+fetch_vector4(const struct prog_decoded_src *decoded,
               const struct gl_program_machine *machine, GLfloat result[4])
 {
-   const GLfloat *src = get_src_register_pointer(source, machine);
+   const struct prog_src_register *source = decoded->Reg;
+   const GLfloat *src = get_decoded_src_pointer(decoded, machine);
    ASSERT(src);
 
-   if (source->Swizzle == SWIZZLE_NOOP) {
+   if (decoded->Flags & DECODE_NOOP_SWIZZLE) {
       /* no swizzling */
       COPY_4V(result, src);
    }
    else {
-      ASSERT(GET_SWZ(source->Swizzle, 0) <= 3);
-      ASSERT(GET_SWZ(source->Swizzle, 1) <= 3);
-      ASSERT(GET_SWZ(source->Swizzle, 2) <= 3);
-      ASSERT(GET_SWZ(source->Swizzle, 3) <= 3);
-      result[0] = src[GET_SWZ(source->Swizzle, 0)];
-      result[1] = src[GET_SWZ(source->Swizzle, 1)];
-      result[2] = src[GET_SWZ(source->Swizzle, 2)];
-      result[3] = src[GET_SWZ(source->Swizzle, 3)];
+      ASSERT(decoded->Swizzle[0] <= 3);
+      ASSERT(decoded->Swizzle[1] <= 3);
+      ASSERT(decoded->Swizzle[2] <= 3);
+      ASSERT(decoded->Swizzle[3] <= 3);
+      result[0] = src[decoded->Swizzle[0]];
+      result[1] = src[decoded->Swizzle[1]];
+      result[2] = src[decoded->Swizzle[2]];
+      result[3] = src[decoded->Swizzle[3]];
    }
 
+   if (decoded->Flags & DECODE_NO_MODIFIERS)
+      return;
+
    if (source->NegateBase) {
       result[0] = -result[0];
       result[1] = -result[1];
@@ -262,25 +512,26 @@ fetch_vector4(const struct prog_src_register *source,
  * Apply swizzling but not negation/abs.
  */
 static void
-fetch_vector4ui(const struct prog_src_register *source,
+fetch_vector4ui(const struct prog_decoded_src *decoded,
                 const struct gl_program_machine *machine, GLuint result[4])
 {
-   const GLuint *src = (GLuint *) get_src_register_pointer(source, machine);
+   const GLuint *src =
+      (const GLuint *) get_decoded_src_pointer(decoded, machine);
    ASSERT(src);
 
-   if (source->Swizzle == SWIZZLE_NOOP) {
+   if (decoded->Flags & DECODE_NOOP_SWIZZLE) {
       /* no swizzling */
       COPY_4V(result, src);
    }
    else {
-      ASSERT(GET_SWZ(source->Swizzle, 0) <= 3);
-      ASSERT(GET_SWZ(source->Swizzle, 1) <= 3);
-      ASSERT(GET_SWZ(source->Swizzle, 2) <= 3);
-      ASSERT(GET_SWZ(source->Swizzle, 3) <= 3);
-      result[0] = src[GET_SWZ(source->Swizzle, 0)];
-      result[1] = src[GET_SWZ(source->Swizzle, 1)];
-      result[2] = src[GET_SWZ(source->Swizzle, 2)];
-      result[3] = src[GET_SWZ(source->Swizzle, 3)];
+      ASSERT(decoded->Swizzle[0] <= 3);
+      ASSERT(decoded->Swizzle[1] <= 3);
+      ASSERT(decoded->Swizzle[2] <= 3);
+      ASSERT(decoded->Swizzle[3] <= 3);
+      result[0] = src[decoded->Swizzle[0]];
+      result[1] = src[decoded->Swizzle[1]];
+      result[2] = src[decoded->Swizzle[2]];
+      result[3] = src[decoded->Swizzle[3]];
    }
 
    /* Note: no NegateBase, Abs, NegateAbs here */
@@ -351,14 +602,18 @@ fetch_vector4_deriv(GLcontext * ctx,
 /**
  * As above, but only return result[0] element.
  */
-static void
-fetch_vector1(const struct prog_src_register *source,
+static INLINE void
+fetch_vector1(const struct prog_decoded_src *decoded,
               const struct gl_program_machine *machine, GLfloat result[4])
 {
-   const GLfloat *src = get_src_register_pointer(source, machine);
+   const struct prog_src_register *source = decoded->Reg;
+   const GLfloat *src = get_decoded_src_pointer(decoded, machine);
    ASSERT(src);
 
-   result[0] = src[GET_SWZ(source->Swizzle, 0)];
+   result[0] = src[decoded->Swizzle[0]];
+
+   if (decoded->Flags & DECODE_NO_MODIFIERS)
+      return;
 
    if (source->NegateBase) {
       result[0] = -result[0];
@@ -383,6 +638,15 @@ fetch_texel(GLcontext *ctx,
             GLfloat color[4])
 {
    const GLuint unit = machine->Samplers[inst->TexSrcUnit];
+   GLuint i;
+
+   /* texels fetched ahead by the caller */
+   for (i = 0; i < machine->NumTexPrefetch; i++) {
+      if (machine->TexPrefetchInst[i] == inst) {
+         COPY_4V(color, machine->TexPrefetch[i][machine->CurElement]);
+         return;
+      }
+   }
 
    /* Note: we only have the right derivatives for fragment input attribs.
     */
@@ -466,15 +730,21 @@ eval_condition(const struct gl_program_machine *machine,
  * Store 4 floats into a register.  Observe the instructions saturate and
  * set-condition-code flags.
  */
-static void
-store_vector4(const struct prog_instruction *inst,
+static INLINE void
+store_vector4(const struct prog_decoded_inst *decoded,
               struct gl_program_machine *machine, const GLfloat value[4])
 {
+   const struct prog_instruction *inst = decoded->Inst;
    const struct prog_dst_register *dstReg = &(inst->DstReg);
    const GLboolean clamp = inst->SaturateMode == SATURATE_ZERO_ONE;
    GLuint writeMask = dstReg->WriteMask;
    GLfloat clampedValue[4];
-   GLfloat *dst = get_dst_register_pointer(dstReg, machine);
+   GLfloat *dst = get_decoded_dst_pointer(decoded, machine);
+
+   if (decoded->DstFlags & DECODE_PLAIN_STORE) {
+      COPY_4V(dst, value);
+      return;
+   }
 
 #if 0
    if (value[0] > 1.0e10 ||
@@ -549,12 +819,13 @@ store_vector4(const struct prog_instruction *inst,
  * Store 4 uints into a register.  Observe the set-condition-code flags.
  */
 static void
-store_vector4ui(const struct prog_instruction *inst,
+store_vector4ui(const struct prog_decoded_inst *decoded,
                 struct gl_program_machine *machine, const GLuint value[4])
 {
+   const struct prog_instruction *inst = decoded->Inst;
    const struct prog_dst_register *dstReg = &(inst->DstReg);
    GLuint writeMask = dstReg->WriteMask;
-   GLuint *dst = (GLuint *) get_dst_register_pointer(dstReg, machine);
+   GLuint *dst = (GLuint *) get_decoded_dst_pointer(decoded, machine);
 
    if (dstReg->CondMask != COND_TR) {
       /* condition codes may turn off some writes */
@@ -625,10 +896,17 @@ _mesa_execute_program(GLcontext * ctx,
 {
    const GLuint numInst = program->NumInstructions;
    const GLuint maxExec = 10000;
+   const struct prog_decoded_program *decoded;
    GLuint pc, numExec = 0;
 
    machine->CurProgram = program;
 
+   decoded = get_decoded_program(program);
+   if (!decoded) {
+      _mesa_error(ctx, GL_OUT_OF_MEMORY, "program execution");
+      return GL_TRUE;
+   }
+
    if (DEBUG_PROG) {
       printf("execute program %u --------------------\n", program->Id);
    }
@@ -644,8 +922,24 @@ _mesa_execute_program(GLcontext * ctx,
       machine->EnvParams = ctx->FragmentProgram.Parameters;
    }
 
+   machine->RegBanks[PROG_BANK_TEMPORARY] = machine->Temporaries[0];
+   if (program->Target == GL_VERTEX_PROGRAM_ARB)
+      machine->RegBanks[PROG_BANK_INPUT] = machine->VertAttribs[0];
+   else
+      machine->RegBanks[PROG_BANK_INPUT] =
+         machine->Attribs[0][machine->CurElement];
+   machine->RegBanks[PROG_BANK_OUTPUT] = machine->Outputs[0];
+   machine->RegBanks[PROG_BANK_LOCAL_PARAM] =
+      (GLfloat *) program->LocalParams[0];
+   machine->RegBanks[PROG_BANK_ENV_PARAM] = machine->EnvParams[0];
+   machine->RegBanks[PROG_BANK_PARAM] = program->Parameters ?
+      (GLfloat *) program->Parameters->ParameterValues : (GLfloat *) ZeroVec;
+   machine->RegBanks[PROG_BANK_ZERO] = (GLfloat *) ZeroVec;
+   machine->RegBanks[PROG_BANK_DUMMY] = DummyReg;
+
    for (pc = 0; pc < numInst; pc++) {
       const struct prog_instruction *inst = program->Instructions + pc;
+      const struct prog_decoded_inst *d = decoded->Inst + pc;
 
 #if FEATURE_MESA_program_debug
       if (ctx->FragmentProgram.CallbackEnabled &&
@@ -664,24 +958,24 @@ _mesa_execute_program(GLcontext * ctx,
       case OPCODE_ABS:
          {
             GLfloat a[4], result[4];
-            fetch_vector4(&inst->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[0], machine, a);
             result[0] = FABSF(a[0]);
             result[1] = FABSF(a[1]);
             result[2] = FABSF(a[2]);
             result[3] = FABSF(a[3]);
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
          }
          break;
       case OPCODE_ADD:
          {
             GLfloat a[4], b[4], result[4];
-            fetch_vector4(&inst->SrcReg[0], machine, a);
-            fetch_vector4(&inst->SrcReg[1], machine, b);
+            fetch_vector4(&d->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[1], machine, b);
             result[0] = a[0] + b[0];
             result[1] = a[1] + b[1];
             result[2] = a[2] + b[2];
             result[3] = a[3] + b[3];
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
             if (DEBUG_PROG) {
                printf("ADD (%g %g %g %g) = (%g %g %g %g) + (%g %g %g %g)\n",
                       result[0], result[1], result[2], result[3],
@@ -692,19 +986,19 @@ _mesa_execute_program(GLcontext * ctx,
       case OPCODE_AND:     /* bitwise AND */
          {
             GLuint a[4], b[4], result[4];
-            fetch_vector4ui(&inst->SrcReg[0], machine, a);
-            fetch_vector4ui(&inst->SrcReg[1], machine, b);
+            fetch_vector4ui(&d->SrcReg[0], machine, a);
+            fetch_vector4ui(&d->SrcReg[1], machine, b);
             result[0] = a[0] & b[0];
             result[1] = a[1] & b[1];
             result[2] = a[2] & b[2];
             result[3] = a[3] & b[3];
-            store_vector4ui(inst, machine, result);
+            store_vector4ui(d, machine, result);
          }
          break;
       case OPCODE_ARL:
          {
             GLfloat t[4];
-            fetch_vector4(&inst->SrcReg[0], machine, t);
+            fetch_vector4(&d->SrcReg[0], machine, t);
             machine->AddressReg[0][0] = IFLOOR(t[0]);
          }
          break;
@@ -744,23 +1038,23 @@ _mesa_execute_program(GLcontext * ctx,
       case OPCODE_CMP:
          {
             GLfloat a[4], b[4], c[4], result[4];
-            fetch_vector4(&inst->SrcReg[0], machine, a);
-            fetch_vector4(&inst->SrcReg[1], machine, b);
-            fetch_vector4(&inst->SrcReg[2], machine, c);
+            fetch_vector4(&d->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[1], machine, b);
+            fetch_vector4(&d->SrcReg[2], machine, c);
             result[0] = a[0] < 0.0F ? b[0] : c[0];
             result[1] = a[1] < 0.0F ? b[1] : c[1];
             result[2] = a[2] < 0.0F ? b[2] : c[2];
             result[3] = a[3] < 0.0F ? b[3] : c[3];
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
          }
          break;
       case OPCODE_COS:
          {
             GLfloat a[4], result[4];
-            fetch_vector1(&inst->SrcReg[0], machine, a);
+            fetch_vector1(&d->SrcReg[0], machine, a);
             result[0] = result[1] = result[2] = result[3]
                = (GLfloat) _mesa_cos(a[0]);
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
          }
          break;
       case OPCODE_DDX:         /* Partial derivative with respect to X */
@@ -768,7 +1062,7 @@ _mesa_execute_program(GLcontext * ctx,
             GLfloat result[4];
             fetch_vector4_deriv(ctx, &inst->SrcReg[0], machine,
                                 'X', result);
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
          }
          break;
       case OPCODE_DDY:         /* Partial derivative with respect to Y */
@@ -776,16 +1070,16 @@ _mesa_execute_program(GLcontext * ctx,
             GLfloat result[4];
             fetch_vector4_deriv(ctx, &inst->SrcReg[0], machine,
                                 'Y', result);
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
          }
          break;
       case OPCODE_DP2:
          {
             GLfloat a[4], b[4], result[4];
-            fetch_vector4(&inst->SrcReg[0], machine, a);
-            fetch_vector4(&inst->SrcReg[1], machine, b);
+            fetch_vector4(&d->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[1], machine, b);
             result[0] = result[1] = result[2] = result[3] = DOT2(a, b);
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
             if (DEBUG_PROG) {
                printf("DP2 %g = (%g %g) . (%g %g)\n",
                       result[0], a[0], a[1], b[0], b[1]);
@@ -795,11 +1089,11 @@ _mesa_execute_program(GLcontext * ctx,
       case OPCODE_DP2A:
          {
             GLfloat a[4], b[4], c, result[4];
-            fetch_vector4(&inst->SrcReg[0], machine, a);
-            fetch_vector4(&inst->SrcReg[1], machine, b);
-            fetch_vector1(&inst->SrcReg[1], machine, &c);
+            fetch_vector4(&d->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[1], machine, b);
+            fetch_vector1(&d->SrcReg[1], machine, &c);
             result[0] = result[1] = result[2] = result[3] = DOT2(a, b) + c;
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
             if (DEBUG_PROG) {
                printf("DP2A %g = (%g %g) . (%g %g) + %g\n",
                       result[0], a[0], a[1], b[0], b[1], c);
@@ -809,10 +1103,10 @@ _mesa_execute_program(GLcontext * ctx,
       case OPCODE_DP3:
          {
             GLfloat a[4], b[4], result[4];
-            fetch_vector4(&inst->SrcReg[0], machine, a);
-            fetch_vector4(&inst->SrcReg[1], machine, b);
+            fetch_vector4(&d->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[1], machine, b);
             result[0] = result[1] = result[2] = result[3] = DOT3(a, b);
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
             if (DEBUG_PROG) {
                printf("DP3 %g = (%g %g %g) . (%g %g %g)\n",
                       result[0], a[0], a[1], a[2], b[0], b[1], b[2]);
@@ -822,10 +1116,10 @@ _mesa_execute_program(GLcontext * ctx,
       case OPCODE_DP4:
          {
             GLfloat a[4], b[4], result[4];
-            fetch_vector4(&inst->SrcReg[0], machine, a);
-            fetch_vector4(&inst->SrcReg[1], machine, b);
+            fetch_vector4(&d->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[1], machine, b);
             result[0] = result[1] = result[2] = result[3] = DOT4(a, b);
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
             if (DEBUG_PROG) {
                printf("DP4 %g = (%g, %g %g %g) . (%g, %g %g %g)\n",
                       result[0], a[0], a[1], a[2], a[3],
@@ -836,28 +1130,28 @@ _mesa_execute_program(GLcontext * ctx,
       case OPCODE_DPH:
          {
             GLfloat a[4], b[4], result[4];
-            fetch_vector4(&inst->SrcReg[0], machine, a);
-            fetch_vector4(&inst->SrcReg[1], machine, b);
+            fetch_vector4(&d->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[1], machine, b);
             result[0] = result[1] = result[2] = result[3] = DOT3(a, b) + b[3];
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
          }
          break;
       case OPCODE_DST:         /* Distance vector */
          {
             GLfloat a[4], b[4], result[4];
-            fetch_vector4(&inst->SrcReg[0], machine, a);
-            fetch_vector4(&inst->SrcReg[1], machine, b);
+            fetch_vector4(&d->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[1], machine, b);
             result[0] = 1.0F;
             result[1] = a[1] * b[1];
             result[2] = a[2];
             result[3] = b[3];
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
          }
          break;
       case OPCODE_EXP:
          {
             GLfloat t[4], q[4], floor_t0;
-            fetch_vector1(&inst->SrcReg[0], machine, t);
+            fetch_vector1(&d->SrcReg[0], machine, t);
             floor_t0 = FLOORF(t[0]);
             if (floor_t0 > FLT_MAX_EXP) {
                SET_POS_INFINITY(q[0]);
@@ -877,38 +1171,38 @@ _mesa_execute_program(GLcontext * ctx,
             }
             q[1] = t[0] - floor_t0;
             q[3] = 1.0F;
-            store_vector4( inst, machine, q );
+            store_vector4(d, machine, q );
          }
          break;
       case OPCODE_EX2:         /* Exponential base 2 */
          {
             GLfloat a[4], result[4];
-            fetch_vector1(&inst->SrcReg[0], machine, a);
+            fetch_vector1(&d->SrcReg[0], machine, a);
             result[0] = result[1] = result[2] = result[3] =
                (GLfloat) _mesa_pow(2.0, a[0]);
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
          }
          break;
       case OPCODE_FLR:
          {
             GLfloat a[4], result[4];
-            fetch_vector4(&inst->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[0], machine, a);
             result[0] = FLOORF(a[0]);
             result[1] = FLOORF(a[1]);
             result[2] = FLOORF(a[2]);
             result[3] = FLOORF(a[3]);
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
          }
          break;
       case OPCODE_FRC:
          {
             GLfloat a[4], result[4];
-            fetch_vector4(&inst->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[0], machine, a);
             result[0] = a[0] - FLOORF(a[0]);
             result[1] = a[1] - FLOORF(a[1]);
             result[2] = a[2] - FLOORF(a[2]);
             result[3] = a[3] - FLOORF(a[3]);
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
          }
          break;
       case OPCODE_IF:
@@ -917,7 +1211,7 @@ _mesa_execute_program(GLcontext * ctx,
             /* eval condition */
             if (inst->SrcReg[0].File != PROGRAM_UNDEFINED) {
                GLfloat a[4];
-               fetch_vector1(&inst->SrcReg[0], machine, a);
+               fetch_vector1(&d->SrcReg[0], machine, a);
                cond = (a[0] != 0.0);
             }
             else {
@@ -953,7 +1247,7 @@ _mesa_execute_program(GLcontext * ctx,
       case OPCODE_KIL:         /* ARB_f_p only */
          {
             GLfloat a[4];
-            fetch_vector4(&inst->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[0], machine, a);
             if (a[0] < 0.0F || a[1] < 0.0F || a[2] < 0.0F || a[3] < 0.0F) {
                return GL_FALSE;
             }
@@ -962,19 +1256,19 @@ _mesa_execute_program(GLcontext * ctx,
       case OPCODE_LG2:         /* log base 2 */
          {
             GLfloat a[4], result[4];
-            fetch_vector1(&inst->SrcReg[0], machine, a);
+            fetch_vector1(&d->SrcReg[0], machine, a);
 	    /* The fast LOG2 macro doesn't meet the precision requirements.
 	     */
             result[0] = result[1] = result[2] = result[3] =
 		(log(a[0]) * 1.442695F);
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
          }
          break;
       case OPCODE_LIT:
          {
             const GLfloat epsilon = 1.0F / 256.0F;      /* from NV VP spec */
             GLfloat a[4], result[4];
-            fetch_vector4(&inst->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[0], machine, a);
             a[0] = MAX2(a[0], 0.0F);
             a[1] = MAX2(a[1], 0.0F);
             /* XXX ARB version clamps a[3], NV version doesn't */
@@ -992,7 +1286,7 @@ _mesa_execute_program(GLcontext * ctx,
                result[2] = 0.0;
             }
             result[3] = 1.0F;
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
             if (DEBUG_PROG) {
                printf("LIT (%g %g %g %g) : (%g %g %g %g)\n",
                       result[0], result[1], result[2], result[3],
@@ -1003,7 +1297,7 @@ _mesa_execute_program(GLcontext * ctx,
       case OPCODE_LOG:
          {
             GLfloat t[4], q[4], abs_t0;
-            fetch_vector1(&inst->SrcReg[0], machine, t);
+            fetch_vector1(&d->SrcReg[0], machine, t);
             abs_t0 = FABSF(t[0]);
             if (abs_t0 != 0.0F) {
                /* Since we really can't handle infinite values on VMS
@@ -1038,20 +1332,20 @@ _mesa_execute_program(GLcontext * ctx,
                SET_NEG_INFINITY(q[2]);
             }
             q[3] = 1.0;
-            store_vector4(inst, machine, q);
+            store_vector4(d, machine, q);
          }
          break;
       case OPCODE_LRP:
          {
             GLfloat a[4], b[4], c[4], result[4];
-            fetch_vector4(&inst->SrcReg[0], machine, a);
-            fetch_vector4(&inst->SrcReg[1], machine, b);
-            fetch_vector4(&inst->SrcReg[2], machine, c);
+            fetch_vector4(&d->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[1], machine, b);
+            fetch_vector4(&d->SrcReg[2], machine, c);
             result[0] = a[0] * b[0] + (1.0F - a[0]) * c[0];
             result[1] = a[1] * b[1] + (1.0F - a[1]) * c[1];
             result[2] = a[2] * b[2] + (1.0F - a[2]) * c[2];
             result[3] = a[3] * b[3] + (1.0F - a[3]) * c[3];
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
             if (DEBUG_PROG) {
                printf("LRP (%g %g %g %g) = (%g %g %g %g), "
                       "(%g %g %g %g), (%g %g %g %g)\n",
@@ -1064,14 +1358,14 @@ _mesa_execute_program(GLcontext * ctx,
       case OPCODE_MAD:
          {
             GLfloat a[4], b[4], c[4], result[4];
-            fetch_vector4(&inst->SrcReg[0], machine, a);
-            fetch_vector4(&inst->SrcReg[1], machine, b);
-            fetch_vector4(&inst->SrcReg[2], machine, c);
+            fetch_vector4(&d->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[1], machine, b);
+            fetch_vector4(&d->SrcReg[2], machine, c);
             result[0] = a[0] * b[0] + c[0];
             result[1] = a[1] * b[1] + c[1];
             result[2] = a[2] * b[2] + c[2];
             result[3] = a[3] * b[3] + c[3];
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
             if (DEBUG_PROG) {
                printf("MAD (%g %g %g %g) = (%g %g %g %g) * "
                       "(%g %g %g %g) + (%g %g %g %g)\n",
@@ -1084,13 +1378,13 @@ _mesa_execute_program(GLcontext * ctx,
       case OPCODE_MAX:
          {
             GLfloat a[4], b[4], result[4];
-            fetch_vector4(&inst->SrcReg[0], machine, a);
-            fetch_vector4(&inst->SrcReg[1], machine, b);
+            fetch_vector4(&d->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[1], machine, b);
             result[0] = MAX2(a[0], b[0]);
             result[1] = MAX2(a[1], b[1]);
             result[2] = MAX2(a[2], b[2]);
             result[3] = MAX2(a[3], b[3]);
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
             if (DEBUG_PROG) {
                printf("MAX (%g %g %g %g) = (%g %g %g %g), (%g %g %g %g)\n",
                       result[0], result[1], result[2], result[3],
@@ -1101,20 +1395,20 @@ _mesa_execute_program(GLcontext * ctx,
       case OPCODE_MIN:
          {
             GLfloat a[4], b[4], result[4];
-            fetch_vector4(&inst->SrcReg[0], machine, a);
-            fetch_vector4(&inst->SrcReg[1], machine, b);
+            fetch_vector4(&d->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[1], machine, b);
             result[0] = MIN2(a[0], b[0]);
             result[1] = MIN2(a[1], b[1]);
             result[2] = MIN2(a[2], b[2]);
             result[3] = MIN2(a[3], b[3]);
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
          }
          break;
       case OPCODE_MOV:
          {
             GLfloat result[4];
-            fetch_vector4(&inst->SrcReg[0], machine, result);
-            store_vector4(inst, machine, result);
+            fetch_vector4(&d->SrcReg[0], machine, result);
+            store_vector4(d, machine, result);
             if (DEBUG_PROG) {
                printf("MOV (%g %g %g %g)\n",
                       result[0], result[1], result[2], result[3]);
@@ -1124,13 +1418,13 @@ _mesa_execute_program(GLcontext * ctx,
       case OPCODE_MUL:
          {
             GLfloat a[4], b[4], result[4];
-            fetch_vector4(&inst->SrcReg[0], machine, a);
-            fetch_vector4(&inst->SrcReg[1], machine, b);
+            fetch_vector4(&d->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[1], machine, b);
             result[0] = a[0] * b[0];
             result[1] = a[1] * b[1];
             result[2] = a[2] * b[2];
             result[3] = a[3] * b[3];
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
             if (DEBUG_PROG) {
                printf("MUL (%g %g %g %g) = (%g %g %g %g) * (%g %g %g %g)\n",
                       result[0], result[1], result[2], result[3],
@@ -1141,44 +1435,44 @@ _mesa_execute_program(GLcontext * ctx,
       case OPCODE_NOISE1:
          {
             GLfloat a[4], result[4];
-            fetch_vector1(&inst->SrcReg[0], machine, a);
+            fetch_vector1(&d->SrcReg[0], machine, a);
             result[0] =
                result[1] =
                result[2] =
                result[3] = _mesa_noise1(a[0]);
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
          }
          break;
       case OPCODE_NOISE2:
          {
             GLfloat a[4], result[4];
-            fetch_vector4(&inst->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[0], machine, a);
             result[0] =
                result[1] =
                result[2] = result[3] = _mesa_noise2(a[0], a[1]);
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
          }
          break;
       case OPCODE_NOISE3:
          {
             GLfloat a[4], result[4];
-            fetch_vector4(&inst->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[0], machine, a);
             result[0] =
                result[1] =
                result[2] =
                result[3] = _mesa_noise3(a[0], a[1], a[2]);
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
          }
          break;
       case OPCODE_NOISE4:
          {
             GLfloat a[4], result[4];
-            fetch_vector4(&inst->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[0], machine, a);
             result[0] =
                result[1] =
                result[2] =
                result[3] = _mesa_noise4(a[0], a[1], a[2], a[3]);
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
          }
          break;
       case OPCODE_NOP:
@@ -1186,19 +1480,19 @@ _mesa_execute_program(GLcontext * ctx,
       case OPCODE_NOT:         /* bitwise NOT */
          {
             GLuint a[4], result[4];
-            fetch_vector4ui(&inst->SrcReg[0], machine, a);
+            fetch_vector4ui(&d->SrcReg[0], machine, a);
             result[0] = ~a[0];
             result[1] = ~a[1];
             result[2] = ~a[2];
             result[3] = ~a[3];
-            store_vector4ui(inst, machine, result);
+            store_vector4ui(d, machine, result);
          }
          break;
       case OPCODE_NRM3:        /* 3-component normalization */
          {
             GLfloat a[4], result[4];
             GLfloat tmp;
-            fetch_vector4(&inst->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[0], machine, a);
             tmp = a[0] * a[0] + a[1] * a[1] + a[2] * a[2];
             if (tmp != 0.0F)
                tmp = INV_SQRTF(tmp);
@@ -1206,14 +1500,14 @@ _mesa_execute_program(GLcontext * ctx,
             result[1] = tmp * a[1];
             result[2] = tmp * a[2];
             result[3] = 0.0;  /* undefined, but prevent valgrind warnings */
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
          }
          break;
       case OPCODE_NRM4:        /* 4-component normalization */
          {
             GLfloat a[4], result[4];
             GLfloat tmp;
-            fetch_vector4(&inst->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[0], machine, a);
             tmp = a[0] * a[0] + a[1] * a[1] + a[2] * a[2] + a[3] * a[3];
             if (tmp != 0.0F)
                tmp = INV_SQRTF(tmp);
@@ -1221,19 +1515,19 @@ _mesa_execute_program(GLcontext * ctx,
             result[1] = tmp * a[1];
             result[2] = tmp * a[2];
             result[3] = tmp * a[3];
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
          }
          break;
       case OPCODE_OR:          /* bitwise OR */
          {
             GLuint a[4], b[4], result[4];
-            fetch_vector4ui(&inst->SrcReg[0], machine, a);
-            fetch_vector4ui(&inst->SrcReg[1], machine, b);
+            fetch_vector4ui(&d->SrcReg[0], machine, a);
+            fetch_vector4ui(&d->SrcReg[1], machine, b);
             result[0] = a[0] | b[0];
             result[1] = a[1] | b[1];
             result[2] = a[2] | b[2];
             result[3] = a[3] | b[3];
-            store_vector4ui(inst, machine, result);
+            store_vector4ui(d, machine, result);
          }
          break;
       case OPCODE_PK2H:        /* pack two 16-bit floats in one 32-bit float */
@@ -1241,21 +1535,21 @@ _mesa_execute_program(GLcontext * ctx,
             GLfloat a[4];
             GLuint result[4];
             GLhalfNV hx, hy;
-            fetch_vector4(&inst->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[0], machine, a);
             hx = _mesa_float_to_half(a[0]);
             hy = _mesa_float_to_half(a[1]);
             result[0] =
             result[1] =
             result[2] =
             result[3] = hx | (hy << 16);
-            store_vector4ui(inst, machine, result);
+            store_vector4ui(d, machine, result);
          }
          break;
       case OPCODE_PK2US:       /* pack two GLushorts into one 32-bit float */
          {
             GLfloat a[4];
             GLuint result[4], usx, usy;
-            fetch_vector4(&inst->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[0], machine, a);
             a[0] = CLAMP(a[0], 0.0F, 1.0F);
             a[1] = CLAMP(a[1], 0.0F, 1.0F);
             usx = IROUND(a[0] * 65535.0F);
@@ -1264,14 +1558,14 @@ _mesa_execute_program(GLcontext * ctx,
             result[1] =
             result[2] =
             result[3] = usx | (usy << 16);
-            store_vector4ui(inst, machine, result);
+            store_vector4ui(d, machine, result);
          }
          break;
       case OPCODE_PK4B:        /* pack four GLbytes into one 32-bit float */
          {
             GLfloat a[4];
             GLuint result[4], ubx, uby, ubz, ubw;
-            fetch_vector4(&inst->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[0], machine, a);
             a[0] = CLAMP(a[0], -128.0F / 127.0F, 1.0F);
             a[1] = CLAMP(a[1], -128.0F / 127.0F, 1.0F);
             a[2] = CLAMP(a[2], -128.0F / 127.0F, 1.0F);
@@ -1284,14 +1578,14 @@ _mesa_execute_program(GLcontext * ctx,
             result[1] =
             result[2] =
             result[3] = ubx | (uby << 8) | (ubz << 16) | (ubw << 24);
-            store_vector4ui(inst, machine, result);
+            store_vector4ui(d, machine, result);
          }
          break;
       case OPCODE_PK4UB:       /* pack four GLubytes into one 32-bit float */
          {
             GLfloat a[4];
             GLuint result[4], ubx, uby, ubz, ubw;
-            fetch_vector4(&inst->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[0], machine, a);
             a[0] = CLAMP(a[0], 0.0F, 1.0F);
             a[1] = CLAMP(a[1], 0.0F, 1.0F);
             a[2] = CLAMP(a[2], 0.0F, 1.0F);
@@ -1304,23 +1598,23 @@ _mesa_execute_program(GLcontext * ctx,
             result[1] =
             result[2] =
             result[3] = ubx | (uby << 8) | (ubz << 16) | (ubw << 24);
-            store_vector4ui(inst, machine, result);
+            store_vector4ui(d, machine, result);
          }
          break;
       case OPCODE_POW:
          {
             GLfloat a[4], b[4], result[4];
-            fetch_vector1(&inst->SrcReg[0], machine, a);
-            fetch_vector1(&inst->SrcReg[1], machine, b);
+            fetch_vector1(&d->SrcReg[0], machine, a);
+            fetch_vector1(&d->SrcReg[1], machine, b);
             result[0] = result[1] = result[2] = result[3]
                = (GLfloat) _mesa_pow(a[0], b[0]);
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
          }
          break;
       case OPCODE_RCP:
          {
             GLfloat a[4], result[4];
-            fetch_vector1(&inst->SrcReg[0], machine, a);
+            fetch_vector1(&d->SrcReg[0], machine, a);
             if (DEBUG_PROG) {
                if (a[0] == 0)
                   printf("RCP(0)\n");
@@ -1328,7 +1622,7 @@ _mesa_execute_program(GLcontext * ctx,
                   printf("RCP(inf)\n");
             }
             result[0] = result[1] = result[2] = result[3] = 1.0F / a[0];
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
          }
          break;
       case OPCODE_RET:         /* return from subroutine (conditional) */
@@ -1343,24 +1637,24 @@ _mesa_execute_program(GLcontext * ctx,
       case OPCODE_RFL:         /* reflection vector */
          {
             GLfloat axis[4], dir[4], result[4], tmpX, tmpW;
-            fetch_vector4(&inst->SrcReg[0], machine, axis);
-            fetch_vector4(&inst->SrcReg[1], machine, dir);
+            fetch_vector4(&d->SrcReg[0], machine, axis);
+            fetch_vector4(&d->SrcReg[1], machine, dir);
             tmpW = DOT3(axis, axis);
             tmpX = (2.0F * DOT3(axis, dir)) / tmpW;
             result[0] = tmpX * axis[0] - dir[0];
             result[1] = tmpX * axis[1] - dir[1];
             result[2] = tmpX * axis[2] - dir[2];
             /* result[3] is never written! XXX enforce in parser! */
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
          }
          break;
       case OPCODE_RSQ:         /* 1 / sqrt() */
          {
             GLfloat a[4], result[4];
-            fetch_vector1(&inst->SrcReg[0], machine, a);
+            fetch_vector1(&d->SrcReg[0], machine, a);
             a[0] = FABSF(a[0]);
             result[0] = result[1] = result[2] = result[3] = INV_SQRTF(a[0]);
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
             if (DEBUG_PROG) {
                printf("RSQ %g = 1/sqrt(|%g|)\n", result[0], a[0]);
             }
@@ -1369,24 +1663,24 @@ _mesa_execute_program(GLcontext * ctx,
       case OPCODE_SCS:         /* sine and cos */
          {
             GLfloat a[4], result[4];
-            fetch_vector1(&inst->SrcReg[0], machine, a);
+            fetch_vector1(&d->SrcReg[0], machine, a);
             result[0] = (GLfloat) _mesa_cos(a[0]);
             result[1] = (GLfloat) _mesa_sin(a[0]);
             result[2] = 0.0;    /* undefined! */
             result[3] = 0.0;    /* undefined! */
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
          }
          break;
       case OPCODE_SEQ:         /* set on equal */
          {
             GLfloat a[4], b[4], result[4];
-            fetch_vector4(&inst->SrcReg[0], machine, a);
-            fetch_vector4(&inst->SrcReg[1], machine, b);
+            fetch_vector4(&d->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[1], machine, b);
             result[0] = (a[0] == b[0]) ? 1.0F : 0.0F;
             result[1] = (a[1] == b[1]) ? 1.0F : 0.0F;
             result[2] = (a[2] == b[2]) ? 1.0F : 0.0F;
             result[3] = (a[3] == b[3]) ? 1.0F : 0.0F;
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
             if (DEBUG_PROG) {
                printf("SEQ (%g %g %g %g) = (%g %g %g %g) == (%g %g %g %g)\n",
                       result[0], result[1], result[2], result[3],
@@ -1398,19 +1692,19 @@ _mesa_execute_program(GLcontext * ctx,
       case OPCODE_SFL:         /* set false, operands ignored */
          {
             static const GLfloat result[4] = { 0.0F, 0.0F, 0.0F, 0.0F };
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
          }
          break;
       case OPCODE_SGE:         /* set on greater or equal */
          {
             GLfloat a[4], b[4], result[4];
-            fetch_vector4(&inst->SrcReg[0], machine, a);
-            fetch_vector4(&inst->SrcReg[1], machine, b);
+            fetch_vector4(&d->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[1], machine, b);
             result[0] = (a[0] >= b[0]) ? 1.0F : 0.0F;
             result[1] = (a[1] >= b[1]) ? 1.0F : 0.0F;
             result[2] = (a[2] >= b[2]) ? 1.0F : 0.0F;
             result[3] = (a[3] >= b[3]) ? 1.0F : 0.0F;
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
             if (DEBUG_PROG) {
                printf("SGE (%g %g %g %g) = (%g %g %g %g) >= (%g %g %g %g)\n",
                       result[0], result[1], result[2], result[3],
@@ -1422,13 +1716,13 @@ _mesa_execute_program(GLcontext * ctx,
       case OPCODE_SGT:         /* set on greater */
          {
             GLfloat a[4], b[4], result[4];
-            fetch_vector4(&inst->SrcReg[0], machine, a);
-            fetch_vector4(&inst->SrcReg[1], machine, b);
+            fetch_vector4(&d->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[1], machine, b);
             result[0] = (a[0] > b[0]) ? 1.0F : 0.0F;
             result[1] = (a[1] > b[1]) ? 1.0F : 0.0F;
             result[2] = (a[2] > b[2]) ? 1.0F : 0.0F;
             result[3] = (a[3] > b[3]) ? 1.0F : 0.0F;
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
             if (DEBUG_PROG) {
                printf("SGT (%g %g %g %g) = (%g %g %g %g) > (%g %g %g %g)\n",
                       result[0], result[1], result[2], result[3],
@@ -1440,22 +1734,22 @@ _mesa_execute_program(GLcontext * ctx,
       case OPCODE_SIN:
          {
             GLfloat a[4], result[4];
-            fetch_vector1(&inst->SrcReg[0], machine, a);
+            fetch_vector1(&d->SrcReg[0], machine, a);
             result[0] = result[1] = result[2] = result[3]
                = (GLfloat) _mesa_sin(a[0]);
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
          }
          break;
       case OPCODE_SLE:         /* set on less or equal */
          {
             GLfloat a[4], b[4], result[4];
-            fetch_vector4(&inst->SrcReg[0], machine, a);
-            fetch_vector4(&inst->SrcReg[1], machine, b);
+            fetch_vector4(&d->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[1], machine, b);
             result[0] = (a[0] <= b[0]) ? 1.0F : 0.0F;
             result[1] = (a[1] <= b[1]) ? 1.0F : 0.0F;
             result[2] = (a[2] <= b[2]) ? 1.0F : 0.0F;
             result[3] = (a[3] <= b[3]) ? 1.0F : 0.0F;
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
             if (DEBUG_PROG) {
                printf("SLE (%g %g %g %g) = (%g %g %g %g) <= (%g %g %g %g)\n",
                       result[0], result[1], result[2], result[3],
@@ -1467,13 +1761,13 @@ _mesa_execute_program(GLcontext * ctx,
       case OPCODE_SLT:         /* set on less */
          {
             GLfloat a[4], b[4], result[4];
-            fetch_vector4(&inst->SrcReg[0], machine, a);
-            fetch_vector4(&inst->SrcReg[1], machine, b);
+            fetch_vector4(&d->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[1], machine, b);
             result[0] = (a[0] < b[0]) ? 1.0F : 0.0F;
             result[1] = (a[1] < b[1]) ? 1.0F : 0.0F;
             result[2] = (a[2] < b[2]) ? 1.0F : 0.0F;
             result[3] = (a[3] < b[3]) ? 1.0F : 0.0F;
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
             if (DEBUG_PROG) {
                printf("SLT (%g %g %g %g) = (%g %g %g %g) < (%g %g %g %g)\n",
                       result[0], result[1], result[2], result[3],
@@ -1485,13 +1779,13 @@ _mesa_execute_program(GLcontext * ctx,
       case OPCODE_SNE:         /* set on not equal */
          {
             GLfloat a[4], b[4], result[4];
-            fetch_vector4(&inst->SrcReg[0], machine, a);
-            fetch_vector4(&inst->SrcReg[1], machine, b);
+            fetch_vector4(&d->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[1], machine, b);
             result[0] = (a[0] != b[0]) ? 1.0F : 0.0F;
             result[1] = (a[1] != b[1]) ? 1.0F : 0.0F;
             result[2] = (a[2] != b[2]) ? 1.0F : 0.0F;
             result[3] = (a[3] != b[3]) ? 1.0F : 0.0F;
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
             if (DEBUG_PROG) {
                printf("SNE (%g %g %g %g) = (%g %g %g %g) != (%g %g %g %g)\n",
                       result[0], result[1], result[2], result[3],
@@ -1503,30 +1797,30 @@ _mesa_execute_program(GLcontext * ctx,
       case OPCODE_SSG:         /* set sign (-1, 0 or +1) */
          {
             GLfloat a[4], result[4];
-            fetch_vector4(&inst->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[0], machine, a);
             result[0] = (GLfloat) ((a[0] > 0.0F) - (a[0] < 0.0F));
             result[1] = (GLfloat) ((a[1] > 0.0F) - (a[1] < 0.0F));
             result[2] = (GLfloat) ((a[2] > 0.0F) - (a[2] < 0.0F));
             result[3] = (GLfloat) ((a[3] > 0.0F) - (a[3] < 0.0F));
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
          }
          break;
       case OPCODE_STR:         /* set true, operands ignored */
          {
             static const GLfloat result[4] = { 1.0F, 1.0F, 1.0F, 1.0F };
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
          }
          break;
       case OPCODE_SUB:
          {
             GLfloat a[4], b[4], result[4];
-            fetch_vector4(&inst->SrcReg[0], machine, a);
-            fetch_vector4(&inst->SrcReg[1], machine, b);
+            fetch_vector4(&d->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[1], machine, b);
             result[0] = a[0] - b[0];
             result[1] = a[1] - b[1];
             result[2] = a[2] - b[2];
             result[3] = a[3] - b[3];
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
             if (DEBUG_PROG) {
                printf("SUB (%g %g %g %g) = (%g %g %g %g) - (%g %g %g %g)\n",
                       result[0], result[1], result[2], result[3],
@@ -1537,11 +1831,12 @@ _mesa_execute_program(GLcontext * ctx,
       case OPCODE_SWZ:         /* extended swizzle */
          {
             const struct prog_src_register *source = &inst->SrcReg[0];
-            const GLfloat *src = get_src_register_pointer(source, machine);
+            const GLfloat *src = get_decoded_src_pointer(&d->SrcReg[0],
+                                                         machine);
             GLfloat result[4];
             GLuint i;
             for (i = 0; i < 4; i++) {
-               const GLuint swz = GET_SWZ(source->Swizzle, i);
+               const GLuint swz = d->SrcReg[0].Swizzle[i];
                if (swz == SWIZZLE_ZERO)
                   result[i] = 0.0;
                else if (swz == SWIZZLE_ONE)
@@ -1554,14 +1849,14 @@ _mesa_execute_program(GLcontext * ctx,
                if (source->NegateBase & (1 << i))
                   result[i] = -result[i];
             }
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
          }
          break;
       case OPCODE_TEX:         /* Both ARB and NV frag prog */
          /* Simple texel lookup */
          {
             GLfloat texcoord[4], color[4];
-            fetch_vector4(&inst->SrcReg[0], machine, texcoord);
+            fetch_vector4(&d->SrcReg[0], machine, texcoord);
 
             fetch_texel(ctx, machine, inst, texcoord, 0.0, color);
 
@@ -1571,7 +1866,7 @@ _mesa_execute_program(GLcontext * ctx,
                       inst->TexSrcUnit,
                       texcoord[0], texcoord[1], texcoord[2], texcoord[3]);
             }
-            store_vector4(inst, machine, color);
+            store_vector4(d, machine, color);
          }
          break;
       case OPCODE_TXB:         /* GL_ARB_fragment_program only */
@@ -1581,7 +1876,7 @@ _mesa_execute_program(GLcontext * ctx,
             const struct gl_texture_unit *texUnit = &ctx->Texture.Unit[unit];
             GLfloat texcoord[4], color[4], lodBias;
 
-            fetch_vector4(&inst->SrcReg[0], machine, texcoord);
+            fetch_vector4(&d->SrcReg[0], machine, texcoord);
 
             /* texcoord[3] is the bias to add to lambda */
             lodBias = texUnit->LodBias + texcoord[3];
@@ -1591,20 +1886,20 @@ _mesa_execute_program(GLcontext * ctx,
 
             fetch_texel(ctx, machine, inst, texcoord, lodBias, color);
 
-            store_vector4(inst, machine, color);
+            store_vector4(d, machine, color);
          }
          break;
       case OPCODE_TXD:         /* GL_NV_fragment_program only */
          /* Texture lookup w/ partial derivatives for LOD */
          {
             GLfloat texcoord[4], dtdx[4], dtdy[4], color[4];
-            fetch_vector4(&inst->SrcReg[0], machine, texcoord);
-            fetch_vector4(&inst->SrcReg[1], machine, dtdx);
-            fetch_vector4(&inst->SrcReg[2], machine, dtdy);
+            fetch_vector4(&d->SrcReg[0], machine, texcoord);
+            fetch_vector4(&d->SrcReg[1], machine, dtdx);
+            fetch_vector4(&d->SrcReg[2], machine, dtdy);
             machine->FetchTexelDeriv(ctx, texcoord, dtdx, dtdy,
                                      0.0, /* lodBias */
                                      inst->TexSrcUnit, color);
-            store_vector4(inst, machine, color);
+            store_vector4(d, machine, color);
          }
          break;
       case OPCODE_TXP:         /* GL_ARB_fragment_program only */
@@ -1612,20 +1907,22 @@ _mesa_execute_program(GLcontext * ctx,
          {
             GLfloat texcoord[4], color[4];
 
-            fetch_vector4(&inst->SrcReg[0], machine, texcoord);
+            fetch_vector4(&d->SrcReg[0], machine, texcoord);
             /* Not so sure about this test - if texcoord[3] is
              * zero, we'd probably be fine except for an ASSERT in
              * IROUND_POS() which gets triggered by the inf values created.
              */
             if (texcoord[3] != 0.0) {
-               texcoord[0] /= texcoord[3];
-               texcoord[1] /= texcoord[3];
-               texcoord[2] /= texcoord[3];
+               /* one reciprocal, as swrast computes it for a whole span */
+               const GLfloat invQ = 1.0F / texcoord[3];
+               texcoord[0] *= invQ;
+               texcoord[1] *= invQ;
+               texcoord[2] *= invQ;
             }
 
             fetch_texel(ctx, machine, inst, texcoord, 0.0, color);
 
-            store_vector4(inst, machine, color);
+            store_vector4(d, machine, color);
          }
          break;
       case OPCODE_TXP_NV:      /* GL_NV_fragment_program only */
@@ -1635,28 +1932,29 @@ _mesa_execute_program(GLcontext * ctx,
          {
             GLfloat texcoord[4], color[4];
 
-            fetch_vector4(&inst->SrcReg[0], machine, texcoord);
+            fetch_vector4(&d->SrcReg[0], machine, texcoord);
             if (inst->TexSrcTarget != TEXTURE_CUBE_INDEX &&
                 texcoord[3] != 0.0) {
-               texcoord[0] /= texcoord[3];
-               texcoord[1] /= texcoord[3];
-               texcoord[2] /= texcoord[3];
+               const GLfloat invQ = 1.0F / texcoord[3];
+               texcoord[0] *= invQ;
+               texcoord[1] *= invQ;
+               texcoord[2] *= invQ;
             }
 
             fetch_texel(ctx, machine, inst, texcoord, 0.0, color);
 
-            store_vector4(inst, machine, color);
+            store_vector4(d, machine, color);
          }
          break;
       case OPCODE_TRUNC:       /* truncate toward zero */
          {
             GLfloat a[4], result[4];
-            fetch_vector4(&inst->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[0], machine, a);
             result[0] = (GLfloat) (GLint) a[0];
             result[1] = (GLfloat) (GLint) a[1];
             result[2] = (GLfloat) (GLint) a[2];
             result[3] = (GLfloat) (GLint) a[3];
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
          }
          break;
       case OPCODE_UP2H:        /* unpack two 16-bit floats */
@@ -1664,12 +1962,12 @@ _mesa_execute_program(GLcontext * ctx,
             GLfloat a[4], result[4];
             const GLuint *rawBits = (const GLuint *) a;
             GLhalfNV hx, hy;
-            fetch_vector1(&inst->SrcReg[0], machine, a);
+            fetch_vector1(&d->SrcReg[0], machine, a);
             hx = rawBits[0] & 0xffff;
             hy = rawBits[0] >> 16;
             result[0] = result[2] = _mesa_half_to_float(hx);
             result[1] = result[3] = _mesa_half_to_float(hy);
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
          }
          break;
       case OPCODE_UP2US:       /* unpack two GLushorts */
@@ -1677,60 +1975,60 @@ _mesa_execute_program(GLcontext * ctx,
             GLfloat a[4], result[4];
             const GLuint *rawBits = (const GLuint *) a;
             GLushort usx, usy;
-            fetch_vector1(&inst->SrcReg[0], machine, a);
+            fetch_vector1(&d->SrcReg[0], machine, a);
             usx = rawBits[0] & 0xffff;
             usy = rawBits[0] >> 16;
             result[0] = result[2] = usx * (1.0f / 65535.0f);
             result[1] = result[3] = usy * (1.0f / 65535.0f);
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
          }
          break;
       case OPCODE_UP4B:        /* unpack four GLbytes */
          {
             GLfloat a[4], result[4];
             const GLuint *rawBits = (const GLuint *) a;
-            fetch_vector1(&inst->SrcReg[0], machine, a);
+            fetch_vector1(&d->SrcReg[0], machine, a);
             result[0] = (((rawBits[0] >> 0) & 0xff) - 128) / 127.0F;
             result[1] = (((rawBits[0] >> 8) & 0xff) - 128) / 127.0F;
             result[2] = (((rawBits[0] >> 16) & 0xff) - 128) / 127.0F;
             result[3] = (((rawBits[0] >> 24) & 0xff) - 128) / 127.0F;
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
          }
          break;
       case OPCODE_UP4UB:       /* unpack four GLubytes */
          {
             GLfloat a[4], result[4];
             const GLuint *rawBits = (const GLuint *) a;
-            fetch_vector1(&inst->SrcReg[0], machine, a);
+            fetch_vector1(&d->SrcReg[0], machine, a);
             result[0] = ((rawBits[0] >> 0) & 0xff) / 255.0F;
             result[1] = ((rawBits[0] >> 8) & 0xff) / 255.0F;
             result[2] = ((rawBits[0] >> 16) & 0xff) / 255.0F;
             result[3] = ((rawBits[0] >> 24) & 0xff) / 255.0F;
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
          }
          break;
       case OPCODE_XOR:         /* bitwise XOR */
          {
             GLuint a[4], b[4], result[4];
-            fetch_vector4ui(&inst->SrcReg[0], machine, a);
-            fetch_vector4ui(&inst->SrcReg[1], machine, b);
+            fetch_vector4ui(&d->SrcReg[0], machine, a);
+            fetch_vector4ui(&d->SrcReg[1], machine, b);
             result[0] = a[0] ^ b[0];
             result[1] = a[1] ^ b[1];
             result[2] = a[2] ^ b[2];
             result[3] = a[3] ^ b[3];
-            store_vector4ui(inst, machine, result);
+            store_vector4ui(d, machine, result);
          }
          break;
       case OPCODE_XPD:         /* cross product */
          {
             GLfloat a[4], b[4], result[4];
-            fetch_vector4(&inst->SrcReg[0], machine, a);
-            fetch_vector4(&inst->SrcReg[1], machine, b);
+            fetch_vector4(&d->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[1], machine, b);
             result[0] = a[1] * b[2] - a[2] * b[1];
             result[1] = a[2] * b[0] - a[0] * b[2];
             result[2] = a[0] * b[1] - a[1] * b[0];
             result[3] = 1.0;
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
             if (DEBUG_PROG) {
                printf("XPD (%g %g %g %g) = (%g %g %g) X (%g %g %g)\n",
                       result[0], result[1], result[2], result[3],
@@ -1741,21 +2039,21 @@ _mesa_execute_program(GLcontext * ctx,
       case OPCODE_X2D:         /* 2-D matrix transform */
          {
             GLfloat a[4], b[4], c[4], result[4];
-            fetch_vector4(&inst->SrcReg[0], machine, a);
-            fetch_vector4(&inst->SrcReg[1], machine, b);
-            fetch_vector4(&inst->SrcReg[2], machine, c);
+            fetch_vector4(&d->SrcReg[0], machine, a);
+            fetch_vector4(&d->SrcReg[1], machine, b);
+            fetch_vector4(&d->SrcReg[2], machine, c);
             result[0] = a[0] + b[0] * c[0] + b[1] * c[1];
             result[1] = a[1] + b[0] * c[2] + b[1] * c[3];
             result[2] = a[2] + b[0] * c[0] + b[1] * c[1];
             result[3] = a[3] + b[0] * c[2] + b[1] * c[3];
-            store_vector4(inst, machine, result);
+            store_vector4(d, machine, result);
          }
          break;
       case OPCODE_PRINT:
          {
             if (inst->SrcReg[0].File != -1) {
                GLfloat a[4];
-               fetch_vector4(&inst->SrcReg[0], machine, a);
+               fetch_vector4(&d->SrcReg[0], machine, a);
                _mesa_printf("%s%g, %g, %g, %g\n", (const char *) inst->Data,
                             a[0], a[1], a[2], a[3]);
             }
@@ -28,6 +28,10 @@
 #include "main/config.h"
 
 
+/** Max number of texture instructions with texels fetched ahead */
+#define MAX_PROGRAM_TEX_PREFETCH 4
+
+
 typedef void (*FetchTexelLodFunc)(GLcontext *ctx, const GLfloat texcoord[4],
                                   GLfloat lambda, GLuint unit, GLfloat color[4]);
 
@@ -38,6 +42,23 @@ typedef void (*FetchTexelDerivFunc)(GLcontext *ctx, const GLfloat texcoord[4],
                                     GLuint unit, GLfloat color[4]);
 
 
+/**
+ * Register banks which decoded program operands are addressed in.
+ */
+enum prog_register_bank
+{
+   PROG_BANK_TEMPORARY,
+   PROG_BANK_INPUT,
+   PROG_BANK_OUTPUT,
+   PROG_BANK_LOCAL_PARAM,
+   PROG_BANK_ENV_PARAM,
+   PROG_BANK_PARAM,      /**< state vars, constants, uniforms, named params */
+   PROG_BANK_ZERO,       /**< out-of-range or invalid source registers */
+   PROG_BANK_DUMMY,      /**< write-only or invalid destination registers */
+   PROG_NUM_BANKS
+};
+
+
 /**
  * Virtual machine state used during execution of vertex/fragment programs.
  */
@@ -69,6 +90,17 @@ struct gl_program_machine
    /** Texture fetch functions */
    FetchTexelLodFunc FetchTexelLod;
    FetchTexelDerivFunc FetchTexelDeriv;
+
+   /**
+    * Texels which the texture instructions TexPrefetchInst[i] return,
+    * fetched ahead for all elements in TexPrefetch[i][element].
+    */
+   GLuint NumTexPrefetch;
+   const struct prog_instruction *TexPrefetchInst[MAX_PROGRAM_TEX_PREFETCH];
+   GLfloat (*TexPrefetch[MAX_PROGRAM_TEX_PREFETCH])[4];
+
+   /** Base address of each register bank, set by _mesa_execute_program() */
+   GLfloat *RegBanks[PROG_NUM_BANKS];
 };
 
 
@@ -76,6 +108,9 @@ extern void
 _mesa_get_program_register(GLcontext *ctx, enum register_file file,
                            GLuint index, GLfloat val[4]);
 
+extern void
+_mesa_free_decoded_program(struct gl_program *program);
+
 extern GLboolean
 _mesa_execute_program(GLcontext *ctx,
                       const struct gl_program *program,
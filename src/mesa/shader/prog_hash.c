@@ -0,0 +1,258 @@
+/*
+ * Mesa 3-D graphics library
+ * Version:  7.4
+ *
+ * Copyright (C) 2009  VMware, Inc.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * BRIAN PAUL BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file prog_hash.c
+ * Hash from 32-bit keys to array indexes, used to speed up searches of
+ * parameter and uniform lists.
+ *
+ * The table only narrows a search down to candidate indexes; the caller
+ * still compares the array entries themselves, so keys may collide and
+ * an index may be inserted under a key it no longer matches.  The
+ * indexes stored under a key are returned in increasing order, so the
+ * first candidate which compares equal is the same entry that a linear
+ * search of the array would find.
+ */
+
+
+#include "main/glheader.h"
+#include "main/imports.h"
+#include "prog_hash.h"
+
+
+#define INITIAL_SIZE 16   /* must be a power of two */
+
+
+struct index_entry
+{
+   GLuint key;
+   GLint index;
+   GLint next;        /**< next entry in the bucket, or -1 */
+};
+
+struct gl_index_hash
+{
+   GLint *heads;      /**< Array [size] of first entry in bucket, or -1 */
+   GLint *tails;      /**< Array [size] of last entry in bucket, or -1 */
+   GLuint size;
+   struct index_entry *entries;
+   GLuint numEntries, maxEntries;
+};
+
+
+/**
+ * Link entry e into its bucket, which is kept sorted by index.
+ */
+static void
+link_entry(struct gl_index_hash *hash, GLint e)
+{
+   struct index_entry *entries = hash->entries;
+   const GLuint b = entries[e].key & (hash->size - 1);
+   GLint prev = hash->tails[b], cur;
+
+   if (prev >= 0 && entries[prev].index > entries[e].index) {
+      /* not the largest index in the bucket: search for its place */
+      prev = -1;
+      for (cur = hash->heads[b];
+           entries[cur].index <= entries[e].index;
+           cur = entries[cur].next)
+         prev = cur;
+      entries[e].next = cur;
+   }
+   else {
+      entries[e].next = -1;
+      hash->tails[b] = e;
+   }
+
+   if (prev >= 0)
+      entries[prev].next = e;
+   else
+      hash->heads[b] = e;
+}
+
+
+/**
+ * Allocate the bucket arrays for the given size and link all entries.
+ */
+static GLboolean
+rehash(struct gl_index_hash *hash, GLuint size)
+{
+   GLint *heads = (GLint *) _mesa_malloc(2 * size * sizeof(GLint));
+   GLuint i;
+
+   if (!heads)
+      return GL_FALSE;
+
+   _mesa_free(hash->heads);
+   hash->heads = heads;
+   hash->tails = heads + size;
+   hash->size = size;
+
+   for (i = 0; i < 2 * size; i++)
+      heads[i] = -1;
+
+   for (i = 0; i < hash->numEntries; i++)
+      link_entry(hash, i);
+
+   return GL_TRUE;
+}
+
+
+struct gl_index_hash *
+_mesa_new_index_hash(void)
+{
+   struct gl_index_hash *hash = CALLOC_STRUCT(gl_index_hash);
+   if (hash && !rehash(hash, INITIAL_SIZE)) {
+      _mesa_free(hash);
+      return NULL;
+   }
+   return hash;
+}
+
+
+void
+_mesa_free_index_hash(struct gl_index_hash *hash)
+{
+   if (hash) {
+      _mesa_free(hash->heads);
+      _mesa_free(hash->entries);
+      _mesa_free(hash);
+   }
+}
+
+
+/**
+ * Add index to the hash under the given key.  Inserting the same key and
+ * index again is a no-op.
+ * \return GL_FALSE if out of memory, in which case the hash is unchanged.
+ */
+GLboolean
+_mesa_index_hash_insert(struct gl_index_hash *hash, GLuint key, GLint index)
+{
+   const GLint tail = hash->tails[key & (hash->size - 1)];
+   GLint iter, i;
+
+   if (tail >= 0 && hash->entries[tail].index >= index) {
+      /* usually indexes are added in increasing order and this is skipped */
+      for (i = _mesa_index_hash_first(hash, key, &iter);
+           i >= 0 && i <= index;
+           i = _mesa_index_hash_next(hash, key, &iter)) {
+         if (i == index)
+            return GL_TRUE;
+      }
+   }
+
+   if (hash->numEntries == hash->maxEntries) {
+      const GLuint max = hash->maxEntries ? 2 * hash->maxEntries : INITIAL_SIZE;
+      struct index_entry *entries = (struct index_entry *)
+         _mesa_realloc(hash->entries,
+                       hash->maxEntries * sizeof(struct index_entry),
+                       max * sizeof(struct index_entry));
+      if (!entries)
+         return GL_FALSE;
+      hash->entries = entries;
+      hash->maxEntries = max;
+   }
+
+   hash->entries[hash->numEntries].key = key;
+   hash->entries[hash->numEntries].index = index;
+   hash->numEntries++;
+
+   if (hash->numEntries > hash->size) {
+      /* keep the buckets about one entry long */
+      if (rehash(hash, 2 * hash->size))
+         return GL_TRUE;
+   }
+
+   link_entry(hash, hash->numEntries - 1);
+   return GL_TRUE;
+}
+
+
+/**
+ * Return the smallest index inserted under key, or -1 if none.
+ * \param iter  returns the position to continue from with
+ *              _mesa_index_hash_next()
+ */
+GLint
+_mesa_index_hash_first(const struct gl_index_hash *hash, GLuint key,
+                       GLint *iter)
+{
+   *iter = hash->heads[key & (hash->size - 1)];
+   while (*iter >= 0 && hash->entries[*iter].key != key)
+      *iter = hash->entries[*iter].next;
+   return *iter >= 0 ? hash->entries[*iter].index : -1;
+}
+
+
+/**
+ * Return the next larger index inserted under key, or -1 if no more.
+ */
+GLint
+_mesa_index_hash_next(const struct gl_index_hash *hash, GLuint key,
+                      GLint *iter)
+{
+   if (*iter < 0)
+      return -1;
+   do {
+      *iter = hash->entries[*iter].next;
+   } while (*iter >= 0 && hash->entries[*iter].key != key);
+   return *iter >= 0 ? hash->entries[*iter].index : -1;
+}
+
+
+/**
+ * Hash a string.
+ * \param len  number of chars, or -1 if str is null-terminated
+ */
+GLuint
+_mesa_hash_string(const char *str, GLint len)
+{
+   GLuint hash = 2166136261u;
+   GLint i;
+
+   for (i = 0; len < 0 ? str[i] != 0 : i < len; i++) {
+      hash ^= (GLubyte) str[i];
+      hash *= 16777619u;
+   }
+
+   hash ^= hash >> 15;
+   return hash;
+}
+
+
+/**
+ * Hash a float such that values which compare equal hash equal.
+ */
+GLuint
+_mesa_hash_float(GLfloat f)
+{
+   fi_type fi;
+   GLuint hash;
+
+   fi.f = (f == 0.0F) ? 0.0F : f;   /* -0 == +0 */
+   hash = (GLuint) fi.i * 2654435761u;
+   hash ^= hash >> 16;
+   return hash;
+}
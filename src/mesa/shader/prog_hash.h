@@ -0,0 +1,62 @@
+/*
+ * Mesa 3-D graphics library
+ * Version:  7.4
+ *
+ * Copyright (C) 2009  VMware, Inc.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * BRIAN PAUL BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef PROG_HASH_H
+#define PROG_HASH_H
+
+
+#include "main/mtypes.h"
+
+
+/** Opaque type */
+struct gl_index_hash;
+
+
+extern struct gl_index_hash *
+_mesa_new_index_hash(void);
+
+extern void
+_mesa_free_index_hash(struct gl_index_hash *hash);
+
+extern GLboolean
+_mesa_index_hash_insert(struct gl_index_hash *hash, GLuint key, GLint index);
+
+extern GLint
+_mesa_index_hash_first(const struct gl_index_hash *hash, GLuint key,
+                       GLint *iter);
+
+extern GLint
+_mesa_index_hash_next(const struct gl_index_hash *hash, GLuint key,
+                      GLint *iter);
+
+
+extern GLuint
+_mesa_hash_string(const char *str, GLint len);
+
+extern GLuint
+_mesa_hash_float(GLfloat f);
+
+
+#endif /* PROG_HASH_H */
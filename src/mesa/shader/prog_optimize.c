@@ -0,0 +1,1006 @@
+/*
+ * Mesa 3-D graphics library
+ * Version:  7.4
+ *
+ * Copyright (C) 2009  VMware, Inc.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * BRIAN PAUL BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/**
+ * \file prog_optimize.c
+ * Optimization passes over a program's instruction list.
+ *
+ * The GLSL code generator puts most expression results into fresh
+ * temporaries and then MOVes them into place.  The passes here clean
+ * that up after linking:
+ *
+ *  - instructions whose operands are all constants are folded into a MOV
+ *  - MOV results are propagated into later reads in the same basic block
+ *  - writes to temporaries which are never read are removed
+ *  - "OP t, ...; MOV dst, t;" pairs become "OP dst, ...;"
+ *  - the remaining temporaries are renumbered without gaps
+ *
+ * Programs which use subroutines, BRA or relative addressing of
+ * temporaries are left alone.
+ */
+
+
+#include "main/glheader.h"
+#include "main/context.h"
+#include "main/imports.h"
+#include "main/macros.h"
+#include "prog_instruction.h"
+#include "prog_optimize.h"
+#include "prog_parameter.h"
+#include "prog_print.h"
+
+
+/**
+ * Does the given opcode start or end a basic block?
+ */
+static GLboolean
+is_flow_control(gl_inst_opcode opcode)
+{
+   switch (opcode) {
+   case OPCODE_BGNLOOP:
+   case OPCODE_BGNSUB:
+   case OPCODE_BRA:
+   case OPCODE_BRK:
+   case OPCODE_CAL:
+   case OPCODE_CONT:
+   case OPCODE_ELSE:
+   case OPCODE_END:
+   case OPCODE_ENDIF:
+   case OPCODE_ENDLOOP:
+   case OPCODE_ENDSUB:
+   case OPCODE_IF:
+   case OPCODE_RET:
+      return GL_TRUE;
+   default:
+      return GL_FALSE;
+   }
+}
+
+
+/**
+ * Check that the program only uses constructs the passes below handle.
+ */
+static GLboolean
+can_optimize(const struct gl_program *prog)
+{
+   GLuint i, j;
+
+   for (i = 0; i < prog->NumInstructions; i++) {
+      const struct prog_instruction *inst = prog->Instructions + i;
+      const GLuint numSrc = _mesa_num_inst_src_regs(inst->Opcode);
+
+      switch (inst->Opcode) {
+      case OPCODE_BGNSUB:
+      case OPCODE_BRA:
+      case OPCODE_CAL:
+      case OPCODE_ENDSUB:
+      case OPCODE_PRINT:
+      case OPCODE_RET:
+         return GL_FALSE;
+      default:
+         ;
+      }
+
+      for (j = 0; j < numSrc; j++) {
+         const struct prog_src_register *src = inst->SrcReg + j;
+         if (src->File == PROGRAM_TEMPORARY &&
+             (src->RelAddr || src->Index < 0 ||
+              src->Index >= MAX_PROGRAM_TEMPS))
+            return GL_FALSE;
+      }
+
+      if (_mesa_num_inst_dst_regs(inst->Opcode) &&
+          inst->DstReg.File == PROGRAM_TEMPORARY &&
+          (inst->DstReg.RelAddr || inst->DstReg.Index >= MAX_PROGRAM_TEMPS))
+         return GL_FALSE;
+   }
+
+   return GL_TRUE;
+}
+
+
+/**
+ * Return the mask of swizzle positions (X=1, Y=2, Z=4, W=8) which the
+ * instruction actually uses from the given source register.
+ */
+static GLuint
+get_src_read_mask(const struct prog_instruction *inst, GLuint src)
+{
+   switch (inst->Opcode) {
+   case OPCODE_ABS:
+   case OPCODE_ADD:
+   case OPCODE_CMP:
+   case OPCODE_FLR:
+   case OPCODE_FRC:
+   case OPCODE_LRP:
+   case OPCODE_MAD:
+   case OPCODE_MAX:
+   case OPCODE_MIN:
+   case OPCODE_MOV:
+   case OPCODE_MUL:
+   case OPCODE_SEQ:
+   case OPCODE_SGE:
+   case OPCODE_SGT:
+   case OPCODE_SLE:
+   case OPCODE_SLT:
+   case OPCODE_SNE:
+   case OPCODE_SSG:
+   case OPCODE_SUB:
+   case OPCODE_TRUNC:
+      /* component-wise */
+      return inst->DstReg.WriteMask;
+   case OPCODE_DP2:
+      return WRITEMASK_XY;
+   case OPCODE_DP3:
+   case OPCODE_XPD:
+      return WRITEMASK_XYZ;
+   case OPCODE_DPH:
+      return src == 0 ? WRITEMASK_XYZ : WRITEMASK_XYZW;
+   case OPCODE_COS:
+   case OPCODE_EX2:
+   case OPCODE_LG2:
+   case OPCODE_POW:
+   case OPCODE_RCP:
+   case OPCODE_RSQ:
+   case OPCODE_SIN:
+      /* scalar */
+      return WRITEMASK_X;
+   default:
+      return WRITEMASK_XYZW;
+   }
+}
+
+
+/**
+ * Return the mask of register components which the instruction reads
+ * from the given source register, i.e. get_src_read_mask() run through
+ * the source swizzle.
+ */
+static GLuint
+get_reg_read_mask(const struct prog_instruction *inst, GLuint src)
+{
+   const GLuint mask = get_src_read_mask(inst, src);
+   GLuint chan, regMask = 0x0;
+
+   for (chan = 0; chan < 4; chan++) {
+      if (mask & (1 << chan)) {
+         const GLuint swz = GET_SWZ(inst->SrcReg[src].Swizzle, chan);
+         if (swz <= SWIZZLE_W)
+            regMask |= 1 << swz;
+      }
+   }
+
+   return regMask;
+}
+
+
+/**
+ * Does the instruction write to the given register?
+ */
+static GLboolean
+writes_register(const struct prog_instruction *inst,
+                GLuint file, GLint index)
+{
+   return _mesa_num_inst_dst_regs(inst->Opcode) > 0 &&
+          inst->DstReg.File == file &&
+          (inst->DstReg.RelAddr || (GLint) inst->DstReg.Index == index);
+}
+
+
+/**
+ * Is this a plain "MOV dst, src" (no saturation, condition codes,
+ * relative addressing or absolute value)?
+ */
+static GLboolean
+is_simple_move(const struct prog_instruction *inst)
+{
+   const struct prog_src_register *src = &inst->SrcReg[0];
+   GLuint chan;
+
+   if (inst->Opcode != OPCODE_MOV ||
+       inst->CondUpdate ||
+       inst->SaturateMode != SATURATE_OFF ||
+       inst->DstReg.CondMask != COND_TR ||
+       inst->DstReg.RelAddr ||
+       src->RelAddr ||
+       src->Abs ||
+       src->NegateAbs ||
+       (src->NegateBase != NEGATE_NONE && src->NegateBase != NEGATE_XYZW))
+      return GL_FALSE;
+
+   for (chan = 0; chan < 4; chan++) {
+      if ((inst->DstReg.WriteMask & (1 << chan)) &&
+          GET_SWZ(src->Swizzle, chan) > SWIZZLE_W)
+         return GL_FALSE;
+   }
+
+   return GL_TRUE;
+}
+
+
+/**
+ * Is this a MOV of a temporary onto itself (which copy propagation
+ * leaves behind)?
+ */
+static GLboolean
+is_self_move(const struct prog_instruction *inst)
+{
+   const struct prog_src_register *src = &inst->SrcReg[0];
+   GLuint chan;
+
+   if (!is_simple_move(inst) ||
+       src->File != inst->DstReg.File ||
+       src->Index != (GLint) inst->DstReg.Index ||
+       src->NegateBase != NEGATE_NONE)
+      return GL_FALSE;
+
+   for (chan = 0; chan < 4; chan++) {
+      if ((inst->DstReg.WriteMask & (1 << chan)) &&
+          GET_SWZ(src->Swizzle, chan) != chan)
+         return GL_FALSE;
+   }
+
+   return GL_TRUE;
+}
+
+
+/**
+ * Return 1 + the highest temporary register index used by the program.
+ */
+static GLuint
+count_temporaries(const struct gl_program *prog)
+{
+   GLuint i, j;
+   GLint maxIndex = -1;
+
+   for (i = 0; i < prog->NumInstructions; i++) {
+      const struct prog_instruction *inst = prog->Instructions + i;
+      const GLuint numSrc = _mesa_num_inst_src_regs(inst->Opcode);
+      for (j = 0; j < numSrc; j++) {
+         if (inst->SrcReg[j].File == PROGRAM_TEMPORARY)
+            maxIndex = MAX2(maxIndex, inst->SrcReg[j].Index);
+      }
+      if (_mesa_num_inst_dst_regs(inst->Opcode) &&
+          inst->DstReg.File == PROGRAM_TEMPORARY)
+         maxIndex = MAX2(maxIndex, (GLint) inst->DstReg.Index);
+   }
+
+   return (GLuint) (maxIndex + 1);
+}
+
+
+/**
+ * Remove the flagged instructions from the program, fixing up branch
+ * targets.
+ * \return number of instructions removed
+ */
+static GLuint
+remove_instructions(struct gl_program *prog, const GLboolean *removeFlags)
+{
+   const GLuint numInst = prog->NumInstructions;
+   GLint *newIndex;
+   GLuint i, j;
+
+   newIndex = (GLint *) _mesa_malloc((numInst + 1) * sizeof(GLint));
+   if (!newIndex)
+      return 0;
+
+   for (i = 0, j = 0; i < numInst; i++) {
+      newIndex[i] = j;
+      if (!removeFlags[i])
+         j++;
+   }
+   newIndex[numInst] = j;
+
+   if (j == numInst) {
+      _mesa_free(newIndex);
+      return 0;
+   }
+
+   /* Removed instructions are never branch targets (those are all flow
+    * control instructions) so every target maps onto a kept instruction.
+    */
+   for (i = 0, j = 0; i < numInst; i++) {
+      struct prog_instruction *inst = prog->Instructions + i;
+      if (removeFlags[i]) {
+         if (inst->Data)
+            _mesa_free(inst->Data);
+         if (inst->Comment)
+            _mesa_free((char *) inst->Comment);
+         continue;
+      }
+      if (is_flow_control(inst->Opcode) &&
+          inst->BranchTarget >= 0 &&
+          inst->BranchTarget <= (GLint) numInst) {
+         inst->BranchTarget = newIndex[inst->BranchTarget];
+      }
+      if (j != i)
+         prog->Instructions[j] = *inst;
+      j++;
+   }
+
+   prog->NumInstructions = j;
+   _mesa_free(newIndex);
+
+   return numInst - j;
+}
+
+
+/**
+ * Fetch the value of a constant source register, with swizzling and
+ * negation applied.  Return GL_FALSE if it isn't a compile-time constant.
+ */
+static GLboolean
+get_constant_src(const struct gl_program *prog,
+                 const struct prog_src_register *src, GLfloat value[4])
+{
+   const GLfloat *reg;
+   GLuint chan;
+
+   if (src->File != PROGRAM_CONSTANT || src->RelAddr ||
+       prog->Parameters->Parameters[src->Index].Type != PROGRAM_CONSTANT)
+      return GL_FALSE;
+
+   reg = prog->Parameters->ParameterValues[src->Index];
+   for (chan = 0; chan < 4; chan++) {
+      const GLuint swz = GET_SWZ(src->Swizzle, chan);
+      if (swz > SWIZZLE_W)
+         return GL_FALSE;
+      value[chan] = reg[swz];
+      if (src->NegateBase)
+         value[chan] = -value[chan];
+      if (src->Abs)
+         value[chan] = FABSF(value[chan]);
+      if (src->NegateAbs)
+         value[chan] = -value[chan];
+   }
+
+   return GL_TRUE;
+}
+
+
+/**
+ * Replace arithmetic instructions whose operands are all constants with
+ * a MOV of the result, evaluated the same way _mesa_execute_program()
+ * would.
+ * \return number of instructions folded
+ */
+static GLuint
+fold_constants(struct gl_program *prog)
+{
+   GLuint i, j, chan, count = 0;
+
+   if (!prog->Parameters)
+      return 0;
+
+   for (i = 0; i < prog->NumInstructions; i++) {
+      struct prog_instruction *inst = prog->Instructions + i;
+      const GLuint numSrc = _mesa_num_inst_src_regs(inst->Opcode);
+      GLfloat a[3][4], result[4], value;
+      GLuint size, swizzle;
+      GLint index;
+
+      if (inst->CondUpdate ||
+          inst->DstReg.CondMask != COND_TR ||
+          (inst->SaturateMode != SATURATE_OFF &&
+           inst->SaturateMode != SATURATE_ZERO_ONE))
+         continue;
+
+      for (j = 0; j < numSrc; j++) {
+         if (!get_constant_src(prog, inst->SrcReg + j, a[j]))
+            break;
+      }
+      if (j < numSrc)
+         continue;
+
+      switch (inst->Opcode) {
+      case OPCODE_ABS:
+         for (chan = 0; chan < 4; chan++)
+            result[chan] = FABSF(a[0][chan]);
+         break;
+      case OPCODE_ADD:
+         for (chan = 0; chan < 4; chan++)
+            result[chan] = a[0][chan] + a[1][chan];
+         break;
+      case OPCODE_SUB:
+         for (chan = 0; chan < 4; chan++)
+            result[chan] = a[0][chan] - a[1][chan];
+         break;
+      case OPCODE_MUL:
+         for (chan = 0; chan < 4; chan++)
+            result[chan] = a[0][chan] * a[1][chan];
+         break;
+      case OPCODE_MAD:
+         for (chan = 0; chan < 4; chan++)
+            result[chan] = a[0][chan] * a[1][chan] + a[2][chan];
+         break;
+      case OPCODE_MIN:
+         for (chan = 0; chan < 4; chan++)
+            result[chan] = MIN2(a[0][chan], a[1][chan]);
+         break;
+      case OPCODE_MAX:
+         for (chan = 0; chan < 4; chan++)
+            result[chan] = MAX2(a[0][chan], a[1][chan]);
+         break;
+      case OPCODE_FLR:
+         for (chan = 0; chan < 4; chan++)
+            result[chan] = FLOORF(a[0][chan]);
+         break;
+      case OPCODE_FRC:
+         for (chan = 0; chan < 4; chan++)
+            result[chan] = a[0][chan] - FLOORF(a[0][chan]);
+         break;
+      case OPCODE_SGE:
+         for (chan = 0; chan < 4; chan++)
+            result[chan] = (a[0][chan] >= a[1][chan]) ? 1.0F : 0.0F;
+         break;
+      case OPCODE_SLT:
+         for (chan = 0; chan < 4; chan++)
+            result[chan] = (a[0][chan] < a[1][chan]) ? 1.0F : 0.0F;
+         break;
+      case OPCODE_RCP:
+         if (a[0][0] == 0.0F)
+            continue;
+         result[0] = result[1] = result[2] = result[3] = 1.0F / a[0][0];
+         break;
+      case OPCODE_DP3:
+         result[0] = result[1] = result[2] = result[3] = DOT3(a[0], a[1]);
+         break;
+      case OPCODE_DP4:
+         result[0] = result[1] = result[2] = result[3] = DOT4(a[0], a[1]);
+         break;
+      default:
+         continue;
+      }
+
+      if (inst->SaturateMode == SATURATE_ZERO_ONE) {
+         for (chan = 0; chan < 4; chan++)
+            result[chan] = CLAMP(result[chan], 0.0F, 1.0F);
+      }
+
+      /* use a scalar constant if all written components are equal */
+      size = 0;
+      value = 0.0F;
+      for (chan = 0; chan < 4; chan++) {
+         if (inst->DstReg.WriteMask & (1 << chan)) {
+            if (size == 0) {
+               value = result[chan];
+               size = 1;
+            }
+            else if (result[chan] != value) {
+               size = 4;
+            }
+         }
+      }
+      if (size == 0)
+         continue;
+
+      if (size == 1)
+         result[0] = value;
+
+      index = _mesa_add_unnamed_constant(prog->Parameters, result, size,
+                                         &swizzle);
+      if (index < 0)
+         continue;
+
+      inst->Opcode = OPCODE_MOV;
+      inst->SaturateMode = SATURATE_OFF;
+      inst->SrcReg[0].File = PROGRAM_CONSTANT;
+      inst->SrcReg[0].Index = index;
+      inst->SrcReg[0].Swizzle = swizzle;
+      inst->SrcReg[0].NegateBase = NEGATE_NONE;
+      inst->SrcReg[0].Abs = GL_FALSE;
+      inst->SrcReg[0].NegateAbs = GL_FALSE;
+      inst->SrcReg[1].File = PROGRAM_UNDEFINED;
+      inst->SrcReg[2].File = PROGRAM_UNDEFINED;
+      count++;
+   }
+
+   return count;
+}
+
+
+/**
+ * Rewrite a source register which reads the result of a MOV to read the
+ * MOV's own source instead.  SWIZZLE_ZERO/ONE components (SWZ only)
+ * don't read the register and are kept as they are.
+ */
+static void
+rewrite_src(struct prog_instruction *inst, GLuint k,
+            const struct prog_src_register *movSrc)
+{
+   struct prog_src_register *src = inst->SrcReg + k;
+   const GLuint readMask = get_src_read_mask(inst, k);
+   GLuint swz[4], chan, regChans = 0x0, fill = SWIZZLE_NIL;
+
+   for (chan = 0; chan < 4; chan++) {
+      const GLuint s = GET_SWZ(src->Swizzle, chan);
+      swz[chan] = SWIZZLE_NIL;
+      if (!(readMask & (1 << chan)))
+         continue;
+      if (s > SWIZZLE_W) {
+         swz[chan] = s;
+      }
+      else {
+         swz[chan] = GET_SWZ(movSrc->Swizzle, s);
+         regChans |= 1 << chan;
+         if (fill == SWIZZLE_NIL)
+            fill = swz[chan];
+      }
+   }
+   /* the unused positions just need to name a valid component */
+   for (chan = 0; chan < 4; chan++) {
+      if (swz[chan] == SWIZZLE_NIL)
+         swz[chan] = fill;
+   }
+
+   src->File = movSrc->File;
+   src->Index = movSrc->Index;
+   src->Swizzle = MAKE_SWIZZLE4(swz[0], swz[1], swz[2], swz[3]);
+   if (inst->Opcode == OPCODE_SWZ) {
+      /* per-component negation, and the constants don't change sign */
+      if (movSrc->NegateBase)
+         src->NegateBase ^= regChans;
+   }
+   else {
+      src->NegateBase = (src->NegateBase ? NEGATE_XYZW : NEGATE_NONE)
+         ^ movSrc->NegateBase;
+   }
+}
+
+
+/**
+ * Copy propagation.  After "MOV t, src" replace reads of t later in the
+ * same basic block with reads of src, as long as src and the components
+ * of t being read are not written in between.  The MOV is left for
+ * remove_dead_code().
+ *
+ * Texture and derivative instructions are not rewritten since the
+ * interpreter treats fragment attribute operands specially for those.
+ * \return number of source registers rewritten
+ */
+static GLuint
+propagate_copies(struct gl_program *prog)
+{
+   GLuint i, j, k, count = 0;
+
+   for (i = 0; i < prog->NumInstructions; i++) {
+      const struct prog_instruction *mov = prog->Instructions + i;
+      const struct prog_src_register *movSrc = &mov->SrcReg[0];
+      const GLint t = mov->DstReg.Index;
+      GLuint valid = mov->DstReg.WriteMask;
+
+      if (!is_simple_move(mov) ||
+          mov->DstReg.File != PROGRAM_TEMPORARY ||
+          (movSrc->File == PROGRAM_TEMPORARY && movSrc->Index == t))
+         continue;
+
+      for (j = i + 1; j < prog->NumInstructions; j++) {
+         struct prog_instruction *inst = prog->Instructions + j;
+         const GLuint numSrc = _mesa_num_inst_src_regs(inst->Opcode);
+
+         if (!_mesa_is_tex_instruction(inst->Opcode) &&
+             inst->Opcode != OPCODE_DDX &&
+             inst->Opcode != OPCODE_DDY) {
+            for (k = 0; k < numSrc; k++) {
+               struct prog_src_register *src = inst->SrcReg + k;
+               GLuint regMask;
+
+               if (src->File != PROGRAM_TEMPORARY || src->Index != t)
+                  continue;
+
+               regMask = get_reg_read_mask(inst, k);
+               if (regMask && !(regMask & ~valid)) {
+                  rewrite_src(inst, k, movSrc);
+                  count++;
+               }
+            }
+         }
+
+         if (is_flow_control(inst->Opcode) ||
+             writes_register(inst, movSrc->File, movSrc->Index))
+            break;
+
+         /* components of t written since the MOV no longer hold src */
+         if (writes_register(inst, PROGRAM_TEMPORARY, t)) {
+            valid &= ~inst->DstReg.WriteMask;
+            if (!valid)
+               break;
+         }
+      }
+   }
+
+   return count;
+}
+
+
+/**
+ * For each instruction, find the BGNLOOP of the outermost loop containing
+ * it, or -1 if it's not inside a loop.
+ * \return malloc'd array, or NULL if out of memory
+ */
+static GLint *
+find_loop_starts(const struct gl_program *prog)
+{
+   GLint *loopStart;
+   GLint start = -1;
+   GLuint i, depth = 0;
+
+   loopStart = (GLint *)
+      _mesa_malloc((prog->NumInstructions + 1) * sizeof(GLint));
+   if (!loopStart)
+      return NULL;
+
+   for (i = 0; i < prog->NumInstructions; i++) {
+      const struct prog_instruction *inst = prog->Instructions + i;
+      if (inst->Opcode == OPCODE_BGNLOOP) {
+         if (depth++ == 0)
+            start = i;
+      }
+      loopStart[i] = start;
+      if (inst->Opcode == OPCODE_ENDLOOP && depth > 0) {
+         if (--depth == 0)
+            start = -1;
+      }
+   }
+
+   return loopStart;
+}
+
+
+/**
+ * Return which of the components 'mask' of temporary t, as they stand
+ * after instruction 'pos', may be read later on.
+ *
+ * Control flow only goes backward through loops, so everything after
+ * pos plus the rest of the enclosing loop is searched.  Writes only hide
+ * earlier values while still in pos's basic block.
+ *
+ * \param skip  instruction whose reads are ignored, or -1
+ */
+static GLuint
+get_live_mask(const struct gl_program *prog, const GLint *loopStart,
+              GLuint pos, GLint t, GLuint mask, GLint skip)
+{
+   GLuint live = 0x0, remaining = mask;
+   GLboolean sameBlock = GL_TRUE;
+   GLuint i, j;
+
+   for (i = pos + 1; i < prog->NumInstructions && remaining; i++) {
+      const struct prog_instruction *inst = prog->Instructions + i;
+      const GLuint numSrc = _mesa_num_inst_src_regs(inst->Opcode);
+
+      if ((GLint) i != skip) {
+         for (j = 0; j < numSrc; j++) {
+            if (inst->SrcReg[j].File == PROGRAM_TEMPORARY &&
+                inst->SrcReg[j].Index == t)
+               live |= get_reg_read_mask(inst, j) & remaining;
+         }
+      }
+
+      if (is_flow_control(inst->Opcode))
+         sameBlock = GL_FALSE;
+      else if (sameBlock &&
+               writes_register(inst, PROGRAM_TEMPORARY, t) &&
+               inst->DstReg.CondMask == COND_TR)
+         remaining &= ~inst->DstReg.WriteMask;
+   }
+
+   if (remaining && loopStart[pos] >= 0) {
+      for (i = loopStart[pos]; i <= pos; i++) {
+         const struct prog_instruction *inst = prog->Instructions + i;
+         const GLuint numSrc = _mesa_num_inst_src_regs(inst->Opcode);
+
+         if ((GLint) i == skip)
+            continue;
+         for (j = 0; j < numSrc; j++) {
+            if (inst->SrcReg[j].File == PROGRAM_TEMPORARY &&
+                inst->SrcReg[j].Index == t)
+               live |= get_reg_read_mask(inst, j) & remaining;
+         }
+      }
+   }
+
+   return live;
+}
+
+
+/**
+ * Remove instructions writing temporaries which are never read before
+ * being overwritten, and trim write masks down to the components which
+ * are read.
+ * \return number of instructions removed
+ */
+static GLuint
+remove_dead_code(struct gl_program *prog)
+{
+   GLboolean *removeFlags;
+   GLint *loopStart;
+   GLuint i, removed, total = 0;
+   GLboolean progress;
+
+   do {
+      progress = GL_FALSE;
+
+      removeFlags = (GLboolean *)
+         _mesa_calloc((prog->NumInstructions + 1) * sizeof(GLboolean));
+      loopStart = find_loop_starts(prog);
+      if (!removeFlags || !loopStart) {
+         if (removeFlags)
+            _mesa_free(removeFlags);
+         if (loopStart)
+            _mesa_free(loopStart);
+         break;
+      }
+
+      for (i = 0; i < prog->NumInstructions; i++) {
+         struct prog_instruction *inst = prog->Instructions + i;
+         GLuint mask;
+
+         if (_mesa_num_inst_dst_regs(inst->Opcode) == 0 ||
+             inst->DstReg.File != PROGRAM_TEMPORARY ||
+             inst->CondUpdate)
+            continue;
+
+         if (is_self_move(inst)) {
+            removeFlags[i] = GL_TRUE;
+            continue;
+         }
+
+         mask = get_live_mask(prog, loopStart, i, inst->DstReg.Index,
+                              inst->DstReg.WriteMask, -1);
+         if (mask == 0x0) {
+            removeFlags[i] = GL_TRUE;
+         }
+         else if (mask != inst->DstReg.WriteMask) {
+            inst->DstReg.WriteMask = mask;
+            progress = GL_TRUE;
+         }
+      }
+
+      removed = remove_instructions(prog, removeFlags);
+      if (removed) {
+         total += removed;
+         progress = GL_TRUE;
+      }
+
+      _mesa_free(removeFlags);
+      _mesa_free(loopStart);
+   } while (progress);
+
+   return total;
+}
+
+
+/**
+ * Fold "OP t, ...; MOV dst, t;" into "OP dst, ...;" when nothing else
+ * reads the value of t.  Since the two instructions are adjacent and the
+ * MOV isn't a branch target, the MOV always executes right after the
+ * instruction computing t.
+ * \return number of MOVs removed
+ */
+static GLuint
+coalesce_moves(struct gl_program *prog)
+{
+   GLboolean *removeFlags;
+   GLint *loopStart;
+   GLuint i;
+
+   removeFlags = (GLboolean *)
+      _mesa_calloc((prog->NumInstructions + 1) * sizeof(GLboolean));
+   loopStart = find_loop_starts(prog);
+   if (!removeFlags || !loopStart) {
+      if (removeFlags)
+         _mesa_free(removeFlags);
+      if (loopStart)
+         _mesa_free(loopStart);
+      return 0;
+   }
+
+   for (i = 1; i < prog->NumInstructions; i++) {
+      const struct prog_instruction *mov = prog->Instructions + i;
+      struct prog_instruction *prev = prog->Instructions + i - 1;
+      const struct prog_src_register *src = &mov->SrcReg[0];
+      GLuint chan;
+
+      if (removeFlags[i - 1] ||
+          !is_simple_move(mov) ||
+          src->File != PROGRAM_TEMPORARY ||
+          src->NegateBase != NEGATE_NONE)
+         continue;
+
+      if (_mesa_num_inst_dst_regs(prev->Opcode) == 0 ||
+          prev->DstReg.File != PROGRAM_TEMPORARY ||
+          (GLint) prev->DstReg.Index != src->Index ||
+          prev->DstReg.CondMask != COND_TR ||
+          prev->CondUpdate)
+         continue;
+
+      /* the MOV must copy components straight across, and only ones
+       * which prev wrote
+       */
+      for (chan = 0; chan < 4; chan++) {
+         if (mov->DstReg.WriteMask & (1 << chan)) {
+            if (GET_SWZ(src->Swizzle, chan) != chan ||
+                !(prev->DstReg.WriteMask & (1 << chan)))
+               break;
+         }
+      }
+      if (chan < 4)
+         continue;
+
+      /* nothing but the MOV may read what prev wrote */
+      if (get_live_mask(prog, loopStart, i - 1, src->Index,
+                        prev->DstReg.WriteMask, i))
+         continue;
+
+      prev->DstReg.File = mov->DstReg.File;
+      prev->DstReg.Index = mov->DstReg.Index;
+      prev->DstReg.WriteMask = mov->DstReg.WriteMask;
+      removeFlags[i] = GL_TRUE;
+   }
+
+   i = remove_instructions(prog, removeFlags);
+   _mesa_free(removeFlags);
+   _mesa_free(loopStart);
+
+   return i;
+}
+
+
+/**
+ * Renumber the temporary registers so the used ones are contiguous.
+ * \return new number of temporaries
+ */
+static GLuint
+compact_temporaries(struct gl_program *prog)
+{
+   GLint newIndex[MAX_PROGRAM_TEMPS];
+   GLuint i, j, numTemps = 0;
+
+   for (i = 0; i < MAX_PROGRAM_TEMPS; i++)
+      newIndex[i] = -1;
+
+   for (i = 0; i < prog->NumInstructions; i++) {
+      const struct prog_instruction *inst = prog->Instructions + i;
+      const GLuint numSrc = _mesa_num_inst_src_regs(inst->Opcode);
+      for (j = 0; j < numSrc; j++) {
+         if (inst->SrcReg[j].File == PROGRAM_TEMPORARY)
+            newIndex[inst->SrcReg[j].Index] = 0;
+      }
+      if (_mesa_num_inst_dst_regs(inst->Opcode) &&
+          inst->DstReg.File == PROGRAM_TEMPORARY)
+         newIndex[inst->DstReg.Index] = 0;
+   }
+
+   for (i = 0; i < MAX_PROGRAM_TEMPS; i++) {
+      if (newIndex[i] == 0)
+         newIndex[i] = numTemps++;
+   }
+
+   for (i = 0; i < prog->NumInstructions; i++) {
+      struct prog_instruction *inst = prog->Instructions + i;
+      const GLuint numSrc = _mesa_num_inst_src_regs(inst->Opcode);
+      for (j = 0; j < numSrc; j++) {
+         if (inst->SrcReg[j].File == PROGRAM_TEMPORARY)
+            inst->SrcReg[j].Index = newIndex[inst->SrcReg[j].Index];
+      }
+      if (_mesa_num_inst_dst_regs(inst->Opcode) &&
+          inst->DstReg.File == PROGRAM_TEMPORARY)
+         inst->DstReg.Index = newIndex[inst->DstReg.Index];
+   }
+
+   return numTemps;
+}
+
+
+/**
+ * Run the optimization passes over a program.  This is meant to be used
+ * on linked GLSL programs; the caller should recompute InputsRead etc.
+ * afterward.
+ */
+void
+_mesa_optimize_program(struct gl_program *prog)
+{
+   const GLuint origInstructions = prog->NumInstructions;
+   const GLuint origTemps = count_temporaries(prog);
+   GLuint progress;
+
+   if (!can_optimize(prog))
+      return;
+
+   /* folding and propagation expose more of each other */
+   do {
+      progress = fold_constants(prog);
+      progress += propagate_copies(prog);
+      progress += remove_dead_code(prog);
+   } while (progress);
+
+   coalesce_moves(prog);
+
+   prog->NumTemporaries = compact_temporaries(prog);
+
+   if (MESA_VERBOSE & VERBOSE_GLSL_DUMP) {
+      _mesa_print_optimize_stats(prog, origInstructions, origTemps);
+   }
+}
+
+
+#if 0 /* debug only */
+
+/**
+ * Test copy propagation into a SWZ whose swizzle has constant
+ * components, i.e. "MOV t, -in.yzwx; SWZ out, t, x,0,1,-w;".
+ */
+static void
+test_propagate_swz(void)
+{
+   struct prog_instruction *inst = _mesa_alloc_instructions(3);
+   struct gl_program prog;
+
+   _mesa_init_instructions(inst, 3);
+   _mesa_bzero(&prog, sizeof(prog));
+   prog.Instructions = inst;
+   prog.NumInstructions = 3;
+
+   inst[0].Opcode = OPCODE_MOV;
+   inst[0].DstReg.File = PROGRAM_TEMPORARY;
+   inst[0].DstReg.Index = 0;
+   inst[0].SrcReg[0].File = PROGRAM_INPUT;
+   inst[0].SrcReg[0].Index = 1;
+   inst[0].SrcReg[0].Swizzle = MAKE_SWIZZLE4(SWIZZLE_Y, SWIZZLE_Z,
+                                             SWIZZLE_W, SWIZZLE_X);
+   inst[0].SrcReg[0].NegateBase = NEGATE_XYZW;
+
+   inst[1].Opcode = OPCODE_SWZ;
+   inst[1].DstReg.File = PROGRAM_OUTPUT;
+   inst[1].DstReg.Index = 0;
+   inst[1].SrcReg[0].File = PROGRAM_TEMPORARY;
+   inst[1].SrcReg[0].Index = 0;
+   inst[1].SrcReg[0].Swizzle = MAKE_SWIZZLE4(SWIZZLE_X, SWIZZLE_ZERO,
+                                             SWIZZLE_ONE, SWIZZLE_W);
+   inst[1].SrcReg[0].NegateBase = NEGATE_W;
+
+   inst[2].Opcode = OPCODE_END;
+
+   assert(propagate_copies(&prog) == 1);
+   assert(inst[1].SrcReg[0].File == PROGRAM_INPUT);
+   assert(inst[1].SrcReg[0].Index == 1);
+   assert(inst[1].SrcReg[0].Swizzle ==
+          MAKE_SWIZZLE4(SWIZZLE_Y, SWIZZLE_ZERO, SWIZZLE_ONE, SWIZZLE_X));
+   /* the MOV's negation only applies to the register components */
+   assert(inst[1].SrcReg[0].NegateBase == NEGATE_X);
+
+   _mesa_free_instructions(inst, 3);
+}
+
+
+void
+_mesa_test_optimize(void)
+{
+   test_propagate_swz();
+}
+
+#endif
@@ -35,12 +35,125 @@
 #include "prog_instruction.h"
 #include "prog_parameter.h"
 #include "prog_statevars.h"
+#include "slang/slang_mem.h"
+
+
+/**
+ * Stop using the name and constant hashes (out of memory).  The searches
+ * fall back to scanning the whole list.
+ */
+static void
+free_hashes(struct gl_program_parameter_list *paramList)
+{
+   _mesa_free_index_hash(paramList->NameHash);
+   _mesa_free_index_hash(paramList->ConstantHash);
+   paramList->NameHash = NULL;
+   paramList->ConstantHash = NULL;
+}
+
+
+/**
+ * Add the new slots [first, first + count) to the name and constant hashes.
+ */
+static void
+hash_parameters(struct gl_program_parameter_list *paramList,
+                GLuint first, GLuint count)
+{
+   const struct gl_program_parameter *p = paramList->Parameters + first;
+   GLboolean ok = GL_TRUE;
+   GLuint i, j;
+
+   if (!paramList->NameHash)
+      return;
+
+   /* the other slots of the parameter have the same name */
+   if (p->Name)
+      ok = _mesa_index_hash_insert(paramList->NameHash,
+                                   _mesa_hash_string(p->Name, -1), first);
+
+   if (p->Type == PROGRAM_CONSTANT) {
+      for (i = first; i < first + count; i++) {
+         for (j = 0; j < 4; j++) {
+            const GLfloat v = paramList->ParameterValues[i][j];
+            ok = ok && _mesa_index_hash_insert(paramList->ConstantHash,
+                                               _mesa_hash_float(v), i);
+         }
+      }
+   }
+
+   if (!ok)
+      free_hashes(paramList);
+}
+
+
+/**
+ * Iterate over the slots which may be the first slot of a parameter with
+ * the given name: the ones in NameHash, or all of them if there's no hash.
+ * Parameters larger than 4 floats have more slots following the first,
+ * with the same name.
+ */
+static GLint
+first_name_candidate(const struct gl_program_parameter_list *paramList,
+                     GLsizei nameLen, const char *name, GLint *iter)
+{
+   if (paramList->NameHash)
+      return _mesa_index_hash_first(paramList->NameHash,
+                                    _mesa_hash_string(name, nameLen), iter);
+   *iter = 0;
+   return paramList->NumParameters > 0 ? 0 : -1;
+}
+
+static GLint
+next_name_candidate(const struct gl_program_parameter_list *paramList,
+                    GLsizei nameLen, const char *name, GLint *iter)
+{
+   if (paramList->NameHash)
+      return _mesa_index_hash_next(paramList->NameHash,
+                                   _mesa_hash_string(name, nameLen), iter);
+   (*iter)++;
+   return *iter < (GLint) paramList->NumParameters ? *iter : -1;
+}
+
+
+/**
+ * Iterate over the slots which may be PROGRAM_CONSTANTs with value v in
+ * one of their components.
+ */
+static GLint
+first_constant_candidate(const struct gl_program_parameter_list *paramList,
+                         GLfloat v, GLint *iter)
+{
+   if (paramList->ConstantHash)
+      return _mesa_index_hash_first(paramList->ConstantHash,
+                                    _mesa_hash_float(v), iter);
+   *iter = 0;
+   return paramList->NumParameters > 0 ? 0 : -1;
+}
+
+static GLint
+next_constant_candidate(const struct gl_program_parameter_list *paramList,
+                        GLfloat v, GLint *iter)
+{
+   if (paramList->ConstantHash)
+      return _mesa_index_hash_next(paramList->ConstantHash,
+                                   _mesa_hash_float(v), iter);
+   (*iter)++;
+   return *iter < (GLint) paramList->NumParameters ? *iter : -1;
+}
 
 
 struct gl_program_parameter_list *
 _mesa_new_parameter_list(void)
 {
-   return CALLOC_STRUCT(gl_program_parameter_list);
+   struct gl_program_parameter_list *paramList
+      = CALLOC_STRUCT(gl_program_parameter_list);
+   if (paramList) {
+      paramList->NameHash = _mesa_new_index_hash();
+      paramList->ConstantHash = _mesa_new_index_hash();
+      if (!paramList->NameHash || !paramList->ConstantHash)
+         free_hashes(paramList);
+   }
+   return paramList;
 }
 
 
@@ -50,14 +163,11 @@ _mesa_new_parameter_list(void)
 void
 _mesa_free_parameter_list(struct gl_program_parameter_list *paramList)
 {
-   GLuint i;
-   for (i = 0; i < paramList->NumParameters; i++) {
-      if (paramList->Parameters[i].Name)
-	 _mesa_free((void *) paramList->Parameters[i].Name);
-   }
    _mesa_free(paramList->Parameters);
    if (paramList->ParameterValues)
       _mesa_align_free(paramList->ParameterValues);
+   free_hashes(paramList);
+   _slang_delete_mempool(paramList->NamePool);
    _mesa_free(paramList);
 }
 
@@ -70,7 +180,8 @@ _mesa_free_parameter_list(struct gl_program_parameter_list *paramList)
  *
  * \param paramList  the list to add the parameter to
  * \param type  type of parameter, such as 
- * \param name  the parameter name, will be duplicated/copied!
+ * \param name  the parameter name, will be duplicated/copied into the
+ *              list's NamePool
  * \param size  number of elements in 'values' vector (1..4, or more)
  * \param values  initial parameter value, up to 4 GLfloats, or NULL
  * \param state  state indexes, or NULL
@@ -85,12 +196,23 @@ _mesa_add_parameter(struct gl_program_parameter_list *paramList,
 {
    const GLuint oldNum = paramList->NumParameters;
    const GLuint sz4 = (size + 3) / 4; /* no. of new param slots needed */
+   const char *nameCopy = NULL;
 
    assert(size > 0);
 
+   if (name) {
+      /* one copy of the name, shared by all the slots */
+      if (!paramList->NamePool)
+         paramList->NamePool = _slang_new_mempool(512);
+      if (paramList->NamePool)
+         nameCopy = _slang_pool_strdup(paramList->NamePool, name);
+      if (!nameCopy)
+         return -1; /* out of memory */
+   }
+
    if (oldNum + sz4 > paramList->Size) {
       /* Need to grow the parameter list array (alloc some extra) */
-      paramList->Size = paramList->Size + 4 * sz4;
+      paramList->Size = MAX2(2 * paramList->Size, paramList->Size + 4 * sz4);
 
       /* realloc arrays */
       paramList->Parameters = (struct gl_program_parameter *)
@@ -110,6 +232,8 @@ _mesa_add_parameter(struct gl_program_parameter_list *paramList,
       /* out of memory */
       paramList->NumParameters = 0;
       paramList->Size = 0;
+      paramList->ConstantSpace = 0;
+      free_hashes(paramList);
       return -1;
    }
    else {
@@ -122,7 +246,7 @@ _mesa_add_parameter(struct gl_program_parameter_list *paramList,
 
       for (i = 0; i < sz4; i++) {
          struct gl_program_parameter *p = paramList->Parameters + oldNum + i;
-         p->Name = name ? _mesa_strdup(name) : NULL;
+         p->Name = nameCopy;
          p->Type = type;
          p->Size = size;
          p->DataType = datatype;
@@ -142,8 +266,19 @@ _mesa_add_parameter(struct gl_program_parameter_list *paramList,
       if (state) {
          for (i = 0; i < STATE_LENGTH; i++)
             paramList->Parameters[oldNum].StateIndexes[i] = state[i];
+
+         if (type == PROGRAM_STATE_VAR) {
+            GLbitfield stateFlags = _mesa_program_state_flags(state);
+            paramList->Parameters[oldNum].StateFlags = stateFlags;
+            paramList->StateFlags |= stateFlags;
+         }
       }
 
+      hash_parameters(paramList, oldNum, sz4);
+
+      /* the new entries have not been loaded yet */
+      paramList->StateContext = NULL;
+
       return (GLint) oldNum;
    }
 }
@@ -179,16 +314,23 @@ _mesa_add_named_constant(struct gl_program_parameter_list *paramList,
                          GLuint size)
 {
    /* first check if this is a duplicate constant */
-   GLint pos;
-   for (pos = 0; pos < paramList->NumParameters; pos++) {
-      const GLfloat *pvals = paramList->ParameterValues[pos];
-      if (pvals[0] == values[0] &&
-          pvals[1] == values[1] &&
-          pvals[2] == values[2] &&
-          pvals[3] == values[3] &&
-          _mesa_strcmp(paramList->Parameters[pos].Name, name) == 0) {
-         /* Same name and value is already in the param list - reuse it */
-         return pos;
+   GLint first, pos, iter;
+   for (first = first_name_candidate(paramList, -1, name, &iter);
+        first >= 0;
+        first = next_name_candidate(paramList, -1, name, &iter)) {
+      for (pos = first;
+           pos < (GLint) paramList->NumParameters &&
+              paramList->Parameters[pos].Name &&
+              _mesa_strcmp(paramList->Parameters[pos].Name, name) == 0;
+           pos++) {
+         const GLfloat *pvals = paramList->ParameterValues[pos];
+         if (pvals[0] == values[0] &&
+             pvals[1] == values[1] &&
+             pvals[2] == values[2] &&
+             pvals[3] == values[3]) {
+            /* Same name and value is already in the param list - reuse it */
+            return pos;
+         }
       }
    }
    /* not found, add new parameter */
@@ -229,7 +371,8 @@ _mesa_add_unnamed_constant(struct gl_program_parameter_list *paramList,
     * constants because we rely on smearing (i.e. .yyyy or .zzzz).
     */
    if (size == 1 && swizzleOut) {
-      for (pos = 0; pos < (GLint) paramList->NumParameters; pos++) {
+      for (pos = paramList->ConstantSpace;
+           pos < (GLint) paramList->NumParameters; pos++) {
          struct gl_program_parameter *p = paramList->Parameters + pos;
          if (p->Type == PROGRAM_CONSTANT && p->Size + size <= 4) {
             /* ok, found room */
@@ -238,9 +381,15 @@ _mesa_add_unnamed_constant(struct gl_program_parameter_list *paramList,
             pVal[p->Size] = values[0];
             p->Size++;
             *swizzleOut = MAKE_SWIZZLE4(swz, swz, swz, swz);
+            paramList->ConstantSpace = pos;
+            if (paramList->ConstantHash &&
+                !_mesa_index_hash_insert(paramList->ConstantHash,
+                                         _mesa_hash_float(values[0]), pos))
+               free_hashes(paramList);
             return pos;
          }
       }
+      paramList->ConstantSpace = paramList->NumParameters;
    }
 
    /* add a new parameter to store this constant */
@@ -292,15 +441,22 @@ void
 _mesa_use_uniform(struct gl_program_parameter_list *paramList,
                   const char *name)
 {
-   GLuint i;
-   for (i = 0; i < paramList->NumParameters; i++) {
-      struct gl_program_parameter *p = paramList->Parameters + i;
-      if ((p->Type == PROGRAM_UNIFORM || p->Type == PROGRAM_SAMPLER) &&
-          _mesa_strcmp(p->Name, name) == 0) {
-         p->Used = GL_TRUE;
-         /* Note that large uniforms may occupy several slots so we're
-          * not done searching yet.
-          */
+   GLint first, i, iter;
+   for (first = first_name_candidate(paramList, -1, name, &iter);
+        first >= 0;
+        first = next_name_candidate(paramList, -1, name, &iter)) {
+      for (i = first;
+           i < (GLint) paramList->NumParameters &&
+              paramList->Parameters[i].Name &&
+              _mesa_strcmp(paramList->Parameters[i].Name, name) == 0;
+           i++) {
+         struct gl_program_parameter *p = paramList->Parameters + i;
+         if (p->Type == PROGRAM_UNIFORM || p->Type == PROGRAM_SAMPLER) {
+            p->Used = GL_TRUE;
+            /* Note that large uniforms may occupy several slots so we're
+             * not done searching yet.
+             */
+         }
       }
    }
 }
@@ -453,7 +609,6 @@ _mesa_add_state_reference(struct gl_program_parameter_list *paramList,
    index = _mesa_add_parameter(paramList, PROGRAM_STATE_VAR, name,
                                size, GL_NONE,
                                NULL, (gl_state_index *) stateTokens, 0x0);
-   paramList->StateFlags |= _mesa_program_state_flags(stateTokens);
 
    /* free name string here since we duplicated it in add_parameter() */
    _mesa_free((void *) name);
@@ -490,22 +645,22 @@ GLint
 _mesa_lookup_parameter_index(const struct gl_program_parameter_list *paramList,
                              GLsizei nameLen, const char *name)
 {
-   GLint i;
+   GLint i, iter;
 
    if (!paramList)
       return -1;
 
-   if (nameLen == -1) {
-      /* name is null-terminated */
-      for (i = 0; i < (GLint) paramList->NumParameters; i++) {
+   for (i = first_name_candidate(paramList, nameLen, name, &iter);
+        i >= 0;
+        i = next_name_candidate(paramList, nameLen, name, &iter)) {
+      if (nameLen == -1) {
+         /* name is null-terminated */
          if (paramList->Parameters[i].Name &&
 	     _mesa_strcmp(paramList->Parameters[i].Name, name) == 0)
             return i;
       }
-   }
-   else {
-      /* name is not null-terminated, use nameLen */
-      for (i = 0; i < (GLint) paramList->NumParameters; i++) {
+      else {
+         /* name is not null-terminated, use nameLen */
          if (paramList->Parameters[i].Name &&
 	     _mesa_strncmp(paramList->Parameters[i].Name, name, nameLen) == 0
              && _mesa_strlen(paramList->Parameters[i].Name) == (size_t)nameLen)
@@ -533,7 +688,7 @@ _mesa_lookup_parameter_constant(const struct gl_program_parameter_list *list,
                                 const GLfloat v[], GLuint vSize,
                                 GLint *posOut, GLuint *swizzleOut)
 {
-   GLuint i;
+   GLint i, iter;
 
    assert(vSize >= 1);
    assert(vSize <= 4);
@@ -541,7 +696,10 @@ _mesa_lookup_parameter_constant(const struct gl_program_parameter_list *list,
    if (!list)
       return -1;
 
-   for (i = 0; i < list->NumParameters; i++) {
+   /* any match has v[0] in one of its components */
+   for (i = first_constant_candidate(list, v[0], &iter);
+        i >= 0;
+        i = next_constant_candidate(list, v[0], &iter)) {
       if (list->Parameters[i].Type == PROGRAM_CONSTANT) {
          if (!swizzleOut) {
             /* swizzle not allowed */
@@ -634,6 +792,7 @@ _mesa_clone_parameter_list(const struct gl_program_parameter_list *list)
          for (k = 0; k < STATE_LENGTH; k++) {
             pCopy->StateIndexes[k] = p->StateIndexes[k];
          }
+         pCopy->StateFlags = p->StateFlags;
       }
       else {
          clone->Parameters[j].Size = p->Size;
@@ -33,6 +33,7 @@
 
 #include "main/mtypes.h"
 #include "prog_statevars.h"
+#include "prog_hash.h"
 
 
 /**
@@ -64,6 +65,11 @@ struct gl_program_parameter
     * A sequence of STATE_* tokens and integers to identify GL state.
     */
    gl_state_index StateIndexes[STATE_LENGTH];
+   /**
+    * For STATE_VAR parameters, the _NEW_* flags indicating which state
+    * changes might invalidate the value, or 0 if unknown (always reload).
+    */
+   GLbitfield StateFlags;
 };
 
 
@@ -78,6 +84,24 @@ struct gl_program_parameter_list
    GLfloat (*ParameterValues)[4];        /**< Array [Size] of GLfloat[4] */
    GLbitfield StateFlags; /**< _NEW_* flags indicating which state changes
                                might invalidate ParameterValues[] */
+   /**
+    * The context and its StateStamp when the STATE_VAR values were last
+    * loaded, so that _mesa_load_state_parameters() only needs to reload
+    * the ones whose state has changed since.  NULL if never loaded.
+    */
+   const GLcontext *StateContext;
+   GLuint StateStamp;
+   /**
+    * Speed up the searches by name and by constant value.  NameHash maps
+    * parameter names to the first slot of each parameter, ConstantHash
+    * maps each component value of PROGRAM_CONSTANT slots to the slot.
+    * NULL if out of memory, in which case the lists are searched linearly.
+    */
+   struct gl_index_hash *NameHash;
+   struct gl_index_hash *ConstantHash;
+   GLuint ConstantSpace;  /**< no PROGRAM_CONSTANT slot before this one has
+                               room for another scalar constant */
+   struct slang_mempool_ *NamePool; /**< storage for the parameter names */
 };
 
 
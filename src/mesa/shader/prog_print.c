@@ -799,6 +799,22 @@ _mesa_print_program_parameters(GLcontext *ctx, const struct gl_program *prog)
 }
 
 
+/**
+ * Print a program's instruction and temporary register counts before and
+ * after _mesa_optimize_program().
+ */
+void
+_mesa_print_optimize_stats(const struct gl_program *prog,
+                           GLuint origInstructions, GLuint origTemps)
+{
+   _mesa_printf("Optimized %s program: %u -> %u instructions, "
+                "%u -> %u temporaries\n",
+                prog->Target == GL_VERTEX_PROGRAM_ARB ? "vertex" : "fragment",
+                origInstructions, prog->NumInstructions,
+                origTemps, prog->NumTemporaries);
+}
+
+
 void
 _mesa_print_parameter_list(const struct gl_program_parameter_list *list)
 {
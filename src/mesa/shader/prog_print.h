@@ -71,5 +71,9 @@ _mesa_print_program_parameters(GLcontext *ctx, const struct gl_program *prog);
 extern void
 _mesa_print_parameter_list(const struct gl_program_parameter_list *list);
 
+extern void
+_mesa_print_optimize_stats(const struct gl_program *prog,
+                           GLuint origInstructions, GLuint origTemps);
+
 
 #endif /* PROG_PRINT_H */
@@ -570,15 +570,28 @@ _mesa_program_state_flags(const gl_state_index state[STATE_LENGTH])
       return _NEW_PROGRAM;
 
    case STATE_NORMAL_SCALE:
-      return _NEW_MODELVIEW;
+      /* _ModelViewInvScale also changes with _NeedEyeCoords */
+      return _MESA_NEW_NEED_EYE_COORDS;
 
    case STATE_INTERNAL:
       switch (state[1]) {
+      case STATE_NORMAL_SCALE:
+      case STATE_LIGHT_SPOT_DIR_NORMALIZED:
+      case STATE_LIGHT_POSITION:
+      case STATE_LIGHT_POSITION_NORMALIZED:
+      case STATE_LIGHT_HALF_VECTOR:
+         /* derived state computed by _mesa_update_tnl_spaces() */
+         return _MESA_NEW_NEED_EYE_COORDS;
       case STATE_TEXRECT_SCALE:
       case STATE_SHADOW_AMBIENT:
 	 return _NEW_TEXTURE;
       case STATE_FOG_PARAMS_OPTIMIZED:
 	 return _NEW_FOG;
+      case STATE_PT_SCALE:
+      case STATE_PT_BIAS:
+      case STATE_PCM_SCALE:
+      case STATE_PCM_BIAS:
+         return _NEW_PIXEL;
       default:
          /* unknown state indexes are silently ignored and
          *  no flag set, since it is handled by the driver.
@@ -912,16 +925,51 @@ _mesa_program_state_string(const gl_state_index state[STATE_LENGTH])
 }
 
 
+/**
+ * Return the _NEW_* flags which have changed since the parameter list's
+ * state references were last loaded in this context.
+ */
+static GLbitfield
+changed_state_flags(const GLcontext *ctx,
+                    const struct gl_program_parameter_list *paramList)
+{
+   GLbitfield flags = paramList->StateFlags, changed;
+   GLuint i;
+
+   if (paramList->StateContext != ctx)
+      return ~0;
+
+   /* changes not yet seen by _mesa_update_state() */
+   changed = ctx->NewState;
+
+   for (i = 0; flags; i++, flags >>= 1) {
+      if ((flags & 1) && ctx->StateFlagStamp[i] > paramList->StateStamp)
+         changed |= 1 << i;
+   }
+
+   /* glColor updates the material for glColorMaterial without flagging
+    * _NEW_LIGHT.
+    */
+   if (ctx->Light.ColorMaterialEnabled)
+      changed |= _NEW_LIGHT;
+
+   return changed;
+}
+
+
 /**
  * Loop over all the parameters in a parameter list.  If the parameter
  * is a GL state reference, look up the current value of that state
  * variable and put it into the parameter's Value[4] array.
+ * Only the references whose state may have changed since the last call
+ * for this list (per their StateFlags) are looked up again.
  * This would be called at glBegin time when using a fragment program.
  */
 void
 _mesa_load_state_parameters(GLcontext *ctx,
                             struct gl_program_parameter_list *paramList)
 {
+   GLbitfield changed;
    GLuint i;
 
    if (!paramList)
@@ -929,13 +977,19 @@ _mesa_load_state_parameters(GLcontext *ctx,
 
    /*assert(ctx->Driver.NeedFlush == 0);*/
 
+   changed = changed_state_flags(ctx, paramList);
+
    for (i = 0; i < paramList->NumParameters; i++) {
-      if (paramList->Parameters[i].Type == PROGRAM_STATE_VAR) {
-         _mesa_fetch_state(ctx,
-			   (gl_state_index *) paramList->Parameters[i].StateIndexes,
+      const struct gl_program_parameter *p = paramList->Parameters + i;
+      if (p->Type == PROGRAM_STATE_VAR &&
+          (!p->StateFlags || (p->StateFlags & changed))) {
+         _mesa_fetch_state(ctx, (gl_state_index *) p->StateIndexes,
                            paramList->ParameterValues[i]);
       }
    }
+
+   paramList->StateContext = ctx;
+   paramList->StateStamp = ctx->StateStamp;
 }
 
 
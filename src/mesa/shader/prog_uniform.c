@@ -29,25 +29,28 @@
  */
 
 #include "main/imports.h"
+#include "main/macros.h"
 #include "main/mtypes.h"
 #include "prog_uniform.h"
+#include "slang/slang_mem.h"
 
 
 struct gl_uniform_list *
 _mesa_new_uniform_list(void)
 {
-   return CALLOC_STRUCT(gl_uniform_list);
+   struct gl_uniform_list *list = CALLOC_STRUCT(gl_uniform_list);
+   if (list)
+      list->NameHash = _mesa_new_index_hash();
+   return list;
 }
 
 
 void
 _mesa_free_uniform_list(struct gl_uniform_list *list)
 {
-   GLuint i;
-   for (i = 0; i < list->NumUniforms; i++) {
-      _mesa_free((void *) list->Uniforms[i].Name);
-   }
    _mesa_free(list->Uniforms);
+   _mesa_free_index_hash(list->NameHash);
+   _slang_delete_mempool(list->NamePool);
    _mesa_free(list);
 }
 
@@ -69,7 +72,7 @@ _mesa_append_uniform(struct gl_uniform_list *list,
 
       if (oldNum + 1 > list->Size) {
          /* Need to grow the list array (alloc some extra) */
-         list->Size += 4;
+         list->Size = MAX2(2 * list->Size, 4);
 
          /* realloc arrays */
          list->Uniforms = (struct gl_uniform *)
@@ -82,16 +85,31 @@ _mesa_append_uniform(struct gl_uniform_list *list,
          /* out of memory */
          list->NumUniforms = 0;
          list->Size = 0;
+         _mesa_free_index_hash(list->NameHash);
+         list->NameHash = NULL;
          return GL_FALSE;
       }
 
       uniform = list->Uniforms + oldNum;
 
-      uniform->Name = _mesa_strdup(name);
+      if (!list->NamePool)
+         list->NamePool = _slang_new_mempool(512);
+      uniform->Name = list->NamePool
+         ? _slang_pool_strdup(list->NamePool, name) : NULL;
+      if (!uniform->Name)
+         return NULL; /* out of memory */
       uniform->VertPos = -1;
       uniform->FragPos = -1;
       uniform->Initialized = GL_FALSE;
 
+      if (list->NameHash &&
+          !_mesa_index_hash_insert(list->NameHash,
+                                   _mesa_hash_string(name, -1), oldNum)) {
+         /* out of memory, search linearly from now on */
+         _mesa_free_index_hash(list->NameHash);
+         list->NameHash = NULL;
+      }
+
       list->NumUniforms++;
    }
    else {
@@ -126,8 +144,21 @@ _mesa_append_uniform(struct gl_uniform_list *list,
 GLint
 _mesa_lookup_uniform(const struct gl_uniform_list *list, const char *name)
 {
-   GLuint i;
-   for (i = 0; list && i < list->NumUniforms; i++) {
+   GLint i, iter;
+
+   if (list && list->NameHash) {
+      const GLuint key = _mesa_hash_string(name, -1);
+      for (i = _mesa_index_hash_first(list->NameHash, key, &iter);
+           i >= 0;
+           i = _mesa_index_hash_next(list->NameHash, key, &iter)) {
+         if (!_mesa_strcmp(list->Uniforms[i].Name, name)) {
+            return i;
+         }
+      }
+      return -1;
+   }
+
+   for (i = 0; list && i < (GLint) list->NumUniforms; i++) {
       if (!_mesa_strcmp(list->Uniforms[i].Name, name)) {
          return i;
       }
@@ -33,6 +33,7 @@
 
 #include "main/mtypes.h"
 #include "prog_statevars.h"
+#include "prog_hash.h"
 
 
 /**
@@ -66,6 +67,8 @@ struct gl_uniform_list
    GLuint Size;                 /**< allocated size of Uniforms array */
    GLuint NumUniforms;          /**< number of uniforms in the array */
    struct gl_uniform *Uniforms; /**< Array [Size] */
+   struct gl_index_hash *NameHash; /**< names to indexes, may be NULL */
+   struct slang_mempool_ *NamePool; /**< storage for the uniform names */
 };
 
 
@@ -36,6 +36,7 @@
 #include "prog_cache.h"
 #include "prog_parameter.h"
 #include "prog_instruction.h"
+#include "prog_execute.h"
 
 
 /**
@@ -81,6 +82,7 @@ _mesa_init_program(GLcontext *ctx)
       ctx->VertexProgram.TrackMatrixTransform[i] = GL_IDENTITY_NV;
    }
    ctx->VertexProgram.Cache = _mesa_new_program_cache();
+   ctx->VertexProgram._TnlKey = NULL;
 #endif
 
 #if FEATURE_NV_fragment_program || FEATURE_ARB_fragment_program
@@ -111,6 +113,10 @@ _mesa_free_program_data(GLcontext *ctx)
 #if FEATURE_NV_vertex_program || FEATURE_ARB_vertex_program
    _mesa_reference_vertprog(ctx, &ctx->VertexProgram.Current, NULL);
    _mesa_delete_program_cache(ctx, ctx->VertexProgram.Cache);
+   if (ctx->VertexProgram._TnlKey) {
+      _mesa_free(ctx->VertexProgram._TnlKey);
+      ctx->VertexProgram._TnlKey = NULL;
+   }
 #endif
 #if FEATURE_NV_fragment_program || FEATURE_ARB_fragment_program
    _mesa_reference_fragprog(ctx, &ctx->FragmentProgram.Current, NULL);
@@ -334,6 +340,7 @@ _mesa_delete_program(GLcontext *ctx, struct gl_program *prog)
       _mesa_free(prog->String);
 
    _mesa_free_instructions(prog->Instructions, prog->NumInstructions);
+   _mesa_free_decoded_program(prog);
 
    if (prog->Parameters) {
       _mesa_free_parameter_list(prog->Parameters);
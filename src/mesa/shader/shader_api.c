@@ -46,6 +46,7 @@
 #include "shader/prog_statevars.h"
 #include "shader/prog_uniform.h"
 #include "shader/shader_api.h"
+#include "shader/shader_queue.h"
 #include "shader/slang/slang_compile.h"
 #include "shader/slang/slang_link.h"
 #include "glapi/dispatch.h"
@@ -108,6 +109,7 @@ _mesa_free_shader_program_data(GLcontext *ctx,
 
    assert(shProg->Type == GL_SHADER_PROGRAM_MESA);
 
+   _mesa_wait_shader_program(shProg);
    _mesa_clear_shader_program_data(ctx, shProg);
 
    if (shProg->Attributes) {
@@ -212,6 +214,8 @@ _mesa_lookup_shader_program(GLcontext *ctx, GLuint name)
       if (shProg && shProg->Type != GL_SHADER_PROGRAM_MESA) {
          return NULL;
       }
+      if (shProg)
+         _mesa_wait_shader_program(shProg);
       return shProg;
    }
    return NULL;
@@ -240,6 +244,7 @@ _mesa_lookup_shader_program_err(GLcontext *ctx, GLuint name,
          _mesa_error(ctx, GL_INVALID_OPERATION, caller);
          return NULL;
       }
+      _mesa_wait_shader_program(shProg);
       return shProg;
    }
 }
@@ -268,6 +273,7 @@ _mesa_new_shader(GLcontext *ctx, GLuint name, GLenum type)
 void
 _mesa_free_shader(GLcontext *ctx, struct gl_shader *sh)
 {
+   _mesa_wait_shader(sh);
    if (sh->Source)
       _mesa_free((void *) sh->Source);
    if (sh->InfoLog)
@@ -339,6 +345,8 @@ _mesa_lookup_shader(GLcontext *ctx, GLuint name)
       if (sh && sh->Type == GL_SHADER_PROGRAM_MESA) {
          return NULL;
       }
+      if (sh)
+         _mesa_wait_shader(sh);
       return sh;
    }
    return NULL;
@@ -366,6 +374,7 @@ _mesa_lookup_shader_err(GLcontext *ctx, GLuint name, const char *caller)
          _mesa_error(ctx, GL_INVALID_OPERATION, caller);
          return NULL;
       }
+      _mesa_wait_shader(sh);
       return sh;
    }
 }
@@ -384,6 +393,8 @@ _mesa_init_shader_state(GLcontext * ctx)
    ctx->Shader.EmitHighLevelInstructions = GL_TRUE;
    ctx->Shader.EmitCondCodes = GL_TRUE; /* XXX probably want GL_FALSE... */
    ctx->Shader.EmitComments = GL_FALSE;
+   ctx->Shader.PendingJobs = 0;
+   _mesa_init_shader_queue(ctx);
 }
 
 
@@ -1411,7 +1422,8 @@ _mesa_compile_shader(GLcontext *ctx, GLuint shaderObj)
    if (!sh)
       return;
 
-   sh->CompileStatus = _slang_compile(ctx, sh);
+   if (!_mesa_queue_compile(ctx, sh))
+      sh->CompileStatus = _slang_compile(ctx, sh);
 }
 
 
@@ -1429,7 +1441,8 @@ _mesa_link_program(GLcontext *ctx, GLuint program)
 
    FLUSH_VERTICES(ctx, _NEW_PROGRAM);
 
-   _slang_link(ctx, program, shProg);
+   if (!_mesa_queue_link(ctx, shProg))
+      _slang_link(ctx, program, shProg);
 }
 
 
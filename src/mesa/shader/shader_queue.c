@@ -0,0 +1,421 @@
+/*
+ * Mesa 3-D graphics library
+ * Version:  7.4
+ *
+ * Copyright (C) 2009  VMware, Inc.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * BRIAN PAUL BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file shader_queue.c
+ * Compile GLSL shaders and link programs on worker threads.
+ *
+ * When the MESA_GLSL_THREADS environment variable is set to a number of
+ * threads, glCompileShader and glLinkProgram queue their work and return
+ * at once, so an application which compiles many shaders at startup gets
+ * them compiled in parallel.  Jobs run in the order they were queued; a
+ * link waits on its worker for the compiles of the attached shaders.
+ *
+ * Every access to a shader or program object from the API goes through
+ * the lookup functions in shader_api.c, which wait for the object's
+ * queued jobs first.  That covers status and info log queries,
+ * glUseProgram, attaching and detaching, and deleting.  A shader counts
+ * the links using it as pending too, so its source or code can't change
+ * under a queued link.  Workers never change reference counts, and
+ * freeing an object waits for its jobs as well.
+ */
+
+
+#include "main/glheader.h"
+#include "main/imports.h"
+#include "main/context.h"
+#include "main/macros.h"
+#include "glapi/glapi.h"
+#include "glapi/glthread.h"
+#include "shader/shader_queue.h"
+#include "shader/slang/slang_compile.h"
+#include "shader/slang/slang_link.h"
+
+
+#if defined(PTHREADS)
+
+#include <pthread.h>
+
+
+#define MAX_SHADER_THREADS 16
+
+
+struct shader_job
+{
+   GLcontext *ctx;
+   struct gl_shader *shader;            /**< shader to compile, or */
+   struct gl_shader_program *program;   /**< program to link */
+   struct shader_job *next;
+};
+
+
+static struct {
+   GLboolean Initialized;
+   GLuint MaxThreads;      /**< from MESA_GLSL_THREADS, 0 if disabled */
+   GLuint NumThreads;      /**< running worker threads */
+   GLuint NumStarted;
+   GLuint NumContexts;
+   GLboolean Quit;
+   struct shader_job *Head, *Tail;
+   pthread_t Threads[MAX_SHADER_THREADS];
+} Queue;
+
+static pthread_mutex_t QueueMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t QueueWork = PTHREAD_COND_INITIALIZER;  /**< job queued */
+static pthread_cond_t QueueDone = PTHREAD_COND_INITIALIZER;  /**< job done */
+
+
+static void
+run_job(struct shader_job *job)
+{
+   GLcontext *ctx = job->ctx;
+
+   _glapi_set_context((void *) ctx);
+
+   if (job->shader) {
+      job->shader->CompileStatus = _slang_compile(ctx, job->shader);
+   }
+   else {
+      struct gl_shader_program *shProg = job->program;
+      GLuint i;
+
+      /* wait for the attached shaders' compiles, queued before the link */
+      pthread_mutex_lock(&QueueMutex);
+      for (i = 0; i < shProg->NumShaders; i++) {
+         while (shProg->Shaders[i]->PendingCompiles)
+            pthread_cond_wait(&QueueDone, &QueueMutex);
+      }
+      pthread_mutex_unlock(&QueueMutex);
+
+      _slang_link(ctx, shProg->Name, shProg);
+   }
+
+   _glapi_set_context(NULL);
+}
+
+
+/**
+ * Drop the pending counts taken by queue_job().  Called with the mutex
+ * held.
+ */
+static void
+retire_job(struct shader_job *job)
+{
+   if (job->shader) {
+      job->shader->PendingCompiles--;
+      job->shader->PendingJobs--;
+   }
+   else {
+      struct gl_shader_program *shProg = job->program;
+      GLuint i;
+      for (i = 0; i < shProg->NumShaders; i++)
+         shProg->Shaders[i]->PendingJobs--;
+      shProg->PendingJobs--;
+   }
+   job->ctx->Shader.PendingJobs--;
+}
+
+
+static void *
+worker_main(void *data)
+{
+   (void) data;
+
+   /* Switch glapi to per-thread contexts, see marshal.c */
+   _glapi_check_multithread();
+
+   pthread_mutex_lock(&QueueMutex);
+   Queue.NumStarted++;
+   pthread_cond_broadcast(&QueueDone);
+
+   for (;;) {
+      struct shader_job *job;
+
+      while (!Queue.Head && !Queue.Quit)
+         pthread_cond_wait(&QueueWork, &QueueMutex);
+      if (!Queue.Head)
+         break;
+
+      job = Queue.Head;
+      Queue.Head = job->next;
+      if (!Queue.Head)
+         Queue.Tail = NULL;
+      pthread_mutex_unlock(&QueueMutex);
+
+      run_job(job);
+
+      pthread_mutex_lock(&QueueMutex);
+      retire_job(job);
+      _mesa_free(job);
+      pthread_cond_broadcast(&QueueDone);
+   }
+
+   pthread_mutex_unlock(&QueueMutex);
+   return NULL;
+}
+
+
+/**
+ * Start the worker threads on first use.  Called with the mutex held.
+ * \return GL_TRUE if there are workers to queue jobs for
+ */
+static GLboolean
+start_workers(void)
+{
+   if (!Queue.Initialized) {
+      const char *threads = _mesa_getenv("MESA_GLSL_THREADS");
+      GLint n = threads ? _mesa_atoi(threads) : 0;
+      Queue.MaxThreads = CLAMP(n, 0, MAX_SHADER_THREADS);
+      Queue.Initialized = GL_TRUE;
+   }
+
+   if (Queue.NumThreads == 0 && Queue.MaxThreads > 0) {
+      GLuint i;
+
+      Queue.Quit = GL_FALSE;
+      Queue.NumStarted = 0;
+      for (i = 0; i < Queue.MaxThreads; i++) {
+         if (pthread_create(&Queue.Threads[i], NULL, worker_main, NULL) != 0)
+            break;
+      }
+      Queue.NumThreads = i;
+      if (i == 0)
+         Queue.MaxThreads = 0;  /* don't try again */
+
+      /* don't let the application dispatch anything while glapi switches
+       * to per-thread contexts
+       */
+      while (Queue.NumStarted < Queue.NumThreads)
+         pthread_cond_wait(&QueueDone, &QueueMutex);
+   }
+
+   return Queue.NumThreads > 0;
+}
+
+
+/**
+ * Wait for the workers to finish and stop them.  Called with the mutex
+ * held; returns with it held.
+ */
+static void
+stop_workers(void)
+{
+   GLuint i, n = Queue.NumThreads;
+
+   Queue.Quit = GL_TRUE;
+   pthread_cond_broadcast(&QueueWork);
+   pthread_mutex_unlock(&QueueMutex);
+
+   for (i = 0; i < n; i++)
+      pthread_join(Queue.Threads[i], NULL);
+
+   pthread_mutex_lock(&QueueMutex);
+   Queue.NumThreads = 0;
+}
+
+
+/**
+ * Append a compile or link job to the queue and mark the objects it uses
+ * as pending.
+ */
+static GLboolean
+queue_job(GLcontext *ctx, struct gl_shader *sh,
+          struct gl_shader_program *shProg)
+{
+   struct shader_job *job;
+   GLuint i;
+
+   pthread_mutex_lock(&QueueMutex);
+
+   if (!start_workers()) {
+      pthread_mutex_unlock(&QueueMutex);
+      return GL_FALSE;
+   }
+
+   job = CALLOC_STRUCT(shader_job);
+   if (!job) {
+      pthread_mutex_unlock(&QueueMutex);
+      return GL_FALSE;
+   }
+
+   job->ctx = ctx;
+   job->shader = sh;
+   job->program = shProg;
+
+   if (sh) {
+      sh->PendingCompiles++;
+      sh->PendingJobs++;
+   }
+   else {
+      for (i = 0; i < shProg->NumShaders; i++)
+         shProg->Shaders[i]->PendingJobs++;
+      shProg->PendingJobs++;
+   }
+   ctx->Shader.PendingJobs++;
+
+   if (Queue.Tail)
+      Queue.Tail->next = job;
+   else
+      Queue.Head = job;
+   Queue.Tail = job;
+
+   pthread_cond_signal(&QueueWork);
+   pthread_mutex_unlock(&QueueMutex);
+   return GL_TRUE;
+}
+
+
+/**
+ * Called when a context is created.
+ */
+void
+_mesa_init_shader_queue(GLcontext *ctx)
+{
+   (void) ctx;
+   pthread_mutex_lock(&QueueMutex);
+   Queue.NumContexts++;
+   pthread_mutex_unlock(&QueueMutex);
+}
+
+
+/**
+ * Called when a context is destroyed: wait for the jobs run with it, and
+ * stop the workers along with the last context.
+ */
+void
+_mesa_free_shader_queue(GLcontext *ctx)
+{
+   pthread_mutex_lock(&QueueMutex);
+   while (ctx->Shader.PendingJobs)
+      pthread_cond_wait(&QueueDone, &QueueMutex);
+   if (--Queue.NumContexts == 0 && Queue.NumThreads)
+      stop_workers();
+   pthread_mutex_unlock(&QueueMutex);
+}
+
+
+/**
+ * Queue compiling a shader.
+ * \return GL_FALSE if the caller should compile it now
+ */
+GLboolean
+_mesa_queue_compile(GLcontext *ctx, struct gl_shader *sh)
+{
+   return queue_job(ctx, sh, NULL);
+}
+
+
+/**
+ * Queue linking a program.  Programs with linked code already are
+ * relinked now, since that code may be bound by a context.
+ * \return GL_FALSE if the caller should link it now
+ */
+GLboolean
+_mesa_queue_link(GLcontext *ctx, struct gl_shader_program *shProg)
+{
+   if (shProg == ctx->Shader.CurrentProgram ||
+       shProg->VertexProgram || shProg->FragmentProgram)
+      return GL_FALSE;
+
+   return queue_job(ctx, NULL, shProg);
+}
+
+
+/**
+ * Wait for the compiles of sh and the links using it.
+ */
+void
+_mesa_wait_shader(struct gl_shader *sh)
+{
+   if (!Queue.NumThreads)
+      return;
+
+   pthread_mutex_lock(&QueueMutex);
+   while (sh->PendingJobs)
+      pthread_cond_wait(&QueueDone, &QueueMutex);
+   pthread_mutex_unlock(&QueueMutex);
+}
+
+
+/**
+ * Wait for the links of shProg.
+ */
+void
+_mesa_wait_shader_program(struct gl_shader_program *shProg)
+{
+   if (!Queue.NumThreads)
+      return;
+
+   pthread_mutex_lock(&QueueMutex);
+   while (shProg->PendingJobs)
+      pthread_cond_wait(&QueueDone, &QueueMutex);
+   pthread_mutex_unlock(&QueueMutex);
+}
+
+
+#else /* PTHREADS */
+
+
+void
+_mesa_init_shader_queue(GLcontext *ctx)
+{
+   (void) ctx;
+}
+
+void
+_mesa_free_shader_queue(GLcontext *ctx)
+{
+   (void) ctx;
+}
+
+GLboolean
+_mesa_queue_compile(GLcontext *ctx, struct gl_shader *sh)
+{
+   (void) ctx;
+   (void) sh;
+   return GL_FALSE;
+}
+
+GLboolean
+_mesa_queue_link(GLcontext *ctx, struct gl_shader_program *shProg)
+{
+   (void) ctx;
+   (void) shProg;
+   return GL_FALSE;
+}
+
+void
+_mesa_wait_shader(struct gl_shader *sh)
+{
+   (void) sh;
+}
+
+void
+_mesa_wait_shader_program(struct gl_shader_program *shProg)
+{
+   (void) shProg;
+}
+
+
+#endif /* PTHREADS */
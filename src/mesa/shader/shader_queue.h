@@ -0,0 +1,53 @@
+/*
+ * Mesa 3-D graphics library
+ * Version:  7.4
+ *
+ * Copyright (C) 2009  VMware, Inc.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * BRIAN PAUL BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef SHADER_QUEUE_H
+#define SHADER_QUEUE_H
+
+
+#include "main/glheader.h"
+#include "main/mtypes.h"
+
+
+extern void
+_mesa_init_shader_queue(GLcontext *ctx);
+
+extern void
+_mesa_free_shader_queue(GLcontext *ctx);
+
+extern GLboolean
+_mesa_queue_compile(GLcontext *ctx, struct gl_shader *sh);
+
+extern GLboolean
+_mesa_queue_link(GLcontext *ctx, struct gl_shader_program *shProg);
+
+extern void
+_mesa_wait_shader(struct gl_shader *sh);
+
+extern void
+_mesa_wait_shader_program(struct gl_shader_program *shProg);
+
+
+#endif /* SHADER_QUEUE_H */
@@ -0,0 +1,923 @@
+/*
+ * Mesa 3-D graphics library
+ * Version:  7.4
+ *
+ * Copyright (C) 2009  VMware, Inc.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * BRIAN PAUL BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file slang_cache.c
+ * On-disk cache of compiled shaders.
+ *
+ * If the MESA_GLSL_CACHE_DIR environment variable names a directory, the
+ * program produced for each successfully compiled shader (instructions,
+ * parameter, varying and attribute lists) is saved to a file there.  Any
+ * later compile of the same source with the same compiler options, by
+ * this or another process running the same Mesa build, loads the program
+ * from that file instead of running the compiler.
+ *
+ * The directory also holds an "index" file recording the size and last
+ * use of each entry.  When the entries add up to more than
+ * MESA_GLSL_CACHE_SIZE kilobytes (16MB by default) the least recently
+ * used ones are deleted.  Processes sharing the directory serialize
+ * index updates with a lock on the "index.lock" file.
+ */
+
+#include <stdio.h>
+#if defined(__unix__) || defined(__APPLE__)
+#define CACHE_HAVE_POSIX 1
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <process.h>
+#endif
+#include "main/imports.h"
+#include "main/context.h"
+#include "main/macros.h"
+#include "main/version.h"
+#include "glapi/glthread.h"
+#include "shader/program.h"
+#include "shader/prog_instruction.h"
+#include "shader/prog_parameter.h"
+#include "slang_cache.h"
+
+
+/** Change this whenever the layout of the entries changes */
+#define CACHE_FORMAT_VERSION 1
+
+/** Default size limit, in kilobytes */
+#define CACHE_DEFAULT_SIZE (16 * 1024)
+
+static const char CacheMagic[8] = { 'M', 'E', 'S', 'A', 'G', 'L', 'S', 'L' };
+
+/**
+ * Entries written by another build of Mesa are never used.  The makefile
+ * recompiles this file whenever any other core object is rebuilt, so the
+ * time stamp changes with every build of the compiler.
+ */
+static const char BuildId[] = MESA_VERSION_STRING " " __DATE__ " " __TIME__;
+
+
+/**
+ * Everything besides the source text which affects the compiler output.
+ */
+struct cache_options
+{
+   GLuint Type;
+   GLuint EmitHighLevelInstructions;
+   GLuint EmitCondCodes;
+   GLuint EmitComments;
+   GLuint VertexMaxTemps;
+   GLuint VertexMaxUniformComponents;
+   GLuint FragmentMaxTemps;
+   GLuint FragmentMaxUniformComponents;
+   GLuint ARB_draw_buffers;
+   GLuint NV_texture_rectangle;
+   GLuint InstructionSize;
+   GLuint ParameterSize;
+};
+
+
+/** One line of the index file */
+struct cache_entry
+{
+   char Name[17];
+   GLuint Size;    /**< file size in bytes */
+   GLuint Stamp;   /**< larger is more recently used */
+};
+
+
+/**
+ * Cache configuration, read from the environment on first use.
+ * The mutex serializes index file updates within the process.
+ */
+static struct {
+   GLboolean Initialized;
+   char *Dir;          /**< NULL if the cache is disabled */
+   GLuint MaxSize;     /**< in bytes */
+} Cache;
+
+_glthread_DECLARE_STATIC_MUTEX(CacheMutex);
+
+
+static GLboolean
+cache_enabled(void)
+{
+   _glthread_LOCK_MUTEX(CacheMutex);
+   if (!Cache.Initialized) {
+      const char *dir = _mesa_getenv("MESA_GLSL_CACHE_DIR");
+      const char *size = _mesa_getenv("MESA_GLSL_CACHE_SIZE");
+      GLint kb = size ? _mesa_atoi(size) : CACHE_DEFAULT_SIZE;
+
+      if (kb <= 0 || kb > 1024 * 1024)
+         kb = CACHE_DEFAULT_SIZE;
+      Cache.Dir = (dir && dir[0]) ? _mesa_strdup(dir) : NULL;
+      Cache.MaxSize = (GLuint) kb * 1024;
+      Cache.Initialized = GL_TRUE;
+   }
+   _glthread_UNLOCK_MUTEX(CacheMutex);
+
+   return Cache.Dir != NULL;
+}
+
+
+/**
+ * Return the path of a file in the cache directory.  Free with _mesa_free.
+ */
+static char *
+cache_path(const char *name, const char *suffix)
+{
+   char *path = (char *) _mesa_malloc(_mesa_strlen(Cache.Dir) +
+                                      _mesa_strlen(name) +
+                                      _mesa_strlen(suffix) + 2);
+   if (path)
+      _mesa_sprintf(path, "%s/%s%s", Cache.Dir, name, suffix);
+   return path;
+}
+
+
+/**
+ * Return a temporary file name for 'name' which no other thread or
+ * process writing to the cache will use.  Free with _mesa_free.
+ * Must be called with CacheMutex held.
+ */
+static char *
+cache_temp_path(const char *name)
+{
+   static GLuint serial = 0;
+   char suffix[48];
+#if defined(CACHE_HAVE_POSIX)
+   const unsigned long pid = (unsigned long) getpid();
+#elif defined(_WIN32)
+   const unsigned long pid = (unsigned long) _getpid();
+#else
+   const unsigned long pid = 0;
+#endif
+
+   _mesa_sprintf(suffix, ".%lx.%x.tmp", pid, serial++);
+   return cache_path(name, suffix);
+}
+
+
+/**
+ * \name Serialization
+ * Entries are written to and parsed from a cache_buffer.  Values are
+ * stored in the native format since entries are only ever read back by
+ * the build which wrote them.
+ */
+/*@{*/
+
+struct cache_buffer
+{
+   GLubyte *Data;
+   GLuint Size;      /**< bytes allocated (writing) or available (reading) */
+   GLuint Pos;       /**< current write/read position */
+   GLboolean Error;  /**< out of memory, or read past the end */
+};
+
+
+static void
+put(struct cache_buffer *buf, const void *data, GLuint n)
+{
+   if (buf->Error)
+      return;
+
+   if (buf->Pos + n > buf->Size) {
+      GLuint newSize = MAX2(2 * buf->Size, buf->Pos + n);
+      newSize = MAX2(newSize, 4096);
+      buf->Data = (GLubyte *) _mesa_realloc(buf->Data, buf->Size, newSize);
+      if (!buf->Data) {
+         buf->Size = 0;
+         buf->Error = GL_TRUE;
+         return;
+      }
+      buf->Size = newSize;
+   }
+
+   _mesa_memcpy(buf->Data + buf->Pos, data, n);
+   buf->Pos += n;
+}
+
+
+static void
+put_uint(struct cache_buffer *buf, GLuint value)
+{
+   put(buf, &value, sizeof(value));
+}
+
+
+static void
+put_string(struct cache_buffer *buf, const char *s)
+{
+   if (s) {
+      const GLuint len = _mesa_strlen(s);
+      put_uint(buf, len);
+      put(buf, s, len);
+   }
+   else {
+      put_uint(buf, ~0u);
+   }
+}
+
+
+static void
+get(struct cache_buffer *buf, void *data, GLuint n)
+{
+   if (buf->Error || n > buf->Size - buf->Pos) {
+      buf->Error = GL_TRUE;
+      _mesa_bzero(data, n);
+      return;
+   }
+
+   _mesa_memcpy(data, buf->Data + buf->Pos, n);
+   buf->Pos += n;
+}
+
+
+static GLuint
+get_uint(struct cache_buffer *buf)
+{
+   GLuint value;
+   get(buf, &value, sizeof(value));
+   return value;
+}
+
+
+/**
+ * Return a copy of the next string (free with _mesa_free), or NULL.
+ */
+static char *
+get_string(struct cache_buffer *buf)
+{
+   const GLuint len = get_uint(buf);
+   char *s;
+
+   if (buf->Error || len == ~0u)
+      return NULL;
+
+   if (len > buf->Size - buf->Pos) {
+      buf->Error = GL_TRUE;
+      return NULL;
+   }
+
+   s = (char *) _mesa_malloc(len + 1);
+   if (!s) {
+      buf->Error = GL_TRUE;
+      return NULL;
+   }
+   get(buf, s, len);
+   s[len] = '\0';
+   return s;
+}
+
+
+static void
+put_parameters(struct cache_buffer *buf,
+               const struct gl_program_parameter_list *list)
+{
+   GLuint i;
+
+   put_uint(buf, list->NumParameters);
+   put_uint(buf, list->StateFlags);
+   for (i = 0; i < list->NumParameters; i++) {
+      struct gl_program_parameter p = list->Parameters[i];
+      put_string(buf, p.Name);
+      p.Name = NULL;
+      put(buf, &p, sizeof(p));
+      put(buf, list->ParameterValues[i], 4 * sizeof(GLfloat));
+   }
+}
+
+
+static struct gl_program_parameter_list *
+get_parameters(struct cache_buffer *buf)
+{
+   struct gl_program_parameter_list *list = _mesa_new_parameter_list();
+   const GLuint count = get_uint(buf);
+   const GLbitfield stateFlags = get_uint(buf);
+   GLuint i;
+
+   if (!list) {
+      buf->Error = GL_TRUE;
+      return NULL;
+   }
+
+   for (i = 0; i < count && !buf->Error; i++) {
+      struct gl_program_parameter p;
+      GLfloat values[4];
+      char *name = get_string(buf);
+      GLint j;
+
+      get(buf, &p, sizeof(p));
+      get(buf, values, sizeof(values));
+      if (buf->Error) {
+         _mesa_free(name);
+         break;
+      }
+
+      /* add a single slot, then overwrite it with the saved fields */
+      j = _mesa_add_parameter(list, p.Type, name, 4, p.DataType,
+                              values, NULL, 0x0);
+      _mesa_free(name);
+      if (j < 0) {
+         buf->Error = GL_TRUE;
+         break;
+      }
+      p.Name = list->Parameters[j].Name;
+      list->Parameters[j] = p;
+   }
+   list->StateFlags = stateFlags;
+
+   if (buf->Error) {
+      _mesa_free_parameter_list(list);
+      return NULL;
+   }
+   return list;
+}
+
+
+/**
+ * \return GL_FALSE if the program can't be cached
+ */
+static GLboolean
+put_program(struct cache_buffer *buf, const struct gl_program *prog)
+{
+   GLuint i;
+
+   if (!prog->Parameters || !prog->Varying || !prog->Attributes)
+      return GL_FALSE;
+
+   put_uint(buf, prog->Target);
+   put_uint(buf, prog->NumInstructions);
+   for (i = 0; i < prog->NumInstructions; i++) {
+      struct prog_instruction inst = prog->Instructions[i];
+      if (inst.Data)
+         return GL_FALSE;
+      inst.Comment = NULL;
+      put(buf, &inst, sizeof(inst));
+      put_string(buf, prog->Instructions[i].Comment);
+   }
+
+   put_uint(buf, prog->InputsRead);
+   put_uint(buf, prog->OutputsWritten);
+   put(buf, prog->InputFlags, sizeof(prog->InputFlags));
+   put(buf, prog->OutputFlags, sizeof(prog->OutputFlags));
+   put(buf, prog->TexturesUsed, sizeof(prog->TexturesUsed));
+   put_uint(buf, prog->SamplersUsed);
+   put_uint(buf, prog->ShadowSamplers);
+   put(buf, prog->SamplerUnits, sizeof(prog->SamplerUnits));
+   put(buf, prog->SamplerTargets, sizeof(prog->SamplerTargets));
+
+   put_uint(buf, prog->NumTemporaries);
+   put_uint(buf, prog->NumParameters);
+   put_uint(buf, prog->NumAttributes);
+   put_uint(buf, prog->NumAddressRegs);
+   put_uint(buf, prog->NumAluInstructions);
+   put_uint(buf, prog->NumTexInstructions);
+   put_uint(buf, prog->NumTexIndirections);
+   put_uint(buf, prog->NumNativeInstructions);
+   put_uint(buf, prog->NumNativeTemporaries);
+   put_uint(buf, prog->NumNativeParameters);
+   put_uint(buf, prog->NumNativeAttributes);
+   put_uint(buf, prog->NumNativeAddressRegs);
+   put_uint(buf, prog->NumNativeAluInstructions);
+   put_uint(buf, prog->NumNativeTexInstructions);
+   put_uint(buf, prog->NumNativeTexIndirections);
+
+   put_parameters(buf, prog->Parameters);
+   put_parameters(buf, prog->Varying);
+   put_parameters(buf, prog->Attributes);
+
+   if (prog->Target == GL_VERTEX_PROGRAM_ARB) {
+      const struct gl_vertex_program *vp
+         = (const struct gl_vertex_program *) prog;
+      put_uint(buf, vp->IsPositionInvariant);
+   }
+   else {
+      const struct gl_fragment_program *fp
+         = (const struct gl_fragment_program *) prog;
+      put_uint(buf, fp->FogOption);
+      put_uint(buf, fp->UsesKill);
+      put_uint(buf, fp->UsesPointCoord);
+      put_uint(buf, fp->UsesFrontFacing);
+      put_uint(buf, fp->UsesFogFragCoord);
+   }
+
+   return !buf->Error;
+}
+
+
+static struct gl_program *
+get_program(GLcontext *ctx, struct cache_buffer *buf, GLenum target)
+{
+   struct gl_program *prog;
+   GLuint i, numInst;
+
+   if (get_uint(buf) != target)
+      return NULL;
+   numInst = get_uint(buf);
+   if (buf->Error || numInst == 0 ||
+       numInst > (buf->Size - buf->Pos) / sizeof(struct prog_instruction))
+      return NULL;
+
+   prog = ctx->Driver.NewProgram(ctx, target, 1);
+   if (!prog)
+      return NULL;
+
+   prog->Instructions = _mesa_alloc_instructions(numInst);
+   if (!prog->Instructions) {
+      _mesa_reference_program(ctx, &prog, NULL);
+      return NULL;
+   }
+   prog->NumInstructions = numInst;
+   for (i = 0; i < numInst; i++) {
+      struct prog_instruction *inst = prog->Instructions + i;
+      get(buf, inst, sizeof(*inst));
+      inst->Data = NULL;
+      inst->Comment = get_string(buf);
+   }
+
+   prog->InputsRead = get_uint(buf);
+   prog->OutputsWritten = get_uint(buf);
+   get(buf, prog->InputFlags, sizeof(prog->InputFlags));
+   get(buf, prog->OutputFlags, sizeof(prog->OutputFlags));
+   get(buf, prog->TexturesUsed, sizeof(prog->TexturesUsed));
+   prog->SamplersUsed = get_uint(buf);
+   prog->ShadowSamplers = get_uint(buf);
+   get(buf, prog->SamplerUnits, sizeof(prog->SamplerUnits));
+   get(buf, prog->SamplerTargets, sizeof(prog->SamplerTargets));
+
+   prog->NumTemporaries = get_uint(buf);
+   prog->NumParameters = get_uint(buf);
+   prog->NumAttributes = get_uint(buf);
+   prog->NumAddressRegs = get_uint(buf);
+   prog->NumAluInstructions = get_uint(buf);
+   prog->NumTexInstructions = get_uint(buf);
+   prog->NumTexIndirections = get_uint(buf);
+   prog->NumNativeInstructions = get_uint(buf);
+   prog->NumNativeTemporaries = get_uint(buf);
+   prog->NumNativeParameters = get_uint(buf);
+   prog->NumNativeAttributes = get_uint(buf);
+   prog->NumNativeAddressRegs = get_uint(buf);
+   prog->NumNativeAluInstructions = get_uint(buf);
+   prog->NumNativeTexInstructions = get_uint(buf);
+   prog->NumNativeTexIndirections = get_uint(buf);
+
+   prog->Parameters = get_parameters(buf);
+   prog->Varying = get_parameters(buf);
+   prog->Attributes = get_parameters(buf);
+
+   if (target == GL_VERTEX_PROGRAM_ARB) {
+      struct gl_vertex_program *vp = (struct gl_vertex_program *) prog;
+      vp->IsPositionInvariant = get_uint(buf);
+   }
+   else {
+      struct gl_fragment_program *fp = (struct gl_fragment_program *) prog;
+      fp->FogOption = get_uint(buf);
+      fp->UsesKill = get_uint(buf);
+      fp->UsesPointCoord = get_uint(buf);
+      fp->UsesFrontFacing = get_uint(buf);
+      fp->UsesFogFragCoord = get_uint(buf);
+   }
+
+   if (buf->Error) {
+      _mesa_reference_program(ctx, &prog, NULL);
+      return NULL;
+   }
+   return prog;
+}
+
+/*@}*/
+
+
+/**
+ * Write the part of an entry which identifies it: the build, the compiler
+ * options and the shader source.  The entry's file name is a hash of this.
+ */
+static void
+put_header(GLcontext *ctx, struct cache_buffer *buf,
+           const struct gl_shader *shader)
+{
+   struct cache_options opt;
+
+   _mesa_bzero(&opt, sizeof(opt));
+   opt.Type = shader->Type;
+   opt.EmitHighLevelInstructions = ctx->Shader.EmitHighLevelInstructions;
+   opt.EmitCondCodes = ctx->Shader.EmitCondCodes;
+   opt.EmitComments = ctx->Shader.EmitComments;
+   opt.VertexMaxTemps = ctx->Const.VertexProgram.MaxTemps;
+   opt.VertexMaxUniformComponents =
+      ctx->Const.VertexProgram.MaxUniformComponents;
+   opt.FragmentMaxTemps = ctx->Const.FragmentProgram.MaxTemps;
+   opt.FragmentMaxUniformComponents =
+      ctx->Const.FragmentProgram.MaxUniformComponents;
+   opt.ARB_draw_buffers = ctx->Extensions.ARB_draw_buffers;
+   opt.NV_texture_rectangle = ctx->Extensions.NV_texture_rectangle;
+   opt.InstructionSize = sizeof(struct prog_instruction);
+   opt.ParameterSize = sizeof(struct gl_program_parameter);
+
+   put(buf, CacheMagic, sizeof(CacheMagic));
+   put_uint(buf, CACHE_FORMAT_VERSION);
+   put_string(buf, BuildId);
+   put(buf, &opt, sizeof(opt));
+   put_string(buf, shader->Source);
+}
+
+
+/**
+ * Compute the entry name from the header bytes.
+ */
+static void
+entry_name(const struct cache_buffer *header, char name[17])
+{
+   GLuint h1 = 2166136261u, h2 = 5381, i;
+
+   for (i = 0; i < header->Pos; i++) {
+      h1 = (h1 ^ header->Data[i]) * 16777619u;
+      h2 = (h2 * 33) ^ header->Data[i];
+   }
+   _mesa_sprintf(name, "%08x%08x", h1, h2);
+}
+
+
+/**
+ * \name Index file
+ */
+/*@{*/
+
+/**
+ * Take the lock which serializes index updates between processes.
+ * CacheMutex must be held as well, since POSIX record locks don't
+ * exclude other threads of the same process.
+ * \return handle to pass to unlock_index()
+ */
+static int
+lock_index(void)
+{
+#if defined(CACHE_HAVE_POSIX)
+   char *path = cache_path("index", ".lock");
+   struct flock lock;
+   int fd;
+
+   if (!path)
+      return -1;
+   fd = open(path, O_RDWR | O_CREAT, 0644);
+   _mesa_free(path);
+   if (fd < 0)
+      return -1;
+
+   _mesa_bzero(&lock, sizeof(lock));
+   lock.l_type = F_WRLCK;
+   lock.l_whence = SEEK_SET;
+   while (fcntl(fd, F_SETLKW, &lock) != 0) {
+      if (errno != EINTR) {
+         close(fd);
+         return -1;
+      }
+   }
+   return fd;
+#else
+   return -1;
+#endif
+}
+
+
+static void
+unlock_index(int fd)
+{
+#if defined(CACHE_HAVE_POSIX)
+   if (fd >= 0)
+      close(fd);  /* releases the lock */
+#else
+   (void) fd;
+#endif
+}
+
+
+static struct cache_entry *
+read_index(const char *path, GLuint *count, GLuint *stamp)
+{
+   struct cache_entry *entries = NULL, e;
+   GLuint size = 0;
+   FILE *f;
+
+   *count = 0;
+   *stamp = 0;
+
+   f = fopen(path, "r");
+   if (!f)
+      return NULL;
+
+   if (fscanf(f, "stamp %u\n", stamp) == 1) {
+      while (fscanf(f, "%16s %u %u\n", e.Name, &e.Size, &e.Stamp) == 3) {
+         if (*count == size) {
+            GLuint newSize = size ? 2 * size : 64;
+            entries = (struct cache_entry *)
+               _mesa_realloc(entries, size * sizeof(e), newSize * sizeof(e));
+            if (!entries) {
+               *count = 0;
+               break;
+            }
+            size = newSize;
+         }
+         entries[(*count)++] = e;
+      }
+   }
+
+   fclose(f);
+   return entries;
+}
+
+
+static void
+write_index(const char *path, const struct cache_entry *entries,
+            GLuint count, GLuint stamp)
+{
+   char *tmpPath = cache_temp_path("index");
+   GLboolean ok;
+   GLuint i;
+   FILE *f;
+
+   if (!tmpPath)
+      return;
+
+   f = fopen(tmpPath, "w");
+   if (f) {
+      ok = fprintf(f, "stamp %u\n", stamp) > 0;
+      for (i = 0; i < count && ok; i++)
+         ok = fprintf(f, "%s %u %u\n", entries[i].Name, entries[i].Size,
+                      entries[i].Stamp) > 0;
+      ok = (fclose(f) == 0) && ok;
+
+      if (ok && rename(tmpPath, path) != 0) {
+         /* rename() won't replace an existing file everywhere */
+         remove(path);
+         ok = (rename(tmpPath, path) == 0);
+      }
+      if (!ok)
+         remove(tmpPath);
+   }
+
+   _mesa_free(tmpPath);
+}
+
+
+/**
+ * Mark the named entry as the most recently used one, then delete the
+ * least recently used entries until the cache fits its size limit.
+ */
+static void
+update_index(const char *name, GLuint size)
+{
+   struct cache_entry *entries;
+   GLuint count, stamp, total, i, cur;
+   char *path;
+   int lock;
+
+   _glthread_LOCK_MUTEX(CacheMutex);
+
+   path = cache_path("index", "");
+   if (!path) {
+      _glthread_UNLOCK_MUTEX(CacheMutex);
+      return;
+   }
+
+   lock = lock_index();
+   entries = read_index(path, &count, &stamp);
+
+   for (cur = 0; cur < count; cur++) {
+      if (_mesa_strcmp(entries[cur].Name, name) == 0)
+         break;
+   }
+   if (cur == count) {
+      struct cache_entry *grown = (struct cache_entry *)
+         _mesa_realloc(entries, count * sizeof(*entries),
+                       (count + 1) * sizeof(*entries));
+      if (!grown) {
+         unlock_index(lock);
+         _mesa_free(entries);
+         _mesa_free(path);
+         _glthread_UNLOCK_MUTEX(CacheMutex);
+         return;
+      }
+      entries = grown;
+      _mesa_strcpy(entries[cur].Name, name);
+      count++;
+   }
+   entries[cur].Size = size;
+   entries[cur].Stamp = stamp++;
+
+   total = 0;
+   for (i = 0; i < count; i++)
+      total += entries[i].Size;
+
+   while (total > Cache.MaxSize && count > 1) {
+      /* evict the least recently used entry, other than this one */
+      GLuint oldest = (cur == 0) ? 1 : 0;
+      char *entryPath;
+
+      for (i = 0; i < count; i++) {
+         if (i != cur && entries[i].Stamp < entries[oldest].Stamp)
+            oldest = i;
+      }
+
+      entryPath = cache_path(entries[oldest].Name, ".prog");
+      if (entryPath) {
+         remove(entryPath);
+         _mesa_free(entryPath);
+      }
+      total -= entries[oldest].Size;
+
+      entries[oldest] = entries[--count];
+      if (cur == count)
+         cur = oldest;
+   }
+
+   write_index(path, entries, count, stamp);
+   unlock_index(lock);
+
+   _mesa_free(entries);
+   _mesa_free(path);
+
+   _glthread_UNLOCK_MUTEX(CacheMutex);
+}
+
+/*@}*/
+
+
+/**
+ * Read a whole entry file into buf.
+ */
+static GLboolean
+read_entry(const char *name, struct cache_buffer *buf)
+{
+   char *path = cache_path(name, ".prog");
+   GLboolean ok = GL_FALSE;
+   FILE *f;
+   long size;
+
+   if (!path)
+      return GL_FALSE;
+
+   f = fopen(path, "rb");
+   _mesa_free(path);
+   if (!f)
+      return GL_FALSE;
+
+   if (fseek(f, 0, SEEK_END) == 0 &&
+       (size = ftell(f)) > 0 &&
+       fseek(f, 0, SEEK_SET) == 0) {
+      buf->Data = (GLubyte *) _mesa_malloc(size);
+      if (buf->Data && fread(buf->Data, 1, size, f) == (size_t) size) {
+         buf->Size = (GLuint) size;
+         buf->Pos = 0;
+         ok = GL_TRUE;
+      }
+   }
+
+   fclose(f);
+   return ok;
+}
+
+
+static void
+write_entry(const char *name, const struct cache_buffer *buf)
+{
+   char *tmpPath, *path = cache_path(name, ".prog");
+   FILE *f;
+
+   _glthread_LOCK_MUTEX(CacheMutex);
+   tmpPath = cache_temp_path(name);
+   _glthread_UNLOCK_MUTEX(CacheMutex);
+
+   if (tmpPath && path) {
+      /* write to a temporary file first so readers never see partial
+       * entries
+       */
+      f = fopen(tmpPath, "wb");
+      if (f) {
+         GLboolean ok = (fwrite(buf->Data, 1, buf->Pos, f) == buf->Pos);
+         ok = (fclose(f) == 0) && ok;
+         if (ok && rename(tmpPath, path) != 0) {
+            remove(path);
+            ok = (rename(tmpPath, path) == 0);
+         }
+         if (!ok)
+            remove(tmpPath);
+      }
+   }
+
+   _mesa_free(tmpPath);
+   _mesa_free(path);
+}
+
+
+/**
+ * Look for the shader in the cache.  If found, replace shader->Program
+ * and the other compile results with the cached ones.
+ * \return GL_TRUE if the shader was found, GL_FALSE if it must be compiled
+ */
+GLboolean
+_slang_cache_load(GLcontext *ctx, struct gl_shader *shader)
+{
+   const GLenum target = (shader->Type == GL_VERTEX_SHADER)
+      ? GL_VERTEX_PROGRAM_ARB : GL_FRAGMENT_PROGRAM_ARB;
+   struct cache_buffer header, buf;
+   struct gl_program *prog = NULL;
+   char name[17];
+   GLuint isMain, optimize, debug;
+   char *infoLog = NULL;
+
+   if (!cache_enabled())
+      return GL_FALSE;
+
+   _mesa_bzero(&header, sizeof(header));
+   _mesa_bzero(&buf, sizeof(buf));
+
+   put_header(ctx, &header, shader);
+   if (header.Error)
+      return GL_FALSE;
+   entry_name(&header, name);
+
+   if (read_entry(name, &buf) &&
+       buf.Size >= header.Pos &&
+       _mesa_memcmp(buf.Data, header.Data, header.Pos) == 0) {
+      buf.Pos = header.Pos;
+      isMain = get_uint(&buf);
+      optimize = get_uint(&buf);
+      debug = get_uint(&buf);
+      infoLog = get_string(&buf);
+      if (!buf.Error)
+         prog = get_program(ctx, &buf, target);
+   }
+
+   if (prog) {
+      if (shader->InfoLog)
+         _mesa_free(shader->InfoLog);
+      shader->InfoLog = infoLog;
+      shader->Main = (GLboolean) isMain;
+      shader->Pragmas.Optimize = (GLboolean) optimize;
+      shader->Pragmas.Debug = (GLboolean) debug;
+      _mesa_reference_program(ctx, &shader->Program, NULL);
+      shader->Program = prog;
+
+      update_index(name, buf.Size);
+   }
+   else if (infoLog) {
+      _mesa_free(infoLog);
+   }
+
+   _mesa_free(header.Data);
+   _mesa_free(buf.Data);
+
+   return prog != NULL;
+}
+
+
+/**
+ * Save the results of a successful compile in the cache.
+ */
+void
+_slang_cache_store(GLcontext *ctx, const struct gl_shader *shader)
+{
+   struct cache_buffer buf;
+   char name[17];
+
+   if (!cache_enabled())
+      return;
+
+   _mesa_bzero(&buf, sizeof(buf));
+
+   put_header(ctx, &buf, shader);
+   entry_name(&buf, name);
+
+   put_uint(&buf, shader->Main);
+   put_uint(&buf, shader->Pragmas.Optimize);
+   put_uint(&buf, shader->Pragmas.Debug);
+   put_string(&buf, shader->InfoLog);
+
+   if (put_program(&buf, shader->Program)) {
+      write_entry(name, &buf);
+      update_index(name, buf.Pos);
+   }
+
+   _mesa_free(buf.Data);
+}
@@ -316,7 +316,17 @@ _slang_attach_storage(slang_ir_node *n, slang_variable *var)
 
    if (!n->Store) {
       /* need to setup storage */
-      if (n->Var && n->Var->store) {
+      if (n->Var && n->Var->store &&
+          n->Var->store->File == PROGRAM_STATE_VAR) {
+         /* A built-in state var.  The built-in library is shared by all
+          * compiles, so give the node its own storage for the parameter
+          * index allocated in this program.
+          */
+         const slang_ir_storage *st = n->Var->store;
+         n->Store = _slang_new_ir_storage_swz(st->File, st->Index,
+                                              st->Size, st->Swizzle);
+      }
+      else if (n->Var && n->Var->store) {
          /* node storage info = var storage info */
          n->Store = n->Var->store;
       }
@@ -1310,6 +1320,8 @@ slang_inline_function_call(slang_assemble_ctx * A, slang_function *fun,
       pCopy->type = p->type;
       pCopy->a_name = p->a_name;
       pCopy->array_len = p->array_len;
+      /* the inlined code must not refer to the function's own vars */
+      newScope = inlined->locals;
    }
 
 
@@ -2929,14 +2941,14 @@ make_constant_array(slang_assemble_ctx *A,
    assert(initializer->type == SLANG_OPER_CALL);
    assert(initializer->array_constructor);
 
-   values = (GLfloat *) _mesa_malloc(numElements * 4 * sizeof(GLfloat));
+   values = (GLfloat *) _slang_alloc(numElements * 4 * sizeof(GLfloat));
 
    /* convert constructor params into ordinary floats */
    for (i = 0; i < numElements; i++) {
       const slang_operation *op = &initializer->children[i];
       if (op->type != SLANG_OPER_LITERAL_FLOAT) {
          /* unsupported type for this optimization */
-         free(values);
+         _slang_free(values);
          return GL_FALSE;
       }
       for (j = 0; j < op->literal_size; j++) {
@@ -2960,7 +2972,7 @@ make_constant_array(slang_assemble_ctx *A,
    }
    assert(var->store->Size == size);
 
-   _mesa_free(values);
+   _slang_free(values);
 
    return GL_TRUE;
 }
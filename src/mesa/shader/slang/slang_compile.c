@@ -30,13 +30,16 @@
 
 #include "main/imports.h"
 #include "main/context.h"
+#include "glapi/glthread.h"
 #include "shader/program.h"
 #include "shader/programopt.h"
 #include "shader/prog_print.h"
 #include "shader/prog_parameter.h"
 #include "shader/grammar/grammar_mesa.h"
+#include "slang_cache.h"
 #include "slang_codegen.h"
 #include "slang_compile.h"
+#include "slang_parse.h"
 #include "slang_preprocess.h"
 #include "slang_storage.h"
 #include "slang_emit.h"
@@ -103,10 +106,6 @@ _slang_code_unit_dtr(slang_code_unit * self)
 GLvoid
 _slang_code_object_ctr(slang_code_object * self)
 {
-   GLuint i;
-
-   for (i = 0; i < SLANG_BUILTIN_TOTAL; i++)
-      _slang_code_unit_ctr(&self->builtin[i], self);
    _slang_code_unit_ctr(&self->unit, self);
    slang_atom_pool_construct(&self->atompool);
 }
@@ -114,10 +113,6 @@ _slang_code_object_ctr(slang_code_object * self)
 GLvoid
 _slang_code_object_dtr(slang_code_object * self)
 {
-   GLuint i;
-
-   for (i = 0; i < SLANG_BUILTIN_TOTAL; i++)
-      _slang_code_unit_dtr(&self->builtin[i]);
    _slang_code_unit_dtr(&self->unit);
    slang_atom_pool_destruct(&self->atompool);
 }
@@ -2475,15 +2470,15 @@ compile_binary(const byte * prod, slang_code_unit * unit,
 }
 
 static GLboolean
-compile_with_grammar(grammar id, const char *source, slang_code_unit * unit,
-                     slang_unit_type type, slang_info_log * infolog,
-                     slang_code_unit * builtin,
-                     struct gl_shader *shader,
-                     const struct gl_extensions *extensions,
-                     struct gl_sl_pragmas *pragmas)
+compile_source(const char *source, slang_code_unit * unit,
+               slang_unit_type type, slang_info_log * infolog,
+               slang_code_unit * builtin, GLboolean extensions_allowed,
+               struct gl_shader *shader,
+               const struct gl_extensions *extensions,
+               struct gl_sl_pragmas *pragmas)
 {
-   byte *prod;
-   GLuint size, start, version;
+   GLubyte *prod;
+   GLuint start, version;
    slang_string preprocessed;
    GLuint maxVersion;
 
@@ -2516,45 +2511,23 @@ compile_with_grammar(grammar id, const char *source, slang_code_unit * unit,
    }
 
    /* Finally check the syntax and generate its binary representation. */
-   if (!grammar_fast_check(id,
-                           (const byte *) (slang_string_cstr(&preprocessed)),
-                           &prod, &size, 65536)) {
-      char buf[1024];
-      GLint pos;
+   prod = _slang_parse_source(slang_string_cstr(&preprocessed), type,
+                              extensions_allowed, infolog);
+   slang_string_free(&preprocessed);
 
-      slang_string_free(&preprocessed);
-      grammar_get_last_error((byte *) (buf), sizeof(buf), &pos);
-      slang_info_log_error(infolog, buf);
-      /* syntax error (possibly in library code) */
-#if 0
-      {
-         int line, col;
-         char *s;
-         s = (char *) _mesa_find_line_column((const GLubyte *) source,
-                                             (const GLubyte *) source + pos,
-                                             &line, &col);
-         printf("Error on line %d, col %d: %s\n", line, col, s);
-      }
-#endif
+   if (!prod)
       return GL_FALSE;
-   }
-   slang_string_free(&preprocessed);
 
    /* Syntax is okay - translate it to internal representation. */
    if (!compile_binary(prod, unit, version, type, infolog, builtin,
-                       &builtin[SLANG_BUILTIN_TOTAL - 1],
-                       shader)) {
-      grammar_alloc_free(prod);
+                       builtin, shader)) {
+      _mesa_free(prod);
       return GL_FALSE;
    }
-   grammar_alloc_free(prod);
+   _mesa_free(prod);
    return GL_TRUE;
 }
 
-LONGSTRING static const char *slang_shader_syn =
-#include "library/slang_shader_syn.h"
-   ;
-
 static const byte slang_core_gc[] = {
 #include "library/slang_core_gc.h"
 };
@@ -2579,111 +2552,158 @@ static const byte slang_vertex_builtin_gc[] = {
 #include "library/slang_vertex_builtin_gc.h"
 };
 
+/**
+ * The built-in library.  It is compiled the first time any shader is
+ * compiled and then shared, read-only, by every later compile in the
+ * process.  Its memory comes from BuiltinPool, which is never freed, and
+ * its identifiers are interned in BuiltinObject.atompool, which each
+ * shader's atom pool searches first (so builtin and user code agree on
+ * atoms).  BuiltinMutex serializes the one-time compile.
+ */
+static slang_code_object BuiltinObject;
+static slang_code_unit BuiltinUnits[SLANG_BUILTIN_TOTAL];
+static slang_mempool *BuiltinPool = NULL;
+_glthread_DECLARE_STATIC_MUTEX(BuiltinMutex);
+
+
+/**
+ * Compile the built-in library units.  Called with BuiltinMutex held and
+ * BuiltinPool current.
+ */
 static GLboolean
-compile_object(grammar * id, const char *source, slang_code_object * object,
-               slang_unit_type type, slang_info_log * infolog,
-               struct gl_shader *shader,
-               const struct gl_extensions *extensions,
-               struct gl_sl_pragmas *pragmas)
+compile_builtin_library(slang_info_log * infolog)
 {
-   slang_code_unit *builtins = NULL;
-   GLuint base_version = 110;
-
-   /* load GLSL grammar */
-   *id = grammar_load_from_text((const byte *) (slang_shader_syn));
-   if (*id == 0) {
-      byte buf[1024];
-      int pos;
+   const GLuint base_version = 110;
+   GLuint i;
 
-      grammar_get_last_error(buf, 1024, &pos);
-      slang_info_log_error(infolog, (const char *) (buf));
+   _slang_code_object_ctr(&BuiltinObject);
+   for (i = 0; i < SLANG_BUILTIN_TOTAL; i++)
+      _slang_code_unit_ctr(&BuiltinUnits[i], &BuiltinObject);
+
+   /* compile core functionality first */
+   if (!compile_binary(slang_core_gc,
+                       &BuiltinUnits[SLANG_BUILTIN_CORE],
+                       base_version,
+                       SLANG_UNIT_FRAGMENT_BUILTIN, infolog,
+                       NULL, NULL, NULL))
       return GL_FALSE;
-   }
-
-   /* set shader type - the syntax is slightly different for different shaders */
-   if (type == SLANG_UNIT_FRAGMENT_SHADER
-       || type == SLANG_UNIT_FRAGMENT_BUILTIN)
-      grammar_set_reg8(*id, (const byte *) "shader_type", 1);
-   else
-      grammar_set_reg8(*id, (const byte *) "shader_type", 2);
-
-   /* enable language extensions */
-   grammar_set_reg8(*id, (const byte *) "parsing_builtin", 1);
-
-   /* if parsing user-specified shader, load built-in library */
-   if (type == SLANG_UNIT_FRAGMENT_SHADER || type == SLANG_UNIT_VERTEX_SHADER) {
-      /* compile core functionality first */
-      if (!compile_binary(slang_core_gc,
-                          &object->builtin[SLANG_BUILTIN_CORE],
-                          base_version,
-                          SLANG_UNIT_FRAGMENT_BUILTIN, infolog,
-                          NULL, NULL, NULL))
-         return GL_FALSE;
 
 #if FEATURE_ARB_shading_language_120
-      if (!compile_binary(slang_120_core_gc,
-                          &object->builtin[SLANG_BUILTIN_120_CORE],
-                          120,
-                          SLANG_UNIT_FRAGMENT_BUILTIN, infolog,
-                          NULL, &object->builtin[SLANG_BUILTIN_CORE], NULL))
-         return GL_FALSE;
+   if (!compile_binary(slang_120_core_gc,
+                       &BuiltinUnits[SLANG_BUILTIN_120_CORE],
+                       120,
+                       SLANG_UNIT_FRAGMENT_BUILTIN, infolog,
+                       NULL, &BuiltinUnits[SLANG_BUILTIN_CORE], NULL))
+      return GL_FALSE;
 #endif
 
-      /* compile common functions and variables, link to core */
-      if (!compile_binary(slang_common_builtin_gc,
-                          &object->builtin[SLANG_BUILTIN_COMMON],
+   /* compile common functions and variables, link to core */
+   if (!compile_binary(slang_common_builtin_gc,
+                       &BuiltinUnits[SLANG_BUILTIN_COMMON],
 #if FEATURE_ARB_shading_language_120
-                          120,
+                       120,
 #else
-                          base_version,
+                       base_version,
 #endif
-                          SLANG_UNIT_FRAGMENT_BUILTIN, infolog, NULL,
+                       SLANG_UNIT_FRAGMENT_BUILTIN, infolog, NULL,
 #if FEATURE_ARB_shading_language_120
-                          &object->builtin[SLANG_BUILTIN_120_CORE],
+                       &BuiltinUnits[SLANG_BUILTIN_120_CORE],
 #else
-                          &object->builtin[SLANG_BUILTIN_CORE],
+                       &BuiltinUnits[SLANG_BUILTIN_CORE],
 #endif
-                          NULL))
-         return GL_FALSE;
+                       NULL))
+      return GL_FALSE;
 
-      /* compile target-specific functions and variables, link to common */
-      if (type == SLANG_UNIT_FRAGMENT_SHADER) {
-         if (!compile_binary(slang_fragment_builtin_gc,
-                             &object->builtin[SLANG_BUILTIN_TARGET],
-                             base_version,
-                             SLANG_UNIT_FRAGMENT_BUILTIN, infolog, NULL,
-                             &object->builtin[SLANG_BUILTIN_COMMON], NULL))
-            return GL_FALSE;
+   /* compile target-specific functions and variables, link to common */
+   if (!compile_binary(slang_fragment_builtin_gc,
+                       &BuiltinUnits[SLANG_BUILTIN_FRAGMENT],
+                       base_version,
+                       SLANG_UNIT_FRAGMENT_BUILTIN, infolog, NULL,
+                       &BuiltinUnits[SLANG_BUILTIN_COMMON], NULL))
+      return GL_FALSE;
 #if FEATURE_ARB_shading_language_120
-         if (!compile_binary(slang_120_fragment_gc,
-                             &object->builtin[SLANG_BUILTIN_TARGET],
-                             120,
-                             SLANG_UNIT_FRAGMENT_BUILTIN, infolog, NULL,
-                             &object->builtin[SLANG_BUILTIN_COMMON], NULL))
-            return GL_FALSE;
+   if (!compile_binary(slang_120_fragment_gc,
+                       &BuiltinUnits[SLANG_BUILTIN_FRAGMENT],
+                       120,
+                       SLANG_UNIT_FRAGMENT_BUILTIN, infolog, NULL,
+                       &BuiltinUnits[SLANG_BUILTIN_COMMON], NULL))
+      return GL_FALSE;
 #endif
+
+   if (!compile_binary(slang_vertex_builtin_gc,
+                       &BuiltinUnits[SLANG_BUILTIN_VERTEX],
+                       base_version,
+                       SLANG_UNIT_VERTEX_BUILTIN, infolog, NULL,
+                       &BuiltinUnits[SLANG_BUILTIN_COMMON], NULL))
+      return GL_FALSE;
+
+   return GL_TRUE;
+}
+
+
+/**
+ * Return the shared built-in library, compiling it on first use.
+ * \return GL_FALSE if the library could not be compiled
+ */
+static GLboolean
+load_builtin_library(slang_info_log * infolog)
+{
+   GLboolean success = GL_TRUE;
+
+   _glthread_LOCK_MUTEX(BuiltinMutex);
+   if (!BuiltinPool) {
+      BuiltinPool = _slang_new_mempool(1024*1024);
+      if (!BuiltinPool) {
+         slang_info_log_memory(infolog);
+         success = GL_FALSE;
       }
-      else if (type == SLANG_UNIT_VERTEX_SHADER) {
-         if (!compile_binary(slang_vertex_builtin_gc,
-                             &object->builtin[SLANG_BUILTIN_TARGET],
-                             base_version,
-                             SLANG_UNIT_VERTEX_BUILTIN, infolog, NULL,
-                             &object->builtin[SLANG_BUILTIN_COMMON], NULL))
-            return GL_FALSE;
+      else {
+         slang_mempool *prevPool = _slang_set_mempool(BuiltinPool);
+         success = compile_builtin_library(infolog);
+         _slang_set_mempool(prevPool);
+         if (!success) {
+            /* try again next time */
+            _slang_delete_mempool(BuiltinPool);
+            BuiltinPool = NULL;
+         }
       }
+   }
+   _glthread_UNLOCK_MUTEX(BuiltinMutex);
+
+   return success;
+}
+
+
+static GLboolean
+compile_object(const char *source, slang_code_object * object,
+               slang_unit_type type, slang_info_log * infolog,
+               struct gl_shader *shader,
+               const struct gl_extensions *extensions,
+               struct gl_sl_pragmas *pragmas)
+{
+   slang_code_unit *builtin = NULL;
+   GLboolean extensions_allowed = GL_TRUE;
+
+   /* if parsing user-specified shader, use the built-in library */
+   if (type == SLANG_UNIT_FRAGMENT_SHADER || type == SLANG_UNIT_VERTEX_SHADER) {
+      if (!load_builtin_library(infolog))
+         return GL_FALSE;
+
+      if (type == SLANG_UNIT_FRAGMENT_SHADER)
+         builtin = &BuiltinUnits[SLANG_BUILTIN_FRAGMENT];
+      else
+         builtin = &BuiltinUnits[SLANG_BUILTIN_VERTEX];
+      object->atompool.parent = &BuiltinObject.atompool;
 
       /* disable language extensions */
-#if NEW_SLANG /* allow-built-ins */
-      grammar_set_reg8(*id, (const byte *) "parsing_builtin", 1);
-#else
-      grammar_set_reg8(*id, (const byte *) "parsing_builtin", 0);
+#if !NEW_SLANG /* allow-built-ins */
+      extensions_allowed = GL_FALSE;
 #endif
-      builtins = object->builtin;
    }
 
    /* compile the actual shader - pass-in built-in library for external shader */
-   return compile_with_grammar(*id, source, &object->unit, type, infolog,
-                               builtins, shader, extensions, pragmas);
+   return compile_source(source, &object->unit, type, infolog, builtin,
+                         extensions_allowed, shader, extensions, pragmas);
 }
 
 
@@ -2693,7 +2713,6 @@ compile_shader(GLcontext *ctx, slang_code_object * object,
                struct gl_shader *shader)
 {
    GLboolean success;
-   grammar id = 0;
 
 #if 0 /* for debug */
    _mesa_printf("********* COMPILE SHADER ***********\n");
@@ -2706,10 +2725,8 @@ compile_shader(GLcontext *ctx, slang_code_object * object,
    _slang_code_object_dtr(object);
    _slang_code_object_ctr(object);
 
-   success = compile_object(&id, shader->Source, object, type, infolog, shader,
+   success = compile_object(shader->Source, object, type, infolog, shader,
                             &ctx->Extensions, &shader->Pragmas);
-   if (id != 0)
-      grammar_destroy(id);
    if (!success)
       return GL_FALSE;
 
@@ -2725,6 +2742,7 @@ _slang_compile(GLcontext *ctx, struct gl_shader *shader)
    slang_info_log info_log;
    slang_code_object obj;
    slang_unit_type type;
+   slang_mempool *pool;
 
    if (shader->Type == GL_VERTEX_SHADER) {
       type = SLANG_UNIT_VERTEX_SHADER;
@@ -2737,7 +2755,13 @@ _slang_compile(GLcontext *ctx, struct gl_shader *shader)
    if (!shader->Source)
       return GL_FALSE;
 
-   ctx->Shader.MemPool = _slang_new_mempool(1024*1024);
+   if (_slang_cache_load(ctx, shader))
+      return GL_TRUE;
+
+   pool = _slang_new_mempool(64 * 1024);
+   if (!pool)
+      return GL_FALSE;
+   _slang_set_mempool(pool);
 
    shader->Main = GL_FALSE;
 
@@ -2776,8 +2800,9 @@ _slang_compile(GLcontext *ctx, struct gl_shader *shader)
    slang_info_log_destruct(&info_log);
    _slang_code_object_dtr(&obj);
 
-   _slang_delete_mempool((slang_mempool *) ctx->Shader.MemPool);
-   ctx->Shader.MemPool = NULL;
+   _slang_set_mempool(NULL);
+   _slang_report_mempool(pool, "compile");
+   _slang_delete_mempool(pool);
 
    /* remove any reads of output registers */
 #if 0
@@ -2794,6 +2819,9 @@ _slang_compile(GLcontext *ctx, struct gl_shader *shader)
    _mesa_print_program(shader->Program);
 #endif
 
+   if (success)
+      _slang_cache_store(ctx, shader);
+
    return success;
 }
 
@@ -72,13 +72,13 @@ _slang_code_unit_dtr (slang_code_unit *);
 #define SLANG_BUILTIN_CORE   0
 #define SLANG_BUILTIN_120_CORE   1
 #define SLANG_BUILTIN_COMMON 2
-#define SLANG_BUILTIN_TARGET 3
+#define SLANG_BUILTIN_FRAGMENT 3
+#define SLANG_BUILTIN_VERTEX 4
 
-#define SLANG_BUILTIN_TOTAL  4
+#define SLANG_BUILTIN_TOTAL  5
 
 typedef struct slang_code_object_
 {
-   slang_code_unit builtin[SLANG_BUILTIN_TOTAL];
    slang_code_unit unit;
    slang_atom_pool atompool;
 } slang_code_object;
@@ -78,9 +78,9 @@ new_subroutine(slang_emit_info *emitInfo, GLuint *id)
    const GLuint n = emitInfo->NumSubroutines;
 
    emitInfo->Subroutines = (struct gl_program **)
-      _mesa_realloc(emitInfo->Subroutines,
-                    n * sizeof(struct gl_program),
-                    (n + 1) * sizeof(struct gl_program));
+      _slang_realloc(emitInfo->Subroutines,
+                     n * sizeof(struct gl_program *),
+                     (n + 1) * sizeof(struct gl_program *));
    emitInfo->Subroutines[n] = ctx->Driver.NewProgram(ctx, emitInfo->prog->Target, 0);
    emitInfo->Subroutines[n]->Parameters = emitInfo->prog->Parameters;
    emitInfo->NumSubroutines++;
@@ -424,7 +424,7 @@ new_instruction(slang_emit_info *emitInfo, gl_inst_opcode opcode)
 
    if (prog->NumInstructions == emitInfo->MaxInstructions) {
       /* grow the instruction buffer */
-      emitInfo->MaxInstructions += 20;
+      emitInfo->MaxInstructions = MAX2(2 * emitInfo->MaxInstructions, 20);
       prog->Instructions =
          _mesa_realloc_instructions(prog->Instructions,
                                     prog->NumInstructions,
@@ -2349,7 +2349,7 @@ _slang_resolve_subroutines(slang_emit_info *emitInfo)
    GLuint *subroutineLoc, i, total;
 
    subroutineLoc
-      = (GLuint *) _mesa_malloc(emitInfo->NumSubroutines * sizeof(GLuint));
+      = (GLuint *) _slang_alloc(emitInfo->NumSubroutines * sizeof(GLuint));
 
    /* total number of instructions */
    total = mainP->NumInstructions;
@@ -2387,7 +2387,7 @@ _slang_resolve_subroutines(slang_emit_info *emitInfo)
 
    /* free subroutine list */
    if (emitInfo->Subroutines) {
-      _mesa_free(emitInfo->Subroutines);
+      _slang_free(emitInfo->Subroutines);
       emitInfo->Subroutines = NULL;
    }
    emitInfo->NumSubroutines = 0;
@@ -2406,7 +2406,7 @@ _slang_resolve_subroutines(slang_emit_info *emitInfo)
       }
    }
 
-   _mesa_free(subroutineLoc);
+   _slang_free(subroutineLoc);
 }
 
 
@@ -7,6 +7,7 @@
  */
 
 
+#include "glapi/glthread.h"
 #include "slang_label.h"
 #include "slang_mem.h"
 
@@ -23,22 +24,32 @@ _slang_label_new(const char *name)
    return l;
 }
 
+/**
+ * Counter for _slang_label_new_unique().  Shaders may be compiled on
+ * several threads at once, so it's guarded by a mutex.
+ */
+static int UniqueId = 1;
+_glthread_DECLARE_STATIC_MUTEX(UniqueIdMutex);
+
 /**
  * As above, but suffix the name with a unique number.
  */
 slang_label *
 _slang_label_new_unique(const char *name)
 {
-   static int id = 1;
    slang_label *l = (slang_label *) _slang_alloc(sizeof(slang_label));
    if (l) {
+      int id;
+
       l->Name = (char *) _slang_alloc(_mesa_strlen(name) + 10);
       if (!l->Name) {
          _mesa_free(l);
          return NULL;
       }
+      _glthread_LOCK_MUTEX(UniqueIdMutex);
+      id = UniqueId++;
+      _glthread_UNLOCK_MUTEX(UniqueIdMutex);
       _mesa_sprintf(l->Name, "%s_%d", name, id);
-      id++;
       l->Location = -1;
    }
    return l;
@@ -35,12 +35,14 @@
 #include "main/macros.h"
 #include "shader/program.h"
 #include "shader/prog_instruction.h"
+#include "shader/prog_optimize.h"
 #include "shader/prog_parameter.h"
 #include "shader/prog_print.h"
 #include "shader/prog_statevars.h"
 #include "shader/prog_uniform.h"
 #include "shader/shader_api.h"
 #include "slang_link.h"
+#include "slang_mem.h"
 
 
 /** cast wrapper */
@@ -102,7 +104,7 @@ link_varying_vars(struct gl_shader_program *shProg, struct gl_program *prog)
    GLuint *map, i, firstVarying, newFile;
    GLbitfield *inOutFlags;
 
-   map = (GLuint *) malloc(prog->Varying->NumParameters * sizeof(GLuint));
+   map = (GLuint *) _slang_alloc(prog->Varying->NumParameters * sizeof(GLuint));
    if (!map)
       return GL_FALSE;
 
@@ -193,7 +195,7 @@ link_varying_vars(struct gl_shader_program *shProg, struct gl_program *prog)
       }
    }
 
-   free(map);
+   _slang_free(map);
 
    /* these will get recomputed before linking is completed */
    prog->InputsRead = 0x0;
@@ -432,6 +434,23 @@ _slang_resolve_attributes(struct gl_shader_program *shProg,
 }
 
 
+/**
+ * Check if the attached shaders of the given type allow optimization
+ * (i.e. none of them has "#pragma optimize(off)").
+ */
+static GLboolean
+optimize_allowed(const struct gl_shader_program *shProg, GLenum type)
+{
+   GLuint i;
+   for (i = 0; i < shProg->NumShaders; i++) {
+      if (shProg->Shaders[i]->Type == type &&
+          !shProg->Shaders[i]->Pragmas.Optimize)
+         return GL_FALSE;
+   }
+   return GL_TRUE;
+}
+
+
 /**
  * Scan program instructions to update the program's NumTemporaries field.
  * Note: this implemenation relies on the code generator allocating
@@ -548,10 +567,8 @@ _slang_update_inputs_outputs(struct gl_program *prog)
  *    src/dst register references so they use the new, linked varying
  *    storage locations.
  */
-void
-_slang_link(GLcontext *ctx,
-            GLhandleARB programObj,
-            struct gl_shader_program *shProg)
+static void
+link_program(GLcontext *ctx, struct gl_shader_program *shProg)
 {
    const struct gl_vertex_program *vertProg;
    const struct gl_fragment_program *fragProg;
@@ -656,6 +673,15 @@ _slang_link(GLcontext *ctx,
       }
    }
 
+   if (shProg->VertexProgram &&
+       optimize_allowed(shProg, GL_VERTEX_SHADER)) {
+      _mesa_optimize_program(&shProg->VertexProgram->Base);
+   }
+   if (shProg->FragmentProgram &&
+       optimize_allowed(shProg, GL_FRAGMENT_SHADER)) {
+      _mesa_optimize_program(&shProg->FragmentProgram->Base);
+   }
+
    if (shProg->VertexProgram) {
       _slang_update_inputs_outputs(&shProg->VertexProgram->Base);
       _slang_count_temporaries(&shProg->VertexProgram->Base);
@@ -742,3 +768,28 @@ _slang_link(GLcontext *ctx,
    shProg->LinkStatus = (shProg->VertexProgram || shProg->FragmentProgram);
 }
 
+
+/**
+ * Link the shader program, allocating the linker's temporary data from a
+ * pool which is freed when done.
+ */
+void
+_slang_link(GLcontext *ctx,
+            GLhandleARB programObj,
+            struct gl_shader_program *shProg)
+{
+   slang_mempool *pool = _slang_new_mempool(16 * 1024);
+   if (!pool) {
+      _mesa_clear_shader_program_data(ctx, shProg);
+      link_error(shProg, "out of memory\n");
+      return;
+   }
+
+   _slang_set_mempool(pool);
+   link_program(ctx, shProg);
+   _slang_set_mempool(NULL);
+
+   _slang_report_mempool(pool, "link");
+   _slang_delete_mempool(pool);
+}
+
@@ -29,43 +29,96 @@
  * allocations out of a large pool then just free the pool when done
  * compiling to avoid intricate malloc/free tracking and memory leaks.
  *
+ * A pool is a list of blocks which allocations are carved from in
+ * order.  Blocks start at the pool's initial size and double up to
+ * MAX_BLOCK_SIZE, so small compiles don't pay for a large block.  Memory
+ * is zeroed as it's handed out rather than when a block is allocated.
+ * Each pool has one lifetime:
+ *   - compile: created and deleted by _slang_compile(),
+ *   - link: created and deleted by _slang_link(),
+ *   - built-in library: kept until exit, see slang_compile.c,
+ *   - program: the names in a parameter or uniform list, freed with it.
+ * The first two are made current with _slang_set_mempool() for
+ * _slang_alloc() and friends; the last is allocated from with
+ * _slang_pool_alloc().  The current pool is per-thread so that shaders
+ * may be compiled and programs linked on several threads at once.
+ *
  * \author Brian Paul
  */
 
 #include "main/context.h"
 #include "main/macros.h"
+#include "glapi/glthread.h"
 #include "slang_mem.h"
 
 
 #define GRANULARITY 8
 #define ROUND_UP(B)  ( ((B) + (GRANULARITY - 1)) & ~(GRANULARITY - 1) )
 
+/** Blocks grow up to this size; larger requests get a block of their own */
+#define MAX_BLOCK_SIZE (1024 * 1024)
+
 
 /** If 1, use conventional malloc/free.  Helpful for debugging */
 #define USE_MALLOC_FREE 0
 
 
-struct slang_mempool_
+struct slang_memblock
 {
-   GLuint Size, Used, Count, Largest;
+   GLuint Size, Used;
    char *Data;
-   struct slang_mempool_ *Next;
+   struct slang_memblock *Next;
 };
 
 
+#if defined(THREADS)
+static _glthread_TSD CurrentPoolTSD;
+#define GET_CURRENT_POOL() \
+   ((slang_mempool *) _glthread_GetTSD(&CurrentPoolTSD))
+#else
+static slang_mempool *CurrentPool = NULL;
+#define GET_CURRENT_POOL() CurrentPool
+#endif
+
+
+struct slang_mempool_
+{
+   struct slang_memblock *Blocks; /**< current block, then older ones */
+   GLuint BlockSize;              /**< size of the next block */
+   GLuint Last;                   /**< offset of last allocation in Blocks */
+
+   /* statistics */
+   GLuint Count, Bytes, NumBlocks, Largest;
+};
+
+
+static struct slang_memblock *
+new_block(slang_mempool *pool, GLuint size)
+{
+   struct slang_memblock *block = (struct slang_memblock *)
+      _mesa_malloc(ROUND_UP(sizeof(struct slang_memblock)) + size);
+   if (block) {
+      block->Data = (char *) block + ROUND_UP(sizeof(struct slang_memblock));
+      block->Size = size;
+      block->Used = 0;
+      block->Next = NULL;
+      pool->NumBlocks++;
+   }
+   return block;
+}
+
+
 slang_mempool *
 _slang_new_mempool(GLuint initialSize)
 {
    slang_mempool *pool = (slang_mempool *) _mesa_calloc(sizeof(slang_mempool));
    if (pool) {
-      pool->Data = (char *) _mesa_calloc(initialSize);
-      /*printf("ALLOC MEMPOOL %d at %p\n", initialSize, pool->Data);*/
-      if (!pool->Data) {
+      pool->BlockSize = ROUND_UP(initialSize);
+      pool->Blocks = new_block(pool, pool->BlockSize);
+      if (!pool->Blocks) {
          _mesa_free(pool);
          return NULL;
       }
-      pool->Size = initialSize;
-      pool->Used = 0;
    }
    return pool;
 }
@@ -74,50 +127,115 @@ _slang_new_mempool(GLuint initialSize)
 void
 _slang_delete_mempool(slang_mempool *pool)
 {
-   GLuint total = 0;
-   while (pool) {
-      slang_mempool *next = pool->Next;
-      /*
-      printf("DELETE MEMPOOL %u / %u  count=%u largest=%u\n",
-             pool->Used, pool->Size, pool->Count, pool->Largest);
-      */
-      total += pool->Used;
-      _mesa_free(pool->Data);
-      _mesa_free(pool);
-      pool = next;
+   struct slang_memblock *block, *next;
+
+   if (!pool)
+      return;
+
+   for (block = pool->Blocks; block; block = next) {
+      next = block->Next;
+      _mesa_free(block);
    }
-   /*printf("TOTAL ALLOCATED: %u\n", total);*/
+   _mesa_free(pool);
 }
 
 
-#ifdef DEBUG
-static void
-check_zero(const char *addr, GLuint n)
+/**
+ * Report the pool's allocation statistics if MESA_VERBOSE=glsl_mem.
+ * \param what  the pool's lifetime/purpose, such as "compile"
+ */
+void
+_slang_report_mempool(const slang_mempool *pool, const char *what)
 {
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      assert(addr[i]==0);
+   if (pool && (MESA_VERBOSE & VERBOSE_GLSL_MEM)) {
+      _mesa_debug(NULL, "GLSL %s: %u allocations, %u bytes, "
+                  "%u blocks, largest %u\n", what, pool->Count, pool->Bytes,
+                  pool->NumBlocks, pool->Largest);
    }
 }
-#endif
 
 
 #ifdef DEBUG
 static GLboolean
 is_valid_address(const slang_mempool *pool, void *addr)
 {
-   while (pool) {
-      if ((char *) addr >= pool->Data &&
-          (char *) addr < pool->Data + pool->Used)
+   const struct slang_memblock *block;
+   for (block = pool->Blocks; block; block = block->Next) {
+      if ((char *) addr >= block->Data &&
+          (char *) addr < block->Data + block->Used)
          return GL_TRUE;
-
-      pool = pool->Next;
    }
    return GL_FALSE;
 }
 #endif
 
 
+/**
+ * Alloc 'bytes' of zeroed memory from the given pool.
+ */
+void *
+_slang_pool_alloc(slang_mempool *pool, GLuint bytes)
+{
+   struct slang_memblock *block = pool->Blocks;
+   const GLuint size = ROUND_UP(bytes ? bytes : 1);
+   char *addr;
+
+   if (block->Used + size > block->Size) {
+      if (size > pool->BlockSize / 4) {
+         /* Give it a block of its own, behind the current one so that
+          * the rest of the current block is still used.
+          */
+         struct slang_memblock *big = new_block(pool, size);
+         if (!big)
+            return NULL;
+         big->Used = size;
+         big->Next = block->Next;
+         block->Next = big;
+         addr = big->Data;
+         goto done;
+      }
+
+      /* start a new block */
+      block = new_block(pool, pool->BlockSize);
+      if (!block)
+         return NULL;
+      block->Next = pool->Blocks;
+      pool->Blocks = block;
+      if (pool->BlockSize < MAX_BLOCK_SIZE)
+         pool->BlockSize *= 2;
+   }
+
+   addr = block->Data + block->Used;
+   pool->Last = block->Used;
+   block->Used += size;
+
+done:
+   _mesa_memset(addr, 0, size);
+   pool->Count++;
+   pool->Bytes += size;
+   pool->Largest = MAX2(pool->Largest, bytes);
+   return addr;
+}
+
+
+/**
+ * Make pool the calling thread's current pool for _slang_alloc(),
+ * _slang_realloc() and _slang_free().
+ * \return the previously current pool, to be restored by the caller
+ */
+slang_mempool *
+_slang_set_mempool(slang_mempool *pool)
+{
+   slang_mempool *prev = GET_CURRENT_POOL();
+#if defined(THREADS)
+   _glthread_SetTSD(&CurrentPoolTSD, (void *) pool);
+#else
+   CurrentPool = pool;
+#endif
+   return prev;
+}
+
+
 /**
  * Alloc 'bytes' from shader mempool.
  */
@@ -127,51 +245,12 @@ _slang_alloc(GLuint bytes)
 #if USE_MALLOC_FREE
    return _mesa_calloc(bytes);
 #else
-   slang_mempool *pool;
-   GET_CURRENT_CONTEXT(ctx);
-   pool = (slang_mempool *) ctx->Shader.MemPool;
+   slang_mempool *pool = GET_CURRENT_POOL();
 
-   if (bytes == 0)
-      bytes = 1;
+   if (!pool)
+      return NULL;
 
-   while (pool) {
-      if (pool->Used + bytes <= pool->Size) {
-         /* found room */
-         void *addr = (void *) (pool->Data + pool->Used);
-#ifdef DEBUG
-         check_zero((char*) addr, bytes);
-#endif
-         pool->Used += ROUND_UP(bytes);
-         pool->Largest = MAX2(pool->Largest, bytes);
-         pool->Count++;
-         /*printf("alloc %u  Used %u\n", bytes, pool->Used);*/
-         return addr;
-      }
-      else if (pool->Next) {
-         /* try next block */
-         pool = pool->Next;
-      }
-      else {
-         /* alloc new pool */
-         const GLuint sz = MAX2(bytes, pool->Size);
-         pool->Next = _slang_new_mempool(sz);
-         if (!pool->Next) {
-            /* we're _really_ out of memory */
-            return NULL;
-         }
-         else {
-            pool = pool->Next;
-            pool->Largest = bytes;
-            pool->Count++;
-            pool->Used = ROUND_UP(bytes);
-#ifdef DEBUG
-            check_zero((char*) pool->Data, bytes);
-#endif
-            return (void *) pool->Data;
-         }
-      }
-   }
-   return NULL;
+   return _slang_pool_alloc(pool, bytes);
 #endif
 }
 
@@ -182,22 +261,36 @@ _slang_realloc(void *oldBuffer, GLuint oldSize, GLuint newSize)
 #if USE_MALLOC_FREE
    return _mesa_realloc(oldBuffer, oldSize, newSize);
 #else
-   GET_CURRENT_CONTEXT(ctx);
-   slang_mempool *pool = (slang_mempool *) ctx->Shader.MemPool;
-   (void) pool;
+   slang_mempool *pool = GET_CURRENT_POOL();
+   struct slang_memblock *block;
+
+   if (newSize <= oldSize) {
+      return oldBuffer;
+   }
+
+   if (!pool)
+      return NULL;
+
+   block = pool->Blocks;
 
-   if (newSize < oldSize) {
+   if (oldBuffer &&
+       (char *) oldBuffer == block->Data + pool->Last &&
+       pool->Last + ROUND_UP(newSize) <= block->Size) {
+      /* the most recent allocation: grow it in place */
+      const GLuint end = pool->Last + ROUND_UP(newSize);
+      _mesa_memset(block->Data + block->Used, 0, end - block->Used);
+      pool->Bytes += end - block->Used;
+      block->Used = end;
       return oldBuffer;
    }
    else {
-      const GLuint copySize = (oldSize < newSize) ? oldSize : newSize;
-      void *newBuffer = _slang_alloc(newSize);
+      void *newBuffer = _slang_pool_alloc(pool, newSize);
 
       if (oldBuffer)
          ASSERT(is_valid_address(pool, oldBuffer));
 
-      if (newBuffer && oldBuffer && copySize > 0)
-         _mesa_memcpy(newBuffer, oldBuffer, copySize);
+      if (newBuffer && oldBuffer && oldSize > 0)
+         _mesa_memcpy(newBuffer, oldBuffer, oldSize);
 
       return newBuffer;
    }
@@ -205,6 +298,25 @@ _slang_realloc(void *oldBuffer, GLuint oldSize, GLuint newSize)
 }
 
 
+/**
+ * Clone string, storing in the given mempool.
+ */
+char *
+_slang_pool_strdup(slang_mempool *pool, const char *s)
+{
+   if (s) {
+      size_t l = _mesa_strlen(s);
+      char *s2 = (char *) _slang_pool_alloc(pool, l + 1);
+      if (s2)
+         _mesa_memcpy(s2, s, l + 1);
+      return s2;
+   }
+   else {
+      return NULL;
+   }
+}
+
+
 /**
  * Clone string, storing in current mempool.
  */
@@ -234,8 +346,7 @@ _slang_free(void *addr)
    _mesa_free(addr);
 #else
    if (addr) {
-      GET_CURRENT_CONTEXT(ctx);
-      slang_mempool *pool = (slang_mempool *) ctx->Shader.MemPool;
+      slang_mempool *pool = GET_CURRENT_POOL();
       (void) pool;
       ASSERT(is_valid_address(pool, addr));
    }
@@ -39,6 +39,18 @@ _slang_new_mempool(GLuint initialSize);
 extern void
 _slang_delete_mempool(slang_mempool *pool);
 
+extern void
+_slang_report_mempool(const slang_mempool *pool, const char *what);
+
+extern void *
+_slang_pool_alloc(slang_mempool *pool, GLuint bytes);
+
+extern char *
+_slang_pool_strdup(slang_mempool *pool, const char *s);
+
+extern slang_mempool *
+_slang_set_mempool(slang_mempool *pool);
+
 extern void *
 _slang_alloc(GLuint bytes);
 
@@ -0,0 +1,2258 @@
+/*
+ * Mesa 3-D graphics library
+ * Version:  7.4
+ *
+ * Copyright (C) 2009  VMware, Inc.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * BRIAN PAUL BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file slang_parse.c
+ * Hand-written GLSL parser.
+ *
+ * The preprocessed source is split into tokens and then parsed by
+ * recursive descent.  The output is the same byte stream that the
+ * library/slang_shader.syn grammar emits (and that the precompiled
+ * built-in library is stored as), so slang_compile.c decodes both the
+ * same way.  Each parse_x() function below corresponds to the grammar
+ * rule of the same name; a function which fails restores the token
+ * position and output size it started with, which gives the same
+ * first-match backtracking as the grammar.  Where the grammar attaches
+ * an .error to a rule the failure is fatal here as well.
+ */
+
+#include "main/imports.h"
+#include "main/macros.h"
+#include "slang_parse.h"
+
+
+/* These must match library/slang_shader.syn and slang_compile.c */
+
+#define REVISION 5
+
+#define EXTERNAL_NULL 0
+#define EXTERNAL_FUNCTION_DEFINITION 1
+#define EXTERNAL_DECLARATION 2
+#define DEFAULT_PRECISION 3
+#define INVARIANT_STMT 4
+
+#define PRECISION_DEFAULT 0
+#define PRECISION_LOW     1
+#define PRECISION_MEDIUM  2
+#define PRECISION_HIGH    3
+
+#define DECLARATION_FUNCTION_PROTOTYPE 1
+#define DECLARATION_INIT_DECLARATOR_LIST 2
+
+#define FUNCTION_ORDINARY 0
+#define FUNCTION_CONSTRUCTOR 1
+#define FUNCTION_OPERATOR 2
+
+#define FUNCTION_CALL_NONARRAY 0
+#define FUNCTION_CALL_ARRAY    1
+
+#define OPERATOR_ADDASSIGN 1
+#define OPERATOR_SUBASSIGN 2
+#define OPERATOR_MULASSIGN 3
+#define OPERATOR_DIVASSIGN 4
+#define OPERATOR_LOGICALXOR 11
+#define OPERATOR_LESS 15
+#define OPERATOR_GREATER 16
+#define OPERATOR_LESSEQUAL 17
+#define OPERATOR_GREATEREQUAL 18
+#define OPERATOR_MULTIPLY 21
+#define OPERATOR_DIVIDE 22
+#define OPERATOR_INCREMENT 24
+#define OPERATOR_DECREMENT 25
+#define OPERATOR_PLUS 26
+#define OPERATOR_MINUS 27
+#define OPERATOR_NOT 29
+
+#define DECLARATOR_NONE 0
+#define DECLARATOR_NEXT 1
+
+#define VARIABLE_NONE 0
+#define VARIABLE_IDENTIFIER 1
+#define VARIABLE_INITIALIZER 2
+#define VARIABLE_ARRAY_EXPLICIT 3
+#define VARIABLE_ARRAY_UNKNOWN 4
+
+#define TYPE_QUALIFIER_NONE 0
+#define TYPE_QUALIFIER_CONST 1
+#define TYPE_QUALIFIER_ATTRIBUTE 2
+#define TYPE_QUALIFIER_VARYING 3
+#define TYPE_QUALIFIER_UNIFORM 4
+#define TYPE_QUALIFIER_FIXEDOUTPUT 5
+#define TYPE_QUALIFIER_FIXEDINPUT 6
+
+#define TYPE_VARIANT    90
+#define TYPE_INVARIANT  91
+
+#define TYPE_CENTER    95
+#define TYPE_CENTROID  96
+
+#define TYPE_SPECIFIER_VOID 0
+#define TYPE_SPECIFIER_BOOL 1
+#define TYPE_SPECIFIER_BVEC2 2
+#define TYPE_SPECIFIER_BVEC3 3
+#define TYPE_SPECIFIER_BVEC4 4
+#define TYPE_SPECIFIER_INT 5
+#define TYPE_SPECIFIER_IVEC2 6
+#define TYPE_SPECIFIER_IVEC3 7
+#define TYPE_SPECIFIER_IVEC4 8
+#define TYPE_SPECIFIER_FLOAT 9
+#define TYPE_SPECIFIER_VEC2 10
+#define TYPE_SPECIFIER_VEC3 11
+#define TYPE_SPECIFIER_VEC4 12
+#define TYPE_SPECIFIER_MAT2 13
+#define TYPE_SPECIFIER_MAT3 14
+#define TYPE_SPECIFIER_MAT4 15
+#define TYPE_SPECIFIER_SAMPLER1D 16
+#define TYPE_SPECIFIER_SAMPLER2D 17
+#define TYPE_SPECIFIER_SAMPLER3D 18
+#define TYPE_SPECIFIER_SAMPLERCUBE 19
+#define TYPE_SPECIFIER_SAMPLER1DSHADOW 20
+#define TYPE_SPECIFIER_SAMPLER2DSHADOW 21
+#define TYPE_SPECIFIER_SAMPLER2DRECT 22
+#define TYPE_SPECIFIER_SAMPLER2DRECTSHADOW 23
+#define TYPE_SPECIFIER_STRUCT 24
+#define TYPE_SPECIFIER_TYPENAME 25
+#define TYPE_SPECIFIER_MAT23 26
+#define TYPE_SPECIFIER_MAT32 27
+#define TYPE_SPECIFIER_MAT24 28
+#define TYPE_SPECIFIER_MAT42 29
+#define TYPE_SPECIFIER_MAT34 30
+#define TYPE_SPECIFIER_MAT43 31
+
+#define TYPE_SPECIFIER_NONARRAY 0
+#define TYPE_SPECIFIER_ARRAY    1
+
+#define FIELD_NONE 0
+#define FIELD_NEXT 1
+#define FIELD_ARRAY 2
+
+#define OP_END 0
+#define OP_BLOCK_BEGIN_NO_NEW_SCOPE 1
+#define OP_BLOCK_BEGIN_NEW_SCOPE 2
+#define OP_DECLARE 3
+#define OP_ASM 4
+#define OP_BREAK 5
+#define OP_CONTINUE 6
+#define OP_DISCARD 7
+#define OP_RETURN 8
+#define OP_EXPRESSION 9
+#define OP_IF 10
+#define OP_WHILE 11
+#define OP_DO 12
+#define OP_FOR 13
+#define OP_PUSH_VOID 14
+#define OP_PUSH_BOOL 15
+#define OP_PUSH_INT 16
+#define OP_PUSH_FLOAT 17
+#define OP_PUSH_IDENTIFIER 18
+#define OP_SEQUENCE 19
+#define OP_ASSIGN 20
+#define OP_ADDASSIGN 21
+#define OP_SUBASSIGN 22
+#define OP_MULASSIGN 23
+#define OP_DIVASSIGN 24
+#define OP_SELECT 31
+#define OP_LOGICALOR 32
+#define OP_LOGICALXOR 33
+#define OP_LOGICALAND 34
+#define OP_EQUAL 38
+#define OP_NOTEQUAL 39
+#define OP_LESS 40
+#define OP_GREATER 41
+#define OP_LESSEQUAL 42
+#define OP_GREATEREQUAL 43
+#define OP_ADD 46
+#define OP_SUBTRACT 47
+#define OP_MULTIPLY 48
+#define OP_DIVIDE 49
+#define OP_PREINCREMENT 51
+#define OP_PREDECREMENT 52
+#define OP_PLUS 53
+#define OP_MINUS 54
+#define OP_NOT 56
+#define OP_SUBSCRIPT 57
+#define OP_CALL 58
+#define OP_FIELD 59
+#define OP_POSTINCREMENT 60
+#define OP_POSTDECREMENT 61
+#define OP_PRECISION 62
+#define OP_METHOD 63
+
+#define PARAM_QUALIFIER_IN 0
+#define PARAM_QUALIFIER_OUT 1
+#define PARAM_QUALIFIER_INOUT 2
+
+#define PARAMETER_NONE 0
+#define PARAMETER_NEXT 1
+
+#define PARAMETER_ARRAY_NOT_PRESENT 0
+#define PARAMETER_ARRAY_PRESENT 1
+
+
+/* Error messages, as in slang_shader.syn */
+#define ERR_SYNTAX            "2001: Syntax error."
+#define ERR_OPERATOR_OVERRIDE "2002: Invalid operator override."
+#define ERR_LBRACE_EXPECTED   "2003: '{' expected but '%.*s' found."
+#define ERR_LPAREN_EXPECTED   "2004: '(' expected but '%.*s' found."
+#define ERR_RPAREN_EXPECTED   "2005: ')' expected but '%.*s' found."
+#define ERR_PRECISION         "2006: Invalid precision specifier '%.*s'."
+#define ERR_PRECISION_TYPE    "2007: Invalid precision type '%.*s'."
+
+
+enum token_type
+{
+   TOKEN_END,
+   TOKEN_IDENTIFIER,
+   TOKEN_FLOAT,
+   TOKEN_INT,
+   TOKEN_AMPAMP,
+   TOKEN_BARBAR,
+   TOKEN_BANG,
+   TOKEN_BANGEQ,
+   TOKEN_CARETCARET,
+   TOKEN_COLON,
+   TOKEN_COMMA,
+   TOKEN_DOT,
+   TOKEN_EQ,
+   TOKEN_EQEQ,
+   TOKEN_GT,
+   TOKEN_GE,
+   TOKEN_LBRACE,
+   TOKEN_LBRACKET,
+   TOKEN_LT,
+   TOKEN_LE,
+   TOKEN_LPAREN,
+   TOKEN_MINUS,
+   TOKEN_MINUSEQ,
+   TOKEN_MINUSMINUS,
+   TOKEN_PLUS,
+   TOKEN_PLUSEQ,
+   TOKEN_PLUSPLUS,
+   TOKEN_QUESTION,
+   TOKEN_RBRACE,
+   TOKEN_RBRACKET,
+   TOKEN_RPAREN,
+   TOKEN_SEMICOLON,
+   TOKEN_SLASH,
+   TOKEN_SLASHEQ,
+   TOKEN_STAR,
+   TOKEN_STAREQ,
+   TOKEN_OTHER      /**< any other character, never accepted */
+};
+
+
+/**
+ * Identifiers which some rule matches by name.  These are not reserved:
+ * where a rule does not ask for one of them it is an ordinary identifier.
+ */
+enum keyword
+{
+   KW_NONE,
+   KW_TYPE,          /**< a built-in type name, code is its specifier */
+   KW_QUALIFIER,     /**< code is the TYPE_QUALIFIER_x */
+   KW_PRECISION_QUALIFIER, /**< code is the PRECISION_x */
+   KW_PARAM_QUALIFIER, /**< code is the PARAM_QUALIFIER_x */
+   KW_ASM,
+   KW_BREAK,
+   KW_CENTROID,
+   KW_CONSTRUCTOR,
+   KW_CONTINUE,
+   KW_DISCARD,
+   KW_DO,
+   KW_ELSE,
+   KW_FALSE,
+   KW_FOR,
+   KW_IF,
+   KW_INVARIANT,
+   KW_OPERATOR,
+   KW_PRECISION,
+   KW_RETURN,
+   KW_STRUCT,
+   KW_TRUE,
+   KW_WHILE
+};
+
+
+static const struct {
+   const char *name;
+   GLubyte keyword;
+   GLubyte code;
+} Keywords[] = {
+   { "void", KW_TYPE, TYPE_SPECIFIER_VOID },
+   { "float", KW_TYPE, TYPE_SPECIFIER_FLOAT },
+   { "int", KW_TYPE, TYPE_SPECIFIER_INT },
+   { "bool", KW_TYPE, TYPE_SPECIFIER_BOOL },
+   { "vec2", KW_TYPE, TYPE_SPECIFIER_VEC2 },
+   { "vec3", KW_TYPE, TYPE_SPECIFIER_VEC3 },
+   { "vec4", KW_TYPE, TYPE_SPECIFIER_VEC4 },
+   { "bvec2", KW_TYPE, TYPE_SPECIFIER_BVEC2 },
+   { "bvec3", KW_TYPE, TYPE_SPECIFIER_BVEC3 },
+   { "bvec4", KW_TYPE, TYPE_SPECIFIER_BVEC4 },
+   { "ivec2", KW_TYPE, TYPE_SPECIFIER_IVEC2 },
+   { "ivec3", KW_TYPE, TYPE_SPECIFIER_IVEC3 },
+   { "ivec4", KW_TYPE, TYPE_SPECIFIER_IVEC4 },
+   { "mat2", KW_TYPE, TYPE_SPECIFIER_MAT2 },
+   { "mat3", KW_TYPE, TYPE_SPECIFIER_MAT3 },
+   { "mat4", KW_TYPE, TYPE_SPECIFIER_MAT4 },
+   { "mat2x3", KW_TYPE, TYPE_SPECIFIER_MAT23 },
+   { "mat3x2", KW_TYPE, TYPE_SPECIFIER_MAT32 },
+   { "mat2x4", KW_TYPE, TYPE_SPECIFIER_MAT24 },
+   { "mat4x2", KW_TYPE, TYPE_SPECIFIER_MAT42 },
+   { "mat3x4", KW_TYPE, TYPE_SPECIFIER_MAT34 },
+   { "mat4x3", KW_TYPE, TYPE_SPECIFIER_MAT43 },
+   { "sampler1D", KW_TYPE, TYPE_SPECIFIER_SAMPLER1D },
+   { "sampler2D", KW_TYPE, TYPE_SPECIFIER_SAMPLER2D },
+   { "sampler3D", KW_TYPE, TYPE_SPECIFIER_SAMPLER3D },
+   { "samplerCube", KW_TYPE, TYPE_SPECIFIER_SAMPLERCUBE },
+   { "sampler1DShadow", KW_TYPE, TYPE_SPECIFIER_SAMPLER1DSHADOW },
+   { "sampler2DShadow", KW_TYPE, TYPE_SPECIFIER_SAMPLER2DSHADOW },
+   { "sampler2DRect", KW_TYPE, TYPE_SPECIFIER_SAMPLER2DRECT },
+   { "sampler2DRectShadow", KW_TYPE, TYPE_SPECIFIER_SAMPLER2DRECTSHADOW },
+   { "const", KW_QUALIFIER, TYPE_QUALIFIER_CONST },
+   { "attribute", KW_QUALIFIER, TYPE_QUALIFIER_ATTRIBUTE },
+   { "varying", KW_QUALIFIER, TYPE_QUALIFIER_VARYING },
+   { "uniform", KW_QUALIFIER, TYPE_QUALIFIER_UNIFORM },
+   { "__fixed_output", KW_QUALIFIER, TYPE_QUALIFIER_FIXEDOUTPUT },
+   { "__fixed_input", KW_QUALIFIER, TYPE_QUALIFIER_FIXEDINPUT },
+   { "lowp", KW_PRECISION_QUALIFIER, PRECISION_LOW },
+   { "mediump", KW_PRECISION_QUALIFIER, PRECISION_MEDIUM },
+   { "highp", KW_PRECISION_QUALIFIER, PRECISION_HIGH },
+   { "in", KW_PARAM_QUALIFIER, PARAM_QUALIFIER_IN },
+   { "out", KW_PARAM_QUALIFIER, PARAM_QUALIFIER_OUT },
+   { "inout", KW_PARAM_QUALIFIER, PARAM_QUALIFIER_INOUT },
+   { "__asm", KW_ASM, 0 },
+   { "break", KW_BREAK, 0 },
+   { "centroid", KW_CENTROID, 0 },
+   { "__constructor", KW_CONSTRUCTOR, 0 },
+   { "continue", KW_CONTINUE, 0 },
+   { "discard", KW_DISCARD, 0 },
+   { "do", KW_DO, 0 },
+   { "else", KW_ELSE, 0 },
+   { "false", KW_FALSE, 0 },
+   { "for", KW_FOR, 0 },
+   { "if", KW_IF, 0 },
+   { "invariant", KW_INVARIANT, 0 },
+   { "__operator", KW_OPERATOR, 0 },
+   { "precision", KW_PRECISION, 0 },
+   { "return", KW_RETURN, 0 },
+   { "struct", KW_STRUCT, 0 },
+   { "true", KW_TRUE, 0 },
+   { "while", KW_WHILE, 0 }
+};
+
+
+struct token
+{
+   GLubyte type;     /**< TOKEN_x */
+   GLubyte keyword;  /**< KW_x, for identifiers */
+   GLubyte code;     /**< keyword's emit code */
+   GLuint length;
+   const char *text;
+};
+
+
+typedef struct
+{
+   const struct token *tokens;
+   GLuint pos;             /**< current token */
+   GLubyte *out;           /**< emitted byte stream */
+   GLuint size, capacity;
+   GLboolean builtin;      /**< accept the built-in library extensions */
+   GLboolean vertex;       /**< vertex (else fragment) shader */
+   const char *error;      /**< set once a fatal error is found */
+   const struct token *errorToken;
+} parse_ctx;
+
+
+/** Token position and output size, for backtracking */
+typedef struct
+{
+   GLuint pos, size;
+} parse_state;
+
+
+#define IS_ALPHA(c) (((c) >= 'a' && (c) <= 'z') || ((c) >= 'A' && (c) <= 'Z') \
+                     || (c) == '_')
+#define IS_DIGIT(c) ((c) >= '0' && (c) <= '9')
+#define IS_OCT_DIGIT(c) ((c) >= '0' && (c) <= '7')
+#define IS_HEX_DIGIT(c) (IS_DIGIT(c) || ((c) >= 'a' && (c) <= 'f') \
+                         || ((c) >= 'A' && (c) <= 'F'))
+
+
+/**
+ * Return the length of the number at s and whether it is a float, using
+ * the same rules as the grammar: float forms are tried before integers.
+ */
+static GLuint
+scan_number(const char *s, GLubyte *type)
+{
+   const char *p = s;
+   GLboolean isFloat = GL_FALSE;
+
+   while (IS_DIGIT(*p))
+      p++;
+   if (*p == '.') {
+      p++;
+      while (IS_DIGIT(*p))
+         p++;
+      isFloat = GL_TRUE;
+   }
+   if (*p == 'e' || *p == 'E') {
+      const char *q = p + 1;
+      if (*q == '+' || *q == '-')
+         q++;
+      if (IS_DIGIT(*q)) {
+         while (IS_DIGIT(*q))
+            q++;
+         p = q;
+         isFloat = GL_TRUE;
+      }
+   }
+   if (*p == 'f') {
+      p++;
+      isFloat = GL_TRUE;
+   }
+   if (isFloat) {
+      *type = TOKEN_FLOAT;
+      return p - s;
+   }
+
+   *type = TOKEN_INT;
+   if (s[0] == '0' && (s[1] == 'x' || s[1] == 'X') && IS_HEX_DIGIT(s[2])) {
+      p = s + 2;
+      while (IS_HEX_DIGIT(*p))
+         p++;
+   }
+   else if (s[0] == '0') {
+      p = s + 1;
+      while (IS_OCT_DIGIT(*p))
+         p++;
+   }
+   else {
+      p = s;
+      while (IS_DIGIT(*p))
+         p++;
+   }
+   return p - s;
+}
+
+
+/**
+ * Return the length of the punctuator at s.
+ */
+static GLuint
+scan_punctuator(const char *s, GLubyte *type)
+{
+   const char c = s[0], next = s[1];
+
+   switch (c) {
+   case '&':
+      if (next == '&') {
+         *type = TOKEN_AMPAMP;
+         return 2;
+      }
+      break;
+   case '|':
+      if (next == '|') {
+         *type = TOKEN_BARBAR;
+         return 2;
+      }
+      break;
+   case '^':
+      if (next == '^') {
+         *type = TOKEN_CARETCARET;
+         return 2;
+      }
+      break;
+   case '!':
+      *type = next == '=' ? TOKEN_BANGEQ : TOKEN_BANG;
+      return next == '=' ? 2 : 1;
+   case '=':
+      *type = next == '=' ? TOKEN_EQEQ : TOKEN_EQ;
+      return next == '=' ? 2 : 1;
+   case '>':
+      *type = next == '=' ? TOKEN_GE : TOKEN_GT;
+      return next == '=' ? 2 : 1;
+   case '<':
+      *type = next == '=' ? TOKEN_LE : TOKEN_LT;
+      return next == '=' ? 2 : 1;
+   case '/':
+      *type = next == '=' ? TOKEN_SLASHEQ : TOKEN_SLASH;
+      return next == '=' ? 2 : 1;
+   case '*':
+      *type = next == '=' ? TOKEN_STAREQ : TOKEN_STAR;
+      return next == '=' ? 2 : 1;
+   case '-':
+      if (next == '-' || next == '=') {
+         *type = next == '-' ? TOKEN_MINUSMINUS : TOKEN_MINUSEQ;
+         return 2;
+      }
+      *type = TOKEN_MINUS;
+      return 1;
+   case '+':
+      if (next == '+' || next == '=') {
+         *type = next == '+' ? TOKEN_PLUSPLUS : TOKEN_PLUSEQ;
+         return 2;
+      }
+      *type = TOKEN_PLUS;
+      return 1;
+   case ':':
+      *type = TOKEN_COLON;
+      return 1;
+   case ',':
+      *type = TOKEN_COMMA;
+      return 1;
+   case '.':
+      *type = TOKEN_DOT;
+      return 1;
+   case '{':
+      *type = TOKEN_LBRACE;
+      return 1;
+   case '}':
+      *type = TOKEN_RBRACE;
+      return 1;
+   case '[':
+      *type = TOKEN_LBRACKET;
+      return 1;
+   case ']':
+      *type = TOKEN_RBRACKET;
+      return 1;
+   case '(':
+      *type = TOKEN_LPAREN;
+      return 1;
+   case ')':
+      *type = TOKEN_RPAREN;
+      return 1;
+   case '?':
+      *type = TOKEN_QUESTION;
+      return 1;
+   case ';':
+      *type = TOKEN_SEMICOLON;
+      return 1;
+   }
+
+   *type = TOKEN_OTHER;
+   return 1;
+}
+
+
+static void
+lookup_keyword(struct token *tok)
+{
+   GLuint i;
+
+   for (i = 0; i < Elements(Keywords); i++) {
+      const char *name = Keywords[i].name;
+      if (name[0] == tok->text[0] &&
+          _mesa_strncmp(name, tok->text, tok->length) == 0 &&
+          name[tok->length] == '\0') {
+         tok->keyword = Keywords[i].keyword;
+         tok->code = Keywords[i].code;
+         return;
+      }
+   }
+}
+
+
+/**
+ * Split the source into tokens, skipping white space and comments.
+ * The list is terminated by a TOKEN_END token.  An unterminated comment
+ * becomes a TOKEN_OTHER so that parsing fails there.
+ * \return GL_FALSE if out of memory
+ */
+static GLboolean
+tokenize(const char *source, struct token **tokens)
+{
+   GLuint count = 0, capacity = 256;
+   struct token *list;
+   const char *p = source;
+
+   list = (struct token *) _mesa_malloc(capacity * sizeof(struct token));
+   if (!list)
+      return GL_FALSE;
+
+   for (;;) {
+      struct token *tok;
+
+      /* white space and comments */
+      for (;;) {
+         if (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r' ||
+             *p == '\v' || *p == '\f') {
+            p++;
+         }
+         else if (p[0] == '/' && p[1] == '/') {
+            p += 2;
+            while (*p && *p != '\n' && *p != '\r')
+               p++;
+         }
+         else if (p[0] == '/' && p[1] == '*') {
+            const char *end = _mesa_strstr(p + 2, "*/");
+            if (!end)
+               break;
+            p = end + 2;
+         }
+         else {
+            break;
+         }
+      }
+
+      if (count == capacity) {
+         struct token *grown = (struct token *)
+            _mesa_realloc(list, capacity * sizeof(struct token),
+                          2 * capacity * sizeof(struct token));
+         if (!grown) {
+            _mesa_free(list);
+            return GL_FALSE;
+         }
+         list = grown;
+         capacity *= 2;
+      }
+
+      tok = &list[count++];
+      tok->keyword = KW_NONE;
+      tok->code = 0;
+      tok->text = p;
+
+      if (*p == '\0') {
+         tok->type = TOKEN_END;
+         tok->length = 0;
+         break;
+      }
+      else if (IS_ALPHA(*p)) {
+         while (IS_ALPHA(*p) || IS_DIGIT(*p))
+            p++;
+         tok->type = TOKEN_IDENTIFIER;
+         tok->length = p - tok->text;
+         lookup_keyword(tok);
+      }
+      else if (IS_DIGIT(*p) || (p[0] == '.' && IS_DIGIT(p[1]))) {
+         tok->length = scan_number(p, &tok->type);
+         p += tok->length;
+      }
+      else if (p[0] == '/' && p[1] == '*') {
+         /* unterminated comment: nothing after it can be parsed */
+         tok->type = TOKEN_OTHER;
+         tok->length = 2;
+         p += _mesa_strlen(p);
+      }
+      else {
+         tok->length = scan_punctuator(p, &tok->type);
+         p += tok->length;
+      }
+   }
+
+   *tokens = list;
+   return GL_TRUE;
+}
+
+
+/**
+ * Output helpers
+ */
+
+static void
+emit(parse_ctx *P, GLubyte b)
+{
+   if (P->size == P->capacity) {
+      GLubyte *grown;
+
+      if (P->error)
+         return;
+      grown = (GLubyte *) _mesa_realloc(P->out, P->capacity,
+                                        2 * P->capacity);
+      if (!grown) {
+         P->error = "Out of memory.";
+         P->errorToken = NULL;
+         return;
+      }
+      P->out = grown;
+      P->capacity *= 2;
+   }
+   P->out[P->size++] = b;
+}
+
+
+static void
+emit_text(parse_ctx *P, const char *text, GLuint length)
+{
+   GLuint i;
+
+   for (i = 0; i < length; i++)
+      emit(P, (GLubyte) text[i]);
+   emit(P, '\0');
+}
+
+
+/**
+ * Emit a float constant as three strings: integer part, fraction and
+ * exponent (with a leading '-' if negative).
+ */
+static void
+emit_float(parse_ctx *P, const struct token *tok)
+{
+   const char *p = tok->text;
+
+   while (IS_DIGIT(*p))
+      emit(P, *p++);
+   emit(P, '\0');
+   if (*p == '.') {
+      p++;
+      while (IS_DIGIT(*p))
+         emit(P, *p++);
+   }
+   emit(P, '\0');
+   if (*p == 'e' || *p == 'E') {
+      p++;
+      if (*p == '-')
+         emit(P, *p++);
+      else if (*p == '+')
+         p++;
+      while (IS_DIGIT(*p))
+         emit(P, *p++);
+   }
+   emit(P, '\0');
+}
+
+
+/**
+ * Emit an integer constant as its radix followed by its digits.
+ */
+static void
+emit_int(parse_ctx *P, const struct token *tok)
+{
+   if (tok->length > 1 && (tok->text[1] == 'x' || tok->text[1] == 'X')) {
+      emit(P, 16);
+      emit_text(P, tok->text + 2, tok->length - 2);
+   }
+   else {
+      emit(P, tok->text[0] == '0' ? 8 : 10);
+      emit_text(P, tok->text, tok->length);
+   }
+}
+
+
+/**
+ * Token helpers
+ */
+
+static INLINE const struct token *
+peek(const parse_ctx *P)
+{
+   return &P->tokens[P->pos];
+}
+
+
+static INLINE const struct token *
+peek_next(const parse_ctx *P)
+{
+   const struct token *tok = &P->tokens[P->pos];
+   return tok->type == TOKEN_END ? tok : tok + 1;
+}
+
+
+static INLINE parse_state
+save(const parse_ctx *P)
+{
+   parse_state s;
+   s.pos = P->pos;
+   s.size = P->size;
+   return s;
+}
+
+
+/** Backtrack to a saved state; returns GL_FALSE for convenience */
+static INLINE GLboolean
+restore(parse_ctx *P, parse_state s)
+{
+   P->pos = s.pos;
+   P->size = s.size;
+   return GL_FALSE;
+}
+
+
+static INLINE GLboolean
+accept(parse_ctx *P, GLubyte type)
+{
+   if (P->tokens[P->pos].type == type) {
+      P->pos++;
+      return GL_TRUE;
+   }
+   return GL_FALSE;
+}
+
+
+static INLINE GLboolean
+accept_keyword(parse_ctx *P, GLubyte keyword)
+{
+   if (P->tokens[P->pos].keyword == keyword) {
+      P->pos++;
+      return GL_TRUE;
+   }
+   return GL_FALSE;
+}
+
+
+static GLboolean
+accept_void(parse_ctx *P)
+{
+   const struct token *tok = peek(P);
+
+   if (tok->keyword == KW_TYPE && tok->code == TYPE_SPECIFIER_VOID) {
+      P->pos++;
+      return GL_TRUE;
+   }
+   return GL_FALSE;
+}
+
+
+/** Record a fatal error at the current token; only the first one counts */
+static GLboolean
+error(parse_ctx *P, const char *msg)
+{
+   if (!P->error) {
+      P->error = msg;
+      P->errorToken = peek(P);
+   }
+   return GL_FALSE;
+}
+
+
+/** Accept the token or fail with a fatal error */
+static GLboolean
+expect(parse_ctx *P, GLubyte type, const char *msg)
+{
+   return accept(P, type) || error(P, msg);
+}
+
+
+/**
+ * Whether white space or a comment separates the current token from the
+ * next one.  The grammar requires it after qualifiers, so that e.g. a
+ * "uniform" followed by punctuation is taken as a type name instead.
+ */
+static GLboolean
+space_follows(const parse_ctx *P)
+{
+   const struct token *tok = peek(P);
+   return peek_next(P)->text > tok->text + tok->length;
+}
+
+
+static GLboolean
+parse_identifier(parse_ctx *P)
+{
+   const struct token *tok = peek(P);
+
+   if (tok->type != TOKEN_IDENTIFIER)
+      return GL_FALSE;
+   emit_text(P, tok->text, tok->length);
+   P->pos++;
+   return GL_TRUE;
+}
+
+
+/**
+ * Expressions.  Operations are emitted in postfix order.
+ */
+
+static GLboolean parse_expression(parse_ctx *P);
+static GLboolean parse_assignment_expression(parse_ctx *P);
+static GLboolean parse_conditional_expression(parse_ctx *P);
+static GLboolean parse_statement(parse_ctx *P);
+
+
+static GLboolean
+parse_constant_expression(parse_ctx *P)
+{
+   if (!parse_conditional_expression(P))
+      return GL_FALSE;
+   emit(P, OP_END);
+   return GL_TRUE;
+}
+
+
+static GLboolean
+parse_initializer(parse_ctx *P)
+{
+   if (!parse_assignment_expression(P))
+      return GL_FALSE;
+   emit(P, OP_END);
+   return GL_TRUE;
+}
+
+
+static GLboolean
+parse_primary_expression(parse_ctx *P)
+{
+   const struct token *tok = peek(P);
+   parse_state s;
+
+   switch (tok->type) {
+   case TOKEN_FLOAT:
+      emit(P, OP_PUSH_FLOAT);
+      emit_float(P, tok);
+      P->pos++;
+      return GL_TRUE;
+   case TOKEN_INT:
+      emit(P, OP_PUSH_INT);
+      emit_int(P, tok);
+      P->pos++;
+      return GL_TRUE;
+   case TOKEN_IDENTIFIER:
+      if (tok->keyword == KW_TRUE || tok->keyword == KW_FALSE) {
+         emit(P, OP_PUSH_BOOL);
+         emit(P, 2);
+         emit(P, tok->keyword == KW_TRUE ? '1' : '0');
+         emit(P, '\0');
+         P->pos++;
+         return GL_TRUE;
+      }
+      emit(P, OP_PUSH_IDENTIFIER);
+      return parse_identifier(P);
+   case TOKEN_LPAREN:
+      s = save(P);
+      P->pos++;
+      if (parse_expression(P) && accept(P, TOKEN_RPAREN))
+         return GL_TRUE;
+      return restore(P, s);
+   default:
+      return GL_FALSE;
+   }
+}
+
+
+/**
+ * The function name, FUNCTION_CALL_ARRAY and the array size or
+ * FUNCTION_CALL_NONARRAY, then the arguments, each ended by OP_END.
+ */
+static GLboolean
+parse_function_call_generic(parse_ctx *P)
+{
+   parse_state s = save(P), args;
+
+   if (!parse_identifier(P))
+      return GL_FALSE;
+   args = save(P);
+   if (accept(P, TOKEN_LBRACKET)) {
+      emit(P, FUNCTION_CALL_ARRAY);
+      if (!parse_constant_expression(P) || !accept(P, TOKEN_RBRACKET)) {
+         if (P->error)
+            return GL_FALSE;
+         restore(P, args);
+         emit(P, FUNCTION_CALL_NONARRAY);
+      }
+   }
+   else {
+      emit(P, FUNCTION_CALL_NONARRAY);
+   }
+   if (!accept(P, TOKEN_LPAREN))
+      return restore(P, s);
+
+   args = save(P);
+   if (parse_assignment_expression(P)) {
+      emit(P, OP_END);
+      for (;;) {
+         parse_state a = save(P);
+         if (!accept(P, TOKEN_COMMA) || !parse_assignment_expression(P)) {
+            restore(P, a);
+            break;
+         }
+         emit(P, OP_END);
+      }
+      return expect(P, TOKEN_RPAREN, ERR_RPAREN_EXPECTED);
+   }
+   if (P->error)
+      return GL_FALSE;
+   accept_void(P);
+   return expect(P, TOKEN_RPAREN, ERR_RPAREN_EXPECTED);
+}
+
+
+/**
+ * <function_call_or_method>: "f(...)" or "a.f(...)".
+ */
+static GLboolean
+parse_function_call(parse_ctx *P)
+{
+   const struct token *next = peek_next(P);
+   parse_state s = save(P);
+
+   if (peek(P)->type != TOKEN_IDENTIFIER)
+      return GL_FALSE;
+
+   if (next->type == TOKEN_LPAREN || next->type == TOKEN_LBRACKET) {
+      emit(P, OP_CALL);
+      if (parse_function_call_generic(P)) {
+         emit(P, OP_END);
+         return GL_TRUE;
+      }
+      return restore(P, s);
+   }
+   else if (next->type == TOKEN_DOT) {
+      emit(P, OP_METHOD);
+      parse_identifier(P);
+      P->pos++;
+      if (parse_function_call_generic(P)) {
+         emit(P, OP_END);
+         return GL_TRUE;
+      }
+      return restore(P, s);
+   }
+   return GL_FALSE;
+}
+
+
+static GLboolean
+parse_postfix_expression(parse_ctx *P)
+{
+   if (!parse_function_call(P) &&
+       (P->error || !parse_primary_expression(P)))
+      return GL_FALSE;
+
+   for (;;) {
+      parse_state s = save(P);
+
+      switch (peek(P)->type) {
+      case TOKEN_LBRACKET:
+         P->pos++;
+         if (!parse_expression(P) || !accept(P, TOKEN_RBRACKET)) {
+            restore(P, s);
+            return !P->error;
+         }
+         emit(P, OP_SUBSCRIPT);
+         break;
+      case TOKEN_DOT:
+         P->pos++;
+         emit(P, OP_FIELD);
+         if (!parse_identifier(P)) {
+            restore(P, s);
+            return GL_TRUE;
+         }
+         break;
+      case TOKEN_PLUSPLUS:
+         P->pos++;
+         emit(P, OP_POSTINCREMENT);
+         break;
+      case TOKEN_MINUSMINUS:
+         P->pos++;
+         emit(P, OP_POSTDECREMENT);
+         break;
+      default:
+         return !P->error;
+      }
+   }
+}
+
+
+static GLboolean
+parse_unary_expression(parse_ctx *P)
+{
+   parse_state s;
+   GLubyte op;
+
+   if (parse_postfix_expression(P))
+      return GL_TRUE;
+   if (P->error)
+      return GL_FALSE;
+
+   switch (peek(P)->type) {
+   case TOKEN_PLUSPLUS:
+      op = OP_PREINCREMENT;
+      break;
+   case TOKEN_MINUSMINUS:
+      op = OP_PREDECREMENT;
+      break;
+   case TOKEN_PLUS:
+      op = OP_PLUS;
+      break;
+   case TOKEN_MINUS:
+      op = OP_MINUS;
+      break;
+   case TOKEN_BANG:
+      op = OP_NOT;
+      break;
+   default:
+      return GL_FALSE;
+   }
+
+   s = save(P);
+   P->pos++;
+   if (!parse_unary_expression(P))
+      return restore(P, s);
+   emit(P, op);
+   return GL_TRUE;
+}
+
+
+/**
+ * Binary operators by precedence level, 1 (multiplicative) binding
+ * tightest and MAX_BINARY_LEVEL (logical or) loosest.
+ * \return the operation or 0 if the token is not an operator of the level
+ */
+#define MAX_BINARY_LEVEL 7
+
+static GLubyte
+binary_operator(GLuint level, GLubyte type)
+{
+   switch (level) {
+   case 1:
+      return type == TOKEN_STAR ? OP_MULTIPLY :
+             type == TOKEN_SLASH ? OP_DIVIDE : 0;
+   case 2:
+      return type == TOKEN_PLUS ? OP_ADD :
+             type == TOKEN_MINUS ? OP_SUBTRACT : 0;
+   case 3:
+      return type == TOKEN_LE ? OP_LESSEQUAL :
+             type == TOKEN_GE ? OP_GREATEREQUAL :
+             type == TOKEN_LT ? OP_LESS :
+             type == TOKEN_GT ? OP_GREATER : 0;
+   case 4:
+      return type == TOKEN_EQEQ ? OP_EQUAL :
+             type == TOKEN_BANGEQ ? OP_NOTEQUAL : 0;
+   case 5:
+      return type == TOKEN_AMPAMP ? OP_LOGICALAND : 0;
+   case 6:
+      return type == TOKEN_CARETCARET ? OP_LOGICALXOR : 0;
+   case 7:
+      return type == TOKEN_BARBAR ? OP_LOGICALOR : 0;
+   default:
+      return 0;
+   }
+}
+
+
+static GLboolean parse_binary_expression(parse_ctx *P, GLuint level);
+
+
+/**
+ * The repeated "operator operand" part of a binary expression level
+ * (multiplicative_expression_1 etc. in the grammar).
+ */
+static GLboolean
+parse_binary_rest(parse_ctx *P, GLuint level)
+{
+   GLubyte op;
+
+   while ((op = binary_operator(level, peek(P)->type)) != 0) {
+      parse_state s = save(P);
+
+      P->pos++;
+      if (!parse_binary_expression(P, level - 1)) {
+         restore(P, s);
+         break;
+      }
+      emit(P, op);
+   }
+   return !P->error;
+}
+
+
+static GLboolean
+parse_binary_expression(parse_ctx *P, GLuint level)
+{
+   if (level == 0)
+      return parse_unary_expression(P);
+   return parse_binary_expression(P, level - 1) &&
+          parse_binary_rest(P, level);
+}
+
+
+static GLboolean
+parse_conditional_rest(parse_ctx *P)
+{
+   for (;;) {
+      parse_state s = save(P);
+
+      if (!accept(P, TOKEN_QUESTION))
+         break;
+      if (!parse_expression(P) || !accept(P, TOKEN_COLON) ||
+          !parse_conditional_expression(P)) {
+         restore(P, s);
+         break;
+      }
+      emit(P, OP_SELECT);
+   }
+   return !P->error;
+}
+
+
+static GLboolean
+parse_conditional_expression(parse_ctx *P)
+{
+   return parse_binary_expression(P, MAX_BINARY_LEVEL) &&
+          parse_conditional_rest(P);
+}
+
+
+/**
+ * The grammar tries "unary_expression assignment_operator
+ * assignment_expression" before conditional_expression, which also
+ * starts with a unary_expression.  Parse that operand only once and
+ * continue with whichever form follows it.
+ */
+static GLboolean
+parse_assignment_expression(parse_ctx *P)
+{
+   GLubyte op;
+   GLuint level;
+
+   if (!parse_unary_expression(P))
+      return GL_FALSE;
+
+   switch (peek(P)->type) {
+   case TOKEN_EQ:
+      op = OP_ASSIGN;
+      break;
+   case TOKEN_STAREQ:
+      op = OP_MULASSIGN;
+      break;
+   case TOKEN_SLASHEQ:
+      op = OP_DIVASSIGN;
+      break;
+   case TOKEN_PLUSEQ:
+      op = OP_ADDASSIGN;
+      break;
+   case TOKEN_MINUSEQ:
+      op = OP_SUBASSIGN;
+      break;
+   default:
+      op = 0;
+   }
+
+   if (op) {
+      parse_state s = save(P);
+
+      P->pos++;
+      if (parse_assignment_expression(P)) {
+         emit(P, op);
+         return GL_TRUE;
+      }
+      if (P->error)
+         return GL_FALSE;
+      restore(P, s);
+   }
+
+   for (level = 1; level <= MAX_BINARY_LEVEL; level++) {
+      if (!parse_binary_rest(P, level))
+         return GL_FALSE;
+   }
+   return parse_conditional_rest(P);
+}
+
+
+static GLboolean
+parse_expression(parse_ctx *P)
+{
+   if (!parse_assignment_expression(P))
+      return GL_FALSE;
+
+   for (;;) {
+      parse_state s = save(P);
+
+      if (!accept(P, TOKEN_COMMA) || !parse_assignment_expression(P)) {
+         restore(P, s);
+         break;
+      }
+      emit(P, OP_SEQUENCE);
+   }
+   return !P->error;
+}
+
+
+/**
+ * Types
+ */
+
+static GLboolean parse_type_specifier(parse_ctx *P);
+
+
+static GLboolean
+parse_type_qualifier(parse_ctx *P)
+{
+   const struct token *tok = peek(P);
+
+   if (tok->keyword != KW_QUALIFIER || !space_follows(P))
+      return GL_FALSE;
+   if (tok->code == TYPE_QUALIFIER_ATTRIBUTE && !P->vertex)
+      return GL_FALSE;
+   if ((tok->code == TYPE_QUALIFIER_FIXEDOUTPUT ||
+        tok->code == TYPE_QUALIFIER_FIXEDINPUT) && !P->builtin)
+      return GL_FALSE;
+   emit(P, tok->code);
+   P->pos++;
+   return GL_TRUE;
+}
+
+
+static GLboolean
+parse_precision(parse_ctx *P)
+{
+   const struct token *tok = peek(P);
+
+   if (tok->keyword != KW_PRECISION_QUALIFIER || !space_follows(P))
+      return GL_FALSE;
+   emit(P, tok->code);
+   P->pos++;
+   return GL_TRUE;
+}
+
+
+static GLboolean
+parse_struct_declarator(parse_ctx *P)
+{
+   parse_state s;
+
+   if (!parse_identifier(P))
+      return GL_FALSE;
+   s = save(P);
+   if (accept(P, TOKEN_LBRACKET)) {
+      emit(P, FIELD_ARRAY);
+      if (parse_constant_expression(P) && accept(P, TOKEN_RBRACKET))
+         return GL_TRUE;
+      if (P->error)
+         return GL_FALSE;
+      restore(P, s);
+   }
+   emit(P, FIELD_NONE);
+   return GL_TRUE;
+}
+
+
+static GLboolean
+parse_struct_declaration(parse_ctx *P)
+{
+   parse_state s = save(P);
+
+   if (!parse_type_specifier(P) || !parse_struct_declarator(P))
+      return restore(P, s);
+   for (;;) {
+      parse_state d = save(P);
+
+      emit(P, FIELD_NEXT);
+      if (!accept(P, TOKEN_COMMA) || !parse_struct_declarator(P)) {
+         restore(P, d);
+         break;
+      }
+   }
+   if (!accept(P, TOKEN_SEMICOLON))
+      return restore(P, s);
+   emit(P, FIELD_NONE);
+   return GL_TRUE;
+}
+
+
+static GLboolean
+parse_struct_specifier(parse_ctx *P)
+{
+   parse_state s = save(P);
+
+   if (!accept_keyword(P, KW_STRUCT))
+      return GL_FALSE;
+   if (!parse_identifier(P))
+      emit(P, '\0');
+   if (!expect(P, TOKEN_LBRACE, ERR_LBRACE_EXPECTED))
+      return GL_FALSE;
+   if (!parse_struct_declaration(P))
+      return restore(P, s);
+   for (;;) {
+      parse_state d = save(P);
+
+      emit(P, FIELD_NEXT);
+      if (!parse_struct_declaration(P)) {
+         restore(P, d);
+         break;
+      }
+   }
+   if (!accept(P, TOKEN_RBRACE))
+      return restore(P, s);
+   emit(P, FIELD_NONE);
+   return GL_TRUE;
+}
+
+
+/**
+ * A built-in type, a structure or the name of a structure type.
+ */
+static GLboolean
+parse_type_specifier_nonarray(parse_ctx *P)
+{
+   const struct token *tok = peek(P);
+
+   if (tok->type != TOKEN_IDENTIFIER)
+      return GL_FALSE;
+
+   if (tok->keyword == KW_STRUCT) {
+      parse_state s = save(P);
+
+      emit(P, TYPE_SPECIFIER_STRUCT);
+      if (parse_struct_specifier(P))
+         return GL_TRUE;
+      if (P->error)
+         return GL_FALSE;
+      restore(P, s);
+   }
+   else if (tok->keyword == KW_TYPE) {
+      emit(P, tok->code);
+      P->pos++;
+      return GL_TRUE;
+   }
+
+   emit(P, TYPE_SPECIFIER_TYPENAME);
+   return parse_identifier(P);
+}
+
+
+static GLboolean
+parse_type_specifier(parse_ctx *P)
+{
+   parse_state s;
+
+   if (!parse_type_specifier_nonarray(P))
+      return GL_FALSE;
+   s = save(P);
+   if (accept(P, TOKEN_LBRACKET)) {
+      emit(P, TYPE_SPECIFIER_ARRAY);
+      if (parse_constant_expression(P) && accept(P, TOKEN_RBRACKET))
+         return GL_TRUE;
+      if (P->error)
+         return GL_FALSE;
+      restore(P, s);
+   }
+   emit(P, TYPE_SPECIFIER_NONARRAY);
+   return GL_TRUE;
+}
+
+
+static GLboolean
+parse_fully_specified_type(parse_ctx *P)
+{
+   parse_state s = save(P);
+
+   if (peek(P)->keyword == KW_INVARIANT && space_follows(P)) {
+      P->pos++;
+      emit(P, TYPE_INVARIANT);
+   }
+   else {
+      emit(P, TYPE_VARIANT);
+   }
+   if (peek(P)->keyword == KW_CENTROID && space_follows(P)) {
+      P->pos++;
+      emit(P, TYPE_CENTROID);
+   }
+   else {
+      emit(P, TYPE_CENTER);
+   }
+   if (!parse_type_qualifier(P))
+      emit(P, TYPE_QUALIFIER_NONE);
+   if (!parse_precision(P))
+      emit(P, PRECISION_DEFAULT);
+   if (!parse_type_specifier(P))
+      return restore(P, s);
+   return GL_TRUE;
+}
+
+
+/**
+ * Declarations
+ */
+
+/**
+ * What may follow a declared variable's name: an initializer, an array
+ * size or nothing (single_declaration_3 and init_declarator_list_2).
+ */
+static GLboolean
+parse_variable_declarator(parse_ctx *P)
+{
+   parse_state s = save(P);
+
+   if (accept(P, TOKEN_EQ)) {
+      emit(P, VARIABLE_INITIALIZER);
+      if (parse_initializer(P))
+         return GL_TRUE;
+      if (P->error)
+         return GL_FALSE;
+      restore(P, s);
+   }
+   else if (accept(P, TOKEN_LBRACKET)) {
+      parse_state size = save(P);
+
+      emit(P, VARIABLE_ARRAY_EXPLICIT);
+      if (!parse_constant_expression(P)) {
+         if (P->error)
+            return GL_FALSE;
+         restore(P, size);
+         emit(P, VARIABLE_ARRAY_UNKNOWN);
+      }
+      if (accept(P, TOKEN_RBRACKET))
+         return GL_TRUE;
+      restore(P, s);
+   }
+   emit(P, VARIABLE_NONE);
+   return !P->error;
+}
+
+
+static GLboolean
+parse_init_declarator_list(parse_ctx *P)
+{
+   if (!parse_fully_specified_type(P))
+      return GL_FALSE;
+
+   if (peek(P)->type == TOKEN_IDENTIFIER) {
+      emit(P, VARIABLE_IDENTIFIER);
+      parse_identifier(P);
+      if (!parse_variable_declarator(P))
+         return GL_FALSE;
+   }
+   else {
+      emit(P, VARIABLE_NONE);
+   }
+
+   for (;;) {
+      parse_state s = save(P);
+
+      emit(P, DECLARATOR_NEXT);
+      if (!accept(P, TOKEN_COMMA) || peek(P)->type != TOKEN_IDENTIFIER) {
+         restore(P, s);
+         break;
+      }
+      emit(P, VARIABLE_IDENTIFIER);
+      parse_identifier(P);
+      if (!parse_variable_declarator(P))
+         return GL_FALSE;
+   }
+   emit(P, DECLARATOR_NONE);
+   return !P->error;
+}
+
+
+/**
+ * Everything in a parameter declaration after the type qualifier:
+ * parameter qualifier, precision, type, name and array size.
+ */
+static GLboolean
+parse_parameter_declaration_rest(parse_ctx *P)
+{
+   parse_state s = save(P), a;
+   const struct token *tok = peek(P);
+
+   if (tok->keyword == KW_PARAM_QUALIFIER && space_follows(P)) {
+      emit(P, tok->code);
+      P->pos++;
+   }
+   else {
+      emit(P, PARAM_QUALIFIER_IN);
+   }
+   if (!parse_precision(P))
+      emit(P, PRECISION_DEFAULT);
+   if (!parse_type_specifier(P))
+      return restore(P, s);
+   if (!parse_identifier(P))
+      emit(P, '\0');
+
+   a = save(P);
+   if (accept(P, TOKEN_LBRACKET)) {
+      emit(P, PARAMETER_ARRAY_PRESENT);
+      if (parse_constant_expression(P) && accept(P, TOKEN_RBRACKET))
+         return GL_TRUE;
+      if (P->error)
+         return GL_FALSE;
+      restore(P, a);
+   }
+   emit(P, PARAMETER_ARRAY_NOT_PRESENT);
+   return GL_TRUE;
+}
+
+
+static GLboolean
+parse_parameter_declaration(parse_ctx *P)
+{
+   parse_state s = save(P);
+
+   emit(P, PARAMETER_NEXT);
+   if (parse_type_qualifier(P)) {
+      if (parse_parameter_declaration_rest(P))
+         return GL_TRUE;
+      if (P->error)
+         return GL_FALSE;
+      restore(P, s);
+      emit(P, PARAMETER_NEXT);
+   }
+   emit(P, TYPE_QUALIFIER_NONE);
+   if (parse_parameter_declaration_rest(P))
+      return GL_TRUE;
+   return restore(P, s);
+}
+
+
+static GLboolean
+parse_overriden_operator(parse_ctx *P)
+{
+   GLubyte op;
+
+   switch (peek(P)->type) {
+   case TOKEN_PLUSPLUS:
+      op = OPERATOR_INCREMENT;
+      break;
+   case TOKEN_PLUSEQ:
+      op = OPERATOR_ADDASSIGN;
+      break;
+   case TOKEN_PLUS:
+      op = OPERATOR_PLUS;
+      break;
+   case TOKEN_MINUSMINUS:
+      op = OPERATOR_DECREMENT;
+      break;
+   case TOKEN_MINUSEQ:
+      op = OPERATOR_SUBASSIGN;
+      break;
+   case TOKEN_MINUS:
+      op = OPERATOR_MINUS;
+      break;
+   case TOKEN_BANG:
+      op = OPERATOR_NOT;
+      break;
+   case TOKEN_STAREQ:
+      op = OPERATOR_MULASSIGN;
+      break;
+   case TOKEN_STAR:
+      op = OPERATOR_MULTIPLY;
+      break;
+   case TOKEN_SLASHEQ:
+      op = OPERATOR_DIVASSIGN;
+      break;
+   case TOKEN_SLASH:
+      op = OPERATOR_DIVIDE;
+      break;
+   case TOKEN_LE:
+      op = OPERATOR_LESSEQUAL;
+      break;
+   case TOKEN_LT:
+      op = OPERATOR_LESS;
+      break;
+   case TOKEN_GE:
+      op = OPERATOR_GREATEREQUAL;
+      break;
+   case TOKEN_GT:
+      op = OPERATOR_GREATER;
+      break;
+   case TOKEN_CARETCARET:
+      op = OPERATOR_LOGICALXOR;
+      break;
+   default:
+      return GL_FALSE;
+   }
+   emit(P, op);
+   P->pos++;
+   return GL_TRUE;
+}
+
+
+/**
+ * Return type, name and the opening parenthesis.  Operators and
+ * constructors may only be declared by the built-in library.
+ */
+static GLboolean
+parse_function_header(parse_ctx *P)
+{
+   parse_state s = save(P);
+   const struct token *tok;
+
+   if (!parse_fully_specified_type(P))
+      return GL_FALSE;
+
+   tok = peek(P);
+   if (P->builtin && tok->keyword == KW_OPERATOR) {
+      P->pos++;
+      emit(P, FUNCTION_OPERATOR);
+      if (!parse_overriden_operator(P))
+         return error(P, ERR_OPERATOR_OVERRIDE);
+   }
+   else if (P->builtin && tok->keyword == KW_CONSTRUCTOR) {
+      P->pos++;
+      emit(P, FUNCTION_CONSTRUCTOR);
+   }
+   else {
+      emit(P, FUNCTION_ORDINARY);
+      if (!parse_identifier(P))
+         return restore(P, s);
+   }
+
+   if (!accept(P, TOKEN_LPAREN))
+      return restore(P, s);
+   return GL_TRUE;
+}
+
+
+/**
+ * The header, the parameters each preceded by PARAMETER_NEXT, and
+ * PARAMETER_NONE.
+ */
+static GLboolean
+parse_function_prototype(parse_ctx *P)
+{
+   if (!parse_function_header(P))
+      return GL_FALSE;
+
+   if (!accept_void(P) && parse_parameter_declaration(P)) {
+      for (;;) {
+         parse_state s = save(P);
+
+         if (!accept(P, TOKEN_COMMA) || !parse_parameter_declaration(P)) {
+            restore(P, s);
+            break;
+         }
+      }
+   }
+   if (P->error || !expect(P, TOKEN_RPAREN, ERR_RPAREN_EXPECTED))
+      return GL_FALSE;
+   emit(P, PARAMETER_NONE);
+   return GL_TRUE;
+}
+
+
+static GLboolean
+parse_declaration(parse_ctx *P)
+{
+   parse_state s = save(P);
+
+   emit(P, DECLARATION_FUNCTION_PROTOTYPE);
+   if (parse_function_prototype(P) && accept(P, TOKEN_SEMICOLON))
+      return GL_TRUE;
+   if (P->error)
+      return GL_FALSE;
+   restore(P, s);
+
+   emit(P, DECLARATION_INIT_DECLARATOR_LIST);
+   if (parse_init_declarator_list(P) && accept(P, TOKEN_SEMICOLON))
+      return GL_TRUE;
+   return restore(P, s);
+}
+
+
+/**
+ * Statements
+ */
+
+static GLboolean
+parse_compound_statement(parse_ctx *P, GLubyte scope)
+{
+   parse_state s = save(P);
+
+   emit(P, scope);
+   if (!accept(P, TOKEN_LBRACE))
+      return restore(P, s);
+   while (parse_statement(P))
+      ;
+   if (!accept(P, TOKEN_RBRACE))
+      return restore(P, s);
+   emit(P, OP_END);
+   return GL_TRUE;
+}
+
+
+static GLboolean
+parse_expression_statement(parse_ctx *P)
+{
+   parse_state s = save(P);
+
+   if (accept(P, TOKEN_SEMICOLON)) {
+      emit(P, OP_PUSH_VOID);
+      emit(P, OP_END);
+      return GL_TRUE;
+   }
+   if (parse_expression(P) && accept(P, TOKEN_SEMICOLON)) {
+      emit(P, OP_END);
+      return GL_TRUE;
+   }
+   return restore(P, s);
+}
+
+
+static GLboolean
+parse_selection_statement(parse_ctx *P)
+{
+   parse_state s = save(P), e;
+
+   if (!accept_keyword(P, KW_IF))
+      return GL_FALSE;
+   emit(P, OP_IF);
+   if (!expect(P, TOKEN_LPAREN, ERR_LPAREN_EXPECTED))
+      return GL_FALSE;
+   if (!parse_expression(P))
+      return restore(P, s);
+   if (!expect(P, TOKEN_RPAREN, ERR_RPAREN_EXPECTED))
+      return GL_FALSE;
+   emit(P, OP_END);
+   if (!parse_statement(P))
+      return restore(P, s);
+
+   e = save(P);
+   if (accept_keyword(P, KW_ELSE)) {
+      if (parse_statement(P))
+         return GL_TRUE;
+      if (P->error)
+         return GL_FALSE;
+      restore(P, e);
+   }
+   emit(P, OP_EXPRESSION);
+   emit(P, OP_PUSH_VOID);
+   emit(P, OP_END);
+   return GL_TRUE;
+}
+
+
+/**
+ * The condition of a while or for loop: an expression or a declaration
+ * with an initializer.  The latter is emitted like a declaration.
+ */
+static GLboolean
+parse_condition(parse_ctx *P)
+{
+   parse_state s = save(P);
+
+   emit(P, OP_DECLARE);
+   emit(P, DECLARATION_INIT_DECLARATOR_LIST);
+   if (parse_fully_specified_type(P) && peek(P)->type == TOKEN_IDENTIFIER) {
+      emit(P, VARIABLE_IDENTIFIER);
+      parse_identifier(P);
+      if (accept(P, TOKEN_EQ)) {
+         emit(P, VARIABLE_INITIALIZER);
+         if (parse_initializer(P)) {
+            emit(P, DECLARATOR_NONE);
+            return GL_TRUE;
+         }
+      }
+   }
+   if (P->error)
+      return GL_FALSE;
+   restore(P, s);
+
+   emit(P, OP_EXPRESSION);
+   if (!parse_expression(P))
+      return restore(P, s);
+   emit(P, OP_END);
+   return GL_TRUE;
+}
+
+
+static GLboolean
+parse_for_init_statement(parse_ctx *P)
+{
+   parse_state s = save(P);
+
+   emit(P, OP_EXPRESSION);
+   if (parse_expression_statement(P))
+      return GL_TRUE;
+   if (P->error)
+      return GL_FALSE;
+   restore(P, s);
+
+   emit(P, OP_DECLARE);
+   if (parse_declaration(P))
+      return GL_TRUE;
+   return restore(P, s);
+}
+
+
+/**
+ * "condition ; expression".  A missing condition is emitted as "true".
+ */
+static GLboolean
+parse_for_rest_statement(parse_ctx *P)
+{
+   parse_state s = save(P);
+
+   if (!parse_condition(P)) {
+      if (P->error)
+         return GL_FALSE;
+      emit(P, OP_EXPRESSION);
+      emit(P, OP_PUSH_BOOL);
+      emit(P, 2);
+      emit(P, '1');
+      emit(P, '\0');
+      emit(P, OP_END);
+   }
+   if (!accept(P, TOKEN_SEMICOLON))
+      return restore(P, s);
+
+   if (!parse_expression(P)) {
+      if (P->error)
+         return GL_FALSE;
+      emit(P, OP_PUSH_VOID);
+   }
+   emit(P, OP_END);
+   return GL_TRUE;
+}
+
+
+static GLboolean
+parse_iteration_statement(parse_ctx *P)
+{
+   parse_state s = save(P);
+
+   switch (peek(P)->keyword) {
+   case KW_WHILE:
+      P->pos++;
+      emit(P, OP_WHILE);
+      if (!expect(P, TOKEN_LPAREN, ERR_LPAREN_EXPECTED))
+         return GL_FALSE;
+      if (!parse_condition(P))
+         return restore(P, s);
+      if (!expect(P, TOKEN_RPAREN, ERR_RPAREN_EXPECTED))
+         return GL_FALSE;
+      if (!parse_statement(P))
+         return restore(P, s);
+      return GL_TRUE;
+   case KW_DO:
+      if (peek_next(P)->type != TOKEN_LBRACE && !space_follows(P))
+         return GL_FALSE;
+      P->pos++;
+      emit(P, OP_DO);
+      if (!parse_statement(P) || !accept_keyword(P, KW_WHILE))
+         return restore(P, s);
+      if (!expect(P, TOKEN_LPAREN, ERR_LPAREN_EXPECTED))
+         return GL_FALSE;
+      if (!parse_expression(P))
+         return restore(P, s);
+      if (!expect(P, TOKEN_RPAREN, ERR_RPAREN_EXPECTED))
+         return GL_FALSE;
+      emit(P, OP_END);
+      if (!accept(P, TOKEN_SEMICOLON))
+         return restore(P, s);
+      return GL_TRUE;
+   case KW_FOR:
+      P->pos++;
+      emit(P, OP_FOR);
+      if (!expect(P, TOKEN_LPAREN, ERR_LPAREN_EXPECTED))
+         return GL_FALSE;
+      if (!parse_for_init_statement(P) || !parse_for_rest_statement(P))
+         return restore(P, s);
+      if (!expect(P, TOKEN_RPAREN, ERR_RPAREN_EXPECTED))
+         return GL_FALSE;
+      if (!parse_statement(P))
+         return restore(P, s);
+      return GL_TRUE;
+   default:
+      return GL_FALSE;
+   }
+}
+
+
+static GLboolean
+parse_jump_statement(parse_ctx *P)
+{
+   parse_state s = save(P);
+   GLubyte op;
+
+   switch (peek(P)->keyword) {
+   case KW_CONTINUE:
+      op = OP_CONTINUE;
+      break;
+   case KW_BREAK:
+      op = OP_BREAK;
+      break;
+   case KW_DISCARD:
+      if (P->vertex)
+         return GL_FALSE;
+      op = OP_DISCARD;
+      break;
+   case KW_RETURN:
+      P->pos++;
+      emit(P, OP_RETURN);
+      if (!accept(P, TOKEN_SEMICOLON)) {
+         if (!parse_expression(P) || !accept(P, TOKEN_SEMICOLON))
+            return restore(P, s);
+      }
+      else {
+         emit(P, OP_PUSH_VOID);
+      }
+      emit(P, OP_END);
+      return GL_TRUE;
+   default:
+      return GL_FALSE;
+   }
+
+   P->pos++;
+   if (!accept(P, TOKEN_SEMICOLON))
+      return restore(P, s);
+   emit(P, op);
+   return GL_TRUE;
+}
+
+
+/**
+ * "precision <precision> <type> ;" without its leading code, which
+ * differs between global and local scope.
+ */
+static GLboolean
+parse_precision_stmt(parse_ctx *P)
+{
+   parse_state s = save(P);
+   const struct token *tok;
+
+   if (peek(P)->keyword != KW_PRECISION || !space_follows(P))
+      return GL_FALSE;
+   P->pos++;
+   if (peek(P)->keyword != KW_PRECISION_QUALIFIER)
+      return error(P, ERR_PRECISION);
+   if (!space_follows(P))
+      return restore(P, s);
+   parse_precision(P);
+
+   tok = peek(P);
+   if (tok->keyword != KW_TYPE ||
+       !(tok->code == TYPE_SPECIFIER_INT ||
+         tok->code == TYPE_SPECIFIER_FLOAT ||
+         (tok->code >= TYPE_SPECIFIER_SAMPLER1D &&
+          tok->code <= TYPE_SPECIFIER_SAMPLER2DRECTSHADOW)))
+      return error(P, ERR_PRECISION_TYPE);
+   emit(P, tok->code);
+   P->pos++;
+
+   if (!accept(P, TOKEN_SEMICOLON))
+      return restore(P, s);
+   return GL_TRUE;
+}
+
+
+static GLboolean
+parse_asm_argument(parse_ctx *P)
+{
+   const struct token *tok = peek(P);
+
+   if (tok->type == TOKEN_FLOAT) {
+      emit(P, OP_PUSH_FLOAT);
+      emit_float(P, tok);
+      P->pos++;
+      return GL_TRUE;
+   }
+   if (tok->type != TOKEN_IDENTIFIER)
+      return GL_FALSE;
+
+   emit(P, OP_PUSH_IDENTIFIER);
+   parse_identifier(P);
+   if (peek(P)->type == TOKEN_DOT &&
+       peek_next(P)->type == TOKEN_IDENTIFIER) {
+      P->pos++;
+      emit(P, OP_FIELD);
+      parse_identifier(P);
+   }
+   return GL_TRUE;
+}
+
+
+/**
+ * "__asm instruction arg, arg, ... ;", built-in library only.
+ */
+static GLboolean
+parse_asm_statement(parse_ctx *P)
+{
+   parse_state s = save(P);
+
+   if (!accept_keyword(P, KW_ASM) || !parse_identifier(P) ||
+       !parse_asm_argument(P))
+      return restore(P, s);
+   emit(P, OP_END);
+
+   for (;;) {
+      parse_state a = save(P);
+
+      if (!accept(P, TOKEN_COMMA) || !parse_asm_argument(P)) {
+         restore(P, a);
+         break;
+      }
+      emit(P, OP_END);
+   }
+
+   if (!accept(P, TOKEN_SEMICOLON))
+      return restore(P, s);
+   emit(P, OP_END);
+   return GL_TRUE;
+}
+
+
+static GLboolean
+parse_simple_statement(parse_ctx *P)
+{
+   parse_state s = save(P);
+
+   if (P->builtin && peek(P)->keyword == KW_ASM) {
+      emit(P, OP_ASM);
+      if (parse_asm_statement(P))
+         return GL_TRUE;
+      restore(P, s);
+   }
+
+   if (parse_selection_statement(P) || parse_iteration_statement(P))
+      return GL_TRUE;
+   if (P->error)
+      return GL_FALSE;
+
+   emit(P, OP_PRECISION);
+   if (parse_precision_stmt(P))
+      return GL_TRUE;
+   if (P->error)
+      return GL_FALSE;
+   restore(P, s);
+
+   if (parse_jump_statement(P))
+      return GL_TRUE;
+
+   emit(P, OP_EXPRESSION);
+   if (parse_expression_statement(P))
+      return GL_TRUE;
+   if (P->error)
+      return GL_FALSE;
+   restore(P, s);
+
+   emit(P, OP_DECLARE);
+   if (parse_declaration(P))
+      return GL_TRUE;
+   return restore(P, s);
+}
+
+
+static GLboolean
+parse_statement(parse_ctx *P)
+{
+   if (peek(P)->type == TOKEN_LBRACE)
+      return parse_compound_statement(P, OP_BLOCK_BEGIN_NEW_SCOPE);
+   return parse_simple_statement(P);
+}
+
+
+/**
+ * Translation unit
+ */
+
+static GLboolean
+parse_external_declaration(parse_ctx *P)
+{
+   parse_state s = save(P);
+   const struct token *tok = peek(P);
+
+   emit(P, DEFAULT_PRECISION);
+   if (parse_precision_stmt(P))
+      return GL_TRUE;
+   if (P->error)
+      return GL_FALSE;
+   restore(P, s);
+
+   emit(P, EXTERNAL_FUNCTION_DEFINITION);
+   if (parse_function_prototype(P) &&
+       parse_compound_statement(P, OP_BLOCK_BEGIN_NO_NEW_SCOPE))
+      return GL_TRUE;
+   if (P->error)
+      return GL_FALSE;
+   restore(P, s);
+
+   if (tok->keyword == KW_INVARIANT &&
+       peek_next(P)->type == TOKEN_IDENTIFIER) {
+      P->pos++;
+      emit(P, INVARIANT_STMT);
+      parse_identifier(P);
+      if (accept(P, TOKEN_SEMICOLON))
+         return GL_TRUE;
+      restore(P, s);
+   }
+
+   emit(P, EXTERNAL_DECLARATION);
+   if (parse_declaration(P))
+      return GL_TRUE;
+   return restore(P, s);
+}
+
+
+static GLboolean
+parse_translation_unit(parse_ctx *P)
+{
+   emit(P, REVISION);
+   if (!parse_external_declaration(P))
+      return error(P, ERR_SYNTAX);
+   while (parse_external_declaration(P))
+      ;
+   if (P->error)
+      return GL_FALSE;
+   if (peek(P)->type != TOKEN_END)
+      return error(P, ERR_SYNTAX);
+   emit(P, EXTERNAL_NULL);
+   return !P->error;
+}
+
+
+/**
+ * Parse preprocessed GLSL source.
+ * \param type  the shader type, which decides whether "attribute" and
+ *              "discard" are allowed
+ * \param builtin  accept the extensions used by the built-in library
+ *                 (__asm, __operator, __constructor, __fixed_input and
+ *                 __fixed_output)
+ * \return the encoded translation unit, to be freed with _mesa_free(),
+ *         or NULL after writing the error to the log
+ */
+GLubyte *
+_slang_parse_source(const char *source, slang_unit_type type,
+                    GLboolean builtin, slang_info_log *infolog)
+{
+   struct token *tokens;
+   parse_ctx P;
+
+   if (!tokenize(source, &tokens)) {
+      slang_info_log_memory(infolog);
+      return NULL;
+   }
+
+   P.tokens = tokens;
+   P.pos = 0;
+   P.size = 0;
+   P.capacity = 1024;
+   P.out = (GLubyte *) _mesa_malloc(P.capacity);
+   P.builtin = builtin;
+   P.vertex = (type == SLANG_UNIT_VERTEX_SHADER ||
+               type == SLANG_UNIT_VERTEX_BUILTIN);
+   P.error = NULL;
+   P.errorToken = NULL;
+
+   if (!P.out || !parse_translation_unit(&P)) {
+      const struct token *tok = P.errorToken;
+
+      if (!P.out || !tok) {
+         slang_info_log_memory(infolog);
+      }
+      else if (tok->type == TOKEN_END) {
+         slang_info_log_error(infolog, P.error, 3, "???");
+      }
+      else {
+         slang_info_log_error(infolog, P.error,
+                              (int) MIN2(tok->length, 64), tok->text);
+      }
+      if (P.out)
+         _mesa_free(P.out);
+      P.out = NULL;
+   }
+
+   _mesa_free(tokens);
+   return P.out;
+}
@@ -141,6 +141,7 @@ slang_atom_pool_construct(slang_atom_pool * pool)
 
    for (i = 0; i < SLANG_ATOM_POOL_SIZE; i++)
       pool->entries[i] = NULL;
+   pool->parent = NULL;
 }
 
 void
@@ -162,7 +163,7 @@ slang_atom_pool_destruct (slang_atom_pool * pool)
 }
 
 /*
- * Search the atom pool for an atom with a given name.
+ * Search the atom pool (and its parent) for an atom with a given name.
  * If atom is not found, create and add it to the pool.
  * Returns ATOM_NULL if the atom was not found and the function failed
  * to create a new atom.
@@ -187,6 +188,18 @@ slang_atom_pool_atom(slang_atom_pool * pool, const char * id)
    }
    hash %= SLANG_ATOM_POOL_SIZE;
 
+   /* Atoms of the parent pool take precedence so that the same name
+    * always maps to the same atom.  The parent is never modified.
+    */
+   if (pool->parent != NULL) {
+      const slang_atom_entry *e = pool->parent->entries[hash];
+      while (e != NULL) {
+         if (slang_string_compare(e->id, id) == 0)
+            return (slang_atom) e->id;
+         e = e->next;
+      }
+   }
+
    /* Now the hash points to a linked list of atoms with names that
     * have the same hash value.  Search the linked list for a given
     * name.
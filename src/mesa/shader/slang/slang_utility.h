@@ -89,6 +89,8 @@ typedef struct slang_atom_entry_
 typedef struct slang_atom_pool_
 {
 	slang_atom_entry *entries[SLANG_ATOM_POOL_SIZE];
+	/** Read-only pool searched before this one, or NULL */
+	const struct slang_atom_pool_ *parent;
 } slang_atom_pool;
 
 GLvoid slang_atom_pool_construct (slang_atom_pool *);
@@ -311,14 +311,10 @@ _swrast_update_fragment_program(GLcontext *ctx, GLbitfield newState)
 
 
 /**
- * Stub for swrast->Triangle to select a true triangle function
- * after a state change.
+ * Examine current GL state and choose a software triangle routine.
  */
 static void
-_swrast_validate_triangle( GLcontext *ctx,
-			   const SWvertex *v0,
-                           const SWvertex *v1,
-                           const SWvertex *v2 )
+_swrast_update_triangle_func( GLcontext *ctx )
 {
    SWcontext *swrast = SWRAST_CONTEXT(ctx);
 
@@ -333,8 +329,20 @@ _swrast_validate_triangle( GLcontext *ctx,
       swrast->SpecTriangle = swrast->Triangle;
       swrast->Triangle = _swrast_add_spec_terms_triangle;
    }
+}
 
-   swrast->Triangle( ctx, v0, v1, v2 );
+/**
+ * Stub for swrast->Triangle to select a true triangle function
+ * after a state change.
+ */
+static void
+_swrast_validate_triangle( GLcontext *ctx,
+			   const SWvertex *v0,
+                           const SWvertex *v1,
+                           const SWvertex *v2 )
+{
+   _swrast_update_triangle_func( ctx );
+   SWRAST_CONTEXT(ctx)->Triangle( ctx, v0, v1, v2 );
 }
 
 /**
@@ -692,6 +700,66 @@ _swrast_Triangle( GLcontext *ctx, const SWvertex *v0,
    SWRAST_CONTEXT(ctx)->Triangle( ctx, v0, v1, v2 );
 }
 
+/**
+ * Render a batch of independent triangles, three elements per triangle.
+ * The triangle function is validated once for the whole batch, and
+ * when culling is enabled the triangles which the span rasterizers
+ * would reject are discarded here, before any setup is done.
+ */
+void
+_swrast_Triangles( GLcontext *ctx, const SWvertex *verts,
+                   const GLuint *elts, GLuint count )
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   swrast_tri_func tri;
+   GLfloat cullSign = 0.0F;
+   GLuint i;
+
+   if (swrast->Triangle == _swrast_validate_triangle)
+      _swrast_update_triangle_func( ctx );
+
+   tri = swrast->Triangle;
+
+   /* The antialiased and feedback/select triangle functions do their
+    * own facing determination, so only pre-cull for the span
+    * rasterizers built from s_tritemp.h.
+    */
+   if (ctx->RenderMode == GL_RENDER && !ctx->Polygon.SmoothFlag)
+      cullSign = swrast->_BackfaceSign * swrast->_BackfaceCullSign;
+
+   for (i = 0; i + 2 < count; i += 3) {
+      const SWvertex *v0 = verts + elts[i];
+      const SWvertex *v1 = verts + elts[i + 1];
+      const SWvertex *v2 = verts + elts[i + 2];
+
+      if (SWRAST_DEBUG) {
+         _mesa_debug(ctx, "_swrast_Triangles\n");
+         _swrast_print_vertex( ctx, v0 );
+         _swrast_print_vertex( ctx, v1 );
+         _swrast_print_vertex( ctx, v2 );
+      }
+
+      if (cullSign != 0.0F) {
+         /* Use the same snapped coordinates as s_tritemp.h so that the
+          * facing agrees with the rasterizer.
+          */
+         const GLint snapMask = ~((FIXED_ONE / (1 << SUB_PIXEL_BITS)) - 1);
+         const GLfixed x0 = FloatToFixed(v0->attrib[FRAG_ATTRIB_WPOS][0] + 0.5F) & snapMask;
+         const GLfixed x1 = FloatToFixed(v1->attrib[FRAG_ATTRIB_WPOS][0] + 0.5F) & snapMask;
+         const GLfixed x2 = FloatToFixed(v2->attrib[FRAG_ATTRIB_WPOS][0] + 0.5F) & snapMask;
+         const GLfixed y0 = FloatToFixed(v0->attrib[FRAG_ATTRIB_WPOS][1] - 0.5F) & snapMask;
+         const GLfixed y1 = FloatToFixed(v1->attrib[FRAG_ATTRIB_WPOS][1] - 0.5F) & snapMask;
+         const GLfixed y2 = FloatToFixed(v2->attrib[FRAG_ATTRIB_WPOS][1] - 0.5F) & snapMask;
+         const GLdouble area = (GLdouble) (x1 - x0) * (GLdouble) (y2 - y0)
+                             - (GLdouble) (x2 - x0) * (GLdouble) (y1 - y0);
+         if (area * cullSign > 0.0)
+            continue;
+      }
+
+      tri( ctx, v0, v1, v2 );
+   }
+}
+
 void
 _swrast_Line( GLcontext *ctx, const SWvertex *v0, const SWvertex *v1 )
 {
@@ -843,6 +911,8 @@ _swrast_DestroyContext( GLcontext *ctx )
    if (swrast->ZoomedArrays)
       FREE( swrast->ZoomedArrays );
    FREE( swrast->TexelBuffer );
+   if (swrast->ProgTexels)
+      FREE( swrast->ProgTexels );
    FREE( swrast );
 
    ctx->swrast_context = 0;
@@ -228,6 +228,11 @@ typedef struct
    /** State used during execution of fragment programs */
    struct gl_program_machine FragProgMachine;
 
+   /** Texels fetched ahead for fragment program texture instructions,
+    * allocated on first use.
+    */
+   GLfloat (*ProgTexels)[MAX_WIDTH][4];
+
 } SWcontext;
 
 
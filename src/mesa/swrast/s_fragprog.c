@@ -64,6 +64,33 @@ fetch_texel_lod( GLcontext *ctx, const GLfloat texcoord[4], GLfloat lambda,
 }
 
 
+/**
+ * Compute the level of detail for sampling texObj at texcoord from the
+ * texcoord's partial derivatives.
+ */
+static INLINE GLfloat
+compute_deriv_lambda(const struct gl_texture_object *texObj,
+                     const GLfloat texcoord[4],
+                     const GLfloat texdx[4], const GLfloat texdy[4],
+                     GLfloat lodBias)
+{
+   const struct gl_texture_image *texImg =
+      texObj->Image[0][texObj->BaseLevel];
+   const GLfloat texW = (GLfloat) texImg->WidthScale;
+   const GLfloat texH = (GLfloat) texImg->HeightScale;
+   GLfloat lambda;
+
+   lambda = _swrast_compute_lambda(texdx[0], texdy[0], /* ds/dx, ds/dy */
+                                   texdx[1], texdy[1], /* dt/dx, dt/dy */
+                                   texdx[3], texdy[2], /* dq/dx, dq/dy */
+                                   texW, texH,
+                                   texcoord[0], texcoord[1], texcoord[3],
+                                   1.0F / texcoord[3]) + lodBias;
+
+   return CLAMP(lambda, texObj->MinLod, texObj->MaxLod);
+}
+
+
 /**
  * Fetch a texel with the given partial derivatives to compute a level
  * of detail in the mipmap.
@@ -78,21 +105,10 @@ fetch_texel_deriv( GLcontext *ctx, const GLfloat texcoord[4],
    const struct gl_texture_object *texObj = ctx->Texture.Unit[unit]._Current;
 
    if (texObj) {
-      const struct gl_texture_image *texImg =
-         texObj->Image[0][texObj->BaseLevel];
-      const GLfloat texW = (GLfloat) texImg->WidthScale;
-      const GLfloat texH = (GLfloat) texImg->HeightScale;
       GLfloat lambda;
       GLchan rgba[4];
 
-      lambda = _swrast_compute_lambda(texdx[0], texdy[0], /* ds/dx, ds/dy */
-                                      texdx[1], texdy[1], /* dt/dx, dt/dy */
-                                      texdx[3], texdy[2], /* dq/dx, dq/dy */
-                                      texW, texH,
-                                      texcoord[0], texcoord[1], texcoord[3],
-                                      1.0F / texcoord[3]) + lodBias;
-
-      lambda = CLAMP(lambda, texObj->MinLod, texObj->MaxLod);
+      lambda = compute_deriv_lambda(texObj, texcoord, texdx, texdy, lodBias);
 
       /* XXX use a float-valued TextureSample routine here!!! */
       swrast->TextureSample[unit](ctx, texObj, 1,
@@ -110,6 +126,184 @@ fetch_texel_deriv( GLcontext *ctx, const GLfloat texcoord[4],
 }
 
 
+/**
+ * Can the texels of this instruction be fetched for the whole span ahead
+ * of running the program?  That's the case for TEX, TXB and TXP whose
+ * coordinate is a plain fragment attribute, since it doesn't depend on
+ * anything the program computes.  FOGC is excluded because init_machine()
+ * stores the facing value in it just before each fragment runs.
+ */
+static GLboolean
+can_prefetch_texels(const struct prog_instruction *inst)
+{
+   const struct prog_src_register *source = &inst->SrcReg[0];
+   GLuint i;
+
+   if (inst->Opcode != OPCODE_TEX &&
+       inst->Opcode != OPCODE_TXB &&
+       inst->Opcode != OPCODE_TXP &&
+       inst->Opcode != OPCODE_TXP_NV)
+      return GL_FALSE;
+
+   if (source->File != PROGRAM_INPUT ||
+       source->RelAddr ||
+       source->Index < 0 ||
+       source->Index >= FRAG_ATTRIB_MAX ||
+       source->Index == FRAG_ATTRIB_FOGC ||
+       source->NegateBase || source->Abs || source->NegateAbs)
+      return GL_FALSE;
+
+   for (i = 0; i < 4; i++) {
+      if (GET_SWZ(source->Swizzle, i) > SWIZZLE_W)
+         return GL_FALSE;
+   }
+
+   return GL_TRUE;
+}
+
+
+/**
+ * Sample the texture of a TEX, TXB or TXP instruction for the fragments
+ * start..end-1 with one TextureSample call.  The coordinates, bias and
+ * level of detail are computed per fragment the same way as when the
+ * program fetches the texel itself (see fetch_texel() in prog_execute.c).
+ */
+static void
+fetch_texels_span(GLcontext *ctx, const struct gl_program_machine *machine,
+                  const struct prog_instruction *inst,
+                  GLuint start, GLuint end, GLfloat (*texels)[4])
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   const GLuint unit = machine->Samplers[inst->TexSrcUnit];
+   const struct gl_texture_unit *texUnit = &ctx->Texture.Unit[unit];
+   const struct gl_texture_object *texObj = texUnit->_Current;
+   const struct prog_src_register *source = &inst->SrcReg[0];
+   const GLuint attr = source->Index;
+   const GLboolean useDeriv = machine->NumDeriv > 0 &&
+      attr == FRAG_ATTRIB_TEX0 + inst->TexSrcUnit;
+   const GLuint n = end - start;
+   /* the coordinates are put where their texels go */
+   GLfloat (*texcoords)[4] = texels + start;
+   GLchan (*rgba)[4] = (GLchan (*)[4]) swrast->TexelBuffer;
+   GLfloat lambda[MAX_WIDTH];
+   GLuint i, j;
+
+   if (!texObj) {
+      for (i = start; i < end; i++) {
+         ASSIGN_4V(texels[i], 0.0F, 0.0F, 0.0F, 1.0F);
+      }
+      return;
+   }
+
+   for (i = 0; i < n; i++) {
+      const GLfloat *src = machine->Attribs[attr][start + i];
+      GLfloat *texcoord = texcoords[i];
+      GLfloat lodBias = 0.0F;
+
+      texcoord[0] = src[GET_SWZ(source->Swizzle, 0)];
+      texcoord[1] = src[GET_SWZ(source->Swizzle, 1)];
+      texcoord[2] = src[GET_SWZ(source->Swizzle, 2)];
+      texcoord[3] = src[GET_SWZ(source->Swizzle, 3)];
+
+      if (inst->Opcode == OPCODE_TXB) {
+         /* texcoord[3] is the bias to add to lambda */
+         lodBias = texUnit->LodBias + texcoord[3];
+         lodBias += texObj->LodBias;
+      }
+      else if ((inst->Opcode == OPCODE_TXP ||
+                (inst->Opcode == OPCODE_TXP_NV &&
+                 inst->TexSrcTarget != TEXTURE_CUBE_INDEX)) &&
+               texcoord[3] != 0.0) {
+         const GLfloat invQ = 1.0F / texcoord[3];
+         texcoord[0] *= invQ;
+         texcoord[1] *= invQ;
+         texcoord[2] *= invQ;
+      }
+
+      if (useDeriv)
+         lambda[i] = compute_deriv_lambda(texObj, texcoord,
+                                          machine->DerivX[attr],
+                                          machine->DerivY[attr], lodBias);
+      else
+         lambda[i] = CLAMP(lodBias, texObj->MinLod, texObj->MaxLod);
+   }
+
+   /* The samplers pick the minified and magnified fragments assuming
+    * lambda is monotonic, as it is along a span of interpolated
+    * coordinates but not across a span of points, say.  Sample each
+    * monotonic run on its own.
+    */
+   for (i = 0; i < n; i = j) {
+      j = i + 1;
+      if (j < n) {
+         const GLboolean increasing = lambda[j] >= lambda[i];
+         while (j < n && (increasing ? lambda[j] >= lambda[j - 1]
+                                     : lambda[j] <= lambda[j - 1]))
+            j++;
+      }
+      swrast->TextureSample[unit](ctx, texObj, j - i,
+                                  (const GLfloat (*)[4]) (texcoords + i),
+                                  lambda + i, rgba + i);
+   }
+
+   for (i = 0; i < n; i++) {
+      texels[start + i][0] = CHAN_TO_FLOAT(rgba[i][0]);
+      texels[start + i][1] = CHAN_TO_FLOAT(rgba[i][1]);
+      texels[start + i][2] = CHAN_TO_FLOAT(rgba[i][2]);
+      texels[start + i][3] = CHAN_TO_FLOAT(rgba[i][3]);
+   }
+}
+
+
+/**
+ * Fetch the texels of the program's texture instructions which don't
+ * depend on the program's computations for fragments start..end-1, so
+ * that each of them samples its texture once per span instead of once
+ * per fragment.
+ */
+static void
+prefetch_texels(GLcontext *ctx, struct gl_program_machine *machine,
+                const struct gl_fragment_program *program,
+                const SWspan *span, GLuint start, GLuint end)
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   GLuint pc;
+
+   machine->NumTexPrefetch = 0;
+
+   if (end - start < 2)
+      return;
+
+   machine->Attribs = span->array->attribs;
+   machine->DerivX = (GLfloat (*)[4]) span->attrStepX;
+   machine->DerivY = (GLfloat (*)[4]) span->attrStepY;
+   machine->NumDeriv = FRAG_ATTRIB_MAX;
+   machine->Samplers = program->Base.SamplerUnits;
+
+   for (pc = 0; pc < program->Base.NumInstructions; pc++) {
+      const struct prog_instruction *inst = program->Base.Instructions + pc;
+      const GLuint k = machine->NumTexPrefetch;
+
+      if (k == MAX_PROGRAM_TEX_PREFETCH)
+         break;
+      if (!can_prefetch_texels(inst))
+         continue;
+
+      if (!swrast->ProgTexels) {
+         swrast->ProgTexels = (GLfloat (*)[MAX_WIDTH][4])
+            MALLOC(MAX_PROGRAM_TEX_PREFETCH * MAX_WIDTH * 4 * sizeof(GLfloat));
+         if (!swrast->ProgTexels)
+            return;
+      }
+
+      fetch_texels_span(ctx, machine, inst, start, end, swrast->ProgTexels[k]);
+      machine->TexPrefetchInst[k] = inst;
+      machine->TexPrefetch[k] = swrast->ProgTexels[k];
+      machine->NumTexPrefetch++;
+   }
+}
+
+
 /**
  * Initialize the virtual fragment program machine state prior to running
  * fragment program on a fragment.  This involves initializing the input
@@ -174,6 +368,8 @@ run_program(GLcontext *ctx, SWspan *span, GLuint start, GLuint end)
    struct gl_program_machine *machine = &swrast->FragProgMachine;
    GLuint i;
 
+   prefetch_texels(ctx, machine, program, span, start, end);
+
    for (i = start; i < end; i++) {
       if (span->array->mask[i]) {
          init_machine(ctx, machine, program, span, i);
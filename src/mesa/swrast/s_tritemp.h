@@ -127,6 +127,8 @@ static void NAME(GLcontext *ctx, const SWvertex *v0,
    } EdgeT;
 
    const SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   const GLint fbWidth = ctx->DrawBuffer->Width;
+   const GLint fbHeight = ctx->DrawBuffer->Height;
 #ifdef INTERP_Z
    const GLint depthBits = ctx->DrawBuffer->Visual.depthBits;
    const GLint fixedToDepthShift = depthBits <= 16 ? FIXED_SHIFT : 0;
@@ -802,6 +804,7 @@ static void NAME(GLcontext *ctx, const SWvertex *v0,
 #endif
 
             while (lines > 0) {
+               GLint skip;  /* pixels trimmed from the left of the span */
                /* initialize the span interpolants to the leftmost value */
                /* ff = fixed-pt fragment */
                const GLint right = FixedToInt(fxRightEdge);
@@ -840,13 +843,65 @@ static void NAME(GLcontext *ctx, const SWvertex *v0,
                ATTRIB_LOOP_END
 #endif
 
+               /* Triangles drawn within the tnl guard band may extend
+                * past the window.  Trim the span to the buffer here, so
+                * that spans never exceed MAX_WIDTH and the direct-access
+                * RENDER_SPAN variants stay inside the buffer.
+                */
+               skip = 0;
+               if (span.x < 0) {
+                  skip = -span.x;
+                  span.x = 0;
+                  span.end = ((GLint) span.end > skip) ? span.end - skip : 0;
+               }
+               if (span.x + (GLint) span.end > fbWidth)
+                  span.end = (span.x < fbWidth) ? fbWidth - span.x : 0;
+
                /* This is where we actually generate fragments */
                /* XXX the test for span.y > 0 _shouldn't_ be needed but
                 * it fixes a problem on 64-bit Opterons (bug 4842).
                 */
-               if (span.end > 0 && span.y >= 0) {
+               if (span.end > 0 && span.y >= 0 && span.y < fbHeight) {
                   const GLint len = span.end - 1;
                   (void) len;
+                  if (skip) {
+                     /* advance the interpolants to the window edge */
+#ifdef PIXEL_ADDRESS
+                     pRow += skip;
+#endif
+#ifdef INTERP_Z
+#  ifdef DEPTH_TYPE
+                     zRow += skip;
+#  endif
+                     span.z += skip * span.zStep;
+#endif
+#ifdef INTERP_RGB
+                     span.red += skip * span.redStep;
+                     span.green += skip * span.greenStep;
+                     span.blue += skip * span.blueStep;
+#endif
+#ifdef INTERP_ALPHA
+                     span.alpha += skip * span.alphaStep;
+#endif
+#ifdef INTERP_INDEX
+                     span.index += skip * span.indexStep;
+#endif
+#ifdef INTERP_INT_TEX
+                     span.intTex[0] += skip * span.intTexStep[0];
+                     span.intTex[1] += skip * span.intTexStep[1];
+#endif
+#ifdef INTERP_ATTRIBS
+                     span.attrStart[FRAG_ATTRIB_WPOS][3]
+                        += skip * span.attrStepX[FRAG_ATTRIB_WPOS][3];
+                     ATTRIB_LOOP_BEGIN
+                        GLuint c;
+                        for (c = 0; c < 4; c++) {
+                           span.attrStart[attr][c]
+                              += skip * span.attrStepX[attr][c];
+                        }
+                     ATTRIB_LOOP_END
+#endif
+                  }
 #ifdef INTERP_RGB
                   CLAMP_INTERPOLANT(red, redStep, len);
                   CLAMP_INTERPOLANT(green, greenStep, len);
@@ -861,6 +916,12 @@ static void NAME(GLcontext *ctx, const SWvertex *v0,
                   {
                      RENDER_SPAN( span );
                   }
+#ifdef PIXEL_ADDRESS
+                  pRow -= skip;
+#endif
+#ifdef DEPTH_TYPE
+                  zRow -= skip;
+#endif
                }
 
                /*
@@ -78,6 +78,15 @@ typedef struct {
 #define FRAG_ATTRIB_CI FRAG_ATTRIB_COL0
 
 
+/**
+ * The triangle rasterizer trims spans to the window, so full software
+ * drivers may let tnl skip X/Y clipping of triangles lying within this
+ * many pixels of the viewport center (see _tnl_allow_guard_band()).
+ * This keeps window coordinates well inside the GLfixed range.
+ */
+#define SWRAST_GUARD_BAND 8192.0F
+
+
 struct swrast_device_driver;
 
 
@@ -170,6 +179,14 @@ _swrast_Quad( GLcontext *ctx,
               const SWvertex *v0, const SWvertex *v1,
 	      const SWvertex *v2,  const SWvertex *v3);
 
+/**
+ * Render a batch of independent triangles.  'elts' holds 'count'
+ * indices into 'verts', three per triangle.
+ */
+extern void
+_swrast_Triangles( GLcontext *ctx, const SWvertex *verts,
+                   const GLuint *elts, GLuint count );
+
 extern void
 _swrast_flush( GLcontext *ctx );
 
@@ -31,6 +31,7 @@
 #include "main/mtypes.h"
 
 #include "tnl/t_context.h"
+#include "tnl/t_pipeline.h"
 
 #include "ss_triangle.h"
 #include "ss_context.h"
@@ -283,6 +284,60 @@ static void swsetup_line( GLcontext *ctx, GLuint v0, GLuint v1 )
 }
 
 
+/* Render tabs for the plain filled case.  Rather than calling
+ * Render.Triangle once per primitive, triangles are collected into an
+ * element list and handed to swrast in batches of SS_TRI_BATCH.
+ */
+#define SS_TRI_BATCH 64
+
+#define RENDER_POINTS( start, count ) \
+   tnl->Driver.Render.Points( ctx, start, count )
+
+#define RENDER_LINE( v1, v2 ) \
+   LineFunc( ctx, v1, v2 )
+
+#define RENDER_TRI( v1, v2, v3 )				\
+do {								\
+   tris[nr++] = v1;						\
+   tris[nr++] = v2;						\
+   tris[nr++] = v3;						\
+   if (nr == SS_TRI_BATCH * 3) {				\
+      _swrast_Triangles( ctx, verts, tris, nr );		\
+      nr = 0;							\
+   }								\
+} while (0)
+
+#define RENDER_QUAD( v1, v2, v3, v4 )	\
+do {					\
+   RENDER_TRI( v1, v2, v4 );		\
+   RENDER_TRI( v2, v3, v4 );		\
+} while (0)
+
+#define LOCAL_VARS						\
+   TNLcontext *tnl = TNL_CONTEXT(ctx);				\
+   struct vertex_buffer *VB = &tnl->vb;				\
+   const GLuint * const elt = VB->Elts;				\
+   const SWvertex *verts = SWSETUP_CONTEXT(ctx)->verts;		\
+   const tnl_line_func LineFunc = tnl->Driver.Render.Line;	\
+   const GLboolean stipple = ctx->Line.StippleFlag;		\
+   GLuint tris[SS_TRI_BATCH * 3];				\
+   GLuint nr = 0;						\
+   (void) elt; (void) verts; (void) LineFunc; (void) stipple;	\
+   (void) tris
+
+#define RESET_STIPPLE if (stipple) tnl->Driver.Render.ResetLineStipple( ctx )
+#define INIT(x) tnl->Driver.Render.PrimitiveNotify( ctx, x )
+#define POSTFIX if (nr) _swrast_Triangles( ctx, verts, tris, nr )
+#define TAG(x) swsetup_##x##_verts
+#define PRESERVE_VB_DEFS
+#include "tnl/t_vb_rendertmp.h"
+
+#undef ELT
+#define TAG(x) swsetup_##x##_elts
+#define ELT(x) elt[x]
+#include "tnl/t_vb_rendertmp.h"
+
+
 
 void _swsetup_choose_trifuncs( GLcontext *ctx )
 {
@@ -313,4 +368,16 @@ void _swsetup_choose_trifuncs( GLcontext *ctx )
    tnl->Driver.Render.Quad = quad_tab[ind];
    tnl->Driver.Render.Line = swsetup_line;
    tnl->Driver.Render.Points = swsetup_points;
+
+   /* Offset, twoside and unfilled triangles need per-triangle setup,
+    * everything else can be batched.
+    */
+   if (ind & (SS_OFFSET_BIT | SS_TWOSIDE_BIT | SS_UNFILLED_BIT)) {
+      tnl->Driver.Render.PrimTabVerts = _tnl_render_tab_verts;
+      tnl->Driver.Render.PrimTabElts = _tnl_render_tab_elts;
+   }
+   else {
+      tnl->Driver.Render.PrimTabVerts = swsetup_render_tab_verts;
+      tnl->Driver.Render.PrimTabElts = swsetup_render_tab_elts;
+   }
 }
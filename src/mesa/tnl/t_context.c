@@ -69,6 +69,8 @@ _tnl_CreateContext( GLcontext *ctx )
    tnl->NeedNdcCoords = GL_TRUE;
    tnl->AllowVertexFog = GL_TRUE;
    tnl->AllowPixelFog = GL_TRUE;
+   tnl->GuardBandSize = 0.0F;
+   tnl->_GuardBand[0] = tnl->_GuardBand[1] = 1.0F;
 
    /* Set a few default values in the driver struct.
     */
@@ -89,11 +91,64 @@ _tnl_DestroyContext( GLcontext *ctx )
 
    _tnl_destroy_pipeline( ctx );
 
+   if (tnl->space)
+      _mesa_align_free(tnl->space);
+
    FREE(tnl);
    ctx->swtnl_context = NULL;
 }
 
 
+/**
+ * Does the viewport cover the whole draw buffer?  The rasterizer only
+ * trims guard-band spans to the buffer, so geometry outside a smaller
+ * viewport would otherwise be drawn.
+ */
+static GLboolean
+viewport_covers_buffer( const GLcontext *ctx )
+{
+   const struct gl_framebuffer *fb = ctx->DrawBuffer;
+
+   return (fb &&
+           ctx->Viewport.X <= 0 &&
+           ctx->Viewport.Y <= 0 &&
+           ctx->Viewport.X + ctx->Viewport.Width >= (GLint) fb->Width &&
+           ctx->Viewport.Y + ctx->Viewport.Height >= (GLint) fb->Height);
+}
+
+
+/**
+ * Compute the clip-space guard band from the viewport.  The guard band is
+ * only usable when triangles are rasterized as filled spans; unfilled and
+ * antialiased polygons, feedback and selection need exact clipping.
+ */
+static void
+update_guard_band( GLcontext *ctx )
+{
+   TNLcontext *tnl = TNL_CONTEXT(ctx);
+   const GLfloat *m = ctx->Viewport._WindowMap.m;
+   const GLfloat sx = FABSF(m[MAT_SX]);
+   const GLfloat sy = FABSF(m[MAT_SY]);
+
+   tnl->_DoGuardBand = (tnl->GuardBandSize > 0.0F &&
+                        tnl->NeedNdcCoords &&
+                        ctx->RenderMode == GL_RENDER &&
+                        ctx->Polygon.FrontMode == GL_FILL &&
+                        ctx->Polygon.BackMode == GL_FILL &&
+                        !ctx->Polygon.SmoothFlag &&
+                        sx > 0.0F && sy > 0.0F &&
+                        viewport_covers_buffer( ctx ));
+
+   if (tnl->_DoGuardBand) {
+      tnl->_GuardBand[0] = MAX2(1.0F, tnl->GuardBandSize / sx);
+      tnl->_GuardBand[1] = MAX2(1.0F, tnl->GuardBandSize / sy);
+   }
+   else {
+      tnl->_GuardBand[0] = tnl->_GuardBand[1] = 1.0F;
+   }
+}
+
+
 void
 _tnl_InvalidateState( GLcontext *ctx, GLuint new_state )
 {
@@ -107,6 +162,10 @@ _tnl_InvalidateState( GLcontext *ctx, GLuint new_state )
          || !tnl->AllowPixelFog) && !fp;
    }
 
+   if (new_state & (_NEW_VIEWPORT | _NEW_BUFFERS | _NEW_POLYGON |
+                    _NEW_RENDERMODE))
+      update_guard_band( ctx );
+
    tnl->pipeline.new_state |= new_state;
 
    /* Calculate tnl->render_inputs.  This bitmask indicates which vertex
@@ -203,6 +262,7 @@ _tnl_need_projected_coords( GLcontext *ctx, GLboolean mode )
 {
    TNLcontext *tnl = TNL_CONTEXT(ctx);
    tnl->NeedNdcCoords = mode;
+   update_guard_band( ctx );
 }
 
 void
@@ -224,3 +284,17 @@ _tnl_allow_pixel_fog( GLcontext *ctx, GLboolean value )
       || !tnl->AllowPixelFog) && !ctx->FragmentProgram._Current;
 }
 
+/**
+ * Drivers whose rasterizer can scissor triangles extending past the
+ * viewport call this to avoid clipping them against the X/Y frustum
+ * planes.  'size' is the largest distance, in window pixels, from the
+ * viewport center that the rasterizer can handle; 0 disables the guard
+ * band.  Near/far and user clip planes are always clipped exactly.
+ */
+void
+_tnl_allow_guard_band( GLcontext *ctx, GLfloat size )
+{
+   TNLcontext *tnl = TNL_CONTEXT(ctx);
+   tnl->GuardBandSize = size;
+   update_guard_band( ctx );
+}
@@ -527,12 +527,24 @@ typedef struct
    GLboolean AllowPixelFog;
    GLboolean _DoVertexFog;  /* eval fog function at each vertex? */
 
+   /* Guard band: triangles which only cross the X/Y frustum planes and
+    * stay within the band are passed to the rasterizer unclipped.
+    */
+   GLfloat GuardBandSize;   /* half-extent in window pixels, 0 = disabled */
+   GLboolean _DoGuardBand;
+   GLfloat _GuardBand[2];   /* clip-space x/y extent, as multiples of w */
+
    DECLARE_RENDERINPUTS(render_inputs_bitset);
 
    GLvector4f tmp_inputs[VERT_ATTRIB_MAX];
 
-   /* Temp storage for t_draw.c: 
+   /* Temp storage for t_draw.c.  Kept between draws and only grown
+    * when a draw needed more than it holds:
     */
+   GLubyte *space;
+   GLuint space_size;
+   GLuint space_used;
+   GLuint space_wanted;
    GLubyte *block[VERT_ATTRIB_MAX];
    GLuint nr_blocks;
 
@@ -543,6 +555,19 @@ typedef struct
 #define TNL_CONTEXT(ctx) ((TNLcontext *)((ctx)->swtnl_context))
 
 
+/* Frustum planes which may be left to the rasterizer's guard band.
+ */
+#define CLIP_GUARD_BAND_BITS (CLIP_RIGHT_BIT | CLIP_LEFT_BIT | \
+                              CLIP_TOP_BIT | CLIP_BOTTOM_BIT)
+
+/* Test a clip-space position against the guard band.
+ */
+#define TNL_INSIDE_GUARD_BAND(tnl, c)				\
+   ((c)[3] > 0.0F &&						\
+    FABSF((c)[0]) <= (tnl)->_GuardBand[0] * (c)[3] &&		\
+    FABSF((c)[1]) <= (tnl)->_GuardBand[1] * (c)[3])
+
+
 #define TYPE_IDX(t) ((t) & 0xf)
 #define MAX_TYPES TYPE_IDX(GL_DOUBLE)+1      /* 0xa + 1 */
 
@@ -44,9 +44,20 @@
 static GLubyte *get_space(GLcontext *ctx, GLuint bytes)
 {
    TNLcontext *tnl = TNL_CONTEXT(ctx);
-   GLubyte *space = _mesa_malloc(bytes);
-   
-   tnl->block[tnl->nr_blocks++] = space;
+   GLubyte *space;
+
+   bytes = (bytes + 15) & ~15;
+   tnl->space_wanted += bytes;
+
+   if (tnl->space_used + bytes <= tnl->space_size) {
+      space = tnl->space + tnl->space_used;
+      tnl->space_used += bytes;
+   }
+   else {
+      space = _mesa_malloc(bytes);
+      tnl->block[tnl->nr_blocks++] = space;
+   }
+
    return space;
 }
 
@@ -57,35 +68,105 @@ static void free_space(GLcontext *ctx)
    GLuint i;
    for (i = 0; i < tnl->nr_blocks; i++)
       _mesa_free(tnl->block[i]);
+
+   /* Grow the persistent space to fit the whole of this draw next time.
+    */
+   if (tnl->nr_blocks) {
+      if (tnl->space)
+	 _mesa_align_free(tnl->space);
+      tnl->space = _mesa_align_malloc(tnl->space_wanted, 16);
+      tnl->space_size = tnl->space ? tnl->space_wanted : 0;
+   }
+
    tnl->nr_blocks = 0;
+   tnl->space_used = 0;
+   tnl->space_wanted = 0;
 }
 
 
-/* Convert the incoming array to GLfloats.  Understands the
- * array->Normalized flag and selects the correct conversion method.
+/* Convert the incoming array to GLfloats.  One function per type, size
+ * and normalization so the inner loops have constant trip counts.
+ * Tightly packed arrays are converted as one flat run of components,
+ * which the compiler can unroll and vectorize.
  */
-#define CONVERT( TYPE, MACRO ) do {		\
-   GLuint i, j;					\
-   if (input->Normalized) {			\
-      for (i = 0; i < count; i++) {		\
-	 const TYPE *in = (TYPE *)ptr;		\
-	 for (j = 0; j < sz; j++) {		\
-	    *fptr++ = MACRO(*in);		\
-	    in++;				\
-	 }					\
-	 ptr += input->StrideB;			\
-      }						\
-   } else {					\
-      for (i = 0; i < count; i++) {		\
-	 const TYPE *in = (TYPE *)ptr;		\
-	 for (j = 0; j < sz; j++) {		\
-	    *fptr++ = (GLfloat)(*in);		\
-	    in++;				\
-	 }					\
-	 ptr += input->StrideB;			\
-      }						\
-   }						\
-} while (0)
+#define CONVERT_FUNC( NAME, TYPE, SZ, MACRO )				\
+static void NAME( GLfloat *fptr, const GLubyte *ptr,			\
+		  GLuint stride, GLuint count )				\
+{									\
+   GLuint i, j;								\
+   if (stride == SZ * sizeof(TYPE)) {					\
+      const TYPE *in = (const TYPE *)ptr;				\
+      for (i = 0; i < count * SZ; i++)					\
+	 fptr[i] = MACRO(in[i]);					\
+   }									\
+   else {								\
+      for (i = 0; i < count; i++) {					\
+	 const TYPE *in = (const TYPE *)ptr;				\
+	 for (j = 0; j < SZ; j++)					\
+	    fptr[j] = MACRO(in[j]);					\
+	 fptr += SZ;							\
+	 ptr += stride;							\
+      }									\
+   }									\
+}
+
+#define TO_FLOAT( x )  ((GLfloat) (x))
+
+#define CONVERT_TYPE( TYPE, MACRO )					\
+CONVERT_FUNC( convert_##TYPE##_1_raw, TYPE, 1, TO_FLOAT )		\
+CONVERT_FUNC( convert_##TYPE##_2_raw, TYPE, 2, TO_FLOAT )		\
+CONVERT_FUNC( convert_##TYPE##_3_raw, TYPE, 3, TO_FLOAT )		\
+CONVERT_FUNC( convert_##TYPE##_4_raw, TYPE, 4, TO_FLOAT )		\
+CONVERT_FUNC( convert_##TYPE##_1_norm, TYPE, 1, MACRO )			\
+CONVERT_FUNC( convert_##TYPE##_2_norm, TYPE, 2, MACRO )			\
+CONVERT_FUNC( convert_##TYPE##_3_norm, TYPE, 3, MACRO )			\
+CONVERT_FUNC( convert_##TYPE##_4_norm, TYPE, 4, MACRO )
+
+CONVERT_TYPE( GLbyte, BYTE_TO_FLOAT )
+CONVERT_TYPE( GLubyte, UBYTE_TO_FLOAT )
+CONVERT_TYPE( GLshort, SHORT_TO_FLOAT )
+CONVERT_TYPE( GLushort, USHORT_TO_FLOAT )
+CONVERT_TYPE( GLint, INT_TO_FLOAT )
+CONVERT_TYPE( GLuint, UINT_TO_FLOAT )
+CONVERT_TYPE( GLdouble, TO_FLOAT )
+
+typedef void (*convert_func)( GLfloat *fptr, const GLubyte *ptr,
+			      GLuint stride, GLuint count );
+
+#define CONVERT_ENTRY( TYPE )						\
+   { { convert_##TYPE##_1_raw, convert_##TYPE##_1_norm },		\
+     { convert_##TYPE##_2_raw, convert_##TYPE##_2_norm },		\
+     { convert_##TYPE##_3_raw, convert_##TYPE##_3_norm },		\
+     { convert_##TYPE##_4_raw, convert_##TYPE##_4_norm } }
+
+/* Indexed by [type][size-1][normalized]:
+ */
+static const convert_func convert_tab[7][4][2] = {
+   CONVERT_ENTRY( GLbyte ),
+   CONVERT_ENTRY( GLubyte ),
+   CONVERT_ENTRY( GLshort ),
+   CONVERT_ENTRY( GLushort ),
+   CONVERT_ENTRY( GLint ),
+   CONVERT_ENTRY( GLuint ),
+   CONVERT_ENTRY( GLdouble )
+};
+
+
+static GLuint convert_type_index( GLenum type )
+{
+   switch (type) {
+   case GL_BYTE:           return 0;
+   case GL_UNSIGNED_BYTE:  return 1;
+   case GL_SHORT:          return 2;
+   case GL_UNSIGNED_SHORT: return 3;
+   case GL_INT:            return 4;
+   case GL_UNSIGNED_INT:   return 5;
+   case GL_DOUBLE:         return 6;
+   default:
+      assert(0);
+      return 0;
+   }
+}
 
 
 
@@ -105,34 +186,9 @@ static void _tnl_import_array( GLcontext *ctx,
    if (input->Type != GL_FLOAT) {
       const GLuint sz = input->Size;
       GLubyte *buf = get_space(ctx, count * sz * sizeof(GLfloat));
-      GLfloat *fptr = (GLfloat *)buf;
-
-      switch (input->Type) {
-      case GL_BYTE: 
-	 CONVERT(GLbyte, BYTE_TO_FLOAT); 
-	 break;
-      case GL_UNSIGNED_BYTE: 
-	 CONVERT(GLubyte, UBYTE_TO_FLOAT); 
-	 break;
-      case GL_SHORT: 
-	 CONVERT(GLshort, SHORT_TO_FLOAT); 
-	 break;
-      case GL_UNSIGNED_SHORT: 
-	 CONVERT(GLushort, USHORT_TO_FLOAT); 
-	 break;
-      case GL_INT: 
-	 CONVERT(GLint, INT_TO_FLOAT); 
-	 break;
-      case GL_UNSIGNED_INT: 
-	 CONVERT(GLuint, UINT_TO_FLOAT); 
-	 break;
-      case GL_DOUBLE: 
-	 CONVERT(GLdouble, (GLfloat)); 
-	 break;
-      default:
-	 assert(0);
-	 break;
-      }
+
+      convert_tab[convert_type_index(input->Type)][sz - 1][input->Normalized != 0]
+	 ( (GLfloat *)buf, ptr, input->StrideB, count );
 
       ptr = buf;
       stride = sz * sizeof(GLfloat);
@@ -54,6 +54,11 @@ extern const struct tnl_pipeline_stage _tnl_point_attenuation_stage;
 extern const struct tnl_pipeline_stage _tnl_vertex_program_stage;
 extern const struct tnl_pipeline_stage _tnl_render_stage;
 
+/* Provided by t_vb_vertex.c, also used by the vertex program stage:
+ */
+extern void _tnl_project_guard_band( GLcontext *ctx,
+                                     const GLubyte *clipmask );
+
 /* Shorthand to plug in the default pipeline:
  */
 extern const struct tnl_pipeline_stage *_tnl_default_pipeline[];
@@ -181,7 +181,8 @@ TAG(clip_line)( GLcontext *ctx, GLuint v0, GLuint v1, GLubyte mask )
 }
 
 
-/* Clip a triangle against the viewport and user clip planes.
+/* Clip a triangle against the viewport and user clip planes.  The X/Y
+ * planes are pushed out to the guard band, if the driver enabled one.
  */
 static INLINE void
 TAG(clip_tri)( GLcontext *ctx, GLuint v0, GLuint v1, GLuint v2, GLubyte mask )
@@ -191,6 +192,8 @@ TAG(clip_tri)( GLcontext *ctx, GLuint v0, GLuint v1, GLuint v2, GLubyte mask )
    tnl_interp_func interp = tnl->Driver.Render.Interp;
    GLuint newvert = VB->Count;
    GLfloat (*coord)[4] = VB->ClipPtr->data;
+   const GLfloat gbx = tnl->_GuardBand[0]; /* 1.0 without a guard band */
+   const GLfloat gby = tnl->_GuardBand[1];
    GLuint pv = v2;
    GLuint vlist[2][MAX_CLIPPED_VERTICES];
    GLuint *inlist = vlist[0], *outlist = vlist[1];
@@ -200,10 +203,10 @@ TAG(clip_tri)( GLcontext *ctx, GLuint v0, GLuint v1, GLuint v2, GLubyte mask )
    ASSIGN_3V(inlist, v2, v0, v1 ); /* pv rotated to slot zero */
 
    if (mask & 0x3f) {
-      POLY_CLIP( CLIP_RIGHT_BIT,  -1,  0,  0, 1 );
-      POLY_CLIP( CLIP_LEFT_BIT,    1,  0,  0, 1 );
-      POLY_CLIP( CLIP_TOP_BIT,     0, -1,  0, 1 );
-      POLY_CLIP( CLIP_BOTTOM_BIT,  0,  1,  0, 1 );
+      POLY_CLIP( CLIP_RIGHT_BIT,  -1,  0,  0, gbx );
+      POLY_CLIP( CLIP_LEFT_BIT,    1,  0,  0, gbx );
+      POLY_CLIP( CLIP_TOP_BIT,     0, -1,  0, gby );
+      POLY_CLIP( CLIP_BOTTOM_BIT,  0,  1,  0, gby );
       POLY_CLIP( CLIP_FAR_BIT,     0,  0, -1, 1 );
       POLY_CLIP( CLIP_NEAR_BIT,    0,  0,  1, 1 );
    }
@@ -231,7 +234,7 @@ TAG(clip_tri)( GLcontext *ctx, GLuint v0, GLuint v1, GLuint v2, GLubyte mask )
 }
 
 
-/* Clip a quad against the viewport and user clip planes.
+/* Clip a quad against the viewport (or guard band) and user clip planes.
  */
 static INLINE void
 TAG(clip_quad)( GLcontext *ctx, GLuint v0, GLuint v1, GLuint v2, GLuint v3,
@@ -242,6 +245,8 @@ TAG(clip_quad)( GLcontext *ctx, GLuint v0, GLuint v1, GLuint v2, GLuint v3,
    tnl_interp_func interp = tnl->Driver.Render.Interp;
    GLuint newvert = VB->Count;
    GLfloat (*coord)[4] = VB->ClipPtr->data;
+   const GLfloat gbx = tnl->_GuardBand[0]; /* 1.0 without a guard band */
+   const GLfloat gby = tnl->_GuardBand[1];
    GLuint pv = v3;
    GLuint vlist[2][MAX_CLIPPED_VERTICES];
    GLuint *inlist = vlist[0], *outlist = vlist[1];
@@ -251,10 +256,10 @@ TAG(clip_quad)( GLcontext *ctx, GLuint v0, GLuint v1, GLuint v2, GLuint v3,
    ASSIGN_4V(inlist, v3, v0, v1, v2 ); /* pv rotated to slot zero */
 
    if (mask & 0x3f) {
-      POLY_CLIP( CLIP_RIGHT_BIT,  -1,  0,  0, 1 );
-      POLY_CLIP( CLIP_LEFT_BIT,    1,  0,  0, 1 );
-      POLY_CLIP( CLIP_TOP_BIT,     0, -1,  0, 1 );
-      POLY_CLIP( CLIP_BOTTOM_BIT,  0,  1,  0, 1 );
+      POLY_CLIP( CLIP_RIGHT_BIT,  -1,  0,  0, gbx );
+      POLY_CLIP( CLIP_LEFT_BIT,    1,  0,  0, gbx );
+      POLY_CLIP( CLIP_TOP_BIT,     0, -1,  0, gby );
+      POLY_CLIP( CLIP_BOTTOM_BIT,  0,  1,  0, gby );
       POLY_CLIP( CLIP_FAR_BIT,     0,  0, -1, 1 );
       POLY_CLIP( CLIP_NEAR_BIT,    0,  0,  1, 1 );
    }
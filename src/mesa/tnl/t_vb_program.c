@@ -158,6 +158,9 @@ do_ndc_cliptest(GLcontext *ctx, struct vp_stage_data *store)
       }
    }
 
+   if (tnl->_DoGuardBand && (store->ormask & CLIP_GUARD_BAND_BITS))
+      _tnl_project_guard_band( ctx, store->clipmask );
+
    VB->ClipAndMask = store->andmask;
    VB->ClipOrMask = store->ormask;
    VB->ClipMask = store->clipmask;
@@ -230,6 +233,7 @@ init_machine(GLcontext *ctx, struct gl_program_machine *machine)
    }
 
    machine->NumDeriv = 0;
+   machine->NumTexPrefetch = 0;
 
    /* init condition codes */
    machine->CondCodes[0] = COND_EQ;
@@ -92,14 +92,28 @@ do {						\
       clip_line_4( ctx, v1, v2, ormask );	\
 } while (0)
 
+/* Primitives which only cross the X/Y frustum planes and lie within the
+ * guard band are passed to the rasterizer without clipping.
+ */
+#define IN_GUARD_BAND( ormask )					\
+   (guard && !((ormask) & ~CLIP_GUARD_BAND_BITS))
+
+#define INSIDE_GUARD( v ) TNL_INSIDE_GUARD_BAND(tnl, coord[v])
+
 #define RENDER_TRI( v1, v2, v3 )			\
 do {							\
    GLubyte c1 = mask[v1], c2 = mask[v2], c3 = mask[v3];	\
    GLubyte ormask = c1|c2|c3;				\
    if (!ormask)						\
       TriangleFunc( ctx, v1, v2, v3 );			\
-   else if (!(c1 & c2 & c3 & CLIPMASK)) 			\
-      clip_tri_4( ctx, v1, v2, v3, ormask );    	\
+   else if (!(c1 & c2 & c3 & CLIPMASK)) {		\
+      if (IN_GUARD_BAND(ormask) &&			\
+          INSIDE_GUARD(v1) && INSIDE_GUARD(v2) &&	\
+          INSIDE_GUARD(v3))				\
+         TriangleFunc( ctx, v1, v2, v3 );		\
+      else						\
+         clip_tri_4( ctx, v1, v2, v3, ormask );		\
+   }							\
 } while (0)
 
 #define RENDER_QUAD( v1, v2, v3, v4 )			\
@@ -109,8 +123,14 @@ do {							\
    GLubyte ormask = c1|c2|c3|c4;			\
    if (!ormask)						\
       QuadFunc( ctx, v1, v2, v3, v4 );			\
-   else if (!(c1 & c2 & c3 & c4 & CLIPMASK)) 		\
-      clip_quad_4( ctx, v1, v2, v3, v4, ormask );	\
+   else if (!(c1 & c2 & c3 & c4 & CLIPMASK)) {		\
+      if (IN_GUARD_BAND(ormask) &&			\
+          INSIDE_GUARD(v1) && INSIDE_GUARD(v2) &&	\
+          INSIDE_GUARD(v3) && INSIDE_GUARD(v4))	\
+         QuadFunc( ctx, v1, v2, v3, v4 );		\
+      else						\
+         clip_quad_4( ctx, v1, v2, v3, v4, ormask );	\
+   }							\
 } while (0)
 
 
@@ -124,8 +144,11 @@ do {							\
    const tnl_triangle_func TriangleFunc = tnl->Driver.Render.Triangle;	\
    const tnl_quad_func QuadFunc = tnl->Driver.Render.Quad;		\
    const GLboolean stipple = ctx->Line.StippleFlag;		\
+   const GLboolean guard = tnl->_DoGuardBand;			\
+   GLfloat (*coord)[4] = VB->ClipPtr->data;			\
    (void) (LineFunc && TriangleFunc && QuadFunc);		\
-   (void) elt; (void) mask; (void) sz; (void) stipple;
+   (void) elt; (void) mask; (void) sz; (void) stipple;		\
+   (void) guard; (void) coord;
 
 #define TAG(x) clip_##x##_verts
 #define INIT(x) tnl->Driver.Render.PrimitiveNotify( ctx, x )
@@ -155,6 +178,8 @@ static void clip_elt_triangles( GLcontext *ctx,
    struct vertex_buffer *VB = &tnl->vb;
    const GLuint * const elt = VB->Elts;
    GLubyte *mask = VB->ClipMask;
+   const GLboolean guard = tnl->_DoGuardBand;
+   GLfloat (*coord)[4] = VB->ClipPtr->data;
    GLuint last = count-2;
    GLuint j;
    (void) flags;
@@ -166,7 +191,10 @@ static void clip_elt_triangles( GLcontext *ctx,
       GLubyte c2 = mask[elt[j+1]];
       GLubyte c3 = mask[elt[j+2]];
       GLubyte ormask = c1|c2|c3;
-      if (ormask) {
+      if (ormask &&
+          !(IN_GUARD_BAND(ormask) &&
+            INSIDE_GUARD(elt[j]) && INSIDE_GUARD(elt[j+1]) &&
+            INSIDE_GUARD(elt[j+2]))) {
 	 if (start < j)
 	    render_tris( ctx, start, j, 0 );
 	 if (!(c1&c2&c3&CLIPMASK))
@@ -119,6 +119,42 @@ static void (*(usercliptab[5]))( GLcontext *,
 
 
 
+/**
+ * The cliptest functions leave the NDC coords of clipped vertices
+ * zeroed.  Vertices which are only outside the X/Y frustum planes but
+ * inside the guard band may be rendered unclipped, so project them.
+ */
+void
+_tnl_project_guard_band( GLcontext *ctx, const GLubyte *clipmask )
+{
+   TNLcontext *tnl = TNL_CONTEXT(ctx);
+   struct vertex_buffer *VB = &tnl->vb;
+   const GLfloat *from = (const GLfloat *) VB->ClipPtr->data;
+   const GLuint stride = VB->ClipPtr->stride;
+   const GLuint count = VB->ClipPtr->count;
+   GLfloat (*proj)[4];
+   GLuint i;
+
+   /* Without a divide, the NDC coords already are the clip coords */
+   if (!VB->NdcPtr || VB->NdcPtr == VB->ClipPtr)
+      return;
+
+   proj = VB->NdcPtr->data;
+
+   for (i = 0; i < count; i++, STRIDE_F(from, stride)) {
+      const GLubyte mask = clipmask[i];
+      if (mask && !(mask & ~CLIP_GUARD_BAND_BITS) &&
+          TNL_INSIDE_GUARD_BAND(tnl, from)) {
+         const GLfloat oow = 1.0F / from[3];
+         proj[i][0] = from[0] * oow;
+         proj[i][1] = from[1] * oow;
+         proj[i][2] = from[2] * oow;
+         proj[i][3] = oow;
+      }
+   }
+}
+
+
 static GLboolean run_vertex_stage( GLcontext *ctx,
 				   struct tnl_pipeline_stage *stage )
 {
@@ -202,6 +238,9 @@ static GLboolean run_vertex_stage( GLcontext *ctx,
 	 return GL_FALSE;
    }
 
+   if (tnl->_DoGuardBand && (store->ormask & CLIP_GUARD_BAND_BITS))
+      _tnl_project_guard_band( ctx, store->clipmask );
+
    VB->ClipAndMask = store->andmask;
    VB->ClipOrMask = store->ormask;
    VB->ClipMask = store->clipmask;
@@ -987,25 +987,75 @@ void _tnl_generate_hardwired_emit( GLcontext *ctx )
  * vertices
  */
 
+/* Emit one attribute for a run of vertices with a given insert
+ * function, which the compiler can inline for the common cases.
+ */
+#define EMIT_ATTR_LOOP( INSERT )				\
+do {								\
+   for (i = 0 ; i < count ; i++, out += stride, in += instride)	\
+      INSERT( a, out, (const GLfloat *) in );			\
+} while (0)
+
+/* Work through the vertices one attribute at a time rather than one
+ * vertex at a time.  This avoids an indirect call per attribute per
+ * vertex for the layouts used by swrast_setup (viewport position,
+ * float attribs and chan colors), and lets constant inputs be
+ * converted once and copied.
+ */
 void _tnl_generic_emit( GLcontext *ctx,
 			GLuint count,
 			GLubyte *v )
 {
    struct tnl_clipspace *vtx = GET_VERTEX_STATE(ctx);
-   struct tnl_clipspace_attr *a = vtx->attr;
    const GLuint attr_count = vtx->attr_count;
    const GLuint stride = vtx->vertex_size;
    GLuint i, j;
 
-   for (i = 0 ; i < count ; i++, v += stride) {
-      for (j = 0; j < attr_count; j++) {
-	 GLfloat *in = (GLfloat *)a[j].inputptr;
-	 a[j].inputptr += a[j].inputstride;
-	 a[j].emit( &a[j], v + a[j].vertoffset, in );
+   for (j = 0; j < attr_count; j++) {
+      struct tnl_clipspace_attr *a = &vtx->attr[j];
+      const tnl_insert_func emit = a->emit;
+      const GLuint instride = a->inputstride;
+      const GLubyte *in = a->inputptr;
+      GLubyte *out = v + a->vertoffset;
+
+      a->inputptr += count * instride;
+
+      if (count == 0)
+	 continue;
+
+      if (instride == 0) {
+	 const GLubyte *first = out;
+	 emit( a, out, (const GLfloat *) in );
+	 for (i = 1, out += stride ; i < count ; i++, out += stride)
+	    _mesa_memcpy( out, first, a->vertattrsize );
       }
+      else if (emit == insert_4f_viewport_4)
+	 EMIT_ATTR_LOOP( insert_4f_viewport_4 );
+      else if (emit == insert_4f_viewport_3)
+	 EMIT_ATTR_LOOP( insert_4f_viewport_3 );
+      else if (emit == insert_4f_viewport_2)
+	 EMIT_ATTR_LOOP( insert_4f_viewport_2 );
+      else if (emit == insert_4f_4)
+	 EMIT_ATTR_LOOP( insert_4f_4 );
+      else if (emit == insert_4f_3)
+	 EMIT_ATTR_LOOP( insert_4f_3 );
+      else if (emit == insert_4f_2)
+	 EMIT_ATTR_LOOP( insert_4f_2 );
+      else if (emit == insert_4f_1)
+	 EMIT_ATTR_LOOP( insert_4f_1 );
+      else if (emit == insert_1f_1)
+	 EMIT_ATTR_LOOP( insert_1f_1 );
+      else if (emit == insert_4chan_4f_rgba_4)
+	 EMIT_ATTR_LOOP( insert_4chan_4f_rgba_4 );
+      else if (emit == insert_4chan_4f_rgba_3)
+	 EMIT_ATTR_LOOP( insert_4chan_4f_rgba_3 );
+      else
+	 EMIT_ATTR_LOOP( emit );
    }
 }
 
+#undef EMIT_ATTR_LOOP
+
 
 void _tnl_generic_interp( GLcontext *ctx,
 			    GLfloat t,
@@ -28,6 +28,7 @@
 #include "main/imports.h"
 #include "main/mtypes.h"
 #include "main/api_arrayelt.h"
+#include "main/macros.h"
 #include "vbo.h"
 #include "vbo_context.h"
 
@@ -244,6 +245,59 @@ void _vbo_DestroyContext( GLcontext *ctx )
 #if FEATURE_dlist
    vbo_save_destroy(ctx);
 #endif
+   if (vbo_context(ctx)->scratch.buffer)
+      _mesa_align_free(vbo_context(ctx)->scratch.buffer);
    FREE(vbo_context(ctx));
    ctx->swtnl_im = NULL;
 }
+
+
+/**
+ * Allocate temporary memory for the duration of a draw.  The rebase
+ * and split helpers can nest, so blocks are handed out as a stack and
+ * must be released with vbo_scratch_free() in reverse order.  Requests
+ * which don't fit fall back to malloc, and the arena grows to the
+ * largest total seen the next time it is empty.
+ */
+void *vbo_scratch_alloc( GLcontext *ctx, GLuint size )
+{
+   struct vbo_context *vbo = vbo_context(ctx);
+   void *ptr;
+
+   size = (size + 15) & ~15;
+
+   if (vbo->scratch.used == 0 && vbo->scratch.wanted > vbo->scratch.size) {
+      if (vbo->scratch.buffer)
+	 _mesa_align_free(vbo->scratch.buffer);
+      vbo->scratch.buffer = _mesa_align_malloc(vbo->scratch.wanted, 16);
+      vbo->scratch.size = vbo->scratch.buffer ? vbo->scratch.wanted : 0;
+   }
+
+   if (vbo->scratch.used + size <= vbo->scratch.size) {
+      ptr = vbo->scratch.buffer + vbo->scratch.used;
+      vbo->scratch.used += size;
+   }
+   else {
+      vbo->scratch.wanted = MAX2(vbo->scratch.wanted,
+				 vbo->scratch.used + size);
+      ptr = _mesa_malloc(size);
+   }
+
+   return ptr;
+}
+
+
+void vbo_scratch_free( GLcontext *ctx, void *ptr )
+{
+   struct vbo_context *vbo = vbo_context(ctx);
+   GLubyte *p = (GLubyte *)ptr;
+
+   if (p >= vbo->scratch.buffer &&
+       p < vbo->scratch.buffer + vbo->scratch.size) {
+      assert(p < vbo->scratch.buffer + vbo->scratch.used);
+      vbo->scratch.used = p - vbo->scratch.buffer;
+   }
+   else if (ptr) {
+      _mesa_free(ptr);
+   }
+}
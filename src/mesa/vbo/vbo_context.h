@@ -84,6 +84,16 @@ struct vbo_context {
     * is responsible for initiating any fallback actions required:
     */
    vbo_draw_func draw_prims;
+
+   /* Temporary indices, prims and vertices for the rebase and split
+    * helpers.  Kept from one draw to the next, see vbo_scratch_alloc().
+    */
+   struct {
+      GLubyte *buffer;
+      GLuint size;
+      GLuint used;
+      GLuint wanted;
+   } scratch;
 };
 
 
@@ -92,6 +102,10 @@ static INLINE struct vbo_context *vbo_context(GLcontext *ctx)
    return (struct vbo_context *)(ctx->swtnl_im);
 }
 
+void *vbo_scratch_alloc( GLcontext *ctx, GLuint size );
+void vbo_scratch_free( GLcontext *ctx, void *ptr );
+
+
 enum {
    VP_NONE = 1,
    VP_NV,
@@ -43,7 +43,7 @@ USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 /* Wierd implementation stuff:
  */
-#define VBO_VERT_BUFFER_SIZE (1024*16)	/* dwords == 64k */
+#define VBO_VERT_BUFFER_SIZE (1024*64)	/* dwords == 256k */
 #define VBO_MAX_ATTR_CODEGEN 16 
 #define ERROR_ATTRIB 16
 
@@ -79,6 +79,7 @@ struct vbo_exec_context
    struct {
       struct gl_buffer_object *bufferobj;
       GLubyte *buffer_map;
+      GLubyte *buffer_ptr;           /* start of the vertices not yet drawn */
 
       GLuint vertex_size;
 
@@ -105,6 +106,12 @@ struct vbo_exec_context
       GLuint program_mode;
       GLuint enabled_flags;
       const struct gl_client_array *inputs[VERT_ATTRIB_MAX];
+
+      /* Layout the arrays above were last bound with.  Later runs of
+       * vertices with the same layout are drawn from the same arrays:
+       */
+      GLubyte *bound_ptr;
+      GLubyte bound_sz[VBO_ATTRIB_MAX];
    } vtx;
 
    
@@ -117,7 +124,7 @@ struct vbo_exec_context
    struct {
       GLuint program_mode;
       GLuint enabled_flags;
-      GLuint array_obj;
+      const struct gl_array_object *array_obj;
 
       /* These just mirror the current arrayobj (todo: make arrayobj
        * look like this and remove the mirror):
@@ -130,6 +137,13 @@ struct vbo_exec_context
        * programs:
        */
       const struct gl_client_array *inputs[VERT_ATTRIB_MAX];
+
+      /* glDrawArrays calls queued up to be drawn together from the
+       * inputs above:
+       */
+      struct _mesa_prim prim[VBO_MAX_PRIM];
+      GLuint prim_count;
+      GLuint min_index, max_index;
    } array;
 };
 
@@ -147,11 +161,13 @@ void vbo_exec_FlushVertices( GLcontext *ctx, GLuint flags );
  */
 void vbo_exec_array_init( struct vbo_exec_context *exec );
 void vbo_exec_array_destroy( struct vbo_exec_context *exec );
+void vbo_exec_array_flush( struct vbo_exec_context *exec );
 
 
 void vbo_exec_vtx_init( struct vbo_exec_context *exec );
 void vbo_exec_vtx_destroy( struct vbo_exec_context *exec );
 void vbo_exec_vtx_flush( struct vbo_exec_context *exec );
+void vbo_exec_vtx_restart( struct vbo_exec_context *exec );
 void vbo_exec_vtx_wrap( struct vbo_exec_context *exec );
 
 void vbo_exec_eval_update( struct vbo_exec_context *exec );
@@ -61,8 +61,8 @@ static void vbo_exec_wrap_buffers( struct vbo_exec_context *exec )
 {
    if (exec->vtx.prim_count == 0) {
       exec->vtx.copied.nr = 0;
-      exec->vtx.vert_count = 0;
-      exec->vtx.vbptr = (GLfloat *)exec->vtx.buffer_map;
+      exec->vtx.vbptr = (GLfloat *)exec->vtx.buffer_ptr;
+      vbo_exec_vtx_restart( exec );
    }
    else {
       GLuint last_begin = exec->vtx.prim[exec->vtx.prim_count-1].begin;
@@ -247,9 +247,7 @@ static void vbo_exec_wrap_upgrade_vertex( struct vbo_exec_context *exec,
    exec->vtx.attrsz[attr] = newsz;
 
    exec->vtx.vertex_size += newsz - oldsz;
-   exec->vtx.max_vert = VBO_VERT_BUFFER_SIZE / exec->vtx.vertex_size;
-   exec->vtx.vert_count = 0;
-   exec->vtx.vbptr = (GLfloat *)exec->vtx.buffer_map;
+   vbo_exec_vtx_restart( exec );
    
 
    /* Recalculate all the attrptr[] values
@@ -278,7 +276,7 @@ static void vbo_exec_wrap_upgrade_vertex( struct vbo_exec_context *exec,
       GLfloat *dest = exec->vtx.vbptr;
       GLuint j;
 
-      assert(exec->vtx.vbptr == (GLfloat *)exec->vtx.buffer_map);
+      assert(exec->vtx.vbptr == (GLfloat *)exec->vtx.buffer_ptr);
       
       for (i = 0 ; i < exec->vtx.copied.nr ; i++) {
 	 for (j = 0 ; j < VBO_ATTRIB_MAX ; j++) {
@@ -685,6 +683,9 @@ void vbo_use_buffer_objects(GLcontext *ctx)
    /* and map it */
    exec->vtx.buffer_map
       = ctx->Driver.MapBuffer(ctx, target, access, exec->vtx.bufferobj);
+   exec->vtx.buffer_ptr = exec->vtx.buffer_map;
+   exec->vtx.vbptr = (GLfloat *)exec->vtx.buffer_map;
+   exec->vtx.bound_ptr = NULL;
 }
 
 
@@ -704,6 +705,9 @@ void vbo_exec_vtx_init( struct vbo_exec_context *exec )
 
    ASSERT(!exec->vtx.buffer_map);
    exec->vtx.buffer_map = ALIGN_MALLOC(VBO_VERT_BUFFER_SIZE * sizeof(GLfloat), 64);
+   exec->vtx.buffer_ptr = exec->vtx.buffer_map;
+   exec->vtx.vbptr = (GLfloat *)exec->vtx.buffer_map;
+   exec->vtx.bound_ptr = NULL;
    vbo_exec_vtxfmt_init( exec );
 
    /* Hook our functions into the dispatch table.
@@ -750,6 +754,8 @@ void vbo_exec_FlushVertices( GLcontext *ctx, GLuint flags )
    if (exec->ctx->Driver.CurrentExecPrimitive != PRIM_OUTSIDE_BEGIN_END)
       return;
 
+   vbo_exec_array_flush( exec );
+
    if (exec->vtx.vert_count) {
       vbo_exec_vtx_flush( exec );
    }
@@ -27,58 +27,66 @@
 
 #include "main/glheader.h"
 #include "main/context.h"
+#include "main/macros.h"
 #include "main/state.h"
 #include "main/api_validate.h"
 #include "main/api_noop.h"
 
 #include "vbo_context.h"
 
-/* Compute min and max elements for drawelements calls.
+/* Compute min and max elements for drawelements calls.  Four
+ * independent running minimums and maximums are kept so that the
+ * loop has no dependency chain and can be vectorized by the compiler.
  */
+#define MINMAX_FUNC( TYPE )						\
+static void minmax_##TYPE( const TYPE *idx, GLuint count,		\
+			   GLuint *min_index, GLuint *max_index )	\
+{									\
+   TYPE min0 = idx[0], min1 = idx[0], min2 = idx[0], min3 = idx[0];	\
+   TYPE max0 = idx[0], max1 = idx[0], max2 = idx[0], max3 = idx[0];	\
+   GLuint i;								\
+									\
+   for (i = 0; i + 4 <= count; i += 4) {				\
+      min0 = idx[i+0] < min0 ? idx[i+0] : min0;				\
+      min1 = idx[i+1] < min1 ? idx[i+1] : min1;				\
+      min2 = idx[i+2] < min2 ? idx[i+2] : min2;				\
+      min3 = idx[i+3] < min3 ? idx[i+3] : min3;				\
+      max0 = idx[i+0] > max0 ? idx[i+0] : max0;				\
+      max1 = idx[i+1] > max1 ? idx[i+1] : max1;				\
+      max2 = idx[i+2] > max2 ? idx[i+2] : max2;				\
+      max3 = idx[i+3] > max3 ? idx[i+3] : max3;				\
+   }									\
+   for ( ; i < count; i++) {						\
+      min0 = idx[i] < min0 ? idx[i] : min0;				\
+      max0 = idx[i] > max0 ? idx[i] : max0;				\
+   }									\
+									\
+   min0 = MIN2(MIN2(min0, min1), MIN2(min2, min3));			\
+   max0 = MAX2(MAX2(max0, max1), MAX2(max2, max3));			\
+   *min_index = min0;							\
+   *max_index = max0;							\
+}
+
+MINMAX_FUNC( GLuint )
+MINMAX_FUNC( GLushort )
+MINMAX_FUNC( GLubyte )
+
+
 static void get_minmax_index( GLuint count, GLuint type, 
 			      const GLvoid *indices,
 			      GLuint *min_index,
 			      GLuint *max_index)
 {
-   GLuint i;
-
    switch(type) {
-   case GL_UNSIGNED_INT: {
-      const GLuint *ui_indices = (const GLuint *)indices;
-      GLuint max_ui = ui_indices[count-1];
-      GLuint min_ui = ui_indices[0];
-      for (i = 0; i < count; i++) {
-	 if (ui_indices[i] > max_ui) max_ui = ui_indices[i];
-	 if (ui_indices[i] < min_ui) min_ui = ui_indices[i];
-      }
-      *min_index = min_ui;
-      *max_index = max_ui;
+   case GL_UNSIGNED_INT:
+      minmax_GLuint((const GLuint *)indices, count, min_index, max_index);
       break;
-   }
-   case GL_UNSIGNED_SHORT: {
-      const GLushort *us_indices = (const GLushort *)indices;
-      GLuint max_us = us_indices[count-1];
-      GLuint min_us = us_indices[0];
-      for (i = 0; i < count; i++) {
-	 if (us_indices[i] > max_us) max_us = us_indices[i];
-	 if (us_indices[i] < min_us) min_us = us_indices[i];
-      }
-      *min_index = min_us;
-      *max_index = max_us;
+   case GL_UNSIGNED_SHORT:
+      minmax_GLushort((const GLushort *)indices, count, min_index, max_index);
       break;
-   }
-   case GL_UNSIGNED_BYTE: {
-      const GLubyte *ub_indices = (const GLubyte *)indices;
-      GLuint max_ub = ub_indices[count-1];
-      GLuint min_ub = ub_indices[0];
-      for (i = 0; i < count; i++) {
-	 if (ub_indices[i] > max_ub) max_ub = ub_indices[i];
-	 if (ub_indices[i] < min_ub) min_ub = ub_indices[i];
-      }
-      *min_index = min_ub;
-      *max_index = max_ub;
+   case GL_UNSIGNED_BYTE:
+      minmax_GLubyte((const GLubyte *)indices, count, min_index, max_index);
       break;
-   }
    default:
       assert(0);
       break;
@@ -86,6 +94,59 @@ static void get_minmax_index( GLuint count, GLuint type,
 }
 
 
+/* Static meshes are usually drawn with the same indices every frame,
+ * so remember the ranges found in each element buffer object until its
+ * contents change (see bufferobj.c).
+ */
+static GLboolean find_index_range( const struct gl_buffer_object *obj,
+				   GLuint count, GLenum type,
+				   const GLvoid *indices,
+				   GLuint *min_index,
+				   GLuint *max_index )
+{
+   GLuint i;
+
+   for (i = 0; i < obj->NumIndexRanges; i++) {
+      const struct gl_index_range *range = &obj->IndexRanges[i];
+      if (range->Offset == (GLintptrARB) indices &&
+	  range->Count == (GLsizei) count &&
+	  range->Type == type) {
+	 *min_index = range->Min;
+	 *max_index = range->Max;
+	 return GL_TRUE;
+      }
+   }
+
+   return GL_FALSE;
+}
+
+
+static void add_index_range( struct gl_buffer_object *obj,
+			     GLuint count, GLenum type,
+			     const GLvoid *indices,
+			     GLuint min_index,
+			     GLuint max_index )
+{
+   struct gl_index_range *range;
+   GLuint i;
+
+   /* When full, drop the oldest range.
+    */
+   if (obj->NumIndexRanges == MAX_INDEX_RANGES) {
+      for (i = 1; i < MAX_INDEX_RANGES; i++)
+	 obj->IndexRanges[i - 1] = obj->IndexRanges[i];
+      obj->NumIndexRanges--;
+   }
+
+   range = &obj->IndexRanges[obj->NumIndexRanges++];
+   range->Offset = (GLintptrARB) indices;
+   range->Count = count;
+   range->Type = type;
+   range->Min = min_index;
+   range->Max = max_index;
+}
+
+
 /* Just translate the arrayobj into a sane layout.
  */
 static void bind_array_obj( GLcontext *ctx )
@@ -120,7 +181,7 @@ static void bind_array_obj( GLcontext *ctx )
       exec->array.generic_array[i] = &ctx->Array.ArrayObj->VertexAttrib[i];
    }
    
-   exec->array.array_obj = ctx->Array.ArrayObj->Name;
+   exec->array.array_obj = ctx->Array.ArrayObj;
 }
 
 static void recalculate_input_bindings( GLcontext *ctx )
@@ -211,22 +272,68 @@ static void recalculate_input_bindings( GLcontext *ctx )
    }
 }
 
+/* The inputs[] only depend on which arrays of which array object are
+ * enabled and on the program mode, not on the array pointers or
+ * strides, so they can be kept from one draw to the next until one of
+ * those changes.  PointSize shares its _Enabled bit with Index and has
+ * to be checked separately.
+ */
 static void bind_arrays( GLcontext *ctx )
 {
-#if 0
-   if (ctx->Array.ArrayObj.Name != exec->array.array_obj) {
+   struct vbo_context *vbo = vbo_context(ctx);
+   struct vbo_exec_context *exec = &vbo->exec;
+   const struct gl_array_object *arrayObj = ctx->Array.ArrayObj;
+
+   if (arrayObj != exec->array.array_obj ||
+       arrayObj->PointSize.Enabled !=
+       (exec->array.legacy_array[VERT_ATTRIB_POINT_SIZE] ==
+        &arrayObj->PointSize)) {
+      vbo_exec_array_flush(exec);
       bind_array_obj(ctx);
       recalculate_input_bindings(ctx);
    }
    else if (exec->array.program_mode != get_program_mode(ctx) ||
-	    exec->array.enabled_flags != ctx->Array.ArrayObj->_Enabled) {
-      
+	    exec->array.enabled_flags != arrayObj->_Enabled) {
+      vbo_exec_array_flush(exec);
       recalculate_input_bindings(ctx);
    }
-#else
-   bind_array_obj(ctx);
-   recalculate_input_bindings(ctx);
-#endif
+}
+
+
+/* Client arrays may be rewritten by the application as soon as the
+ * draw call returns, so only draws sourcing all their arrays from
+ * buffer objects can be held back.  Current values have StrideB == 0.
+ */
+static GLboolean arrays_in_buffer_objects( const struct vbo_exec_context *exec )
+{
+   GLuint i;
+
+   for (i = 0; i < VERT_ATTRIB_MAX; i++) {
+      const struct gl_client_array *array = exec->array.inputs[i];
+      if (array->StrideB && !array->BufferObj->Name)
+	 return GL_FALSE;
+   }
+
+   return GL_TRUE;
+}
+
+
+/* Draw the queued glDrawArrays calls, if any.  Called before anything
+ * that could change the inputs or render ahead of them, and from
+ * vbo_exec_FlushVertices() so that state changes, queries and
+ * readbacks see them drawn.
+ */
+void vbo_exec_array_flush( struct vbo_exec_context *exec )
+{
+   GLuint nr = exec->array.prim_count;
+
+   if (nr) {
+      exec->array.prim_count = 0;
+      vbo_context(exec->ctx)->draw_prims( exec->ctx, exec->array.inputs,
+					  exec->array.prim, nr, NULL,
+					  exec->array.min_index,
+					  exec->array.max_index );
+   }
 }
 
 
@@ -241,7 +348,7 @@ vbo_exec_DrawArrays(GLenum mode, GLint start, GLsizei count)
    GET_CURRENT_CONTEXT(ctx);
    struct vbo_context *vbo = vbo_context(ctx);
    struct vbo_exec_context *exec = &vbo->exec;
-   struct _mesa_prim prim[1];
+   struct _mesa_prim single, *prim;
 
    if (!_mesa_validate_DrawArrays( ctx, mode, start, count ))
       return;
@@ -258,16 +365,48 @@ vbo_exec_DrawArrays(GLenum mode, GLint start, GLsizei count)
 
    bind_arrays( ctx );
 
-   prim[0].begin = 1;
-   prim[0].end = 1;
-   prim[0].weak = 0;
-   prim[0].pad = 0;
-   prim[0].mode = mode;
-   prim[0].start = start;
-   prim[0].count = count;
-   prim[0].indexed = 0;
+   if (start < 0 || !arrays_in_buffer_objects(exec)) {
+      vbo_exec_array_flush( exec );
+      prim = &single;
+   }
+   else {
+      /* Queue the draw behind the ones already waiting.  Only draws
+       * over the same or adjacent vertices are merged, so the
+       * backend isn't made to transform vertices nobody refers to.
+       */
+      GLuint end = start + count - 1;
 
-   vbo->draw_prims( ctx, exec->array.inputs, prim, 1, NULL, start, start + count - 1 );
+      if (exec->array.prim_count == VBO_MAX_PRIM ||
+	  (exec->array.prim_count &&
+	   ((GLuint) start > exec->array.max_index + 1 ||
+	    end + 1 < exec->array.min_index)))
+	 vbo_exec_array_flush( exec );
+
+      if (exec->array.prim_count == 0) {
+	 exec->array.min_index = start;
+	 exec->array.max_index = end;
+      }
+      else {
+	 exec->array.min_index = MIN2(exec->array.min_index, (GLuint) start);
+	 exec->array.max_index = MAX2(exec->array.max_index, end);
+      }
+
+      prim = &exec->array.prim[exec->array.prim_count++];
+   }
+
+   prim->begin = 1;
+   prim->end = 1;
+   prim->weak = 0;
+   prim->pad = 0;
+   prim->mode = mode;
+   prim->start = start;
+   prim->count = count;
+   prim->indexed = 0;
+
+   if (prim == &single)
+      vbo->draw_prims( ctx, exec->array.inputs, prim, 1, NULL, start, start + count - 1 );
+   else
+      ctx->Driver.NeedFlush |= FLUSH_STORED_VERTICES;
 }
 
 
@@ -297,6 +436,7 @@ vbo_exec_DrawRangeElements(GLenum mode,
    }
 
    bind_arrays( ctx );
+   vbo_exec_array_flush( exec );
 
    ib.count = count;
    ib.type = type; 
@@ -362,16 +502,27 @@ vbo_exec_DrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid *ind
    }
 
    if (ctx->Array.ElementArrayBufferObj->Name) {
-      const GLvoid *map = ctx->Driver.MapBuffer(ctx,
-						 GL_ELEMENT_ARRAY_BUFFER_ARB,
-						 GL_READ_ONLY,
-						 ctx->Array.ElementArrayBufferObj);
-
-      get_minmax_index(count, type, ADD_POINTERS(map, indices), &min_index, &max_index);
+      struct gl_buffer_object *obj = ctx->Array.ElementArrayBufferObj;
 
-      ctx->Driver.UnmapBuffer(ctx,
-			      GL_ELEMENT_ARRAY_BUFFER_ARB,
-			      ctx->Array.ElementArrayBufferObj);
+      /* A buffer bound for pixel packing may change under us.
+       */
+      if (obj == ctx->Pack.BufferObj ||
+	  !find_index_range(obj, count, type, indices,
+			    &min_index, &max_index)) {
+	 const GLvoid *map = ctx->Driver.MapBuffer(ctx,
+						    GL_ELEMENT_ARRAY_BUFFER_ARB,
+						    GL_READ_ONLY,
+						    obj);
+
+	 get_minmax_index(count, type, ADD_POINTERS(map, indices), &min_index, &max_index);
+
+	 ctx->Driver.UnmapBuffer(ctx,
+				 GL_ELEMENT_ARRAY_BUFFER_ARB,
+				 obj);
+
+	 if (obj != ctx->Pack.BufferObj)
+	    add_index_range(obj, count, type, indices, min_index, max_index);
+      }
    }
    else {
       get_minmax_index(count, type, indices, &min_index, &max_index);
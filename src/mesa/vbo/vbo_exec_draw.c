@@ -70,7 +70,7 @@ static GLuint vbo_copy_vertices( struct vbo_exec_context *exec )
    GLuint ovf, i;
    GLuint sz = exec->vtx.vertex_size;
    GLfloat *dst = exec->vtx.copied.buffer;
-   GLfloat *src = ((GLfloat *)exec->vtx.buffer_map + 
+   GLfloat *src = ((GLfloat *)exec->vtx.buffer_ptr + 
 		   exec->vtx.prim[exec->vtx.prim_count-1].start * 
 		   exec->vtx.vertex_size);
 
@@ -140,21 +140,50 @@ static GLuint vbo_copy_vertices( struct vbo_exec_context *exec )
 
 
 /* TODO: populate these as the vertex is defined:
+ *
+ * Returns the index of the first vertex of the current run within the
+ * bound arrays.
  */
-static void vbo_exec_bind_arrays( GLcontext *ctx )
+static GLuint vbo_exec_bind_arrays( GLcontext *ctx )
 {
    struct vbo_context *vbo = vbo_context(ctx);
    struct vbo_exec_context *exec = &vbo->exec;
    struct gl_client_array *arrays = exec->vtx.arrays;
-   GLuint count = exec->vtx.vert_count;
-   GLubyte *data = exec->vtx.buffer_map;
+   GLubyte *data = exec->vtx.buffer_ptr;
+   GLuint stride = exec->vtx.vertex_size * sizeof(GLfloat);
+   GLuint mode = get_program_mode(ctx);
+   GLboolean alias = GL_FALSE;
    const GLuint *map;
    GLuint attr;
 
+   /* check if VERT_ATTRIB_POS is not read but VERT_BIT_GENERIC0 is read.
+    * In that case we effectively need to route the data from
+    * glVertexAttrib(0, val) calls to feed into the GENERIC0 input.
+    */
+   if (mode != VP_NONE) {
+      const GLbitfield inputs = ctx->VertexProgram._Current->Base.InputsRead;
+      alias = ((inputs & VERT_BIT_POS) == 0 &&
+               (inputs & VERT_BIT_GENERIC0) != 0);
+   }
+
+   /* Vertices appended after an earlier run of the same layout can be
+    * drawn from the arrays already bound, starting at a later index.
+    * The generic0 aliasing rewrites the layout, so it always rebinds.
+    */
+   if (exec->vtx.bound_ptr &&
+       !alias &&
+       exec->vtx.program_mode == mode &&
+       data >= exec->vtx.bound_ptr &&
+       (data - exec->vtx.bound_ptr) % stride == 0 &&
+       _mesa_memcmp(exec->vtx.bound_sz, exec->vtx.attrsz,
+                    sizeof(exec->vtx.attrsz)) == 0) {
+      return (data - exec->vtx.bound_ptr) / stride;
+   }
+
    /* Install the default (ie Current) attributes first, then overlay
     * all active ones.
     */
-   switch (get_program_mode(exec->ctx)) {
+   switch (mode) {
    case VP_NONE:
       for (attr = 0; attr < 16; attr++) {
          exec->vtx.inputs[attr] = &vbo->legacy_currval[attr];
@@ -176,12 +205,7 @@ static void vbo_exec_bind_arrays( GLcontext *ctx )
       }
       map = vbo->map_vp_arb;
 
-      /* check if VERT_ATTRIB_POS is not read but VERT_BIT_GENERIC0 is read.
-       * In that case we effectively need to route the data from
-       * glVertexAttrib(0, val) calls to feed into the GENERIC0 input.
-       */
-      if ((ctx->VertexProgram._Current->Base.InputsRead & VERT_BIT_POS) == 0 &&
-          (ctx->VertexProgram._Current->Base.InputsRead & VERT_BIT_GENERIC0)) {
+      if (alias) {
          exec->vtx.inputs[16] = exec->vtx.inputs[0];
          exec->vtx.attrsz[16] = exec->vtx.attrsz[0];
          exec->vtx.attrptr[16] = exec->vtx.attrptr[0];
@@ -215,18 +239,53 @@ static void vbo_exec_bind_arrays( GLcontext *ctx )
             arrays[attr].Ptr = (void *) data;
          }
 	 arrays[attr].Size = exec->vtx.attrsz[src];
-	 arrays[attr].StrideB = exec->vtx.vertex_size * sizeof(GLfloat);
-	 arrays[attr].Stride = exec->vtx.vertex_size * sizeof(GLfloat);
+	 arrays[attr].StrideB = stride;
+	 arrays[attr].Stride = stride;
 	 arrays[attr].Type = GL_FLOAT;
 	 arrays[attr].Enabled = 1;
          _mesa_reference_buffer_object(ctx,
                                        &arrays[attr].BufferObj,
                                        exec->vtx.bufferobj);
-	 arrays[attr]._MaxElement = count; /* ??? */
+	 arrays[attr]._MaxElement = exec->vtx.max_vert;
 
 	 data += exec->vtx.attrsz[src] * sizeof(GLfloat);
       }
    }
+
+   /* The generic0 aliasing above rewrote attrsz[], so it can't be
+    * used to recognize the layout next time.
+    */
+   if (alias) {
+      exec->vtx.bound_ptr = NULL;
+   }
+   else {
+      exec->vtx.bound_ptr = exec->vtx.buffer_ptr;
+      exec->vtx.program_mode = mode;
+      _mesa_memcpy(exec->vtx.bound_sz, exec->vtx.attrsz,
+                   sizeof(exec->vtx.attrsz));
+   }
+
+   return 0;
+}
+
+
+/**
+ * Start a new run of vertices at the cursor.  The store is only
+ * recycled from the beginning once the room left after the cursor gets
+ * small, so that flushes between runs don't need to copy or rebind.
+ */
+void vbo_exec_vtx_restart( struct vbo_exec_context *exec )
+{
+   GLfloat *end = (GLfloat *)exec->vtx.buffer_map + VBO_VERT_BUFFER_SIZE;
+
+   if (end - exec->vtx.vbptr < VBO_VERT_BUFFER_SIZE / 8)
+      exec->vtx.vbptr = (GLfloat *)exec->vtx.buffer_map;
+
+   exec->vtx.buffer_ptr = (GLubyte *)exec->vtx.vbptr;
+   exec->vtx.vert_count = 0;
+
+   if (exec->vtx.vertex_size)
+      exec->vtx.max_vert = (end - exec->vtx.vbptr) / exec->vtx.vertex_size;
 }
 
 
@@ -238,6 +297,9 @@ void vbo_exec_vtx_flush( struct vbo_exec_context *exec )
    if (0)
       vbo_exec_debug_verts( exec );
 
+   /* Array draws queued before these vertices go first:
+    */
+   vbo_exec_array_flush( exec );
 
    if (exec->vtx.prim_count && 
        exec->vtx.vert_count) {
@@ -251,10 +313,14 @@ void vbo_exec_vtx_flush( struct vbo_exec_context *exec )
 	 GLenum access = GL_READ_WRITE_ARB;
 	 GLenum usage = GL_STREAM_DRAW_ARB;
 	 GLsizei size = VBO_VERT_BUFFER_SIZE * sizeof(GLfloat);
+	 GLuint base, i;
 	 
 	 /* Before the unmap (why?)
 	  */
-	 vbo_exec_bind_arrays( ctx );
+	 base = vbo_exec_bind_arrays( ctx );
+
+	 for (i = 0; i < exec->vtx.prim_count; i++)
+	    exec->vtx.prim[i].start += base;
 
          /* if using a real VBO, unmap it before drawing */
          if (exec->vtx.bufferobj->Name) {
@@ -267,19 +333,28 @@ void vbo_exec_vtx_flush( struct vbo_exec_context *exec )
 				       exec->vtx.prim, 
 				       exec->vtx.prim_count,
 				       NULL,
-				       0,
-				       exec->vtx.vert_count - 1);
+				       base,
+				       base + exec->vtx.vert_count - 1);
 
 	 /* If using a real VBO, get new storage */
          if (exec->vtx.bufferobj->Name) {
             ctx->Driver.BufferData(ctx, target, size, NULL, usage, exec->vtx.bufferobj);
             exec->vtx.buffer_map = 
                ctx->Driver.MapBuffer(ctx, target, access, exec->vtx.bufferobj);
+            exec->vtx.vbptr = (GLfloat *)exec->vtx.buffer_map;
+            exec->vtx.bound_ptr = NULL;
          }
       }
+      else {
+	 /* Nothing drawn, the copied vertices are all there is.
+	  */
+	 exec->vtx.vbptr = (GLfloat *)exec->vtx.buffer_ptr;
+      }
+   }
+   else {
+      exec->vtx.vbptr = (GLfloat *)exec->vtx.buffer_ptr;
    }
 
    exec->vtx.prim_count = 0;
-   exec->vtx.vert_count = 0;
-   exec->vtx.vbptr = (GLfloat *)exec->vtx.buffer_map;
+   vbo_exec_vtx_restart( exec );
 }
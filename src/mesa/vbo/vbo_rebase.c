@@ -51,15 +51,17 @@
 #include "main/mtypes.h"
 
 #include "vbo.h"
+#include "vbo_context.h"
 
 
 #define REBASE(TYPE) 						\
-static void *rebase_##TYPE( const void *ptr,			\
+static void *rebase_##TYPE( GLcontext *ctx,			\
+			  const void *ptr,			\
 			  GLuint count, 			\
 			  TYPE min_index )			\
 {								\
    const TYPE *in = (TYPE *)ptr;				\
-   TYPE *tmp_indices = malloc(count * sizeof(TYPE));	\
+   TYPE *tmp_indices = vbo_scratch_alloc(ctx, count * sizeof(TYPE)); \
    GLuint i;							\
 								\
    for (i = 0; i < count; i++)  				\
@@ -146,13 +148,13 @@ void vbo_rebase_prims( GLcontext *ctx,
        */
       switch (ib->type) {
       case GL_UNSIGNED_INT: 
-	 tmp_indices = rebase_GLuint( ptr, ib->count, min_index );
+	 tmp_indices = rebase_GLuint( ctx, ptr, ib->count, min_index );
 	 break;
       case GL_UNSIGNED_SHORT: 
-	 tmp_indices = rebase_GLushort( ptr, ib->count, min_index );
+	 tmp_indices = rebase_GLushort( ctx, ptr, ib->count, min_index );
 	 break;
       case GL_UNSIGNED_BYTE: 
-	 tmp_indices = rebase_GLubyte( ptr, ib->count, min_index );
+	 tmp_indices = rebase_GLubyte( ctx, ptr, ib->count, min_index );
 	 break;
       }      
 
@@ -171,7 +173,7 @@ void vbo_rebase_prims( GLcontext *ctx,
    else {
       /* Otherwise the primitives need adjustment.
        */
-      tmp_prims = (struct _mesa_prim *)_mesa_malloc(sizeof(*prim) * nr_prims);
+      tmp_prims = (struct _mesa_prim *)vbo_scratch_alloc(ctx, sizeof(*prim) * nr_prims);
 
       for (i = 0; i < nr_prims; i++) {
 	 /* If this fails, it could indicate an application error:
@@ -212,10 +214,10 @@ void vbo_rebase_prims( GLcontext *ctx,
 	 max_index - min_index );
    
    if (tmp_indices)
-      _mesa_free(tmp_indices);
+      vbo_scratch_free(ctx, tmp_indices);
    
    if (tmp_prims)
-      _mesa_free(tmp_prims);
+      vbo_scratch_free(ctx, tmp_prims);
 }
 
 
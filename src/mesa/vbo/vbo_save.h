@@ -87,7 +87,7 @@ struct vbo_save_vertex_list {
  * likelyhood as it occurs.  No reason we couldn't change usage
  * internally even though this probably isn't allowed for client VBOs?
  */
-#define VBO_SAVE_BUFFER_SIZE (8*1024) /* dwords */
+#define VBO_SAVE_BUFFER_SIZE (64*1024) /* dwords */
 #define VBO_SAVE_PRIM_SIZE   128
 #define VBO_SAVE_PRIM_WEAK 0x40
 
@@ -139,6 +139,9 @@ struct vbo_save_context {
    GLboolean have_materials;
 
    GLuint opcode_vertex_list;
+   struct vbo_save_vertex_list *last_list; /* most recently compiled node */
+   Node *last_block;		/* list position just after last_list */
+   GLuint last_pos;
 
    struct vbo_save_copied_vtx copied;
    
@@ -256,6 +256,77 @@ static void _save_reset_counters( GLcontext *ctx )
 }
 
 
+/* Can two adjacent primitives be drawn as one?  Only complete
+ * primitives of the independent types qualify, and the first must hold
+ * a whole number of points, lines, triangles or quads so that the
+ * second one's vertices keep their grouping.
+ */
+static GLboolean _save_can_merge_prims( const struct _mesa_prim *p0,
+					const struct _mesa_prim *p1 )
+{
+   GLuint n;
+
+   if (p0->mode != p1->mode ||
+       p0->weak != p1->weak ||
+       p0->indexed || p1->indexed ||
+       !p0->begin || !p0->end ||
+       !p1->begin || !p1->end ||
+       p0->start + p0->count != p1->start)
+      return GL_FALSE;
+
+   switch (p0->mode) {
+   case GL_POINTS: n = 1; break;
+   case GL_LINES: n = 2; break;
+   case GL_TRIANGLES: n = 3; break;
+   case GL_QUADS: n = 4; break;
+   default: return GL_FALSE;
+   }
+
+   return (p0->count % n) == 0;
+}
+
+
+/* Return the vertex list compiled immediately before the current run
+ * of vertices if the run can simply be appended to it: no other opcode
+ * may have been compiled in between, the vertex format must match and
+ * both the vertex and primitive storage must be contiguous.
+ */
+static struct vbo_save_vertex_list *_save_mergeable_list( GLcontext *ctx )
+{
+   struct vbo_save_context *save = &vbo_context(ctx)->save;
+   struct vbo_save_vertex_list *prev = save->last_list;
+   GLuint offset;
+
+   if (!prev ||
+       save->last_block != ctx->ListState.CurrentBlock ||
+       save->last_pos != ctx->ListState.CurrentPos)
+      return NULL;
+
+   if (prev->vertex_store != save->vertex_store ||
+       prev->prim_store != save->prim_store ||
+       prev->vertex_size != save->vertex_size ||
+       _mesa_memcmp(prev->attrsz, save->attrsz, sizeof(prev->attrsz)) != 0)
+      return NULL;
+
+   /* Only runs starting on a fresh glBegin, after a list whose last
+    * primitive is complete, need no copied vertices at the join:
+    */
+   if (save->copied.nr != 0 ||
+       prev->prim_count == 0 || save->prim_count == 0 ||
+       !prev->prim[prev->prim_count - 1].end ||
+       !save->prim[0].begin)
+      return NULL;
+
+   offset = (save->buffer - save->vertex_store->buffer) * sizeof(GLfloat);
+   if (prev->buffer_offset + 
+       prev->count * prev->vertex_size * sizeof(GLfloat) != offset ||
+       prev->prim + prev->prim_count != save->prim)
+      return NULL;
+
+   return prev;
+}
+
+
 /* Insert the active immediate struct onto the display list currently
  * being built.
  */
@@ -264,30 +335,82 @@ static void _save_compile_vertex_list( GLcontext *ctx )
    struct vbo_save_context *save = &vbo_context(ctx)->save;
    struct vbo_save_vertex_list *node;
 
-   /* Allocate space for this structure in the display list currently
-    * being compiled.
+   /* Deal with GL_COMPILE_AND_EXECUTE:
     */
-   node = (struct vbo_save_vertex_list *)
-      _mesa_alloc_instruction(ctx, save->opcode_vertex_list, sizeof(*node));
+   if (ctx->ExecuteFlag) {
+      struct _glapi_table *dispatch = GET_DISPATCH();
 
-   if (!node)
-      return;
+      _glapi_set_dispatch(ctx->Exec);
 
-   /* Duplicate our template, increment refcounts to the storage structs:
-    */
-   _mesa_memcpy(node->attrsz, save->attrsz, sizeof(node->attrsz)); 
-   node->vertex_size = save->vertex_size;
-   node->buffer_offset = (save->buffer - save->vertex_store->buffer) * sizeof(GLfloat); 
-   node->count = save->vert_count;
-   node->wrap_count = save->copied.nr;
-   node->dangling_attr_ref = save->dangling_attr_ref;
-   node->prim = save->prim;
-   node->prim_count = save->prim_count;
-   node->vertex_store = save->vertex_store;
-   node->prim_store = save->prim_store;
-
-   node->vertex_store->refcount++;
-   node->prim_store->refcount++;
+      vbo_loopback_vertex_list( ctx,
+				save->buffer,
+				save->attrsz,
+				save->prim,
+				save->prim_count,
+				save->copied.nr,
+				save->vertex_size);
+
+      _glapi_set_dispatch(dispatch);
+   }
+
+   node = _save_mergeable_list( ctx );
+
+   if (node) {
+      /* Extend the previous vertex list with this run, joining the
+       * primitives at the seam where possible.  Display lists built
+       * from many small Begin/End pairs then replay as a few large
+       * draws.
+       */
+      struct _mesa_prim *prim = node->prim + node->prim_count;
+      GLuint i;
+
+      for (i = 0 ; i < save->prim_count ; i++)
+	 prim[i].start += node->count;
+
+      if (_save_can_merge_prims( &prim[-1], &prim[0] )) {
+	 prim[-1].count += prim[0].count;
+	 for (i = 1 ; i < save->prim_count ; i++)
+	    prim[i-1] = prim[i];
+	 node->prim_count--;
+      }
+
+      node->count += save->vert_count;
+      node->prim_count += save->prim_count;
+      node->dangling_attr_ref |= save->dangling_attr_ref;
+   }
+   else {
+      /* Allocate space for this structure in the display list currently
+       * being compiled.
+       */
+      node = (struct vbo_save_vertex_list *)
+	 _mesa_alloc_instruction(ctx, save->opcode_vertex_list, sizeof(*node));
+
+      if (!node)
+	 return;
+
+      /* Duplicate our template, increment refcounts to the storage structs:
+       */
+      _mesa_memcpy(node->attrsz, save->attrsz, sizeof(node->attrsz)); 
+      node->vertex_size = save->vertex_size;
+      node->buffer_offset = (save->buffer - save->vertex_store->buffer) * sizeof(GLfloat); 
+      node->count = save->vert_count;
+      node->wrap_count = save->copied.nr;
+      node->dangling_attr_ref = save->dangling_attr_ref;
+      node->prim = save->prim;
+      node->prim_count = save->prim_count;
+      node->vertex_store = save->vertex_store;
+      node->prim_store = save->prim_store;
+
+      node->vertex_store->refcount++;
+      node->prim_store->refcount++;
+
+      /* Remember where the node ends, to detect whether the next run
+       * directly follows it:
+       */
+      save->last_list = node;
+      save->last_block = ctx->ListState.CurrentBlock;
+      save->last_pos = ctx->ListState.CurrentPos;
+   }
 
    assert(node->attrsz[VBO_ATTRIB_POS] != 0 ||
 	  node->count == 0);
@@ -295,33 +418,15 @@ static void _save_compile_vertex_list( GLcontext *ctx )
    if (save->dangling_attr_ref)
       ctx->ListState.CurrentList->flags |= MESA_DLIST_DANGLING_REFS;
 
-   save->vertex_store->used += save->vertex_size * node->count;
-   save->prim_store->used += node->prim_count;
+   save->vertex_store->used += save->vertex_size * save->vert_count;
+   save->prim_store->used = (node->prim + node->prim_count) - save->prim_store->buffer;
 
 
    /* Copy duplicated vertices 
     */
-   save->copied.nr = _save_copy_vertices( ctx, node, save->buffer );
-
-
-   /* Deal with GL_COMPILE_AND_EXECUTE:
-    */
-   if (ctx->ExecuteFlag) {
-      struct _glapi_table *dispatch = GET_DISPATCH();
-
-      _glapi_set_dispatch(ctx->Exec);
-
-      vbo_loopback_vertex_list( ctx,
-				(const GLfloat *)((const char *)save->vertex_store->buffer + 
-						  node->buffer_offset),
-				node->attrsz,
-				node->prim,
-				node->prim_count,
-				node->wrap_count,
-				node->vertex_size);
-
-      _glapi_set_dispatch(dispatch);
-   }
+   save->copied.nr = _save_copy_vertices( ctx, node, 
+					  save->vertex_store->buffer + 
+					  node->buffer_offset / sizeof(GLfloat) );
 
 
    /* Decide whether the storage structs are full, or can be used for
@@ -433,6 +538,13 @@ static void _save_copy_to_current( GLcontext *ctx )
 	 COPY_CLEAN_4V(save->current[i], 
 		       save->attrsz[i], 
 		       save->attrptr[i]);
+
+	 /* A repeated glColor isn't a no-op after glMaterial with
+	  * GL_COLOR_MATERIAL, so dlist.c mustn't drop it.
+	  */
+	 if (i >= VBO_ATTRIB_FIRST_MATERIAL &&
+	     i <= VBO_ATTRIB_LAST_MATERIAL)
+	    ctx->ListState.KnownAttribs &= ~VERT_BIT_COLOR0;
       }
    }
 }
@@ -751,6 +863,15 @@ static void GLAPIENTRY _save_End( void )
    save->prim[i].count = (save->vert_count - 
 			  save->prim[i].start);
 
+   /* Fold runs of glBegin(GL_TRIANGLES)/glEnd() and the like into a
+    * single primitive:
+    */
+   if (i > 0 && _save_can_merge_prims( &save->prim[i-1], &save->prim[i] )) {
+      save->prim[i-1].count += save->prim[i].count;
+      save->prim_count--;
+      i--;
+   }
+
    if (i == (GLint) save->prim_max - 1) {
       _save_compile_vertex_list( ctx );
       assert(save->copied.nr == 0);
@@ -1034,6 +1155,8 @@ void vbo_save_NewList( GLcontext *ctx, GLuint list, GLenum mode )
 
    if (!save->vertex_store) 
       save->vertex_store = alloc_vertex_store( ctx );
+
+   save->last_list = NULL;
       
    save->vbptr = map_vertex_store( ctx, save->vertex_store );
    
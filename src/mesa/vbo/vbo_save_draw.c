@@ -243,6 +243,7 @@ void vbo_save_playback_vertex_list( GLcontext *ctx, void *data )
          return;
       }
 
+      vbo_exec_array_flush( &vbo_context(ctx)->exec );
       vbo_bind_vertex_list( ctx, node );
 
       vbo_context(ctx)->draw_prims( ctx, 
@@ -123,12 +123,16 @@ void vbo_split_prims( GLcontext *ctx,
       }
       else if (max_index - min_index >= limits->max_verts) {
 	 /* The vertex buffers are too large for hardware (or the
-	  * swtnl module).  Traverse the indices, re-emitting vertices
-	  * in turn.  Use a vertex cache to preserve some of the
-	  * sharing from the original index list.
+	  * swtnl module).  Try drawing pieces of the primitives
+	  * straight from the arrays, rebasing their indices.  Failing
+	  * that, traverse the indices, re-emitting vertices in turn.
+	  * Use a vertex cache to preserve some of the sharing from the
+	  * original index list.
 	  */
-	 vbo_split_copy(ctx, arrays, prim, nr_prims, ib,
-			draw, limits );
+	 if (!vbo_split_inplace_elts(ctx, arrays, prim, nr_prims, ib,
+				     draw, limits ))
+	    vbo_split_copy(ctx, arrays, prim, nr_prims, ib,
+			   draw, limits );
       }
       else if (ib->count > limits->max_indices) {
 	 /* The index buffer is too large for hardware.  Try to split
@@ -59,6 +59,16 @@ void vbo_split_inplace( GLcontext *ctx,
 			vbo_draw_func draw,
 			const struct split_limits *limits );
 
+/* Requires ib != NULL:
+ */
+GLboolean vbo_split_inplace_elts( GLcontext *ctx,
+				  const struct gl_client_array *arrays[],
+				  const struct _mesa_prim *prim,
+				  GLuint nr_prims,
+				  const struct _mesa_index_buffer *ib,
+				  vbo_draw_func draw,
+				  const struct split_limits *limits );
+
 /* Requires ib != NULL:
  */
 void vbo_split_copy( GLcontext *ctx,
@@ -36,6 +36,7 @@
 #include "main/mtypes.h"
 
 #include "vbo_split.h"
+#include "vbo_context.h"
 #include "vbo.h"
 
 
@@ -414,7 +415,7 @@ static void replay_init( struct copy_context *copy )
 
    switch (copy->ib->type) {
    case GL_UNSIGNED_BYTE:
-      copy->translated_elt_buf = _mesa_malloc(sizeof(GLuint) * copy->ib->count);
+      copy->translated_elt_buf = vbo_scratch_alloc(ctx, sizeof(GLuint) * copy->ib->count);
       copy->srcelt = copy->translated_elt_buf;
 
       for (i = 0; i < copy->ib->count; i++)
@@ -422,7 +423,7 @@ static void replay_init( struct copy_context *copy )
       break;
 
    case GL_UNSIGNED_SHORT:
-      copy->translated_elt_buf = _mesa_malloc(sizeof(GLuint) * copy->ib->count);
+      copy->translated_elt_buf = vbo_scratch_alloc(ctx, sizeof(GLuint) * copy->ib->count);
       copy->srcelt = copy->translated_elt_buf;
 
       for (i = 0; i < copy->ib->count; i++)
@@ -449,8 +450,8 @@ static void replay_init( struct copy_context *copy )
     *
     * XXX:  This should be a VBO!
     */
-   copy->dstbuf = _mesa_malloc(copy->dstbuf_size * 
-			       copy->vertex_size);   
+   copy->dstbuf = vbo_scratch_alloc(ctx, copy->dstbuf_size * 
+				    copy->vertex_size);   
    copy->dstptr = copy->dstbuf;
 
    /* Setup new vertex arrays to point into the output buffer: 
@@ -478,7 +479,7 @@ static void replay_init( struct copy_context *copy )
 			    copy->ib->count * 2 + 3);
    copy->dstelt_size = MIN2(copy->dstelt_size,
 			    copy->limits->max_indices);
-   copy->dstelt = _mesa_malloc(sizeof(GLuint) * copy->dstelt_size);
+   copy->dstelt = vbo_scratch_alloc(ctx, sizeof(GLuint) * copy->dstelt_size);
    copy->dstelt_nr = 0;
 
    /* Setup the new index buffer to point to the allocated element
@@ -496,11 +497,11 @@ static void replay_finish( struct copy_context *copy )
    GLcontext *ctx = copy->ctx;
    GLuint i;
 
-   /* Free our vertex and index buffers: 
+   /* Free our vertex and index buffers, newest first: 
     */
-   _mesa_free(copy->translated_elt_buf);
-   _mesa_free(copy->dstbuf);
-   _mesa_free(copy->dstelt);
+   vbo_scratch_free(ctx, copy->dstelt);
+   vbo_scratch_free(ctx, copy->dstbuf);
+   vbo_scratch_free(ctx, copy->translated_elt_buf);
    
    /* Unmap VBO's 
     */
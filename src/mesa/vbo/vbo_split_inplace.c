@@ -31,6 +31,7 @@
 #include "main/macros.h"
 #include "main/enums.h"
 #include "vbo_split.h"
+#include "vbo_context.h"
 
 
 #define MAX_PRIM 32
@@ -213,7 +214,7 @@ static void split_prims( struct split_context *split)
 	  */
 	 struct _mesa_index_buffer ib;
 	 struct _mesa_prim tmpprim;
-	 GLuint *elts = malloc(count * sizeof(GLuint));
+	 GLuint *elts = vbo_scratch_alloc(split->ctx, count * sizeof(GLuint));
 	 GLuint j;
 	 
 	 for (j = 0; j < count; j++)
@@ -238,7 +239,7 @@ static void split_prims( struct split_context *split)
 			split->draw,
 			split->limits);
 	    
-	 free(elts);
+	 vbo_scratch_free(split->ctx, elts);
       }
       else {
 	 flush_vertex(split);
@@ -284,3 +285,205 @@ void vbo_split_inplace( GLcontext *ctx,
 }
 
 
+
+/* Used for splitting indexed primitives without copying vertices.
+ */
+struct elt_split_context {
+   GLcontext *ctx;
+   const struct gl_client_array **array;
+   vbo_draw_func draw;
+   const struct split_limits *limits;
+
+   const GLuint *elts;		/* whole index buffer as GLuint */
+   GLuint *dstelt;		/* rebased indices of one piece */
+};
+
+
+static void draw_elts_piece( struct elt_split_context *split,
+			     const struct _mesa_prim *prim,
+			     GLuint start, GLuint end, GLuint count,
+			     GLuint min_index, GLuint max_index )
+{
+   struct gl_client_array tmp_arrays[VERT_ATTRIB_MAX];
+   const struct gl_client_array *tmp_array_pointers[VERT_ATTRIB_MAX];
+   struct _mesa_index_buffer ib;
+   struct _mesa_prim outprim;
+   const GLuint *elts = split->elts + prim->start;
+   GLuint i;
+
+   for (i = 0; i < end - start; i++)
+      split->dstelt[i] = elts[start + i] - min_index;
+
+   /* Point the arrays at the piece's first vertex, as vbo_rebase_prims()
+    * does.  The vertex data itself stays where it is.
+    */
+   for (i = 0; i < VERT_ATTRIB_MAX; i++) {
+      tmp_arrays[i] = *split->array[i];
+      tmp_arrays[i].Ptr += min_index * tmp_arrays[i].StrideB;
+      tmp_array_pointers[i] = &tmp_arrays[i];
+   }
+
+   outprim = *prim;
+   outprim.begin = (start == 0 && prim->begin);
+   outprim.end = (end == count && prim->end);
+   outprim.indexed = 1;
+   outprim.start = 0;
+   outprim.count = end - start;
+
+   ib.count = end - start;
+   ib.type = GL_UNSIGNED_INT;
+   ib.obj = split->ctx->Array.NullBufferObj;
+   ib.ptr = split->dstelt;
+
+   split->draw( split->ctx,
+		tmp_array_pointers,
+		&outprim, 1,
+		&ib,
+		0,
+		max_index - min_index );
+}
+
+
+/* Cut one primitive into pieces whose indices each span fewer than
+ * max_verts vertices.  Returns false if that isn't possible.  Only
+ * draws the pieces when 'emit' is set, so it can be used to test the
+ * whole draw first.
+ */
+static GLboolean split_elts_prim( struct elt_split_context *split,
+				  const struct _mesa_prim *prim,
+				  GLboolean emit )
+{
+   const GLuint *elts = split->elts + prim->start;
+   const GLuint max_verts = split->limits->max_verts;
+   const GLuint max_indices = split->limits->max_indices;
+   GLuint first, incr, count, start, end, i;
+
+   if (!split_prim_inplace(prim->mode, &first, &incr))
+      return GL_FALSE;
+
+   if (prim->count < first)
+      return GL_TRUE;
+
+   count = prim->count - (prim->count - first) % incr;
+
+   for (start = 0; ; start = end - (first - incr)) {
+      GLuint min_index = elts[start];
+      GLuint max_index = elts[start];
+
+      for (i = start + 1; i < start + first; i++) {
+	 min_index = MIN2(min_index, elts[i]);
+	 max_index = MAX2(max_index, elts[i]);
+      }
+
+      if (max_index - min_index >= max_verts)
+	 return GL_FALSE;
+
+      /* Grow the piece while its vertices still fit:
+       */
+      for (end = start + first;
+	   end + incr <= count && end + incr - start <= max_indices;
+	   end += incr) {
+	 GLuint tmp_min = min_index, tmp_max = max_index;
+
+	 for (i = end; i < end + incr; i++) {
+	    tmp_min = MIN2(tmp_min, elts[i]);
+	    tmp_max = MAX2(tmp_max, elts[i]);
+	 }
+
+	 if (tmp_max - tmp_min >= max_verts)
+	    break;
+
+	 min_index = tmp_min;
+	 max_index = tmp_max;
+      }
+
+      /* Restart triangle strips on an even vertex to keep the winding.
+       * The range found above still covers the shorter piece.
+       */
+      if (end < count && prim->mode == GL_TRIANGLE_STRIP && (end & 1)) {
+	 if (end - 1 - start < first)
+	    return GL_FALSE;
+	 end--;
+      }
+
+      if (emit)
+	 draw_elts_piece(split, prim, start, end, count, min_index, max_index);
+
+      if (end == count)
+	 return GL_TRUE;
+   }
+}
+
+
+/* Indexed primitives whose indices span more vertices than the limits
+ * allow.  The indices of large meshes are usually local enough that
+ * each primitive can be drawn in pieces straight from the original
+ * arrays, only rewriting the indices.  Returns false without drawing
+ * anything when that doesn't work out and vertices must be copied
+ * with vbo_split_copy() instead.
+ */
+GLboolean vbo_split_inplace_elts( GLcontext *ctx,
+				  const struct gl_client_array *arrays[],
+				  const struct _mesa_prim *prim,
+				  GLuint nr_prims,
+				  const struct _mesa_index_buffer *ib,
+				  vbo_draw_func draw,
+				  const struct split_limits *limits )
+{
+   struct elt_split_context split;
+   GLboolean map_ib = ib->obj->Name && !ib->obj->Pointer;
+   const void *ptr;
+   GLuint *elts;
+   GLboolean ok = GL_TRUE;
+   GLuint i;
+
+   if (map_ib)
+      ctx->Driver.MapBuffer(ctx,
+			    GL_ELEMENT_ARRAY_BUFFER,
+			    GL_READ_ONLY_ARB,
+			    ib->obj);
+
+   ptr = ADD_POINTERS(ib->obj->Pointer, ib->ptr);
+
+   elts = vbo_scratch_alloc(ctx, ib->count * sizeof(GLuint));
+   switch (ib->type) {
+   case GL_UNSIGNED_INT:
+      _mesa_memcpy(elts, ptr, ib->count * sizeof(GLuint));
+      break;
+   case GL_UNSIGNED_SHORT:
+      for (i = 0; i < ib->count; i++)
+	 elts[i] = ((const GLushort *)ptr)[i];
+      break;
+   case GL_UNSIGNED_BYTE:
+      for (i = 0; i < ib->count; i++)
+	 elts[i] = ((const GLubyte *)ptr)[i];
+      break;
+   }
+
+   if (map_ib)
+      ctx->Driver.UnmapBuffer(ctx,
+			      GL_ELEMENT_ARRAY_BUFFER,
+			      ib->obj);
+
+   split.ctx = ctx;
+   split.array = arrays;
+   split.draw = draw;
+   split.limits = limits;
+   split.elts = elts;
+   split.dstelt = NULL;
+
+   for (i = 0; i < nr_prims && ok; i++)
+      ok = split_elts_prim(&split, &prim[i], GL_FALSE);
+
+   if (ok) {
+      split.dstelt = vbo_scratch_alloc(ctx, ib->count * sizeof(GLuint));
+
+      for (i = 0; i < nr_prims; i++)
+	 split_elts_prim(&split, &prim[i], GL_TRUE);
+
+      vbo_scratch_free(ctx, split.dstelt);
+   }
+
+   vbo_scratch_free(ctx, elts);
+   return ok;
+}